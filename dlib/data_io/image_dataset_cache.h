@@ -0,0 +1,442 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_IMAGE_DATASET_CACHE_Hh_
+#define DLIB_IMAGE_DATASET_CACHE_Hh_
+
+#include "image_dataset_cache_abstract.h"
+#include "image_dataset_metadata.h"
+#include "load_image_dataset.h"
+#include "../serialize.h"
+#include "../dir_nav.h"
+#include "../image_io.h"
+#include "../array2d.h"
+#include "../pixel.h"
+#include "../threads.h"
+#include "../image_processing/full_object_detection.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        const int image_dataset_cache_version = 1;
+
+        inline void serialize_cache_box (
+            const image_dataset_metadata::box& item,
+            std::ostream& out
+        )
+        {
+            serialize(item.rect, out);
+            serialize(item.parts, out);
+            serialize(item.label, out);
+            serialize(item.difficult, out);
+            serialize(item.truncated, out);
+            serialize(item.occluded, out);
+            serialize(item.ignore, out);
+            serialize(item.pose, out);
+            serialize(item.detection_score, out);
+            serialize(item.angle, out);
+        }
+
+        inline void deserialize_cache_box (
+            image_dataset_metadata::box& item,
+            std::istream& in
+        )
+        {
+            deserialize(item.rect, in);
+            deserialize(item.parts, in);
+            deserialize(item.label, in);
+            deserialize(item.difficult, in);
+            deserialize(item.truncated, in);
+            deserialize(item.occluded, in);
+            deserialize(item.ignore, in);
+            deserialize(item.pose, in);
+            deserialize(item.detection_score, in);
+            deserialize(item.angle, in);
+        }
+
+        // The index is found through the last 8 bytes of the file, which hold its offset
+        // as a little endian number.  This lets the images be streamed to disk before the
+        // index is known.
+        inline void write_cache_offset (
+            uint64 offset,
+            std::ostream& out
+        )
+        {
+            char buf[8];
+            for (int i = 0; i < 8; ++i)
+                buf[i] = static_cast<char>((offset >> (8*i))&0xFF);
+            out.write(buf, 8);
+        }
+
+        inline uint64 read_cache_offset (
+            std::istream& in
+        )
+        {
+            unsigned char buf[8];
+            in.read(reinterpret_cast<char*>(buf), 8);
+            uint64 offset = 0;
+            for (int i = 0; i < 8; ++i)
+                offset |= static_cast<uint64>(buf[i]) << (8*i);
+            return offset;
+        }
+
+        template <typename pixel_type>
+        struct cache_pixel_format;
+        template <> struct cache_pixel_format<unsigned char> { const static int value = 1; };
+        template <> struct cache_pixel_format<rgb_pixel>     { const static int value = 3; };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type
+        >
+    void create_image_dataset_cache (
+        const std::string& dataset_filename,
+        const std::string& cache_filename
+    )
+    {
+        const int pixel_format = impl::cache_pixel_format<pixel_type>::value;
+
+        image_dataset_metadata::dataset data;
+        image_dataset_metadata::load_image_dataset_metadata(data, dataset_filename);
+
+        std::ofstream fout(cache_filename.c_str(), std::ios::binary);
+        if (!fout)
+            throw error("Unable to open " + cache_filename + " for writing.");
+
+        serialize(std::string("dlib::image_dataset_cache"), fout);
+        serialize(impl::image_dataset_cache_version, fout);
+        serialize(pixel_format, fout);
+
+        std::vector<uint64> offsets(data.images.size());
+        std::vector<long> nr(data.images.size()), nc(data.images.size());
+        {
+            // The image file names are relative to the folder containing the XML file.
+            locally_change_current_dir chdir(get_parent_directory(file(dataset_filename)));
+
+            array2d<pixel_type> img;
+            for (unsigned long i = 0; i < data.images.size(); ++i)
+            {
+                load_image(img, data.images[i].filename);
+                offsets[i] = fout.tellp();
+                nr[i] = img.nr();
+                nc[i] = img.nc();
+                for (long r = 0; r < img.nr(); ++r)
+                    fout.write(reinterpret_cast<const char*>(&img[r][0]), img.nc()*sizeof(pixel_type));
+            }
+        }
+
+        const uint64 index_offset = fout.tellp();
+        serialize(data.name, fout);
+        serialize(data.comment, fout);
+        serialize(data.images.size(), fout);
+        for (unsigned long i = 0; i < data.images.size(); ++i)
+        {
+            serialize(offsets[i], fout);
+            serialize(nr[i], fout);
+            serialize(nc[i], fout);
+            serialize(data.images[i].filename, fout);
+            serialize(data.images[i].boxes.size(), fout);
+            for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
+                impl::serialize_cache_box(data.images[i].boxes[j], fout);
+        }
+        impl::write_cache_offset(index_offset, fout);
+
+        if (!fout)
+            throw error("Error while writing to " + cache_filename);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class image_dataset_cache : noncopyable
+    {
+    public:
+
+        image_dataset_cache (
+            const std::string& cache_filename
+        ) : filename(cache_filename)
+        {
+            std::ifstream fin(filename.c_str(), std::ios::binary);
+            if (!fin)
+                throw error("Unable to open " + filename + " for reading.");
+
+            std::string magic;
+            int version = 0;
+            deserialize(magic, fin);
+            deserialize(version, fin);
+            if (magic != "dlib::image_dataset_cache" || version != impl::image_dataset_cache_version)
+                throw serialization_error("Unexpected file contents in " + filename + ".  It isn't an image dataset cache file.");
+            deserialize(pixel_format, fin);
+            if (pixel_format != 1 && pixel_format != 3)
+                throw serialization_error("Unknown pixel format in image dataset cache file " + filename + ".");
+
+            // The file must at least hold the header and the index offset, and the offset
+            // must point between them.  Anything else means the file was truncated or
+            // damaged.
+            const uint64 header_size = fin.tellg();
+            fin.seekg(0, std::ios::end);
+            const uint64 file_size = fin.tellg();
+            if (!fin || file_size < header_size + 8)
+                throw serialization_error("The image dataset cache file " + filename + " is truncated.");
+            fin.seekg(file_size - 8);
+            const uint64 index_offset = impl::read_cache_offset(fin);
+            if (!fin || index_offset < header_size || index_offset > file_size - 8)
+                throw serialization_error("The image dataset cache file " + filename + " is corrupt.  Its index offset is outside the file.");
+            fin.seekg(index_offset);
+            deserialize(data.name, fin);
+            deserialize(data.comment, fin);
+            unsigned long num;
+            deserialize(num, fin);
+            data.images.resize(num);
+            offsets.resize(num);
+            nr.resize(num);
+            nc.resize(num);
+            for (unsigned long i = 0; i < num; ++i)
+            {
+                deserialize(offsets[i], fin);
+                deserialize(nr[i], fin);
+                deserialize(nc[i], fin);
+                if (nr[i] < 0 || nc[i] < 0 || offsets[i] < header_size || offsets[i] > index_offset ||
+                    (index_offset - offsets[i])/pixel_format < static_cast<uint64>(nr[i])*nc[i])
+                    throw serialization_error("The image dataset cache file " + filename + " is corrupt.  Image " + 
+                                              cast_to_string(i) + " lies outside the image data.");
+                deserialize(data.images[i].filename, fin);
+                unsigned long num_boxes;
+                deserialize(num_boxes, fin);
+                data.images[i].boxes.resize(num_boxes);
+                for (unsigned long j = 0; j < num_boxes; ++j)
+                    impl::deserialize_cache_box(data.images[i].boxes[j], fin);
+            }
+            if (!fin)
+                throw serialization_error("Error while reading " + filename);
+        }
+
+        unsigned long size (
+        ) const { return data.images.size(); }
+
+        bool is_color (
+        ) const { return pixel_format == 3; }
+
+        const image_dataset_metadata::dataset& get_metadata (
+        ) const { return data; }
+
+        const std::string& get_filename (
+        ) const { return filename; }
+
+        template <
+            typename image_type
+            >
+        void get_image (
+            unsigned long idx,
+            image_type& img_
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(idx < size(),
+                "\t void image_dataset_cache::get_image()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t idx:    " << idx
+                << "\n\t size(): " << size()
+                );
+
+            image_view<image_type> img(img_);
+            img.set_size(nr[idx], nc[idx]);
+
+            // Each call reads through its own stream so threads loading different images
+            // don't wait on each other.
+            std::unique_ptr<std::ifstream> fin = checkout_stream();
+            fin->seekg(offsets[idx]);
+            if (pixel_format == 1)
+                read_rows<unsigned char>(*fin, img);
+            else
+                read_rows<rgb_pixel>(*fin, img);
+
+            if (!*fin)
+                throw serialization_error("Error while reading image " + cast_to_string(idx) + " from " + filename);
+            return_stream(std::move(fin));
+        }
+
+    private:
+
+        std::unique_ptr<std::ifstream> checkout_stream (
+        ) const
+        /*!
+            ensures
+                - returns an open stream on the cache file that no other thread is using.
+                  Streams handed back with return_stream() are reused, so there are only
+                  ever about as many open streams as threads calling get_image() at once.
+        !*/
+        {
+            {
+                auto_mutex lock(m);
+                if (idle_streams.size() != 0)
+                {
+                    std::unique_ptr<std::ifstream> fin = std::move(idle_streams.back());
+                    idle_streams.pop_back();
+                    return fin;
+                }
+            }
+            std::unique_ptr<std::ifstream> fin(new std::ifstream(filename.c_str(), std::ios::binary));
+            if (!*fin)
+                throw error("Unable to open " + filename + " for reading.");
+            return fin;
+        }
+
+        void return_stream (
+            std::unique_ptr<std::ifstream>&& fin
+        ) const
+        {
+            auto_mutex lock(m);
+            idle_streams.push_back(std::move(fin));
+        }
+
+        template <typename stored_type, typename view_type>
+        static typename enable_if<is_same_type<stored_type,typename view_type::pixel_type> >::type read_rows (
+            std::istream& fin,
+            view_type& img
+        ) 
+        {
+            // The pixels are stored in exactly the caller's format so read them straight
+            // into the image.
+            for (long r = 0; r < img.nr(); ++r)
+                fin.read(reinterpret_cast<char*>(&img[r][0]), img.nc()*sizeof(stored_type));
+        }
+
+        template <typename stored_type, typename view_type>
+        static typename disable_if<is_same_type<stored_type,typename view_type::pixel_type> >::type read_rows (
+            std::istream& fin,
+            view_type& img
+        ) 
+        {
+            std::vector<stored_type> row(img.nc());
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                fin.read(reinterpret_cast<char*>(&row[0]), img.nc()*sizeof(stored_type));
+                for (long c = 0; c < img.nc(); ++c)
+                    assign_pixel(img[r][c], row[c]);
+            }
+        }
+
+        std::string filename;
+        int pixel_format;
+        image_dataset_metadata::dataset data;
+        std::vector<uint64> offsets;
+        std::vector<long> nr, nc;
+
+        mutable std::vector<std::unique_ptr<std::ifstream> > idle_streams;
+        mutable mutex m;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<rectangle> >& object_locations,
+        const image_dataset_cache& cache,
+        const image_dataset_file& options
+    )
+    {
+        return impl::load_dataset_images(images, object_locations, cache.get_metadata(), options,
+            [&](unsigned long i, typename array_type::value_type& img) { cache.get_image(i, img); });
+    }
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<rectangle> >& object_locations,
+        const image_dataset_cache& cache
+    )
+    {
+        return load_image_dataset(images, object_locations, cache, image_dataset_file());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    void load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<mmod_rect> >& object_locations,
+        const image_dataset_cache& cache,
+        const image_dataset_file& options
+    )
+    {
+        impl::load_dataset_images(images, object_locations, cache.get_metadata(), options,
+            [&](unsigned long i, typename array_type::value_type& img) { cache.get_image(i, img); });
+    }
+
+    template <
+        typename array_type
+        >
+    void load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<mmod_rect> >& object_locations,
+        const image_dataset_cache& cache
+    )
+    {
+        load_image_dataset(images, object_locations, cache, image_dataset_file());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<full_object_detection> >& object_locations,
+        const image_dataset_cache& cache,
+        const image_dataset_file& options,
+        std::vector<std::string>& parts_list
+    )
+    {
+        return impl::load_dataset_images(images, object_locations, cache.get_metadata(), options, parts_list,
+            [&](unsigned long i, typename array_type::value_type& img) { cache.get_image(i, img); });
+    }
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<full_object_detection> >& object_locations,
+        const image_dataset_cache& cache,
+        const image_dataset_file& options
+    )
+    {
+        std::vector<std::string> parts_list;
+        return load_image_dataset(images, object_locations, cache, options, parts_list);
+    }
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<full_object_detection> >& object_locations,
+        const image_dataset_cache& cache
+    )
+    {
+        return load_image_dataset(images, object_locations, cache, image_dataset_file());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_IMAGE_DATASET_CACHE_Hh_
+
@@ -0,0 +1,296 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_IMAGE_DATASET_CACHE_ABSTRACT_Hh_
+#ifdef DLIB_IMAGE_DATASET_CACHE_ABSTRACT_Hh_
+
+#include "image_dataset_metadata.h"
+#include "load_image_dataset_abstract.h"
+#include "../image_processing/full_object_detection_abstract.h"
+#include <string>
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type
+        >
+    void create_image_dataset_cache (
+        const std::string& dataset_filename,
+        const std::string& cache_filename
+    );
+    /*!
+        requires
+            - pixel_type == unsigned char or rgb_pixel
+        ensures
+            - Loads the XML image dataset file dataset_filename (i.e. a file produced by
+              imglab or save_image_dataset_metadata()), decodes every image it lists, and
+              writes the decoded pixels along with all the image annotations into the
+              binary file cache_filename.  The images are converted to pixel_type before
+              they are written.
+            - The resulting file can be read with image_dataset_cache.  Since its images
+              are already decoded, loading them is limited only by disk bandwidth.  So it
+              is useful to create a cache once and then use it in every training run
+              rather than decoding the original image files each time.
+        throws
+            - dlib::error
+                This exception is thrown if the dataset can't be loaded or the cache file
+                can't be written.
+            - image_load_error
+                This exception is thrown if one of the images can't be loaded.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    class image_dataset_cache : noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object gives random access to the images and annotations in a file
+                created by create_image_dataset_cache().
+
+                When constructed it only reads the file's index, i.e. the annotations and
+                the location of each image in the file.  The pixels of an image are read
+                from disk when get_image() is called.
+
+            THREAD SAFETY
+                It is safe to call the const member functions of this object from
+                multiple threads at the same time.  Each thread that is inside
+                get_image() reads through its own file stream, so threads loading
+                different images don't block each other.
+        !*/
+
+    public:
+
+        image_dataset_cache (
+            const std::string& cache_filename
+        );
+        /*!
+            ensures
+                - Opens the given cache file, which must have been created by
+                  create_image_dataset_cache(), and loads its index.
+            throws
+                - dlib::error
+                    This exception is thrown if the file can't be opened.
+                - serialization_error
+                    This exception is thrown if the file isn't an image dataset cache, or
+                    if it is truncated or otherwise damaged so that its index can't be
+                    read.
+        !*/
+
+        unsigned long size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of images in the cache.
+        !*/
+
+        bool is_color (
+        ) const;
+        /*!
+            ensures
+                - returns true if the images were stored as rgb_pixel images and false if
+                  they were stored as unsigned char images.
+        !*/
+
+        const image_dataset_metadata::dataset& get_metadata (
+        ) const;
+        /*!
+            ensures
+                - returns the annotations from the XML file the cache was created from.
+                  In particular, get_metadata().images.size() == size() and
+                  get_metadata().images[i] describes the i-th image in the cache.
+        !*/
+
+        const std::string& get_filename (
+        ) const;
+        /*!
+            ensures
+                - returns the name of the cache file this object reads from.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void get_image (
+            unsigned long idx,
+            image_type& img
+        ) const;
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h
+                - idx < size()
+            ensures
+                - #img == the idx-th image in the cache.  If img's pixel type is the type
+                  the image was stored as then the pixels are read from disk directly
+                  into img.  Otherwise they are converted with assign_pixel().
+            throws
+                - serialization_error
+                    This exception is thrown if the image can't be read.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<rectangle> >& object_locations,
+        const image_dataset_cache& cache,
+        const image_dataset_file& options
+    );
+    /*!
+        requires
+            - array_type == An array of images.  This is anything with an interface that
+              looks like std::vector<some generic image type> where a "generic image" is
+              anything that implements the generic image interface defined in
+              dlib/image_processing/generic_image.h.
+        ensures
+            - This function has the same behavior as the load_image_dataset() routine
+              that takes an image_dataset_file and rectangles, except that the images
+              and annotations come from cache rather than from an XML file.  That is,
+              box filtering, skip_empty_images(), shrink_big_images(), and
+              load_in_parallel() settings in options are all applied to the contents of
+              cache.  options.get_filename() is not used.
+            - Therefore, if cache was made from the file options.get_filename() then this
+              function outputs the same thing as
+              load_image_dataset(images, object_locations, options), except for any
+              differences in pixel type introduced when the cache was created.
+            - returns the ignored boxes, in the same format as the XML version does.
+    !*/
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<rectangle> >& object_locations,
+        const image_dataset_cache& cache
+    );
+    /*!
+        requires
+            - array_type == An array of images.  This is anything with an interface that
+              looks like std::vector<some generic image type> where a "generic image" is
+              anything that implements the generic image interface defined in
+              dlib/image_processing/generic_image.h.
+        ensures
+            - performs: return load_image_dataset(images, object_locations, cache, image_dataset_file());
+              That is, it loads every image in cache into images, all their non-ignored
+              boxes into object_locations, and returns the ignored boxes.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    void load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<mmod_rect> >& object_locations,
+        const image_dataset_cache& cache,
+        const image_dataset_file& options
+    );
+    /*!
+        requires
+            - array_type == An array of images.  This is anything with an interface that
+              looks like std::vector<some generic image type> where a "generic image" is
+              anything that implements the generic image interface defined in
+              dlib/image_processing/generic_image.h.
+        ensures
+            - This function has the same behavior as the load_image_dataset() routine
+              that takes an image_dataset_file and mmod_rects, except that the images
+              and annotations come from cache rather than from an XML file.  As above,
+              all the settings in options are applied and options.get_filename() is not
+              used.
+    !*/
+
+    template <
+        typename array_type
+        >
+    void load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<mmod_rect> >& object_locations,
+        const image_dataset_cache& cache
+    );
+    /*!
+        requires
+            - array_type == An array of images.  This is anything with an interface that
+              looks like std::vector<some generic image type> where a "generic image" is
+              anything that implements the generic image interface defined in
+              dlib/image_processing/generic_image.h.
+        ensures
+            - performs: load_image_dataset(images, object_locations, cache, image_dataset_file());
+              That is, it loads every image in cache into images and all their boxes into
+              object_locations.  Boxes with the ignore flag set are loaded as ignored
+              mmod_rects.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<full_object_detection> >& object_locations,
+        const image_dataset_cache& cache,
+        const image_dataset_file& options,
+        std::vector<std::string>& parts_list
+    );
+    /*!
+        requires
+            - array_type == An array of images.  This is anything with an interface that
+              looks like std::vector<some generic image type> where a "generic image" is
+              anything that implements the generic image interface defined in
+              dlib/image_processing/generic_image.h.
+        ensures
+            - This function has the same behavior as the load_image_dataset() routine
+              that takes an image_dataset_file, full_object_detections, and a parts_list,
+              except that the images and annotations come from cache rather than from an
+              XML file.  As above, all the settings in options are applied and
+              options.get_filename() is not used.
+            - #parts_list == the names of the object parts, where the i-th part of each
+              full_object_detection in #object_locations is named parts_list[i].
+            - returns the ignored boxes, in the same format as the XML version does.
+    !*/
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<full_object_detection> >& object_locations,
+        const image_dataset_cache& cache,
+        const image_dataset_file& options
+    );
+    /*!
+        ensures
+            - performs: 
+                std::vector<std::string> parts_list;
+                return load_image_dataset(images, object_locations, cache, options, parts_list);
+    !*/
+
+    template <
+        typename array_type
+        >
+    std::vector<std::vector<rectangle> > load_image_dataset (
+        array_type& images,
+        std::vector<std::vector<full_object_detection> >& object_locations,
+        const image_dataset_cache& cache
+    );
+    /*!
+        ensures
+            - performs: return load_image_dataset(images, object_locations, cache, image_dataset_file());
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_IMAGE_DATASET_CACHE_ABSTRACT_Hh_
+
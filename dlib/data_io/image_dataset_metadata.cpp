@@ -7,10 +7,15 @@
 
 #include <fstream>
 #include <sstream>
+#include <locale>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
 #include "../compress_stream.h"
 #include "../base64.h"
-#include "../xml_parser.h"
 #include "../string.h"
+#include "../assert.h"
 
 // ----------------------------------------------------------------------------------------
 
@@ -39,277 +44,779 @@ namespace dlib
                 throw dlib::error("ERROR: Unable to write to image_metadata_stylesheet.xsl.");
         }
 
-        void save_image_dataset_metadata (
-            const dataset& meta,
-            const std::string& filename
-        )
+    // ------------------------------------------------------------------------------------
+
+        dataset_writer::
+        dataset_writer (
+            const std::string& filename_,
+            const std::string& name,
+            const std::string& comment
+        ) : filename(filename_)
         {
             create_image_metadata_stylesheet_file(filename);
 
-            const std::vector<image>& images = meta.images;
-
-            std::ofstream fout(filename.c_str());
+            fout.open(filename.c_str());
             if (!fout)
                 throw dlib::error("ERROR: Unable to open " + filename + " for writing.");
+            // Always write numbers the same way, regardless of the program's locale.
+            fout.imbue(std::locale::classic());
 
             fout << "<?xml version='1.0' encoding='ISO-8859-1'?>\n";
             fout << "<?xml-stylesheet type='text/xsl' href='image_metadata_stylesheet.xsl'?>\n";
             fout << "<dataset>\n";
-            fout << "<name>" << meta.name << "</name>\n";
-            fout << "<comment>" << meta.comment << "</comment>\n";
+            fout << "<name>" << name << "</name>\n";
+            fout << "<comment>" << comment << "</comment>\n";
             fout << "<images>\n";
-            for (unsigned long i = 0; i < images.size(); ++i)
-            {
-                fout << "  <image file='" << images[i].filename << "'>\n";
+        }
+
+        dataset_writer::
+        ~dataset_writer (
+        )
+        {
+            try { close(); } catch (...) {}
+        }
 
-                // save all the boxes
-                for (unsigned long j = 0; j < images[i].boxes.size(); ++j)
+        void dataset_writer::
+        write (
+            const image& img
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(fout.is_open(),
+                "\t void dataset_writer::write()"
+                << "\n\t You can't write to a dataset_writer after it has been closed."
+                << "\n\t this: " << this
+                );
+
+            fout << "  <image file='" << img.filename << "'>\n";
+
+            // save all the boxes
+            for (unsigned long j = 0; j < img.boxes.size(); ++j)
+            {
+                const box& b = img.boxes[j];
+                fout << "    <box top='" << b.rect.top() << "' "
+                             << "left='" << b.rect.left() << "' "
+                            << "width='" << b.rect.width() << "' "
+                           << "height='" << b.rect.height() << "'";
+                if (b.difficult)
+                    fout << " difficult='" << b.difficult << "'";
+                if (b.truncated)
+                    fout << " truncated='" << b.truncated << "'";
+                if (b.occluded)
+                    fout << " occluded='" << b.occluded << "'";
+                if (b.ignore)
+                    fout << " ignore='" << b.ignore << "'";
+                if (b.angle != 0)
+                    fout << " angle='" << b.angle << "'";
+                if (b.pose != 0)
+                    fout << " pose='" << b.pose << "'";
+                if (b.detection_score != 0)
+                    fout << " detection_score='" << b.detection_score << "'";
+
+                if (b.has_label() || b.parts.size() != 0)
                 {
-                    const box& b = images[i].boxes[j];
-                    fout << "    <box top='" << b.rect.top() << "' "
-                                 << "left='" << b.rect.left() << "' "
-                                << "width='" << b.rect.width() << "' "
-                               << "height='" << b.rect.height() << "'";
-                    if (b.difficult)
-                        fout << " difficult='" << b.difficult << "'";
-                    if (b.truncated)
-                        fout << " truncated='" << b.truncated << "'";
-                    if (b.occluded)
-                        fout << " occluded='" << b.occluded << "'";
-                    if (b.ignore)
-                        fout << " ignore='" << b.ignore << "'";
-                    if (b.angle != 0)
-                        fout << " angle='" << b.angle << "'";
-                    if (b.pose != 0)
-                        fout << " pose='" << b.pose << "'";
-                    if (b.detection_score != 0)
-                        fout << " detection_score='" << b.detection_score << "'";
-
-                    if (b.has_label() || b.parts.size() != 0)
-                    {
-                        fout << ">\n";
-
-                        if (b.has_label())
-                            fout << "      <label>" << b.label << "</label>\n";
-                        
-                        // save all the parts
-                        std::map<std::string,point>::const_iterator itr;
-                        for (itr = b.parts.begin(); itr != b.parts.end(); ++itr)
-                        {
-                            fout << "      <part name='"<< itr->first << "' x='"<< itr->second.x() <<"' y='"<< itr->second.y() <<"'/>\n";
-                        }
+                    fout << ">\n";
 
-                        fout << "    </box>\n";
-                    }
-                    else
+                    if (b.has_label())
+                        fout << "      <label>" << b.label << "</label>\n";
+
+                    // save all the parts
+                    std::map<std::string,point>::const_iterator itr;
+                    for (itr = b.parts.begin(); itr != b.parts.end(); ++itr)
                     {
-                        fout << "/>\n";
+                        fout << "      <part name='"<< itr->first << "' x='"<< itr->second.x() <<"' y='"<< itr->second.y() <<"'/>\n";
                     }
+
+                    fout << "    </box>\n";
+                }
+                else
+                {
+                    fout << "/>\n";
                 }
+            }
 
+            fout << "  </image>\n";
 
+            if (!fout)
+                throw dlib::error("ERROR: Unable to write to " + filename + ".");
+        }
 
-                fout << "  </image>\n";
+        void dataset_writer::
+        close (
+        )
+        {
+            if (!fout.is_open())
+                return;
 
-                if (!fout)
-                    throw dlib::error("ERROR: Unable to write to " + filename + ".");
-            }
             fout << "</images>\n";
             fout << "</dataset>";
+            fout.close();
+            if (!fout)
+                throw dlib::error("ERROR: Unable to write to " + filename + ".");
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        void save_image_dataset_metadata (
+            const dataset& meta,
+            const std::string& filename
+        )
+        {
+            dataset_writer writer(filename, meta.name, meta.comment);
+            for (unsigned long i = 0; i < meta.images.size(); ++i)
+                writer.write(meta.images[i]);
+            writer.close();
         }
 
     // ------------------------------------------------------------------------------------
     // ------------------------------------------------------------------------------------
     // ------------------------------------------------------------------------------------
 
-        class doc_handler : public document_handler
+        namespace
+        {
+            long parse_long (
+                const std::string& str
+            )
+            {
+                // Same rules as string_cast<long>(), which the old xml_parser based loader
+                // used, but without building a std::istringstream for each number.
+                const bool is_hex = str.size() > 2 && str[0] == '0' && str[1] == 'x';
+                const char* begin = str.c_str() + (is_hex ? 2 : 0);
+                char* end;
+                errno = 0;
+                const long val = std::strtol(begin, &end, is_hex ? 16 : 10);
+                if (end == begin || *end != 0 || errno == ERANGE)
+                    throw string_cast_error(str);
+                return val;
+            }
+
+            // The tags and attributes the reader understands.  Their names are mapped to
+            // these numbers when they are read so the parser doesn't have to do lots of
+            // string comparisons.
+            enum tag_id 
+            { 
+                tag_dataset, tag_name, tag_comment, tag_images, tag_image, tag_box, tag_label,
+                tag_part, tag_other
+            };
+            const char* const tag_names[] = {
+                "dataset", "name", "comment", "images", "image", "box", "label", "part"
+            };
+
+            enum attribute_id
+            {
+                att_top, att_left, att_width, att_height, att_difficult, att_truncated,
+                att_occluded, att_ignore, att_angle, att_pose, att_detection_score, att_x,
+                att_y, att_name, att_file, att_other
+            };
+            const char* const attribute_names[] = {
+                "top", "left", "width", "height", "difficult", "truncated", "occluded",
+                "ignore", "angle", "pose", "detection_score", "x", "y", "name", "file"
+            };
+
+            int find_known_name (
+                const std::string& str,
+                const char* const* names,
+                int num_names
+            )
+            /*!
+                requires
+                    - str.size() != 0
+                ensures
+                    - returns the index of str in names or num_names if it isn't there.
+            !*/
+            {
+                // This is called for every tag and attribute so it's written out by hand
+                // rather than using std::string::compare(), which is a lot slower for
+                // such short strings.
+                for (int i = 0; i < num_names; ++i)
+                {
+                    const char* name = names[i];
+                    size_t j = 0;
+                    while (j < str.size() && str[j] == name[j])
+                        ++j;
+                    if (j == str.size() && name[j] == 0)
+                        return i;
+                }
+                return num_names;
+            }
+        }
+
+        struct dataset_reader::parser_state
         {
-            std::vector<std::string> ts;
+            /*!
+                This is a small XML parser that only does what's needed to read the files
+                written by dataset_writer.  It reads the file in large blocks and all the
+                strings it uses are kept around between tags, so once they have grown to
+                the right size reading an image doesn't allocate any memory other than
+                what ends up in the image itself.
+            !*/
+
+            parser_state (
+            ) : buf(1<<16), pos(0), end(0), line(1), depth(0), seen_root(false), done(false) 
+            {
+                // strtod() and string_cast() follow the program's locale, so they would
+                // misread "0.5" if the program had switched to a locale that uses ',' as
+                // the decimal point.  The files are always written in the classic locale,
+                // so read them that way.
+                number_in.imbue(std::locale::classic());
+            }
+
+            std::ifstream fin;
+            std::vector<char> buf;
+            size_t pos, end;
+            unsigned long line;
+
+            // tags[0] through tags[depth-1] are the currently open elements and
+            // tag_ids[i] is the tag_id of tags[i].
+            std::vector<std::string> tags;
+            std::vector<int> tag_ids;
+            size_t depth;
+            std::string tag, attribute, text;
+
+            // The values of the known attributes of the current tag.  has_att[i] tells if
+            // the i-th attribute_id was present.  Unknown attributes are all read into
+            // att_values[att_other].
+            std::string att_values[att_other+1];
+            bool has_att[att_other+1];
+
             image temp_image;
             box temp_box;
+            bool seen_root;
+            bool done;
+
+            std::string name;
+            std::string comment;
+
+            // parse_double() reads through this one stream so it doesn't have to build
+            // and imbue a new stream for every number.
+            std::istringstream number_in;
+
+            double parse_double (
+                const std::string& str
+            )
+            {
+                number_in.clear();
+                number_in.str(str);
+                double val;
+                number_in >> val;
+                if (!number_in || number_in.get() != EOF)
+                    throw string_cast_error(str);
+                return val;
+            }
+
+            bool fill (
+            )
+            {
+                fin.read(&buf[0], buf.size());
+                end = fin.gcount();
+                pos = 0;
+                return end != 0;
+            }
 
-            dataset& meta;
+            int peek (
+            )
+            {
+                if (pos == end && !fill())
+                    return EOF;
+                return static_cast<unsigned char>(buf[pos]);
+            }
+
+            int get (
+            )
+            {
+                const int c = peek();
+                if (c != EOF)
+                {
+                    ++pos;
+                    if (c == '\n')
+                        ++line;
+                }
+                return c;
+            }
+
+            void fatal_error (
+            ) const
+            {
+                std::ostringstream sout;
+                sout << "There is a fatal error on line " << line << " so parsing will now halt.";
+                throw dlib::error(sout.str());
+            }
+
+            void expect (
+                int ch
+            )
+            {
+                if (get() != ch)
+                    fatal_error();
+            }
+
+            static bool is_space (int c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+            static bool is_name_char (
+                char c
+            )
+            {
+                switch (c)
+                {
+                    case ' ': case '\t': case '\n': case '\r': 
+                    case '<': case '>': case '/': case '=': case '\'': case '"':
+                        return false;
+                    default:
+                        return true;
+                }
+            }
+
+            void skip_whitespace (
+            )
+            {
+                while (is_space(peek()))
+                    get();
+            }
+
+            void read_name (
+                std::string& str
+            )
+            {
+                str.clear();
+                while (true)
+                {
+                    if (pos == end && !fill())
+                        break;
+                    const size_t start = pos;
+                    while (pos < end && is_name_char(buf[pos]))
+                        ++pos;
+                    str.append(&buf[start], pos-start);
+                    if (pos < end)
+                        break;
+                }
+                if (str.size() == 0)
+                    fatal_error();
+            }
 
-        public:
+            void read_entity (
+                std::string& str
+            )
+            /*!
+                ensures
+                    - reads the entity following a '&' and appends the character it
+                      stands for to str.
+            !*/
+            {
+                char ent[12];
+                int n = 0;
+                int c;
+                while ((c = get()) != ';')
+                {
+                    if (c == EOF || n == 10)
+                        fatal_error();
+                    ent[n++] = static_cast<char>(c);
+                }
+                ent[n] = 0;
+
+                if      (std::strcmp(ent, "lt") == 0)   str += '<';
+                else if (std::strcmp(ent, "gt") == 0)   str += '>';
+                else if (std::strcmp(ent, "amp") == 0)  str += '&';
+                else if (std::strcmp(ent, "quot") == 0) str += '"';
+                else if (std::strcmp(ent, "apos") == 0) str += '\'';
+                else if (ent[0] == '#')
+                {
+                    // The files are ISO-8859-1 so only character codes < 256 can be
+                    // represented.
+                    const bool is_hex = ent[1] == 'x';
+                    const char* begin = ent + (is_hex ? 2 : 1);
+                    char* last;
+                    const unsigned long val = std::strtoul(begin, &last, is_hex ? 16 : 10);
+                    if (last == begin || *last != 0 || val > 255)
+                        fatal_error();
+                    str += static_cast<char>(val);
+                }
+                else
+                {
+                    fatal_error();
+                }
+            }
 
-            doc_handler(
-                dataset& metadata_
-            ):
-                meta(metadata_) 
-            {}
+            void read_text (
+                std::string& str,
+                int terminator
+            )
+            /*!
+                ensures
+                    - reads characters, decoding entities, until terminator or the end of
+                      the file is found.  The terminator is not consumed.
+            !*/
+            {
+                str.clear();
+                while (true)
+                {
+                    if (pos == end && !fill())
+                        return;
+                    const size_t start = pos;
+                    while (pos < end && buf[pos] != terminator && buf[pos] != '&' && buf[pos] != '<')
+                    {
+                        if (buf[pos] == '\n')
+                            ++line;
+                        ++pos;
+                    }
+                    str.append(&buf[start], pos-start);
+                    if (pos < end)
+                    {
+                        if (buf[pos] != '&')
+                            return;
+                        ++pos;
+                        read_entity(str);
+                    }
+                }
+            }
 
+            void skip_past (
+                const char* terminator,
+                std::string* data = 0
+            )
+            /*!
+                requires
+                    - strlen(terminator) <= 3
+                ensures
+                    - consumes everything up to and including the next occurrence of
+                      terminator.  If data != 0 then the consumed characters, minus the
+                      terminator, are stored into *data.
+            !*/
+            {
+                const size_t n = std::strlen(terminator);
+                char window[3] = {0,0,0};
+                if (data)
+                    data->clear();
+                while (true)
+                {
+                    const int c = get();
+                    if (c == EOF)
+                        fatal_error();
+                    window[0] = window[1];
+                    window[1] = window[2];
+                    window[2] = static_cast<char>(c);
+                    if (data)
+                        *data += static_cast<char>(c);
+                    if (std::memcmp(window+3-n, terminator, n) == 0)
+                        break;
+                }
+                if (data)
+                    data->resize(data->size()-n);
+            }
 
-            virtual void start_document (
+            void skip_markup (
             )
+            /*!
+                ensures
+                    - skips a comment, CDATA section, or DOCTYPE declaration.  The contents
+                      of a CDATA section are handled as character data.
+            !*/
+            {
+                expect('!');
+                if (peek() == '-')
+                {
+                    get();
+                    expect('-');
+                    skip_past("-->");
+                }
+                else if (peek() == '[')
+                {
+                    const char* cdata = "[CDATA[";
+                    for (int i = 0; cdata[i]; ++i)
+                        expect(cdata[i]);
+                    skip_past("]]>", &text);
+                    characters();
+                }
+                else
+                {
+                    int nesting = 0;
+                    while (true)
+                    {
+                        const int c = get();
+                        if (c == EOF)
+                            fatal_error();
+                        else if (c == '[')
+                            ++nesting;
+                        else if (c == ']')
+                            --nesting;
+                        else if (c == '>' && nesting == 0)
+                            break;
+                    }
+                }
+            }
+
+            const std::string* find_attribute (
+                attribute_id id
+            ) const
             {
-                meta = dataset();
-                ts.clear();
-                temp_image = image();
-                temp_box = box();
+                if (has_att[id])
+                    return &att_values[id];
+                return 0;
             }
 
-            virtual void end_document (
+            void characters (
             )
             {
+                if (text.size() == 0)
+                    return;
+
+                if (depth == 2 && tag_ids[1] == tag_name)
+                {
+                    name = trim(text);
+                }
+                else if (depth == 2 && tag_ids[1] == tag_comment)
+                {
+                    comment = trim(text);
+                }
+                else if (depth >= 2 && tag_ids[depth-1] == tag_label && 
+                                       tag_ids[depth-2] == tag_box)
+                {
+                    temp_box.label = trim(text);
+                }
             }
 
-            virtual void start_element ( 
-                const unsigned long line_number,
-                const std::string& name,
-                const dlib::attribute_list& atts
+            bool start_element (
             )
+            /*!
+                ensures
+                    - parses a start tag whose '<' has already been consumed.
+                    - returns true if it was a self closing <image> tag that completed
+                      temp_image.
+            !*/
             {
+                const unsigned long line_number = line;
+                read_name(tag);
+                const int id = find_known_name(tag, tag_names, tag_other);
+
+                // read all the attributes
+                std::fill(has_att, has_att+att_other+1, false);
+                bool self_closing = false;
+                while (true)
+                {
+                    skip_whitespace();
+                    const int c = peek();
+                    if (c == '>')
+                    {
+                        get();
+                        break;
+                    }
+                    else if (c == '/')
+                    {
+                        get();
+                        expect('>');
+                        self_closing = true;
+                        break;
+                    }
+
+                    read_name(attribute);
+                    const int att = find_known_name(attribute, attribute_names, att_other);
+                    skip_whitespace();
+                    expect('=');
+                    skip_whitespace();
+                    const int quote = get();
+                    if (quote != '\'' && quote != '"')
+                        fatal_error();
+                    read_text(att_values[att], quote);
+                    expect(quote);
+                    has_att[att] = true;
+                }
+
+                if (depth == 0 && seen_root)
+                    fatal_error();
+
                 try
                 {
-                    if (ts.size() == 0) 
+                    if (depth == 0) 
                     {
-                        if (name != "dataset")
+                        if (id != tag_dataset)
                         {
                             std::ostringstream sout;
-                            sout << "Invalid XML document.  Root tag must be <dataset>.  Found <" << name << "> instead.";
+                            sout << "Invalid XML document.  Root tag must be <dataset>.  Found <" << tag << "> instead.";
                             throw dlib::error(sout.str());
                         }
-                        else
-                        {
-                            ts.push_back(name);
-                            return;
-                        }
+                        seen_root = true;
                     }
-
-
-                    if (name == "box")
+                    else if (id == tag_box)
                     {
-                        if (atts.is_in_list("top")) temp_box.rect.top() = sa = atts["top"];
+                        const std::string* val;
+                        temp_box = box();
+
+                        if ((val = find_attribute(att_top))) temp_box.rect.top() = parse_long(*val);
                         else throw dlib::error("<box> missing required attribute 'top'");
 
-                        if (atts.is_in_list("left")) temp_box.rect.left() = sa = atts["left"];
+                        if ((val = find_attribute(att_left))) temp_box.rect.left() = parse_long(*val);
                         else throw dlib::error("<box> missing required attribute 'left'");
 
-                        if (atts.is_in_list("width")) temp_box.rect.right() = sa = atts["width"];
+                        if ((val = find_attribute(att_width))) temp_box.rect.right() = parse_long(*val);
                         else throw dlib::error("<box> missing required attribute 'width'");
 
-                        if (atts.is_in_list("height")) temp_box.rect.bottom() = sa = atts["height"];
+                        if ((val = find_attribute(att_height))) temp_box.rect.bottom() = parse_long(*val);
                         else throw dlib::error("<box> missing required attribute 'height'");
 
-                        if (atts.is_in_list("difficult")) temp_box.difficult = sa = atts["difficult"];
-                        if (atts.is_in_list("truncated")) temp_box.truncated = sa = atts["truncated"];
-                        if (atts.is_in_list("occluded"))  temp_box.occluded  = sa = atts["occluded"];
-                        if (atts.is_in_list("ignore"))  temp_box.ignore  = sa = atts["ignore"];
-                        if (atts.is_in_list("angle"))  temp_box.angle  = sa = atts["angle"];
-                        if (atts.is_in_list("pose"))  temp_box.pose  = sa = atts["pose"];
-                        if (atts.is_in_list("detection_score"))  temp_box.detection_score  = sa = atts["detection_score"];
+                        if ((val = find_attribute(att_difficult))) temp_box.difficult = string_cast<bool>(*val);
+                        if ((val = find_attribute(att_truncated))) temp_box.truncated = string_cast<bool>(*val);
+                        if ((val = find_attribute(att_occluded)))  temp_box.occluded  = string_cast<bool>(*val);
+                        if ((val = find_attribute(att_ignore)))    temp_box.ignore    = string_cast<bool>(*val);
+                        if ((val = find_attribute(att_angle)))     temp_box.angle     = parse_double(*val);
+                        if ((val = find_attribute(att_pose)))      temp_box.pose      = parse_double(*val);
+                        if ((val = find_attribute(att_detection_score))) temp_box.detection_score = parse_double(*val);
 
                         temp_box.rect.bottom() += temp_box.rect.top()-1;
                         temp_box.rect.right() += temp_box.rect.left()-1;
                     }
-                    else if (name == "part" && ts.back() == "box")
+                    else if (id == tag_part && tag_ids[depth-1] == tag_box)
                     {
+                        const std::string* val;
                         point temp;
-                        if (atts.is_in_list("x")) temp.x() = sa = atts["x"];
+                        if ((val = find_attribute(att_x))) temp.x() = parse_long(*val);
                         else throw dlib::error("<part> missing required attribute 'x'");
 
-                        if (atts.is_in_list("y")) temp.y() = sa = atts["y"];
+                        if ((val = find_attribute(att_y))) temp.y() = parse_long(*val);
                         else throw dlib::error("<part> missing required attribute 'y'");
 
-                        if (atts.is_in_list("name")) 
+                        if ((val = find_attribute(att_name))) 
                         {
-                            if (temp_box.parts.count(atts["name"])==0)
-                            {
-                                temp_box.parts[atts["name"]] = temp;
-                            }
-                            else
-                            {
-                                throw dlib::error("<part> with name '" + atts["name"] + "' is defined more than one time in a single box.");
-                            }
+                            // The parts are saved in sorted order so hinting that each
+                            // one goes at the end makes the insertion O(1).
+                            const size_t num_parts = temp_box.parts.size();
+                            temp_box.parts.emplace_hint(temp_box.parts.end(), *val, temp);
+                            if (temp_box.parts.size() == num_parts)
+                                throw dlib::error("<part> with name '" + *val + "' is defined more than one time in a single box.");
                         }
                         else 
                         {
                             throw dlib::error("<part> missing required attribute 'name'");
                         }
                     }
-                    else if (name == "image")
+                    else if (id == tag_image)
                     {
                         temp_image.boxes.clear();
 
-                        if (atts.is_in_list("file")) temp_image.filename = atts["file"];
+                        const std::string* val;
+                        if ((val = find_attribute(att_file))) temp_image.filename = *val;
                         else throw dlib::error("<image> missing required attribute 'file'");
                     }
-
-                    ts.push_back(name);
                 }
                 catch (error& e)
                 {
                     throw dlib::error("Error on line " + cast_to_string(line_number) + ": " + e.what());
                 }
+
+                if (depth == tags.size())
+                {
+                    tags.resize(depth+1);
+                    tag_ids.resize(depth+1);
+                }
+                tags[depth] = tag;
+                tag_ids[depth] = id;
+                ++depth;
+
+                if (self_closing)
+                    return end_element();
+                return false;
             }
 
-            virtual void end_element ( 
-                const unsigned long ,
-                const std::string& name
+            bool end_element (
             )
+            /*!
+                requires
+                    - tag == the name of the element being closed.
+                ensures
+                    - returns true if this completed an image.
+            !*/
             {
-                ts.pop_back();
-                if (ts.size() == 0)
-                    return;
-
-                if (name == "box" && ts.back() == "image")
+                if (depth == 0 || tags[depth-1] != tag)
+                    fatal_error();
+                --depth;
+                if (depth == 0)
+                    return false;
+
+                const int id = tag_ids[depth];
+                if (id == tag_box && tag_ids[depth-1] == tag_image)
                 {
-                    temp_image.boxes.push_back(temp_box);
+                    temp_image.boxes.push_back(std::move(temp_box));
                     temp_box = box();
                 }
-                else if (name == "image" && ts.back() == "images")
+                else if (id == tag_image && tag_ids[depth-1] == tag_images)
                 {
-                    meta.images.push_back(temp_image);
-                    temp_image = image();
+                    return true;
                 }
+                return false;
             }
+        };
 
-            virtual void characters ( 
-                const std::string& data
-            )
+    // ------------------------------------------------------------------------------------
+
+        dataset_reader::
+        dataset_reader (
+            const std::string& filename
+        ) : state(new parser_state)
+        {
+            state->fin.open(filename.c_str(), std::ios::binary);
+            if (!state->fin)
+                throw dlib::error("ERROR: unable to open " + filename + " for reading.");
+        }
+
+        dataset_reader::
+        ~dataset_reader (
+        )
+        {
+        }
+
+        bool dataset_reader::
+        read (
+            image& img
+        )
+        {
+            parser_state& s = *state;
+            while (!s.done)
             {
-                if (ts.size() == 2 && ts[1] == "name")
+                s.read_text(s.text, '<');
+                s.characters();
+
+                if (s.peek() == EOF)
                 {
-                    meta.name = trim(data);
+                    if (s.depth != 0 || !s.seen_root)
+                        s.fatal_error();
+                    s.done = true;
+                    break;
                 }
-                else if (ts.size() == 2 && ts[1] == "comment")
+
+                s.expect('<');
+                bool got_image = false;
+                switch (s.peek())
                 {
-                    meta.comment = trim(data);
+                    case '?': s.skip_past("?>"); break;
+                    case '!': s.skip_markup(); break;
+                    case '/': 
+                        s.get();
+                        s.read_name(s.tag);
+                        s.skip_whitespace();
+                        s.expect('>');
+                        got_image = s.end_element();
+                        break;
+                    default:
+                        got_image = s.start_element();
                 }
-                else if (ts.size() >= 2 && ts[ts.size()-1] == "label" && 
-                                           ts[ts.size()-2] == "box")
+
+                if (got_image)
                 {
-                    temp_box.label = trim(data);
+                    // Swap rather than copy so the memory in img gets recycled for the
+                    // next image.
+                    img.filename.swap(s.temp_image.filename);
+                    img.boxes.swap(s.temp_image.boxes);
+                    return true;
                 }
             }
+            return false;
+        }
 
-            virtual void processing_instruction (
-                const unsigned long ,
-                const std::string& ,
-                const std::string& 
-            )
-            {
-            }
-        };
-
-    // ----------------------------------------------------------------------------------------
-
-        class xml_error_handler : public error_handler
-        {
-        public:
-            virtual void error (
-                const unsigned long 
-            ) { }
+        const std::string& dataset_reader::
+        get_name (
+        ) const { return state->name; }
 
-            virtual void fatal_error (
-                const unsigned long line_number
-            )
-            {
-                std::ostringstream sout;
-                sout << "There is a fatal error on line " << line_number << " so parsing will now halt.";
-                throw dlib::error(sout.str());
-            }
-        };
+        const std::string& dataset_reader::
+        get_comment (
+        ) const { return state->comment; }
 
     // ------------------------------------------------------------------------------------
 
@@ -318,17 +825,15 @@ namespace dlib
             const std::string& filename
         )
         {
-            xml_error_handler eh;
-            doc_handler dh(meta);
+            dataset_reader reader(filename);
+            meta = dataset();
 
-            std::ifstream fin(filename.c_str());
-            if (!fin)
-                throw dlib::error("ERROR: unable to open " + filename + " for reading.");
+            image img;
+            while (reader.read(img))
+                meta.images.push_back(std::move(img));
 
-            xml_parser parser;
-            parser.add_document_handler(dh);
-            parser.add_error_handler(eh);
-            parser.parse(fin);
+            meta.name = reader.get_name();
+            meta.comment = reader.get_comment();
         }
 
     // ------------------------------------------------------------------------------------
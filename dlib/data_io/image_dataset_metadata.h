@@ -5,7 +5,10 @@
 
 #include <string>
 #include <vector>
+#include <fstream>
+#include <memory>
 #include "../geometry.h"
+#include "../noncopyable.h"
 
 // ----------------------------------------------------------------------------------------
 
@@ -143,6 +146,141 @@ namespace dlib
                   this function from succeeding.
         !*/
 
+    // ------------------------------------------------------------------------------------
+
+        class dataset_reader : noncopyable
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object reads the images in an XML file produced by
+                    save_image_dataset_metadata() one at a time.  So you can process a
+                    dataset without ever holding all of it in memory.  It also only
+                    understands the XML written by save_image_dataset_metadata() and is
+                    therefore much faster than parsing the file with dlib::xml_parser.
+                    Unknown tags and attributes are ignored.
+            !*/
+
+        public:
+
+            dataset_reader (
+                const std::string& filename
+            );
+            /*!
+                ensures
+                    - Opens the given XML file for reading.
+                throws
+                    - dlib::error
+                      This exception is thrown if the file can't be opened.
+            !*/
+
+            ~dataset_reader (
+            );
+
+            bool read (
+                image& img
+            );
+            /*!
+                ensures
+                    - If there is another image in the file then this function reads it
+                      into #img and returns true.  The memory already held by img is
+                      reused where possible.
+                    - Otherwise, the whole file has been read and this function returns
+                      false.
+                throws
+                    - dlib::error
+                      This exception is thrown if the file isn't a valid dataset file.
+                      The error message contains the offending line number.
+            !*/
+
+            const std::string& get_name (
+            ) const;
+            /*!
+                ensures
+                    - returns the contents of the dataset's <name> tag.  Files written
+                      by save_image_dataset_metadata() put the name before the images so
+                      it is available as soon as the first call to read() has returned.
+            !*/
+
+            const std::string& get_comment (
+            ) const;
+            /*!
+                ensures
+                    - returns the contents of the dataset's <comment> tag.  Like
+                      get_name(), it is available after the first call to read().
+            !*/
+
+        private:
+            struct parser_state;
+            std::unique_ptr<parser_state> state;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        class dataset_writer : noncopyable
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object writes an XML dataset file one image at a time.  The file
+                    it produces is exactly what save_image_dataset_metadata() would write
+                    for a dataset containing the same images, but the images don't need
+                    to be held in memory all at once.
+            !*/
+
+        public:
+
+            dataset_writer (
+                const std::string& filename,
+                const std::string& name = "",
+                const std::string& comment = ""
+            );
+            /*!
+                ensures
+                    - Creates the given file and writes the XML header along with the
+                      dataset name and comment to it.  Like save_image_dataset_metadata(),
+                      this also writes image_metadata_stylesheet.xsl into the folder
+                      containing filename.
+                throws
+                    - dlib::error
+                      This exception is thrown if the file can't be created.
+            !*/
+
+            ~dataset_writer (
+            );
+            /*!
+                ensures
+                    - calls close().  Any error is ignored, so call close() yourself if
+                      you want to know that the file was written successfully.
+            !*/
+
+            void write (
+                const image& img
+            );
+            /*!
+                requires
+                    - close() has not been called.
+                ensures
+                    - Appends img to the file.
+                throws
+                    - dlib::error
+                      This exception is thrown if the file can't be written.
+            !*/
+
+            void close (
+            );
+            /*!
+                ensures
+                    - Finishes the XML document and closes the file.  Calling close()
+                      more than once has no effect.
+                throws
+                    - dlib::error
+                      This exception is thrown if the file can't be written.
+            !*/
+
+        private:
+            std::string filename;
+            std::ofstream fout;
+        };
+
     // ------------------------------------------------------------------------------------
 
     }
@@ -17,6 +17,7 @@
 #include <utility>
 #include <limits>
 #include "../image_transforms/image_pyramid.h"
+#include "../threads/parallel_for_extension.h"
 
 #include <cv.h>
 #include <iostream>
@@ -36,8 +37,12 @@ namespace dlib
             _have_parts = false;
             _filename = filename;
             _box_area_thresh = std::numeric_limits<double>::infinity();
+            _num_threads = 1;
         }
 
+        image_dataset_file(
+        ) : image_dataset_file(std::string()) {}
+
         image_dataset_file boxes_match_label(
             const std::string& label
         ) const
@@ -72,6 +77,15 @@ namespace dlib
             return temp;
         }
 
+        image_dataset_file load_in_parallel(
+            unsigned long num_threads
+        ) const
+        {
+            image_dataset_file temp(*this);
+            temp._num_threads = num_threads;
+            return temp;
+        }
+
         bool should_load_box (
             const image_dataset_metadata::box& box
         ) const
@@ -89,6 +103,7 @@ namespace dlib
         bool should_skip_empty_images() const { return _skip_empty_images; }
         bool should_boxes_have_parts() const { return _have_parts; }
         double box_area_thresh() const { return _box_area_thresh; }
+        unsigned long get_num_threads() const { return _num_threads; }
         const std::set<std::string>& get_selected_box_labels() const { return _labels; }
 
     private:
@@ -97,9 +112,294 @@ namespace dlib
         bool _skip_empty_images;
         bool _have_parts;
         double _box_area_thresh;
+        unsigned long _num_threads;
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename T>
+        void for_each_dataset_image (
+            unsigned long num_threads,
+            unsigned long num_images,
+            const T& funct
+        )
+        /*!
+            ensures
+                - calls funct(k) for all k in the range [0, num_images), using num_threads
+                  threads.  The calls for different k must not touch the same objects.
+        !*/
+        {
+            if (num_threads <= 1)
+            {
+                for (unsigned long k = 0; k < num_images; ++k)
+                    funct(k);
+            }
+            else
+            {
+                // Images take very different amounts of time to decode, so use small
+                // blocks to keep the threads evenly loaded.
+                parallel_for(num_threads, 0, num_images, funct, 32);
+            }
+        }
+
+        template <typename T>
+        void add_ignored_box (
+            const rectangle& rect,
+            std::vector<T>& ,
+            std::vector<rectangle>& ignored
+        ) { ignored.push_back(rect); }
+
+        inline void add_ignored_box (
+            const rectangle& rect,
+            std::vector<mmod_rect>& objects,
+            std::vector<rectangle>& 
+        ) { objects.push_back(ignored_mmod_rect(rect)); }
+
+        template <typename pyramid_type>
+        void pyramid_down_object (
+            const pyramid_type& pyr,
+            rectangle& obj
+        ) { obj = pyr.rect_down(obj); }
+
+        template <typename pyramid_type>
+        void pyramid_down_object (
+            const pyramid_type& pyr,
+            mmod_rect& obj
+        ) { obj.rect = pyr.rect_down(obj.rect); }
+
+        template <typename pyramid_type>
+        void pyramid_down_object (
+            const pyramid_type& pyr,
+            full_object_detection& obj
+        )
+        {
+            obj.get_rect() = pyr.rect_down(obj.get_rect());
+            for (unsigned long k = 0; k < obj.num_parts(); ++k)
+                obj.part(k) = pyr.point_down(obj.part(k));
+        }
+
+        template <typename image_type, typename T>
+        void shrink_dataset_image (
+            image_type& img,
+            std::vector<T>& objects,
+            std::vector<rectangle>& ignored,
+            double min_rect_size,
+            double box_area_thresh
+        )
+        /*!
+            ensures
+                - Downsamples img for as long as the smallest non-ignored box, whose area
+                  is min_rect_size, stays bigger than box_area_thresh.  objects and
+                  ignored are mapped into the downsampled image.
+        !*/
+        {
+            // An image with only ignored boxes has nothing to measure the shrinking
+            // against, so leave it alone.
+            if (min_rect_size == std::numeric_limits<double>::infinity())
+                return;
+
+            // if shrinking the image would still result in the smallest box being
+            // bigger than the box area threshold then shrink the image.
+            while(min_rect_size/2/2 > box_area_thresh)
+            {
+                pyramid_down<2> pyr;
+                pyr(img);
+                min_rect_size *= (1.0/2.0)*(1.0/2.0);
+                for (auto&& r : objects)
+                    pyramid_down_object(pyr, r);
+                for (auto&& r : ignored)
+                    r = pyr.rect_down(r);
+            }
+            while(min_rect_size*(2.0/3.0)*(2.0/3.0) > box_area_thresh)
+            {
+                pyramid_down<3> pyr;
+                pyr(img);
+                min_rect_size *= (2.0/3.0)*(2.0/3.0);
+                for (auto&& r : objects)
+                    pyramid_down_object(pyr, r);
+                for (auto&& r : ignored)
+                    r = pyr.rect_down(r);
+            }
+        }
+
+        template <
+            typename array_type,
+            typename T,
+            typename object_maker,
+            typename image_loader
+            >
+        std::vector<std::vector<rectangle> > select_and_load_dataset_images (
+            array_type& images,
+            std::vector<std::vector<T> >& object_locations,
+            const image_dataset_metadata::dataset& data,
+            const image_dataset_file& source,
+            const object_maker& make_object,
+            const image_loader& load_image_number
+        )
+        /*!
+            ensures
+                - This is the part of load_image_dataset() that doesn't depend on where
+                  the images come from.  It selects the images and boxes in data that
+                  source asks for, calls load_image_number(i, img) to load
+                  data.images[i] into img, and shrinks the loaded images as source
+                  says.
+                - make_object(box) converts a non-ignored box into a T.  Ignored boxes
+                  are put in the returned vector, except for mmod_rects, which hold
+                  them in object_locations.
+        !*/
+        {
+            images.clear();
+            object_locations.clear();
+            std::vector<std::vector<rectangle> > ignored_rects;
+
+            // First figure out which images we are going to load and which boxes go with
+            // them.
+            std::vector<unsigned long> image_idx;
+            std::vector<double> min_rect_sizes;
+            std::vector<T> objects;
+            std::vector<rectangle> ignored;
+            for (unsigned long i = 0; i < data.images.size(); ++i)
+            {
+                double min_rect_size = std::numeric_limits<double>::infinity();
+                objects.clear();
+                ignored.clear();
+                for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
+                {
+                    const image_dataset_metadata::box& box = data.images[i].boxes[j];
+                    if (source.should_load_box(box))
+                    {
+                        if (box.ignore)
+                        {
+                            add_ignored_box(box.rect, objects, ignored);
+                        }
+                        else
+                        {
+                            objects.push_back(make_object(box));
+                            min_rect_size = std::min<double>(min_rect_size, box.rect.area());
+                        }
+                    }
+                }
+
+                if (!source.should_skip_empty_images() || objects.size() != 0)
+                {
+                    image_idx.push_back(i);
+                    min_rect_sizes.push_back(min_rect_size);
+                    object_locations.push_back(objects);
+                    ignored_rects.push_back(ignored);
+                }
+            }
+
+            // Now load the images.  This is where nearly all the time goes, so it's split
+            // over source.get_num_threads() threads.  Each image is loaded straight into
+            // its final place in images.
+            images.resize(image_idx.size());
+            for_each_dataset_image(source.get_num_threads(), image_idx.size(), [&](long k)
+                {
+                    load_image_number(image_idx[k], images[k]);
+                    shrink_dataset_image(images[k], object_locations[k], ignored_rects[k],
+                                         min_rect_sizes[k], source.box_area_thresh());
+                });
+
+            return ignored_rects;
+        }
+
+        template <
+            typename array_type,
+            typename image_loader
+            >
+        std::vector<std::vector<rectangle> > load_dataset_images (
+            array_type& images,
+            std::vector<std::vector<rectangle> >& object_locations,
+            const image_dataset_metadata::dataset& data,
+            const image_dataset_file& source,
+            const image_loader& load_image_number
+        )
+        {
+            return select_and_load_dataset_images(images, object_locations, data, source,
+                [](const image_dataset_metadata::box& box) { return box.rect; },
+                load_image_number);
+        }
+
+        template <
+            typename array_type,
+            typename image_loader
+            >
+        void load_dataset_images (
+            array_type& images,
+            std::vector<std::vector<mmod_rect> >& object_locations,
+            const image_dataset_metadata::dataset& data,
+            const image_dataset_file& source,
+            const image_loader& load_image_number
+        )
+        {
+            select_and_load_dataset_images(images, object_locations, data, source,
+                [](const image_dataset_metadata::box& box) { return mmod_rect(box.rect); },
+                load_image_number);
+        }
+
+        template <
+            typename array_type,
+            typename image_loader
+            >
+        std::vector<std::vector<rectangle> > load_dataset_images (
+            array_type& images,
+            std::vector<std::vector<full_object_detection> >& object_locations,
+            const image_dataset_metadata::dataset& data,
+            const image_dataset_file& source,
+            std::vector<std::string>& parts_list,
+            const image_loader& load_image_number
+        )
+        {
+            parts_list.clear();
+            std::set<std::string> all_parts;
+
+            // find out what parts are being used in the dataset.  Store results in all_parts.
+            for (unsigned long i = 0; i < data.images.size(); ++i)
+            {
+                for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
+                {
+                    if (source.should_load_box(data.images[i].boxes[j]))
+                    {
+                        const std::map<std::string,point>& parts = data.images[i].boxes[j].parts;
+                        std::map<std::string,point>::const_iterator itr;
+
+                        for (itr = parts.begin(); itr != parts.end(); ++itr)
+                        {
+                            all_parts.insert(itr->first);
+                        }
+                    }
+                }
+            }
+
+            // make a mapping between part names and the integers [0, all_parts.size())
+            std::map<std::string,int> parts_idx;
+            for (std::set<std::string>::iterator i = all_parts.begin(); i != all_parts.end(); ++i)
+            {
+                parts_idx[*i] = parts_list.size();
+                parts_list.push_back(*i);
+            }
+
+            return select_and_load_dataset_images(images, object_locations, data, source,
+                [&](const image_dataset_metadata::box& box)
+                {
+                    std::vector<point> partlist(parts_idx.size(), OBJECT_PART_NOT_PRESENT);
+
+                    // populate partlist with all the parts present in this box.
+                    std::map<std::string,point>::const_iterator itr;
+                    for (itr = box.parts.begin(); itr != box.parts.end(); ++itr)
+                    {
+                        partlist[parts_idx[itr->first]] = itr->second;
+                    }
+
+                    return full_object_detection(box.rect, partlist);
+                },
+                load_image_number);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
     template <
             typename image_type
@@ -231,11 +531,6 @@ namespace dlib
         const image_dataset_file& source
     )
     {
-        images.clear();
-        object_locations.clear();
-
-        std::vector<std::vector<rectangle> > ignored_rects;
-
         using namespace dlib::image_dataset_metadata;
         dataset data;
         load_image_dataset_metadata(data, source.get_filename());
@@ -245,68 +540,8 @@ namespace dlib
         // file paths which are relative to this folder.
         locally_change_current_dir chdir(get_parent_directory(file(source.get_filename())));
 
-
-        typedef typename array_type::value_type image_type;
-
-
-        image_type img;
-        std::vector<rectangle> rects, ignored;
-        for (unsigned long i = 0; i < data.images.size(); ++i)
-        {
-            double min_rect_size = std::numeric_limits<double>::infinity();
-            rects.clear();
-            ignored.clear();
-            for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
-            {
-                if (source.should_load_box(data.images[i].boxes[j]))
-                {
-                    if (data.images[i].boxes[j].ignore)
-                    {
-                        ignored.push_back(data.images[i].boxes[j].rect);
-                    }
-                    else
-                    {
-                        rects.push_back(data.images[i].boxes[j].rect);
-                        min_rect_size = std::min<double>(min_rect_size, rects.back().area());
-                    }
-                }
-            }
-
-            if (!source.should_skip_empty_images() || rects.size() != 0)
-            {
-                load_image(img, data.images[i].filename);
-                if (rects.size() != 0)  
-                {
-                    // if shrinking the image would still result in the smallest box being
-                    // bigger than the box area threshold then shrink the image.
-                    while(min_rect_size/2/2 > source.box_area_thresh())
-                    {
-                        pyramid_down<2> pyr;
-                        pyr(img);
-                        min_rect_size *= (1.0/2.0)*(1.0/2.0);
-                        for (auto&& r : rects)
-                            r = pyr.rect_down(r);
-                        for (auto&& r : ignored)
-                            r = pyr.rect_down(r);
-                    }
-                    while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
-                    {
-                        pyramid_down<3> pyr;
-                        pyr(img);
-                        min_rect_size *= (2.0/3.0)*(2.0/3.0);
-                        for (auto&& r : rects)
-                            r = pyr.rect_down(r);
-                        for (auto&& r : ignored)
-                            r = pyr.rect_down(r);
-                    }
-                }
-                images.push_back(img);
-                object_locations.push_back(rects);
-                ignored_rects.push_back(ignored);
-            }
-        }
-
-        return ignored_rects;
+        return impl::load_dataset_images(images, object_locations, data, source,
+            [&](unsigned long i, typename array_type::value_type& img) { load_image(img, data.images[i].filename); });
     }
 
 // ----------------------------------------------------------------------------------------
@@ -320,9 +555,6 @@ namespace dlib
         const image_dataset_file& source
     )
     {
-        images.clear();
-        object_locations.clear();
-
         using namespace dlib::image_dataset_metadata;
         dataset data;
         load_image_dataset_metadata(data, source.get_filename());
@@ -332,59 +564,8 @@ namespace dlib
         // file paths which are relative to this folder.
         locally_change_current_dir chdir(get_parent_directory(file(source.get_filename())));
 
-        typedef typename array_type::value_type image_type;
-
-        image_type img;
-        std::vector<mmod_rect> rects;
-        for (unsigned long i = 0; i < data.images.size(); ++i)
-        {
-            double min_rect_size = std::numeric_limits<double>::infinity();
-            rects.clear();
-            for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
-            {
-                if (source.should_load_box(data.images[i].boxes[j]))
-                {
-                    if (data.images[i].boxes[j].ignore)
-                    {
-                        rects.push_back(ignored_mmod_rect(data.images[i].boxes[j].rect));
-                    }
-                    else
-                    {
-                        rects.push_back(mmod_rect(data.images[i].boxes[j].rect));
-                        min_rect_size = std::min<double>(min_rect_size, rects.back().rect.area());
-                    }
-
-                }
-            }
-
-            if (!source.should_skip_empty_images() || rects.size() != 0)
-            {
-                load_image(img, data.images[i].filename);
-                if (rects.size() != 0)  
-                {
-                    // if shrinking the image would still result in the smallest box being
-                    // bigger than the box area threshold then shrink the image.
-                    while(min_rect_size/2/2 > source.box_area_thresh())
-                    {
-                        pyramid_down<2> pyr;
-                        pyr(img);
-                        min_rect_size *= (1.0/2.0)*(1.0/2.0);
-                        for (auto&& r : rects)
-                            r.rect = pyr.rect_down(r.rect);
-                    }
-                    while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
-                    {
-                        pyramid_down<3> pyr;
-                        pyr(img);
-                        min_rect_size *= (2.0/3.0)*(2.0/3.0);
-                        for (auto&& r : rects)
-                            r.rect = pyr.rect_down(r.rect);
-                    }
-                }
-                images.push_back(std::move(img));
-                object_locations.push_back(std::move(rects));
-            }
-        }
+        impl::load_dataset_images(images, object_locations, data, source,
+            [&](unsigned long i, typename array_type::value_type& img) { load_image(img, data.images[i].filename); });
     }
 
 // ----------------------------------------------------------------------------------------
@@ -467,11 +648,6 @@ namespace dlib
         std::vector<std::string>& parts_list
     )
     {
-        typedef typename array_type::value_type image_type;
-        parts_list.clear();
-        images.clear();
-        object_locations.clear();
-
         using namespace dlib::image_dataset_metadata;
         dataset data;
         load_image_dataset_metadata(data, source.get_filename());
@@ -481,118 +657,8 @@ namespace dlib
         // file paths which are relative to this folder.
         locally_change_current_dir chdir(get_parent_directory(file(source.get_filename())));
 
-
-        std::set<std::string> all_parts;
-
-        // find out what parts are being used in the dataset.  Store results in all_parts.
-        for (unsigned long i = 0; i < data.images.size(); ++i)
-        {
-            for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
-            {
-                if (source.should_load_box(data.images[i].boxes[j]))
-                {
-                    const std::map<std::string,point>& parts = data.images[i].boxes[j].parts;
-                    std::map<std::string,point>::const_iterator itr;
-
-                    for (itr = parts.begin(); itr != parts.end(); ++itr)
-                    {
-                        all_parts.insert(itr->first);
-                    }
-                }
-            }
-        }
-
-        // make a mapping between part names and the integers [0, all_parts.size())
-        std::map<std::string,int> parts_idx;
-        for (std::set<std::string>::iterator i = all_parts.begin(); i != all_parts.end(); ++i)
-        {
-            parts_idx[*i] = parts_list.size();
-            parts_list.push_back(*i);
-        }
-
-        std::vector<std::vector<rectangle> > ignored_rects;
-        std::vector<rectangle> ignored;
-        image_type img;
-        std::vector<full_object_detection> object_dets;
-        for (unsigned long i = 0; i < data.images.size(); ++i)
-        {
-            double min_rect_size = std::numeric_limits<double>::infinity();
-            object_dets.clear();
-            ignored.clear();
-            for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
-            {
-                if (source.should_load_box(data.images[i].boxes[j]))
-                {
-                    if (data.images[i].boxes[j].ignore)
-                    {
-                        ignored.push_back(data.images[i].boxes[j].rect);
-                    }
-                    else
-                    {
-                        std::vector<point> partlist(parts_idx.size(), OBJECT_PART_NOT_PRESENT);
-
-                        // populate partlist with all the parts present in this box.
-                        const std::map<std::string,point>& parts = data.images[i].boxes[j].parts;
-                        std::map<std::string,point>::const_iterator itr;
-                        for (itr = parts.begin(); itr != parts.end(); ++itr)
-                        {
-                            partlist[parts_idx[itr->first]] = itr->second;
-                        }
-
-                        object_dets.push_back(full_object_detection(data.images[i].boxes[j].rect, partlist));
-                        min_rect_size = std::min<double>(min_rect_size, object_dets.back().get_rect().area());
-                    }
-                }
-            }
-
-            if (!source.should_skip_empty_images() || object_dets.size() != 0)
-            {
-                load_image(img, data.images[i].filename);
-                if (object_dets.size() != 0)  
-                {
-                    // if shrinking the image would still result in the smallest box being
-                    // bigger than the box area threshold then shrink the image.
-                    while(min_rect_size/2/2 > source.box_area_thresh())
-                    {
-                        pyramid_down<2> pyr;
-                        pyr(img);
-                        min_rect_size *= (1.0/2.0)*(1.0/2.0);
-                        for (auto&& r : object_dets)
-                        {
-                            r.get_rect() = pyr.rect_down(r.get_rect());
-                            for (unsigned long k = 0; k < r.num_parts(); ++k)
-                                r.part(k) = pyr.point_down(r.part(k));
-                        }
-                        for (auto&& r : ignored)
-                        {
-                            r = pyr.rect_down(r);
-                        }
-                    }
-                    while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
-                    {
-                        pyramid_down<3> pyr;
-                        pyr(img);
-                        min_rect_size *= (2.0/3.0)*(2.0/3.0);
-                        for (auto&& r : object_dets)
-                        {
-                            r.get_rect() = pyr.rect_down(r.get_rect());
-                            for (unsigned long k = 0; k < r.num_parts(); ++k)
-                                r.part(k) = pyr.point_down(r.part(k));
-                        }
-                        for (auto&& r : ignored)
-                        {
-                            r = pyr.rect_down(r);
-                        }
-                    }
-                }
-                images.push_back(img);
-                object_locations.push_back(object_dets);
-                ignored_rects.push_back(ignored);
-            }
-        }
-
-
-        return ignored_rects;
+        return impl::load_dataset_images(images, object_locations, data, source, parts_list,
+            [&](unsigned long i, typename array_type::value_type& img) { load_image(img, data.images[i].filename); });
     }
 
 // ----------------------------------------------------------------------------------------
@@ -37,6 +37,17 @@ namespace dlib
                   possible boxes B we have:
                     - #should_load_box(B) == true
                 - #box_area_thresh() == infinity
+                - #get_num_threads() == 1
+        !*/
+
+        image_dataset_file(
+        );
+        /*!
+            ensures
+                - #get_filename() == ""
+                - All the other options have the same defaults as above.  This constructor
+                  is for use with the load_image_dataset() overloads that read from an
+                  image_dataset_cache, which only need the options and not a file name.
         !*/
 
         const std::string& get_filename(
@@ -136,6 +147,26 @@ namespace dlib
                   load it in its native high resolution.  Setting the box_area_thresh()
                   allows you to control the resolution of the loaded images.
         !*/
+
+        image_dataset_file load_in_parallel(
+            unsigned long num_threads
+        ) const;
+        /*!
+            ensures
+                - returns a copy of *this that is identical in all respects to *this except
+                  that #get_num_threads() == num_threads
+        !*/
+
+        unsigned long get_num_threads(
+        ) const;
+        /*!
+            ensures
+                - returns the number of threads load_image_dataset() uses to load and
+                  shrink the images.  Images are still returned in the order they appear
+                  in the XML file, so the output doesn't depend on get_num_threads().
+                  Since decoding the images is what takes most of the time when loading a
+                  big dataset, using several threads can make loading much faster.
+        !*/
     };
 
 // ----------------------------------------------------------------------------------------
@@ -20,6 +20,7 @@
 #include "dnn/tensor_tools.h"
 #include "dnn/utilities.h"
 #include "dnn/validation.h"
+#include "dnn/detection.h"
 
 #endif // DLIB_DNn_
 
@@ -0,0 +1,333 @@
+// Copyright (C) 2017  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_DNn_DETECTION_H_
+#define DLIB_DNn_DETECTION_H_
+
+#include "detection_abstract.h"
+#include "core.h"
+#include "loss.h"
+#include "input.h"
+#include "utilities.h"
+#include "../geometry.h"
+#include "../image_transforms/image_pyramid.h"
+#include <vector>
+#include <algorithm>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <
+            typename GATE_SUBNET,
+            typename SUBNET,
+            typename forward_iterator
+            >
+        void cascaded_detection (
+            loss_mmod<GATE_SUBNET>& gate,
+            loss_mmod<SUBNET>& net,
+            forward_iterator ibegin,
+            forward_iterator iend,
+            std::vector<std::vector<mmod_rect>>& dets,
+            double gate_threshold,
+            double adjust_threshold,
+            resizable_tensor& temp
+        )
+        {
+            const size_t num = std::distance(ibegin, iend);
+            dets.assign(num, std::vector<mmod_rect>());
+            if (num == 0)
+                return;
+
+            // Run the cheap gating network over all the images.  An image survives the
+            // gate if any location in any pyramid level scores above gate_threshold.
+            gate.to_tensor(ibegin, iend, temp);
+            const tensor& gout = gate.subnet().forward(temp);
+            DLIB_CASSERT(gout.num_samples() == (long long)num);
+            const size_t sample_size = gout.k()*gout.nr()*gout.nc();
+            const float* g = gout.host();
+            std::vector<bool> passed(num);
+            for (size_t i = 0; i < num; ++i)
+            {
+                passed[i] = sample_size != 0 && 
+                    *std::max_element(g + i*sample_size, g + (i+1)*sample_size) > gate_threshold;
+            }
+
+            // Now run the expensive network only on the images that got through the gate.
+            // We do this on maximal runs of consecutive surviving images so that they can
+            // be processed as a batch without needing to copy any of them.
+            size_t i = 0;
+            while (i < num)
+            {
+                if (!passed[i])
+                {
+                    ++i;
+                    continue;
+                }
+                size_t j = i;
+                while (j < num && passed[j])
+                    ++j;
+
+                auto b = ibegin;
+                std::advance(b, i);
+                auto e = b;
+                std::advance(e, j-i);
+                net.to_tensor(b, e, temp);
+                net.subnet().forward(temp);
+                net.loss_details().to_label(temp, net.subnet(), dets.begin()+i, adjust_threshold);
+                i = j;
+            }
+        }
+
+        template <typename input_layer_type>
+        std::vector<rectangle> roi_tensor_regions (
+            const input_layer_type&,
+            const tensor& ,
+            const rectangle& roi
+        )
+        /*!
+            ensures
+                - returns the parts of a tensor made by the input layer's to_tensor() whose
+                  points map into roi in the original image.  There is one element for each
+                  pyramid level.  This generic version is for input layers that don't make
+                  pyramids and whose tensor space is the same as image space.
+        !*/
+        {
+            return std::vector<rectangle>(1, grow_rect(roi,1));
+        }
+
+        template <typename input_layer_type>
+        bool tensor_point_in_level (
+            const input_layer_type&,
+            const tensor& ,
+            size_t ,
+            const point& 
+        )
+        /*!
+            ensures
+                - returns true if the given point in a tensor made by the input layer's
+                  to_tensor() gets mapped back to the image from the given pyramid level.
+        !*/
+        {
+            return true;
+        }
+
+        template <typename pyramid_type>
+        std::vector<rectangle> roi_tensor_regions (
+            const input_rgb_image_pyramid<pyramid_type>&,
+            const tensor& data,
+            const rectangle& roi
+        )
+        {
+            auto&& rects = any_cast<std::vector<rectangle>>(data.annotation());
+            pyramid_type pyr;
+            std::vector<rectangle> regions;
+            for (size_t l = 0; l < rects.size(); ++l)
+            {
+                const rectangle r = pyr.rect_down(drectangle(roi), l);
+                regions.push_back(translate_rect(grow_rect(r,1), rects[l].tl_corner()));
+            }
+            return regions;
+        }
+
+        template <typename pyramid_type>
+        bool tensor_point_in_level (
+            const input_rgb_image_pyramid<pyramid_type>&,
+            const tensor& data,
+            size_t level,
+            const point& p
+        )
+        {
+            // This is the same test tiled_pyramid_to_image() uses to pick a level.
+            auto&& rects = any_cast<std::vector<rectangle>>(data.annotation());
+            return nearest_rect(rects, p) == level;
+        }
+
+        inline void copy_tensor_window (
+            const tensor& data,
+            const rectangle& window,
+            resizable_tensor& out
+        )
+        /*!
+            requires
+                - get_rect(data).contains(window)
+            ensures
+                - #out == the part of data inside window, for all samples and channels.
+        !*/
+        {
+            out.set_size(data.num_samples(), data.k(), window.height(), window.width());
+            const float* in = data.host();
+            float* o = out.host();
+            for (long n = 0; n < data.num_samples(); ++n)
+            {
+                for (long k = 0; k < data.k(); ++k)
+                {
+                    const float* plane = in + (n*data.k()+k)*data.nr()*data.nc();
+                    for (long r = window.top(); r <= window.bottom(); ++r)
+                    {
+                        o = std::copy(plane + r*data.nc() + window.left(),
+                                      plane + r*data.nc() + window.right()+1, o);
+                    }
+                }
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename GATE_SUBNET,
+        typename SUBNET
+        >
+    std::vector<std::vector<mmod_rect>> cascaded_detection (
+        loss_mmod<GATE_SUBNET>& gate,
+        loss_mmod<SUBNET>& net,
+        const std::vector<typename SUBNET::input_type>& images,
+        double gate_threshold = 0,
+        double adjust_threshold = 0,
+        size_t batch_size = 32
+    )
+    {
+        DLIB_CASSERT(batch_size > 0);
+
+        std::vector<std::vector<mmod_rect>> results, dets;
+        results.reserve(images.size());
+        resizable_tensor temp;
+        for (size_t i = 0; i < images.size(); i += batch_size)
+        {
+            const size_t inc = std::min(batch_size, images.size()-i);
+            impl::cascaded_detection(gate, net, images.begin()+i, images.begin()+i+inc,
+                dets, gate_threshold, adjust_threshold, temp);
+            for (auto&& d : dets)
+                results.emplace_back(std::move(d));
+        }
+        return results;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename GATE_SUBNET,
+        typename SUBNET
+        >
+    std::vector<mmod_rect> cascaded_detection (
+        loss_mmod<GATE_SUBNET>& gate,
+        loss_mmod<SUBNET>& net,
+        const typename SUBNET::input_type& image,
+        double gate_threshold = 0,
+        double adjust_threshold = 0
+    )
+    {
+        std::vector<std::vector<mmod_rect>> dets;
+        resizable_tensor temp;
+        impl::cascaded_detection(gate, net, &image, &image+1, dets, gate_threshold,
+            adjust_threshold, temp);
+        return std::move(dets[0]);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename SUBNET
+        >
+    std::vector<mmod_rect> detect_in_rois (
+        loss_mmod<SUBNET>& net,
+        const typename SUBNET::input_type& image,
+        const std::vector<rectangle>& rois,
+        double adjust_threshold = 0
+    )
+    {
+        const mmod_options& options = net.loss_details().get_options();
+
+        // Make the input tensor for the whole image.  For pyramid input layers this is
+        // the tiled image pyramid.  Building it is cheap compared to running the network
+        // on it, and running the network on parts of it gives exactly the outputs we
+        // would get from the whole tensor, as long as each part includes the receptive
+        // field of the outputs we keep and is aligned to the network's stride.  That
+        // includes the coarse pyramid levels, where the needed context in image pixels
+        // is the receptive field scaled up by one over the level's scale.
+        resizable_tensor data;
+        net.to_tensor(&image, &image+1, data);
+        const rectangle data_rect = get_rect(data);
+
+        const point origin = output_tensor_to_input_tensor(net.subnet(), point(0,0));
+        const rectangle rf = output_tensor_receptive_field(net.subnet(), point(0,0));
+        const long pad = std::max(std::max(origin.x()-rf.left(), rf.right()-origin.x()),
+                                  std::max(origin.y()-rf.top(), rf.bottom()-origin.y()));
+        const point stride = output_tensor_to_input_tensor(net.subnet(), point(1,1)) - origin;
+        DLIB_CASSERT(stride.x() > 0 && stride.y() > 0);
+
+        std::vector<mmod_rect> dets;
+        resizable_tensor temp;
+        for (auto&& roi : rois)
+        {
+            if (roi.intersect(get_rect(image)).is_empty())
+                continue;
+
+            const std::vector<rectangle> regions = impl::roi_tensor_regions(input_layer(net), data, roi);
+            for (size_t l = 0; l < regions.size(); ++l)
+            {
+                const rectangle region = regions[l].intersect(data_rect);
+                if (region.is_empty())
+                    continue;
+
+                rectangle window = grow_rect(region, pad).intersect(data_rect);
+                window.left() -= window.left()%stride.x();
+                window.top() -= window.top()%stride.y();
+                impl::copy_tensor_window(data, window, temp);
+                const tensor& out = net.subnet().forward(temp);
+                DLIB_CASSERT(out.k() == 1);
+
+                // This is what loss_mmod_::to_label() does, except that we only look at
+                // the outputs inside region, since the others are missing some of their
+                // context.
+                const float* out_data = out.host();
+                for (long r = 0; r < out.nr(); ++r)
+                {
+                    for (long c = 0; c < out.nc(); ++c)
+                    {
+                        const double score = out_data[r*out.nc() + c];
+                        if (score <= adjust_threshold)
+                            continue;
+                        const point p = output_tensor_to_input_tensor(net.subnet(), point(c,r)) + window.tl_corner();
+                        if (!region.contains(p) || !impl::tensor_point_in_level(input_layer(net), data, l, p))
+                            continue;
+                        drectangle rect = centered_drect(p, options.detector_width, options.detector_height);
+                        const rectangle image_rect = input_layer(net).tensor_space_to_image_space(data, rect);
+                        if (roi.contains(center(image_rect)))
+                            dets.push_back(mmod_rect(image_rect, score));
+                    }
+                }
+            }
+        }
+
+        // Do non-max suppression over the merged detections.  This also removes the
+        // copies of a detection found by several overlapping ROIs.
+        std::sort(dets.begin(), dets.end(), 
+            [](const mmod_rect& a, const mmod_rect& b) { return a.detection_confidence > b.detection_confidence; });
+        std::vector<mmod_rect> final_dets;
+        for (auto&& d : dets)
+        {
+            bool overlaps = false;
+            for (auto&& f : final_dets)
+            {
+                if (f.rect == d.rect || options.overlaps_nms(f.rect, d.rect))
+                {
+                    overlaps = true;
+                    break;
+                }
+            }
+            if (!overlaps)
+                final_dets.push_back(d);
+        }
+        return final_dets;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_DNn_DETECTION_H_
+
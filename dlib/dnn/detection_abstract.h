@@ -0,0 +1,126 @@
+// Copyright (C) 2017  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_DNn_DETECTION_ABSTRACT_H_
+#ifdef DLIB_DNn_DETECTION_ABSTRACT_H_
+
+#include "core_abstract.h"
+#include "loss_abstract.h"
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename GATE_SUBNET,
+        typename SUBNET
+        >
+    std::vector<std::vector<mmod_rect>> cascaded_detection (
+        loss_mmod<GATE_SUBNET>& gate,
+        loss_mmod<SUBNET>& net,
+        const std::vector<typename SUBNET::input_type>& images,
+        double gate_threshold = 0,
+        double adjust_threshold = 0,
+        size_t batch_size = 32
+    );
+    /*!
+        requires
+            - GATE_SUBNET::input_type == SUBNET::input_type
+              (i.e. gate and net must take the same kind of images as input)
+            - batch_size > 0
+        ensures
+            - Runs a two stage detection cascade over the given images.  That is, this
+              function first runs the gate network on each image.  Any image for which no
+              location of gate's output tensor has a score > gate_threshold is considered
+              to contain no objects and net is never run on it.  Only the images that get
+              through the gate are processed by net.  
+            - The intended use is to make gate a very small and fast network, trained with
+              loss_mmod on the same data as net, and then to pick gate_threshold so that
+              gate has essentially 100% recall.  Then, when most images contain no objects
+              (e.g. a surveillance video stream) the average cost of running the detector is
+              close to the cost of running gate rather than net.
+            - returns a vector R such that:
+                - R.size() == images.size()
+                - R[i] contains the detections for images[i].  If images[i] was rejected by
+                  the gate then R[i] is empty.  Otherwise, R[i] contains exactly the
+                  detections net would output for images[i] when run with the given
+                  adjust_threshold (see loss_mmod_::to_label()).
+            - The images are pushed through the networks in mini-batches of at most
+              batch_size images.  Within each mini-batch, consecutive images that pass the
+              gate are given to net together as a batch.
+    !*/
+
+    template <
+        typename GATE_SUBNET,
+        typename SUBNET
+        >
+    std::vector<mmod_rect> cascaded_detection (
+        loss_mmod<GATE_SUBNET>& gate,
+        loss_mmod<SUBNET>& net,
+        const typename SUBNET::input_type& image,
+        double gate_threshold = 0,
+        double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - GATE_SUBNET::input_type == SUBNET::input_type
+        ensures
+            - This function is identical to the above cascaded_detection() routine except
+              that it processes just one image.  Therefore, it returns an empty vector if
+              image doesn't get through the gate and otherwise returns the output of net
+              for image.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename SUBNET
+        >
+    std::vector<mmod_rect> detect_in_rois (
+        loss_mmod<SUBNET>& net,
+        const typename SUBNET::input_type& image,
+        const std::vector<rectangle>& rois,
+        double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - SUBNET::input_type is an image object that implements the interface defined
+              in dlib/image_processing/generic_image.h (e.g. net uses
+              input_rgb_image_pyramid)
+            - All the layers in net must provide map_output_to_input() (i.e. it must be
+              possible to call output_tensor_to_input_tensor() on net.subnet()).
+        ensures
+            - Runs the detector net only on the parts of image given by rois rather than on
+              the whole image.  This is useful when you know in advance that objects can
+              only be in a few small parts of a large image (e.g. the moving parts of a
+              video frame).
+            - This function first makes net's input tensor for the whole image (e.g. the
+              tiled image pyramid for input_rgb_image_pyramid), which is cheap compared to
+              running the network.  Then, for each ROI and each pyramid level, it runs the
+              network only on the part of that tensor the ROI maps to, padded by net's
+              receptive field (see output_tensor_receptive_field()) and aligned to net's
+              stride.  So the network outputs inside the ROIs are exactly the ones net
+              would compute on the whole image, at every pyramid level.  The cost of the
+              network evaluations scales with the area of the ROIs plus this padding,
+              which in image pixels is the receptive field divided by the scale of each
+              level.
+            - returns the detections output by net (using the given adjust_threshold, see
+              loss_mmod_::to_label()) whose centers are inside at least one of the rois.
+              The detections from all the ROIs are merged together and non-max suppression,
+              as defined by net.loss_details().get_options().overlaps_nms, is applied so
+              that overlapping ROIs don't produce duplicate detections.  Therefore, the
+              output is the same as running net on the whole image and keeping the
+              detections centered inside the ROIs, except that detections outside the
+              ROIs can't suppress detections inside them.
+            - The returned detections are sorted in order of decreasing
+              detection_confidence and are in the coordinate system of image.
+            - ROIs that don't overlap image are ignored.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_DNn_DETECTION_ABSTRACT_H_
+
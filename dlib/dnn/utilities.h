@@ -165,6 +165,61 @@ namespace dlib
         return p;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        class visitor_net_receptive_field
+        {
+        public:
+            visitor_net_receptive_field(rectangle& r_) : r(r_) {}
+
+            rectangle& r;
+
+            template<typename layer_type>
+            void operator()(size_t , const layer_type& net) 
+            {
+                map_output_to_input(net, 0);
+            }
+
+        private:
+
+            // Only layers with a spatial filter window (e.g. con_, max_pool_, and
+            // avg_pool_) change the receptive field.  All other layers are ignored.
+            template <typename layer_type>
+            auto map_output_to_input(
+                const layer_type& net,
+                int
+            ) -> decltype(net.layer_details().padding_y(), net.layer_details().stride_y(), void())
+            {
+                auto&& l = net.layer_details();
+                // A filter size of 0 means the layer pools over its entire input, which
+                // doesn't have a finite size we can map to.
+                if (l.nr() == 0 || l.nc() == 0)
+                    return;
+                r = rectangle(r.left()*l.stride_x() - l.padding_x(),
+                              r.top()*l.stride_y() - l.padding_y(),
+                              r.right()*l.stride_x() - l.padding_x() + l.nc()-1,
+                              r.bottom()*l.stride_y() - l.padding_y() + l.nr()-1);
+            }
+
+            template <typename layer_type>
+            void map_output_to_input(const layer_type&, long) {}
+        };
+    }
+
+    template <typename net_type>
+    inline rectangle output_tensor_receptive_field(
+        const net_type& net,
+        point p  
+    )
+    {
+        rectangle r(p,p);
+        impl::visitor_net_receptive_field temp(r);
+        visit_layers_range<0,net_type::num_layers-1>(net, temp);
+        return r;
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -92,6 +92,31 @@ namespace dlib
               in the input tensor?
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename net_type>
+    rectangle output_tensor_receptive_field(
+        const net_type& net,
+        point p  
+    );
+    /*!
+        requires
+            - net_type is an object of type add_layer, add_skip_layer, or add_tag_layer.
+        ensures
+            - Given a point in net.get_output(), this function returns the rectangle in the
+              input tensor containing all the input locations that can influence the value
+              of net's output at p.  That is, it returns the receptive field of the output
+              location p.  Note that the returned rectangle may extend outside the input
+              tensor when the network's layers use zero padding.
+            - The receptive field is computed by looking at every layer whose
+              layer_details() provides nr(), nc(), stride_y(), stride_x(), padding_y(), and
+              padding_x() (e.g. con_, max_pool_, and avg_pool_).  All other layers are
+              assumed to operate on each spatial location independently and therefore
+              don't change the receptive field.
+            - center(output_tensor_receptive_field(net,p)) == output_tensor_to_input_tensor(net,p)
+              (ignoring rounding when a filter has an even size)
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
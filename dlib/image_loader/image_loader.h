@@ -853,6 +853,57 @@ namespace dlib
         load_dng(image, fin);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        class memory_streambuf : public std::streambuf
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is a read only std::streambuf that reads directly out of a block
+                    of memory rather than copying it.  
+            !*/
+        public:
+            memory_streambuf (
+                const unsigned char* buffer,
+                size_t buffer_size
+            )
+            {
+                char* p = const_cast<char*>(reinterpret_cast<const char*>(buffer));
+                setg(p, p, p+buffer_size);
+            }
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename image_type>
+    void load_bmp (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size
+    )
+    {
+        impl::memory_streambuf buf(buffer, buffer_size);
+        std::istream in(&buf);
+        load_bmp(image, in);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename image_type>
+    void load_dng (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size
+    )
+    {
+        impl::memory_streambuf buf(buffer, buffer_size);
+        std::istream in(&buf);
+        load_dng(image, in);
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -70,6 +70,27 @@ namespace dlib
               load_bmp(image,fin);
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_bmp (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - buffer points to an array of at least buffer_size bytes
+        ensures
+            - loads the BMP file contained in buffer[0] through buffer[buffer_size-1].
+              That is, performs load_bmp(image,in) where in is an std::istream that
+              reads directly from buffer, without copying it.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     /*!
@@ -128,6 +149,27 @@ namespace dlib
               load_dng(image,fin);
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_dng (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - buffer points to an array of at least buffer_size bytes
+        ensures
+            - loads the DNG file contained in buffer[0] through buffer[buffer_size-1].
+              That is, performs load_dng(image,in) where in is an std::istream that
+              reads directly from buffer, without copying it.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
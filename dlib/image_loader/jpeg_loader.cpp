@@ -46,6 +46,14 @@ namespace dlib
         read_image( f.full_name().c_str() );
     }
 
+// ----------------------------------------------------------------------------------------
+
+    jpeg_loader::
+    jpeg_loader( const unsigned char* buffer, size_t buffer_size ) : height_( 0 ), width_( 0 ), output_components_(0)
+    {
+        read_image( buffer, buffer_size );
+    }
+
 // ----------------------------------------------------------------------------------------
 
     bool jpeg_loader::is_gray() const
@@ -79,79 +87,242 @@ namespace dlib
 
 // ----------------------------------------------------------------------------------------
 
-    void jpeg_loader::read_image( const char* filename )
+    namespace
     {
-        if ( filename == NULL )
+        // These functions implement a libjpeg data source that reads from a block of
+        // memory.  libjpeg 6b doesn't come with one (jpeg_mem_src() was added in v8).
+        void jpeg_memory_init_source (j_decompress_ptr) {}
+
+        boolean jpeg_memory_fill_input_buffer (j_decompress_ptr cinfo)
         {
-            throw image_load_error("jpeg_loader: invalid filename, it is NULL");
+            // All the data was in the buffer so if libjpeg wants more the data is
+            // truncated.  Do what libjpeg's stdio source does in this case and insert a
+            // fake EOI marker.
+            static const JOCTET fake_eoi[2] = { 0xFF, JPEG_EOI };
+            cinfo->src->next_input_byte = fake_eoi;
+            cinfo->src->bytes_in_buffer = 2;
+            return TRUE;
         }
-        FILE *fp = fopen( filename, "rb" );
-        if ( !fp )
+
+        void jpeg_memory_skip_input_data (j_decompress_ptr cinfo, long num_bytes)
         {
-            throw image_load_error(std::string("jpeg_loader: unable to open file ") + filename);
+            if (num_bytes <= 0)
+                return;
+            if (static_cast<size_t>(num_bytes) > cinfo->src->bytes_in_buffer)
+            {
+                jpeg_memory_fill_input_buffer(cinfo);
+            }
+            else
+            {
+                cinfo->src->next_input_byte += num_bytes;
+                cinfo->src->bytes_in_buffer -= num_bytes;
+            }
         }
 
-        jpeg_decompress_struct cinfo;
-        jpeg_loader_error_mgr jerr;
-
-        cinfo.err = jpeg_std_error(&jerr.pub);
-
-        jerr.pub.error_exit = jpeg_loader_error_exit;
-
-        /* Establish the setjmp return context for my_error_exit to use. */
-        if (setjmp(jerr.setjmp_buffer)) 
+        void jpeg_memory_term_source (j_decompress_ptr) {}
+
+    // ------------------------------------------------------------------------------------
+
+        void decode_jpeg_from_source (
+            FILE* fp,
+            jpeg_source_mgr* src,
+            const std::string& source_name,
+            unsigned long scale_denom,
+            impl::jpeg_row_sink& sink
+        )
+        /*!
+            requires
+                - exactly one of fp and src is non-NULL.  The JPEG data is read from it.
+            ensures
+                - decodes the JPEG data into sink.  source_name is only used in error
+                  messages.
+                - does not close fp.
+        !*/
         {
-            /* If we get here, the JPEG code has signaled an error.
-             * We need to clean up the JPEG object, close the input file, and return.
-             */
+            jpeg_decompress_struct cinfo;
+            jpeg_loader_error_mgr jerr;
+
+            cinfo.err = jpeg_std_error(&jerr.pub);
+
+            jerr.pub.error_exit = jpeg_loader_error_exit;
+
+            /* Establish the setjmp return context for my_error_exit to use. */
+            if (setjmp(jerr.setjmp_buffer)) 
+            {
+                /* If we get here, the JPEG code has signaled an error.
+                 * We need to clean up the JPEG object and return.
+                 */
+                jpeg_destroy_decompress(&cinfo);
+                throw image_load_error("jpeg_loader: error while reading " + source_name);
+            }
+
+
+            jpeg_create_decompress(&cinfo);
+
+            if (fp)
+                jpeg_stdio_src(&cinfo, fp);
+            else
+                cinfo.src = src;
+
+            jpeg_read_header(&cinfo, TRUE);
+
+            // Let libjpeg shrink the image while doing the IDCT.  This skips most of the
+            // decoding work rather than throwing its results away afterwards.
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = scale_denom;
+
+            jpeg_start_decompress(&cinfo);
+
+            const unsigned long output_components = cinfo.output_components;
+            if (output_components != 1 && 
+                output_components != 3)
+            {
+                jpeg_destroy_decompress(&cinfo);
+                std::ostringstream sout;
+                sout << "jpeg_loader: Unsupported number of colors (" << output_components << ") in " << source_name;
+                throw image_load_error(sout.str());
+            }
+
+            try
+            {
+                sink.set_size(cinfo.output_height, cinfo.output_width, output_components);
+
+                // read the data into the sink one row at a time
+                while (cinfo.output_scanline < cinfo.output_height)
+                {
+                    const unsigned long r = cinfo.output_scanline;
+                    JSAMPROW row = sink.get_row(r);
+                    jpeg_read_scanlines(&cinfo, &row, 1);
+                    sink.finish_row(r);
+                }
+            }
+            catch (...)
+            {
+                jpeg_destroy_decompress(&cinfo);
+                throw;
+            }
+
+            jpeg_finish_decompress(&cinfo);
             jpeg_destroy_decompress(&cinfo);
-            fclose(fp);
-            throw image_load_error(std::string("jpeg_loader: error while reading ") + filename);
         }
+    }
 
+// ----------------------------------------------------------------------------------------
 
-        jpeg_create_decompress(&cinfo);
-
-        jpeg_stdio_src(&cinfo, fp);
-
-        jpeg_read_header(&cinfo, TRUE);
-
-        jpeg_start_decompress(&cinfo);
-
-        height_ = cinfo.output_height;
-        width_ = cinfo.output_width;
-        output_components_ = cinfo.output_components;
-
-        if (output_components_ != 1 && 
-            output_components_ != 3)
+    namespace impl
+    {
+        void decode_jpeg (
+            const char* filename,
+            unsigned long scale_denom,
+            jpeg_row_sink& sink
+        )
         {
+            if ( filename == NULL )
+            {
+                throw image_load_error("jpeg_loader: invalid filename, it is NULL");
+            }
+            FILE *fp = fopen( filename, "rb" );
+            if ( !fp )
+            {
+                throw image_load_error(std::string("jpeg_loader: unable to open file ") + filename);
+            }
+
+            try
+            {
+                decode_jpeg_from_source(fp, NULL, std::string("file ") + filename, scale_denom, sink);
+            }
+            catch (...)
+            {
+                fclose( fp );
+                throw;
+            }
             fclose( fp );
-            jpeg_destroy_decompress(&cinfo);
-            std::ostringstream sout;
-            sout << "jpeg_loader: Unsupported number of colors (" << output_components_ << ") in file " << filename;
-            throw image_load_error(sout.str());
         }
 
-        std::vector<unsigned char*> rows;
-        rows.resize(height_);
-
-        // size the image buffer
-        data.resize(height_*width_*output_components_);
+        void decode_jpeg (
+            const unsigned char* buffer,
+            size_t buffer_size,
+            unsigned long scale_denom,
+            jpeg_row_sink& sink
+        )
+        {
+            if ( buffer == NULL && buffer_size != 0 )
+            {
+                throw image_load_error("jpeg_loader: invalid buffer, it is NULL");
+            }
+
+            jpeg_source_mgr src;
+            src.next_input_byte = buffer;
+            src.bytes_in_buffer = buffer_size;
+            src.init_source = jpeg_memory_init_source;
+            src.fill_input_buffer = jpeg_memory_fill_input_buffer;
+            src.skip_input_data = jpeg_memory_skip_input_data;
+            src.resync_to_restart = jpeg_resync_to_restart;
+            src.term_source = jpeg_memory_term_source;
+
+            decode_jpeg_from_source(NULL, &src, "memory buffer", scale_denom, sink);
+        }
+    }
 
-        // setup pointers to each row
-        for (unsigned long i = 0; i < rows.size(); ++i)
-            rows[i] = &data[i*width_*output_components_];
+// ----------------------------------------------------------------------------------------
 
-        // read the data into the buffer
-        while (cinfo.output_scanline < cinfo.output_height)
+    namespace
+    {
+        class jpeg_buffer_sink : public impl::jpeg_row_sink
         {
-            jpeg_read_scanlines(&cinfo, &rows[cinfo.output_scanline], 100);
-        }
+        public:
+            jpeg_buffer_sink (
+                unsigned long& height_,
+                unsigned long& width_,
+                unsigned long& output_components_,
+                std::vector<unsigned char>& data_
+            ) : height(height_), width(width_), output_components(output_components_), data(data_) {}
+
+            virtual void set_size (
+                unsigned long nr,
+                unsigned long nc,
+                unsigned long num_components
+            )
+            {
+                height = nr;
+                width = nc;
+                output_components = num_components;
+                data.resize(height*width*output_components);
+            }
+
+            virtual unsigned char* get_row (
+                unsigned long r
+            )
+            {
+                return &data[r*width*output_components];
+            }
+
+            virtual void finish_row (
+                unsigned long 
+            )
+            {
+            }
+
+        private:
+            unsigned long& height;
+            unsigned long& width;
+            unsigned long& output_components;
+            std::vector<unsigned char>& data;
+        };
+    }
+
+    void jpeg_loader::read_image( const char* filename )
+    {
+        jpeg_buffer_sink sink(height_, width_, output_components_, data);
+        impl::decode_jpeg(filename, 1, sink);
+    }
 
-        jpeg_finish_decompress(&cinfo);
-        jpeg_destroy_decompress(&cinfo);
+// ----------------------------------------------------------------------------------------
 
-        fclose( fp );
+    void jpeg_loader::read_image( const unsigned char* buffer, size_t buffer_size )
+    {
+        jpeg_buffer_sink sink(height_, width_, output_components_, data);
+        impl::decode_jpeg(buffer, buffer_size, 1, sink);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -13,6 +13,71 @@
 namespace dlib
 {
 
+    namespace impl
+    {
+        class jpeg_row_sink
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the interface decode_jpeg() uses to hand off the decoded
+                    image.  It first calls set_size() and then, for each row r in order,
+                    decodes into the buffer returned by get_row(r) and calls
+                    finish_row(r).  Each row holds nc*num_components bytes, which are
+                    either gray values or interleaved RGB values.
+            !*/
+        public:
+            virtual ~jpeg_row_sink() {}
+
+            virtual void set_size (
+                unsigned long nr,
+                unsigned long nc,
+                unsigned long num_components
+            ) = 0;
+
+            virtual unsigned char* get_row (
+                unsigned long r
+            ) = 0;
+
+            virtual void finish_row (
+                unsigned long r
+            ) = 0;
+        };
+
+        void decode_jpeg (
+            const char* filename,
+            unsigned long scale_denom,
+            jpeg_row_sink& sink
+        );
+        /*!
+            requires
+                - scale_denom == 1, 2, 4, or 8
+            ensures
+                - Decodes the given JPEG file into sink.  The image is scaled down by a
+                  factor of scale_denom inside libjpeg's IDCT, which is much faster than
+                  decoding the whole image and then shrinking it.
+            throws
+                - image_load_error
+        !*/
+
+        void decode_jpeg (
+            const unsigned char* buffer,
+            size_t buffer_size,
+            unsigned long scale_denom,
+            jpeg_row_sink& sink
+        );
+        /*!
+            requires
+                - scale_denom == 1, 2, 4, or 8
+            ensures
+                - Decodes the JPEG file held in buffer[0] through buffer[buffer_size-1]
+                  into sink.  libjpeg reads straight from buffer so it isn't copied.
+            throws
+                - image_load_error
+        !*/
+    }
+
+// ----------------------------------------------------------------------------------------
+
     class jpeg_loader : noncopyable
     {
     public:
@@ -20,6 +85,7 @@ namespace dlib
         jpeg_loader( const char* filename );
         jpeg_loader( const std::string& filename );
         jpeg_loader( const dlib::file& f );
+        jpeg_loader( const unsigned char* buffer, size_t buffer_size );
 
         bool is_gray() const;
         bool is_rgb() const;
@@ -68,12 +134,121 @@ namespace dlib
         }
 
         void read_image( const char* filename );
+        void read_image( const unsigned char* buffer, size_t buffer_size );
         unsigned long height_; 
         unsigned long width_;
         unsigned long output_components_;
         std::vector<unsigned char> data;
     };
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename image_type>
+        class jpeg_image_sink : public jpeg_row_sink
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object decodes a JPEG straight into an image.  When the image's
+                    pixels have the same layout as the decoded rows, i.e. unsigned char
+                    for gray JPEGs and rgb_pixel for color ones, libjpeg writes into the
+                    image's rows directly.  Otherwise each row is decoded into a
+                    temporary buffer and converted with assign_pixel().
+            !*/
+        public:
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+
+            jpeg_image_sink(image_type& img_) : img(img_), components(0), direct(false) {}
+
+            virtual void set_size (
+                unsigned long nr,
+                unsigned long nc,
+                unsigned long num_components
+            )
+            {
+                img.set_size(nr, nc);
+                components = num_components;
+                direct = (components == 1 && is_same_type<pixel_type,unsigned char>::value) ||
+                         (components == 3 && is_same_type<pixel_type,rgb_pixel>::value);
+                if (!direct)
+                    buf.resize(nc*components);
+            }
+
+            virtual unsigned char* get_row (
+                unsigned long r
+            )
+            {
+                if (direct)
+                    return reinterpret_cast<unsigned char*>(&img[r][0]);
+                return &buf[0];
+            }
+
+            virtual void finish_row (
+                unsigned long r
+            )
+            {
+                if (direct)
+                    return;
+
+                const long nc = img.nc();
+                if (components == 1)
+                {
+                    for (long m = 0; m < nc; ++m)
+                        assign_pixel(img[r][m], buf[m]);
+                }
+                else
+                {
+                    for (long m = 0; m < nc; ++m)
+                    {
+                        rgb_pixel p;
+                        p.red = buf[m*3];
+                        p.green = buf[m*3+1];
+                        p.blue = buf[m*3+2];
+                        assign_pixel(img[r][m], p);
+                    }
+                }
+            }
+
+        private:
+            image_view<image_type> img;
+            unsigned long components;
+            bool direct;
+            std::vector<unsigned char> buf;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const std::string& file_name,
+        unsigned long scale_denom = 1
+    )
+    {
+#ifndef DLIB_JPEG_SUPPORT
+        /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+            You are getting this error because you are trying to use the load_jpeg 
+            function but you haven't defined DLIB_JPEG_SUPPORT.  You must do so to use
+            this function.   You must also make sure you set your build environment
+            to link against the libjpeg library.
+        !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
+        COMPILE_TIME_ASSERT(sizeof(image_type) == 0);
+#endif
+        // make sure requires clause is not broken
+        DLIB_ASSERT(scale_denom == 1 || scale_denom == 2 || scale_denom == 4 || scale_denom == 8,
+            "\t void load_jpeg()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t scale_denom: " << scale_denom
+            );
+
+        impl::jpeg_image_sink<image_type> sink(image);
+        impl::decode_jpeg(file_name.c_str(), scale_denom, sink);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -81,10 +256,29 @@ namespace dlib
         >
     void load_jpeg (
         image_type& image,
-        const std::string& file_name
+        const unsigned char* buffer,
+        size_t buffer_size,
+        unsigned long scale_denom = 1
     )
     {
-        jpeg_loader(file_name).get_image(image);
+#ifndef DLIB_JPEG_SUPPORT
+        /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+            You are getting this error because you are trying to use the load_jpeg 
+            function but you haven't defined DLIB_JPEG_SUPPORT.  You must do so to use
+            this function.   You must also make sure you set your build environment
+            to link against the libjpeg library.
+        !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
+        COMPILE_TIME_ASSERT(sizeof(image_type) == 0);
+#endif
+        // make sure requires clause is not broken
+        DLIB_ASSERT(scale_denom == 1 || scale_denom == 2 || scale_denom == 4 || scale_denom == 8,
+            "\t void load_jpeg()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t scale_denom: " << scale_denom
+            );
+
+        impl::jpeg_image_sink<image_type> sink(image);
+        impl::decode_jpeg(buffer, buffer_size, scale_denom, sink);
     }
 
 // ----------------------------------------------------------------------------------------
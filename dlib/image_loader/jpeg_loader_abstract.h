@@ -65,6 +65,24 @@ namespace dlib
                   us from loading the given JPEG file.
         !*/
 
+        jpeg_loader( 
+            const unsigned char* buffer,
+            size_t buffer_size
+        );
+        /*!
+            requires
+                - buffer points to an array of at least buffer_size bytes
+            ensures
+                - loads the JPEG file contained in buffer[0] through
+                  buffer[buffer_size-1] into this object.  The data is decoded
+                  directly from buffer.
+            throws
+                - std::bad_alloc
+                - image_load_error
+                  This exception is thrown if there is some error that prevents
+                  us from loading the given JPEG data.
+        !*/
+
         ~jpeg_loader(
         );
         /*!
@@ -115,14 +133,59 @@ namespace dlib
         >
     void load_jpeg (
         image_type& image,
-        const std::string& file_name
+        const std::string& file_name,
+        unsigned long scale_denom = 1
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - scale_denom == 1, 2, 4, or 8
+        ensures
+            - if (scale_denom == 1) then
+                - performs: jpeg_loader(file_name).get_image(image);
+            - else
+                - loads the JPEG file with the given file name into image, shrunk by a
+                  factor of scale_denom.  That is, #image.nr() == ceil(H/scale_denom)
+                  and #image.nc() == ceil(W/scale_denom), where H and W are the
+                  dimensions of the image in the file.  The shrinking is done by
+                  libjpeg's scaled IDCT, so this is much faster than loading the whole
+                  image and then downsampling it.
+            - The image is decoded directly into image rather than into an
+              intermediate buffer.  So unlike jpeg_loader, a second copy of the full
+              resolution image is never held in memory.
+        throws
+            - image_load_error
+              This exception is thrown if there is some error that prevents
+              us from loading the given JPEG file.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size,
+        unsigned long scale_denom = 1
     );
     /*!
         requires
             - image_type == an image object that implements the interface defined in
               dlib/image_processing/generic_image.h 
+            - buffer points to an array of at least buffer_size bytes
+            - scale_denom == 1, 2, 4, or 8
         ensures
-            - performs: jpeg_loader(file_name).get_image(image);
+            - This function is identical to the file name version of load_jpeg() except
+              that it decodes the JPEG file contained in buffer[0] through
+              buffer[buffer_size-1].  libjpeg reads directly from buffer and writes
+              directly into image, so no intermediate copies are made.
+        throws
+            - image_load_error
+              This exception is thrown if there is some error that prevents
+              us from loading the given JPEG data.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -10,6 +10,7 @@
 #include "image_loader.h"
 #include <fstream>
 #include <sstream>
+#include <cstring>
 #ifdef DLIB_GIF_SUPPORT
 #include <gif_lib.h>
 #endif
@@ -28,32 +29,35 @@ namespace dlib
             UNKNOWN
         };
 
-        inline type read_type(const std::string& file_name) 
+        inline type read_type(const unsigned char* buffer, size_t buffer_size) 
         {
-            std::ifstream file(file_name.c_str(), std::ios::in|std::ios::binary);
-            if (!file)
-                throw image_load_error("Unable to open file: " + file_name);
-
-            char buffer[9];
-            file.read((char*)buffer, 8);
-            buffer[8] = 0;
-
             // Determine the true image type using link:
             // http://en.wikipedia.org/wiki/List_of_file_signatures
 
-            if (strcmp(buffer, "\x89\x50\x4E\x47\x0D\x0A\x1A\x0A") == 0) 
+            if (buffer_size >= 8 && std::memcmp(buffer, "\x89\x50\x4E\x47\x0D\x0A\x1A\x0A", 8) == 0) 
                 return PNG;
-            else if(buffer[0]=='\xff' && buffer[1]=='\xd8' && buffer[2]=='\xff') 
+            else if(buffer_size >= 3 && buffer[0]==0xff && buffer[1]==0xd8 && buffer[2]==0xff) 
                 return JPG;
-            else if(buffer[0]=='B' && buffer[1]=='M') 
+            else if(buffer_size >= 2 && buffer[0]=='B' && buffer[1]=='M') 
                 return BMP;
-            else if(buffer[0]=='D' && buffer[1]=='N' && buffer[2] == 'G') 
+            else if(buffer_size >= 3 && buffer[0]=='D' && buffer[1]=='N' && buffer[2] == 'G') 
                 return DNG;
-            else if(buffer[0]=='G' && buffer[1]=='I' && buffer[2] == 'F') 
+            else if(buffer_size >= 3 && buffer[0]=='G' && buffer[1]=='I' && buffer[2] == 'F') 
                 return GIF;
 
             return UNKNOWN;
         }
+
+        inline type read_type(const std::string& file_name) 
+        {
+            std::ifstream file(file_name.c_str(), std::ios::in|std::ios::binary);
+            if (!file)
+                throw image_load_error("Unable to open file: " + file_name);
+
+            unsigned char buffer[8];
+            file.read((char*)buffer, 8);
+            return read_type(buffer, file.gcount());
+        }
     };
 
 // ----------------------------------------------------------------------------------------
@@ -218,6 +222,50 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename image_type>
+    void load_image (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size
+    )
+    {
+        const image_file_type::type im_type = image_file_type::read_type(buffer, buffer_size);
+        switch (im_type)
+        {
+            case image_file_type::BMP: load_bmp(image, buffer, buffer_size); return;
+            case image_file_type::DNG: load_dng(image, buffer, buffer_size); return;
+#ifdef DLIB_PNG_SUPPORT
+            case image_file_type::PNG: load_png(image, buffer, buffer_size); return;
+#endif
+#ifdef DLIB_JPEG_SUPPORT
+            case image_file_type::JPG: load_jpeg(image, buffer, buffer_size); return;
+#endif
+            default:  ;
+        }
+
+        if (im_type == image_file_type::JPG)
+        {
+            throw image_load_error("Unable to load JPEG image from memory buffer.\n"
+                "You must #define DLIB_JPEG_SUPPORT and link to libjpeg to read JPEG files.");
+        }
+        else if (im_type == image_file_type::PNG)
+        {
+            throw image_load_error("Unable to load PNG image from memory buffer.\n"
+                "You must #define DLIB_PNG_SUPPORT and link to libpng to read PNG files.");
+        }
+        else if (im_type == image_file_type::GIF)
+        {
+            throw image_load_error("Unable to load GIF image from memory buffer.\n"
+                "GIF images can only be loaded from files.");
+        }
+        else
+        {
+            throw image_load_error("Unknown image file format: Unable to load image from memory buffer");
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -30,6 +30,34 @@ namespace dlib
                 us from loading the given image file.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename image_type>
+    void load_image (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - buffer points to an array of at least buffer_size bytes
+        ensures
+            - This function is identical to the file name version of load_image()
+              except that it loads the image file contained in buffer[0] through
+              buffer[buffer_size-1].  This is useful for images that arrive over a
+              network connection since they don't need to be written to disk first.
+              The data is decoded directly from buffer, without copying it.
+            - It is capable of reading the PNG, JPEG, BMP, and DNG image formats, with
+              the same requirements regarding DLIB_PNG_SUPPORT and DLIB_JPEG_SUPPORT
+              as the file name version.  GIF images can not be loaded from memory.
+        throws
+            - image_load_error
+                This exception is thrown if there is some error that prevents
+                us from loading the given image data.
+    !*/
+
 }
 
 #endif // DLIB_LOAd_IMAGE_ABSTRACT_ 
@@ -13,19 +13,273 @@
 #include <png.h>
 #include "../string.h"
 #include "../byte_orderer.h"
+#include <cstring>
 
 namespace dlib
 {
 
 // ----------------------------------------------------------------------------------------
 
-    struct LibpngData
+    // Don't do anything when libpng calls us to tell us about an error.  Just return to 
+    // our own code and throw an exception (at the long jump target).
+    void png_loader_user_error_fn_silent(png_structp  png_struct, png_const_charp ) 
+    {
+        longjmp(png_jmpbuf(png_struct),1);
+    }
+    void png_loader_user_warning_fn_silent(png_structp , png_const_charp ) 
+    {
+    }
+
+    namespace
+    {
+        struct png_memory_reader
+        {
+            const unsigned char* buffer;
+            size_t buffer_size;
+            size_t pos;
+        };
+
+        void png_loader_read_from_memory(png_structp png_ptr, png_bytep data, png_size_t length)
+        {
+            png_memory_reader* reader = static_cast<png_memory_reader*>(png_get_io_ptr(png_ptr));
+            if (length > reader->buffer_size - reader->pos)
+                png_error(png_ptr, "read past the end of the buffer");
+            std::memcpy(data, reader->buffer + reader->pos, length);
+            reader->pos += length;
+        }
+
+        void read_png (
+            FILE* fp,
+            png_memory_reader* reader,
+            const std::string& source_name,
+            impl::png_row_sink& sink,
+            std::vector<png_bytep>& row_pointers
+        )
+        /*!
+            requires
+                - exactly one of fp and reader is non-NULL.  The PNG data, minus the 8
+                  byte signature which the caller has already checked, is read from it.
+                - row_pointers.size() == 0
+            ensures
+                - decodes the PNG data into sink.  source_name is only used in error
+                  messages.
+                - does not close fp.
+                - row_pointers is used as scratch space.  It's passed in rather than
+                  being a local variable because this function changes it after calling
+                  setjmp(), and such local variables have indeterminate values after a
+                  longjmp() back to the setjmp().
+        !*/
+        {
+            png_structp png_ptr = png_create_read_struct( PNG_LIBPNG_VER_STRING, NULL, &png_loader_user_error_fn_silent, &png_loader_user_warning_fn_silent );
+            if ( png_ptr == NULL )
+            {
+                throw image_load_error("png_loader: parse error in " + source_name);
+            }
+            png_infop info_ptr = png_create_info_struct( png_ptr );
+            if ( info_ptr == NULL )
+            {
+                png_destroy_read_struct( &png_ptr, ( png_infopp )NULL, ( png_infopp )NULL );
+                throw image_load_error("png_loader: parse error in " + source_name);
+            }
+
+            // This has to exist before setjmp() is called so that it's safe to
+            // longjmp() back past it.
+            byte_orderer bo;
+
+            if (setjmp(png_jmpbuf(png_ptr)))
+            {
+                // If we get here, we had a problem reading the file 
+                png_destroy_read_struct( &png_ptr, &info_ptr, ( png_infopp )NULL );
+                throw image_load_error("png_loader: parse error in " + source_name);
+            }
+
+            if (fp)
+                png_init_io( png_ptr, fp );
+            else
+                png_set_read_fn( png_ptr, reader, png_loader_read_from_memory );
+            png_set_sig_bytes( png_ptr, 8 );
+            png_read_info( png_ptr, info_ptr );
+
+            // Expand palettes and force at least one byte per channel.  16 bit samples
+            // are delivered in the host's byte order.
+            png_set_palette_to_rgb( png_ptr );
+            png_set_packing( png_ptr );
+            if (bo.host_is_little_endian())
+                png_set_swap( png_ptr );
+            png_set_interlace_handling( png_ptr );
+            png_read_update_info( png_ptr, info_ptr );
+
+            const unsigned long height = png_get_image_height( png_ptr, info_ptr );
+            const unsigned long width = png_get_image_width( png_ptr, info_ptr );
+            const unsigned long bit_depth = png_get_bit_depth( png_ptr, info_ptr );
+            const int color_type = png_get_color_type( png_ptr, info_ptr );
+
+            unsigned long num_channels = 0;
+            switch (color_type)
+            {
+                case PNG_COLOR_TYPE_GRAY:       num_channels = 1; break;
+                case PNG_COLOR_TYPE_GRAY_ALPHA: num_channels = 2; break;
+                case PNG_COLOR_TYPE_RGB:        num_channels = 3; break;
+                case PNG_COLOR_TYPE_RGB_ALPHA:  num_channels = 4; break;
+                default:
+                    png_destroy_read_struct( &png_ptr, &info_ptr, ( png_infopp )NULL );
+                    throw image_load_error("png_loader: unsupported color type in " + source_name);
+            }
+
+            if (bit_depth != 8 && bit_depth != 16)
+            {
+                png_destroy_read_struct( &png_ptr, &info_ptr, ( png_infopp )NULL );
+                throw image_load_error("png_loader: unsupported bit depth of " + cast_to_string(bit_depth) + " in " + source_name);
+            }
+
+            try
+            {
+                sink.set_size(height, width, num_channels, bit_depth);
+                row_pointers.resize(height);
+                for (unsigned long r = 0; r < height; ++r)
+                    row_pointers[r] = sink.get_row(r);
+            }
+            catch (...)
+            {
+                png_destroy_read_struct( &png_ptr, &info_ptr, ( png_infopp )NULL );
+                throw;
+            }
+
+            png_read_image( png_ptr, &row_pointers[0] );
+            png_read_end( png_ptr, NULL );
+            png_destroy_read_struct( &png_ptr, &info_ptr, ( png_infopp )NULL );
+
+            sink.finish();
+        }
+
+        void read_png (
+            FILE* fp,
+            png_memory_reader* reader,
+            const std::string& source_name,
+            impl::png_row_sink& sink
+        )
+        {
+            std::vector<png_bytep> row_pointers;
+            read_png(fp, reader, source_name, sink, row_pointers);
+        }
+
+        class png_buffer_sink : public impl::png_row_sink
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object stores the decoded rows in png_loader's buffer.
+            !*/
+        public:
+            png_buffer_sink (
+                std::vector<unsigned char>& data_,
+                unsigned& height_,
+                unsigned& width_,
+                unsigned& bit_depth_,
+                unsigned long& num_channels_,
+                size_t& row_bytes_
+            ) : data(data_), height(height_), width(width_), bit_depth(bit_depth_), 
+                num_channels(num_channels_), row_bytes(row_bytes_) {}
+
+            virtual void set_size (
+                unsigned long nr,
+                unsigned long nc,
+                unsigned long channels,
+                unsigned long depth
+            )
+            {
+                height = nr;
+                width = nc;
+                num_channels = channels;
+                bit_depth = depth;
+                row_bytes = nc*channels*depth/8;
+                data.resize(nr*row_bytes);
+            }
+
+            virtual unsigned char* get_row (
+                unsigned long r
+            )
+            {
+                return &data[r*row_bytes];
+            }
+
+            virtual void finish (
+            ) {}
+
+        private:
+            std::vector<unsigned char>& data;
+            unsigned& height;
+            unsigned& width;
+            unsigned& bit_depth;
+            unsigned long& num_channels;
+            size_t& row_bytes;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
     {
-        png_bytep* row_pointers_;
-        png_structp png_ptr_;
-        png_infop info_ptr_;
-        png_infop end_info_;
-    };
+        void decode_png (
+            const char* filename,
+            png_row_sink& sink
+        )
+        {
+            if ( filename == NULL )
+            {
+                throw image_load_error("png_loader: invalid filename, it is NULL");
+            }
+            FILE *fp = fopen( filename, "rb" );
+            if ( !fp )
+            {
+                throw image_load_error(std::string("png_loader: unable to open file ") + filename);
+            }
+            png_byte sig[8];
+            if (fread( sig, 1, 8, fp ) != 8)
+            {
+                fclose( fp );
+                throw image_load_error(std::string("png_loader: error reading file ") + filename);
+            }
+            if ( png_sig_cmp( sig, 0, 8 ) != 0 )
+            {
+                fclose( fp );
+                throw image_load_error(std::string("png_loader: format error in file ") + filename);
+            }
+
+            try
+            {
+                read_png(fp, NULL, std::string("file ") + filename, sink);
+            }
+            catch (...)
+            {
+                fclose( fp );
+                throw;
+            }
+            fclose( fp );
+        }
+
+        void decode_png (
+            const unsigned char* buffer,
+            size_t buffer_size,
+            png_row_sink& sink
+        )
+        {
+            if ( buffer == NULL && buffer_size != 0 )
+            {
+                throw image_load_error("png_loader: invalid buffer, it is NULL");
+            }
+            if ( buffer_size < 8 || png_sig_cmp( const_cast<png_bytep>(buffer), 0, 8 ) != 0 )
+            {
+                throw image_load_error("png_loader: format error in memory buffer");
+            }
+
+            // libpng reads straight out of buffer, so it's never copied.
+            png_memory_reader reader;
+            reader.buffer = buffer;
+            reader.buffer_size = buffer_size;
+            reader.pos = 8;
+            read_png(NULL, &reader, "memory buffer", sink);
+        }
+    }
 
 // ----------------------------------------------------------------------------------------
 
@@ -53,152 +307,60 @@ namespace dlib
 
 // ----------------------------------------------------------------------------------------
 
-    const unsigned char* png_loader::get_row( unsigned i ) const
+    png_loader::
+    png_loader( const unsigned char* buffer, size_t buffer_size ) : height_( 0 ), width_( 0 )
     {
-        return ld_->row_pointers_[i];
+        read_image( buffer, buffer_size );
     }
 
 // ----------------------------------------------------------------------------------------
 
     png_loader::~png_loader()
     {
-        if ( ld_ && ld_->row_pointers_ != NULL )
-            png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
     }
 
 // ----------------------------------------------------------------------------------------
 
     bool png_loader::is_gray() const
     {
-        return ( color_type_ == PNG_COLOR_TYPE_GRAY );
+        return ( num_channels_ == 1 );
     }
 
 // ----------------------------------------------------------------------------------------
 
     bool png_loader::is_graya() const
     {
-        return ( color_type_ == PNG_COLOR_TYPE_GRAY_ALPHA );
+        return ( num_channels_ == 2 );
     }
 
 // ----------------------------------------------------------------------------------------
 
     bool png_loader::is_rgb() const
     {
-        return ( color_type_ == PNG_COLOR_TYPE_RGB );
+        return ( num_channels_ == 3 );
     }
 
 // ----------------------------------------------------------------------------------------
 
     bool png_loader::is_rgba() const
     {
-        return ( color_type_ == PNG_COLOR_TYPE_RGB_ALPHA );
+        return ( num_channels_ == 4 );
     }
 
 // ----------------------------------------------------------------------------------------
 
-    // Don't do anything when libpng calls us to tell us about an error.  Just return to 
-    // our own code and throw an exception (at the long jump target).
-    void png_loader_user_error_fn_silent(png_structp  png_struct, png_const_charp ) 
-    {
-        longjmp(png_jmpbuf(png_struct),1);
-    }
-    void png_loader_user_warning_fn_silent(png_structp , png_const_charp ) 
-    {
-    }
-
     void png_loader::read_image( const char* filename )
     {
-        ld_.reset(new LibpngData);
-        if ( filename == NULL )
-        {
-            throw image_load_error("png_loader: invalid filename, it is NULL");
-        }
-        FILE *fp = fopen( filename, "rb" );
-        if ( !fp )
-        {
-            throw image_load_error(std::string("png_loader: unable to open file ") + filename);
-        }
-        png_byte sig[8];
-        if (fread( sig, 1, 8, fp ) != 8)
-        {
-            fclose( fp );
-            throw image_load_error(std::string("png_loader: error reading file ") + filename);
-        }
-        if ( png_sig_cmp( sig, 0, 8 ) != 0 )
-        {
-            fclose( fp );
-            throw image_load_error(std::string("png_loader: format error in file ") + filename);
-        }
-        ld_->png_ptr_ = png_create_read_struct( PNG_LIBPNG_VER_STRING, NULL, &png_loader_user_error_fn_silent, &png_loader_user_warning_fn_silent );
-        if ( ld_->png_ptr_ == NULL )
-        {
-            fclose( fp );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
-        }
-        ld_->info_ptr_ = png_create_info_struct( ld_->png_ptr_ );
-        if ( ld_->info_ptr_ == NULL )
-        {
-            fclose( fp );
-            png_destroy_read_struct( &( ld_->png_ptr_ ), ( png_infopp )NULL, ( png_infopp )NULL );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
-        }
-        ld_->end_info_ = png_create_info_struct( ld_->png_ptr_ );
-        if ( ld_->end_info_ == NULL )
-        {
-            fclose( fp );
-            png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), ( png_infopp )NULL );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
-        }
-
-        if (setjmp(png_jmpbuf(ld_->png_ptr_)))
-        {
-            // If we get here, we had a problem writing the file 
-            fclose(fp);
-            png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
-        }
-
-        png_set_palette_to_rgb(ld_->png_ptr_);
-
-        png_init_io( ld_->png_ptr_, fp );
-        png_set_sig_bytes( ld_->png_ptr_, 8 );
-        // flags force one byte per channel output
-        byte_orderer bo;
-        int png_transforms = PNG_TRANSFORM_PACKING;
-        if (bo.host_is_little_endian())
-            png_transforms |= PNG_TRANSFORM_SWAP_ENDIAN;
-        png_read_png( ld_->png_ptr_, ld_->info_ptr_, png_transforms, NULL );
-        height_ = png_get_image_height( ld_->png_ptr_, ld_->info_ptr_ );
-        width_ = png_get_image_width( ld_->png_ptr_, ld_->info_ptr_ );
-        bit_depth_ = png_get_bit_depth( ld_->png_ptr_, ld_->info_ptr_ );
-        color_type_ = png_get_color_type( ld_->png_ptr_, ld_-> info_ptr_ );
-
-
-        if (color_type_ != PNG_COLOR_TYPE_GRAY && 
-            color_type_ != PNG_COLOR_TYPE_RGB && 
-            color_type_ != PNG_COLOR_TYPE_RGB_ALPHA &&
-            color_type_ != PNG_COLOR_TYPE_GRAY_ALPHA)
-        {
-            fclose( fp );
-            png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
-            throw image_load_error(std::string("png_loader: unsupported color type in file ") + filename);
-        }
-
-        if (bit_depth_ != 8 && bit_depth_ != 16)
-        {
-            fclose( fp );
-            png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
-            throw image_load_error("png_loader: unsupported bit depth of " + cast_to_string(bit_depth_) + " in file " + std::string(filename));
-        }
+        png_buffer_sink sink(data, height_, width_, bit_depth_, num_channels_, row_bytes_);
+        impl::decode_png(filename, sink);
+    }
 
-        ld_->row_pointers_ = png_get_rows( ld_->png_ptr_, ld_->info_ptr_ );
+// ----------------------------------------------------------------------------------------
 
-        fclose( fp );
-        if ( ld_->row_pointers_ == NULL )
-        {
-            png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
-        }
+    void png_loader::read_image( const unsigned char* buffer, size_t buffer_size )
+    {
+        png_buffer_sink sink(data, height_, width_, bit_depth_, num_channels_, row_bytes_);
+        impl::decode_png(buffer, buffer_size, sink);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -4,79 +4,122 @@
 #define DLIB_PNG_IMPORT
 
 #include "png_loader_abstract.h"
-#include "../smart_pointers.h"
 #include "image_loader.h"
 #include "../pixel.h"
 #include "../dir_nav.h"
+#include <vector>
 
 namespace dlib
 {
 
-    struct LibpngData;
-    class png_loader : noncopyable
+    namespace impl
     {
-    public:
+        class png_row_sink
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the interface decode_png() uses to hand off the decoded image.
+                    It first calls set_size() and then get_row(r) for every row r.  libpng
+                    then decodes the whole image into those rows, possibly in several
+                    passes if the PNG is interlaced, and finally finish() is called.  Each
+                    row holds nc*num_channels samples of bit_depth bits, in the host's
+                    byte order.  The channels are gray, gray+alpha, RGB, or RGBA for
+                    num_channels equal to 1, 2, 3, and 4 respectively.
+            !*/
+        public:
+            virtual ~png_row_sink() {}
 
-        png_loader( const char* filename );
-        png_loader( const std::string& filename );
-        png_loader( const dlib::file& f );
-        ~png_loader();
+            virtual void set_size (
+                unsigned long nr,
+                unsigned long nc,
+                unsigned long num_channels,
+                unsigned long bit_depth
+            ) = 0;
 
-        bool is_gray() const;
-        bool is_graya() const;
-        bool is_rgb() const;
-        bool is_rgba() const;
+            virtual unsigned char* get_row (
+                unsigned long r
+            ) = 0;
 
-        unsigned int bit_depth () const { return bit_depth_; }
+            virtual void finish (
+            ) = 0;
+        };
 
-        template<typename T>
-        void get_image( T& t_) const
-        {
-#ifndef DLIB_PNG_SUPPORT
-            /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-                You are getting this error because you are trying to use the png_loader
-                object but you haven't defined DLIB_PNG_SUPPORT.  You must do so to use
-                this object.   You must also make sure you set your build environment
-                to link against the libpng library.
-            !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
-            COMPILE_TIME_ASSERT(sizeof(T) == 0);
-#endif
+        void decode_png (
+            const char* filename,
+            png_row_sink& sink
+        );
+        /*!
+            ensures
+                - Decodes the given PNG file into sink.  Palette images are expanded to
+                  RGB or RGBA and images with less than 8 bits per sample are unpacked to
+                  8 bits, so bit_depth is always 8 or 16.
+            throws
+                - image_load_error
+        !*/
 
-            typedef typename image_traits<T>::pixel_type pixel_type;
-            image_view<T> t(t_);
-            t.set_size( height_, width_ );
+        void decode_png (
+            const unsigned char* buffer,
+            size_t buffer_size,
+            png_row_sink& sink
+        );
+        /*!
+            ensures
+                - Decodes the PNG file held in buffer[0] through buffer[buffer_size-1]
+                  into sink.  libpng reads straight from buffer so it isn't copied.
+            throws
+                - image_load_error
+        !*/
 
+        template <typename image_view_type>
+        void assign_png_rows (
+            image_view_type& t,
+            const unsigned char* data,
+            size_t row_bytes,
+            unsigned long num_channels,
+            unsigned long bit_depth
+        )
+        /*!
+            requires
+                - data points to t.nr() rows of decoded PNG data, each row_bytes long, in
+                  the format described by png_row_sink.
+            ensures
+                - converts the pixels into t using assign_pixel().
+        !*/
+        {
+            typedef typename image_view_type::pixel_type pixel_type;
+            const long height_ = t.nr();
+            const long width_ = t.nc();
 
-            if (is_gray() && bit_depth_ == 8)
+            if (num_channels == 1 && bit_depth == 8)
             {
-                for ( unsigned n = 0; n < height_;n++ )
+                for ( long n = 0; n < height_;n++ )
                 {
-                    const unsigned char* v = get_row( n );
-                    for ( unsigned m = 0; m < width_;m++ )
+                    const unsigned char* v = data + n*row_bytes;
+                    for ( long m = 0; m < width_;m++ )
                     {
                         unsigned char p = v[m];
                         assign_pixel( t[n][m], p );
                     }
                 }
             }
-            else if (is_gray() && bit_depth_ == 16)
+            else if (num_channels == 1 && bit_depth == 16)
             {
-                for ( unsigned n = 0; n < height_;n++ )
+                for ( long n = 0; n < height_;n++ )
                 {
-                    const uint16* v = (uint16*)get_row( n );
-                    for ( unsigned m = 0; m < width_;m++ )
+                    const uint16* v = (const uint16*)(data + n*row_bytes);
+                    for ( long m = 0; m < width_;m++ )
                     {
                         dlib::uint16 p = v[m];
                         assign_pixel( t[n][m], p );
                     }
                 }
             }
-            else if (is_graya() && bit_depth_ == 8)
+            else if (num_channels == 2 && bit_depth == 8)
             {
-                for ( unsigned n = 0; n < height_;n++ )
+                for ( long n = 0; n < height_;n++ )
                 {
-                    const unsigned char* v = get_row( n );
-                    for ( unsigned m = 0; m < width_; m++ )
+                    const unsigned char* v = data + n*row_bytes;
+                    for ( long m = 0; m < width_; m++ )
                     {
                         unsigned char p = v[m*2];
                         if (!pixel_traits<pixel_type>::has_alpha)
@@ -94,12 +137,12 @@ namespace dlib
                     }
                 }
             }
-            else if (is_graya() && bit_depth_ == 16)
+            else if (num_channels == 2 && bit_depth == 16)
             {
-                for ( unsigned n = 0; n < height_;n++ )
+                for ( long n = 0; n < height_;n++ )
                 {
-                    const uint16* v = (uint16*)get_row( n );
-                    for ( unsigned m = 0; m < width_; m++ )
+                    const uint16* v = (const uint16*)(data + n*row_bytes);
+                    for ( long m = 0; m < width_; m++ )
                     {
                         dlib::uint16 p = v[m*2];
                         if (!pixel_traits<pixel_type>::has_alpha)
@@ -117,12 +160,12 @@ namespace dlib
                     }
                 }
             }
-            else if (is_rgb() && bit_depth_ == 8)
+            else if (num_channels == 3 && bit_depth == 8)
             {
-                for ( unsigned n = 0; n < height_;n++ )
+                for ( long n = 0; n < height_;n++ )
                 {
-                    const unsigned char* v = get_row( n );
-                    for ( unsigned m = 0; m < width_;m++ )
+                    const unsigned char* v = data + n*row_bytes;
+                    for ( long m = 0; m < width_;m++ )
                     {
                         rgb_pixel p;
                         p.red = v[m*3];
@@ -132,12 +175,12 @@ namespace dlib
                     }
                 }
             }
-            else if (is_rgb() && bit_depth_ == 16)
+            else if (num_channels == 3 && bit_depth == 16)
             {
-                for ( unsigned n = 0; n < height_;n++ )
+                for ( long n = 0; n < height_;n++ )
                 {
-                    const uint16* v = (uint16*)get_row( n );
-                    for ( unsigned m = 0; m < width_;m++ )
+                    const uint16* v = (const uint16*)(data + n*row_bytes);
+                    for ( long m = 0; m < width_;m++ )
                     {
                         rgb_pixel p;
                         p.red   = static_cast<uint8>(v[m*3]);
@@ -147,15 +190,15 @@ namespace dlib
                     }
                 }
             }
-            else if (is_rgba() && bit_depth_ == 8)
+            else if (num_channels == 4 && bit_depth == 8)
             {
                 if (!pixel_traits<pixel_type>::has_alpha)
                     assign_all_pixels(t,0);
 
-                for ( unsigned n = 0; n < height_;n++ )
+                for ( long n = 0; n < height_;n++ )
                 {
-                    const unsigned char* v = get_row( n );
-                    for ( unsigned m = 0; m < width_;m++ )
+                    const unsigned char* v = data + n*row_bytes;
+                    for ( long m = 0; m < width_;m++ )
                     {
                         rgb_alpha_pixel p;
                         p.red = v[m*4];
@@ -166,15 +209,15 @@ namespace dlib
                     }
                 }
             }
-            else if (is_rgba() && bit_depth_ == 16)
+            else if (num_channels == 4 && bit_depth == 16)
             {
                 if (!pixel_traits<pixel_type>::has_alpha)
                     assign_all_pixels(t,0);
 
-                for ( unsigned n = 0; n < height_;n++ )
+                for ( long n = 0; n < height_;n++ )
                 {
-                    const uint16* v = (uint16*)get_row( n );
-                    for ( unsigned m = 0; m < width_;m++ )
+                    const uint16* v = (const uint16*)(data + n*row_bytes);
+                    for ( long m = 0; m < width_;m++ )
                     {
                         rgb_alpha_pixel p;
                         p.red   = static_cast<uint8>(v[m*4]);
@@ -186,16 +229,121 @@ namespace dlib
                 }
             }
         }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class png_loader : noncopyable
+    {
+    public:
+
+        png_loader( const char* filename );
+        png_loader( const std::string& filename );
+        png_loader( const dlib::file& f );
+        png_loader( const unsigned char* buffer, size_t buffer_size );
+        ~png_loader();
+
+        bool is_gray() const;
+        bool is_graya() const;
+        bool is_rgb() const;
+        bool is_rgba() const;
+
+        unsigned int bit_depth () const { return bit_depth_; }
+
+        template<typename T>
+        void get_image( T& t_) const
+        {
+#ifndef DLIB_PNG_SUPPORT
+            /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+                You are getting this error because you are trying to use the png_loader
+                object but you haven't defined DLIB_PNG_SUPPORT.  You must do so to use
+                this object.   You must also make sure you set your build environment
+                to link against the libpng library.
+            !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
+            COMPILE_TIME_ASSERT(sizeof(T) == 0);
+#endif
+
+            image_view<T> t(t_);
+            t.set_size( height_, width_ );
+            impl::assign_png_rows(t, &data[0], row_bytes_, num_channels_, bit_depth_);
+        }
 
     private:
-        const unsigned char* get_row( unsigned i ) const;
         void read_image( const char* filename );
+        void read_image( const unsigned char* buffer, size_t buffer_size );
         unsigned height_, width_;
         unsigned bit_depth_;
-        int color_type_;
-        scoped_ptr<LibpngData> ld_;
+        unsigned long num_channels_;
+        size_t row_bytes_;
+        std::vector<unsigned char> data;
     };
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename image_type>
+        class png_image_sink : public png_row_sink
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object decodes a PNG straight into an image.  When the image's
+                    pixels have the same layout as the decoded rows, i.e. unsigned char or
+                    uint16 for gray PNGs, rgb_pixel for RGB ones, and rgb_alpha_pixel for
+                    8 bit RGBA ones, libpng writes into the image's rows directly.
+                    Otherwise the PNG is decoded into a temporary buffer and converted with
+                    assign_png_rows().
+            !*/
+        public:
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+
+            png_image_sink(image_type& img_) : img(img_), channels(0), depth(0), row_bytes(0), direct(false) {}
+
+            virtual void set_size (
+                unsigned long nr,
+                unsigned long nc,
+                unsigned long num_channels,
+                unsigned long bit_depth
+            )
+            {
+                img.set_size(nr, nc);
+                channels = num_channels;
+                depth = bit_depth;
+                row_bytes = nc*channels*depth/8;
+                direct = (channels == 1 && depth == 8  && is_same_type<pixel_type,unsigned char>::value) ||
+                         (channels == 1 && depth == 16 && is_same_type<pixel_type,uint16>::value) ||
+                         (channels == 3 && depth == 8  && is_same_type<pixel_type,rgb_pixel>::value) ||
+                         (channels == 4 && depth == 8  && is_same_type<pixel_type,rgb_alpha_pixel>::value);
+                if (!direct)
+                    buf.resize(nr*row_bytes);
+            }
+
+            virtual unsigned char* get_row (
+                unsigned long r
+            )
+            {
+                if (direct)
+                    return reinterpret_cast<unsigned char*>(&img[r][0]);
+                return &buf[r*row_bytes];
+            }
+
+            virtual void finish (
+            )
+            {
+                if (!direct)
+                    assign_png_rows(img, &buf[0], row_bytes, channels, depth);
+            }
+
+        private:
+            image_view<image_type> img;
+            unsigned long channels;
+            unsigned long depth;
+            size_t row_bytes;
+            bool direct;
+            std::vector<unsigned char> buf;
+        };
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -206,7 +354,41 @@ namespace dlib
         const std::string& file_name
     )
     {
-        png_loader(file_name).get_image(image);
+#ifndef DLIB_PNG_SUPPORT
+        /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+            You are getting this error because you are trying to use the load_png
+            function but you haven't defined DLIB_PNG_SUPPORT.  You must do so to use
+            this function.   You must also make sure you set your build environment
+            to link against the libpng library.
+        !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
+        COMPILE_TIME_ASSERT(sizeof(image_type) == 0);
+#endif
+        impl::png_image_sink<image_type> sink(image);
+        impl::decode_png(file_name.c_str(), sink);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_png (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size
+    )
+    {
+#ifndef DLIB_PNG_SUPPORT
+        /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+            You are getting this error because you are trying to use the load_png
+            function but you haven't defined DLIB_PNG_SUPPORT.  You must do so to use
+            this function.   You must also make sure you set your build environment
+            to link against the libpng library.
+        !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
+        COMPILE_TIME_ASSERT(sizeof(image_type) == 0);
+#endif
+        impl::png_image_sink<image_type> sink(image);
+        impl::decode_png(buffer, buffer_size, sink);
     }
 
 // ----------------------------------------------------------------------------------------
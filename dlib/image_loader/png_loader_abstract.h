@@ -65,6 +65,24 @@ namespace dlib
                   us from loading the given PNG file.
         !*/
 
+        png_loader( 
+            const unsigned char* buffer,
+            size_t buffer_size
+        );
+        /*!
+            requires
+                - buffer points to an array of at least buffer_size bytes
+            ensures
+                - loads the PNG file contained in buffer[0] through
+                  buffer[buffer_size-1] into this object.  The data is decoded
+                  directly from buffer.
+            throws
+                - std::bad_alloc
+                - image_load_error
+                  This exception is thrown if there is some error that prevents
+                  us from loading the given PNG data.
+        !*/
+
         ~png_loader(
         );
         /*!
@@ -150,7 +168,38 @@ namespace dlib
             - image_type == an image object that implements the interface defined in
               dlib/image_processing/generic_image.h 
         ensures
-            - performs: png_loader(file_name).get_image(image);
+            - Loads the PNG file with the given file name into image.  The result is the
+              same as performing png_loader(file_name).get_image(image).  However, if
+              the image's pixel type matches the PNG's pixel format then libpng decodes
+              straight into image, so no intermediate copy is made.  That is the case
+              for unsigned char or uint16 images with grayscale PNGs, rgb_pixel images
+              with 8 bit RGB PNGs, and rgb_alpha_pixel images with 8 bit RGBA PNGs.
+        throws
+            - image_load_error
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_png (
+        image_type& image,
+        const unsigned char* buffer,
+        size_t buffer_size
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - buffer points to an array of at least buffer_size bytes
+        ensures
+            - Loads the PNG file contained in buffer[0] through buffer[buffer_size-1]
+              into image.  The result is the same as performing
+              png_loader(buffer, buffer_size).get_image(image) and, like the above
+              load_png(), the pixels are decoded directly into image when possible.
+        throws
+            - image_load_error
     !*/
 
 // ----------------------------------------------------------------------------------------
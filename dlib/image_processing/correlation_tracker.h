@@ -8,11 +8,67 @@
 #include "../matrix.h"
 #include "../array2d.h"
 #include "../image_transforms/assign_image.h"
-
+#include "../threads.h"
+#include <memory>
 
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        inline long fastlog2(long n)
+        {
+            long log = -1;
+            while(n) {
+                log++;
+                n >>= 1;
+            }
+            return log ;
+        }
+
+        class correlation_tracker_workspace
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds the temporary images and FFT buffers a
+                    correlation_tracker needs while it runs.  None of it is part of a
+                    tracker's state.  So one workspace can be shared by any number of
+                    trackers, as long as only one of them uses it at a time.
+            !*/
+        public:
+
+            template <long NR, long NC>
+            void fft (
+                matrix<std::complex<double>,NR,NC>& data,
+                bool do_backward_fft
+            )
+            /*!
+                ensures
+                    - if (do_backward_fft) then
+                        - performs ifft_inplace(data)
+                    - else
+                        - performs fft_inplace(data)
+                    - Reuses this object's buffers rather than allocating new ones.
+            !*/
+            {
+                if (data.size() == 0)
+                    return;
+
+                fft2d(&data(0,0), &data(0,0), data.nr(), data.nc(), do_backward_fft, temp);
+            }
+
+            std::vector<matrix<std::complex<double> > > F;
+            std::vector<matrix<std::complex<double>,0,1> > Fs;
+            matrix<std::complex<double> > G;
+            matrix<std::complex<double>,0,1> Gs;
+
+        private:
+            std::vector<std::complex<double> > temp;
+        };
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class correlation_tracker
@@ -54,41 +110,9 @@ namespace dlib
             const drectangle& p
         )
         {
-            DLIB_CASSERT(p.is_empty() == false,
-                "\t void correlation_tracker::start_track()"
-                << "\n\t You can't give an empty rectangle."
-            );
-
-            B.set_size(0,0);
-
-            point_transform_affine tform = inv(make_chip(img, p, F));
-            for (unsigned long i = 0; i < F.size(); ++i)
-                fft_inplace(F[i]);
-            make_target_location_image(tform(center(p)), G);
-            A.resize(F.size());
-            for (unsigned long i = 0; i < F.size(); ++i)
-            {
-                A[i] = pointwise_multiply(G, F[i]);
-                B += squared(real(F[i]))+squared(imag(F[i]));
-            }
-
-            position = p;
-
-            // now do the scale space stuff
-            make_scale_space(img, Fs);
-            for (unsigned long i = 0; i < Fs.size(); ++i)
-                fft_inplace(Fs[i]);
-            make_scale_target_location_image(get_num_scale_levels()/2, Gs);
-            Bs.set_size(0);
-            As.resize(Fs.size());
-            for (unsigned long i = 0; i < Fs.size(); ++i)
-            {
-                As[i] = pointwise_multiply(Gs, Fs[i]);
-                Bs += squared(real(Fs[i]))+squared(imag(Fs[i]));
-            }
+            start_track(img, p, ws);
         }
 
-
         unsigned long get_filter_size (
         ) const { return filter_size; } 
 
@@ -123,6 +147,91 @@ namespace dlib
             const image_type& img,
             const drectangle& guess
         )
+        {
+            return update_noscale(img, guess, ws);
+        }
+
+        template <typename image_type>
+        double update (
+            const image_type& img,
+            const drectangle& guess
+        )
+        {
+            return update(img, guess, ws);
+        }
+
+        template <typename image_type>
+        double update_noscale (
+            const image_type& img
+        )
+        {
+            return update_noscale(img, get_position());
+        }
+
+        template <typename image_type>
+        double update(
+            const image_type& img
+            )
+        {
+            return update(img, get_position());
+        }
+
+    private:
+
+        friend class multi_correlation_tracker;
+
+        template <typename image_type>
+        void start_track (
+            const image_type& img,
+            const drectangle& p,
+            impl::correlation_tracker_workspace& ws
+        )
+        {
+            DLIB_CASSERT(p.is_empty() == false,
+                "\t void correlation_tracker::start_track()"
+                << "\n\t You can't give an empty rectangle."
+            );
+
+            B.set_size(0,0);
+
+            std::vector<matrix<std::complex<double> > >& F = ws.F;
+            std::vector<matrix<std::complex<double>,0,1> >& Fs = ws.Fs;
+            matrix<std::complex<double> >& G = ws.G;
+            matrix<std::complex<double>,0,1>& Gs = ws.Gs;
+
+            point_transform_affine tform = inv(make_chip(img, p, F));
+            for (unsigned long i = 0; i < F.size(); ++i)
+                ws.fft(F[i], false);
+            make_target_location_image(tform(center(p)), G, ws);
+            A.resize(F.size());
+            for (unsigned long i = 0; i < F.size(); ++i)
+            {
+                A[i] = pointwise_multiply(G, F[i]);
+                B += squared(real(F[i]))+squared(imag(F[i]));
+            }
+
+            position = p;
+
+            // now do the scale space stuff
+            make_scale_space(img, Fs);
+            for (unsigned long i = 0; i < Fs.size(); ++i)
+                ws.fft(Fs[i], false);
+            make_scale_target_location_image(get_num_scale_levels()/2, Gs, ws);
+            Bs.set_size(0);
+            As.resize(Fs.size());
+            for (unsigned long i = 0; i < Fs.size(); ++i)
+            {
+                As[i] = pointwise_multiply(Gs, Fs[i]);
+                Bs += squared(real(Fs[i]))+squared(imag(Fs[i]));
+            }
+        }
+
+        template <typename image_type>
+        double update_noscale(
+            const image_type& img,
+            const drectangle& guess,
+            impl::correlation_tracker_workspace& ws
+        )
         {
             DLIB_CASSERT(get_position().is_empty() == false,
                 "\t double correlation_tracker::update()"
@@ -130,16 +239,20 @@ namespace dlib
             );
 
 
+            std::vector<matrix<std::complex<double> > >& F = ws.F;
+            matrix<std::complex<double> >& G = ws.G;
+
             const point_transform_affine tform = make_chip(img, guess, F);
             for (unsigned long i = 0; i < F.size(); ++i)
-                fft_inplace(F[i]);
+                ws.fft(F[i], false);
 
             // use the current filter to predict the object's location
+            G.set_size(get_filter_size(), get_filter_size());
             G = 0;
             for (unsigned long i = 0; i < F.size(); ++i)
                 G += pointwise_multiply(F[i],conj(A[i]));
             G = pointwise_multiply(G, reciprocal(B+get_regularizer_space()));
-            ifft_inplace(G);
+            ws.fft(G, true);
             const dlib::vector<double,2> pp = max_point_interpolated(real(G));
 
 
@@ -161,7 +274,7 @@ namespace dlib
             position = translate_rect(guess, tform(pp)-center(guess));
 
             // now update the position filters
-            make_target_location_image(pp, G);
+            make_target_location_image(pp, G, ws);
             B *= (1-get_nu_space());
             for (unsigned long i = 0; i < F.size(); ++i)
             {
@@ -175,20 +288,25 @@ namespace dlib
         template <typename image_type>
         double update (
             const image_type& img,
-            const drectangle& guess
+            const drectangle& guess,
+            impl::correlation_tracker_workspace& ws
         )
         {
-            double psr = update_noscale(img, guess);
+            double psr = update_noscale(img, guess, ws);
+
+            std::vector<matrix<std::complex<double>,0,1> >& Fs = ws.Fs;
+            matrix<std::complex<double>,0,1>& Gs = ws.Gs;
 
             // Now predict the scale change
             make_scale_space(img, Fs);
             for (unsigned long i = 0; i < Fs.size(); ++i)
-                fft_inplace(Fs[i]);
+                ws.fft(Fs[i], false);
+            Gs.set_size(get_num_scale_levels());
             Gs = 0;
             for (unsigned long i = 0; i < Fs.size(); ++i)
                 Gs += pointwise_multiply(Fs[i],conj(As[i]));
             Gs = pointwise_multiply(Gs, reciprocal(Bs+get_regularizer_scale()));
-            ifft_inplace(Gs);
+            ws.fft(Gs, true);
             const double pos = max_point_interpolated(real(Gs)).y();
 
             // update the rectangle's scale
@@ -197,7 +315,7 @@ namespace dlib
 
 
             // Now update the scale filters
-            make_scale_target_location_image(pos, Gs);
+            make_scale_target_location_image(pos, Gs, ws);
             Bs *= (1-get_nu_scale());
             for (unsigned long i = 0; i < Fs.size(); ++i)
             {
@@ -209,24 +327,6 @@ namespace dlib
             return psr;
         }
 
-        template <typename image_type>
-        double update_noscale (
-            const image_type& img
-        )
-        {
-            return update_noscale(img, get_position());
-        }
-
-        template <typename image_type>
-        double update(
-            const image_type& img
-            )
-        {
-            return update(img, get_position());
-        }
-
-    private:
-
         template <typename image_type>
         void make_scale_space(
             const image_type& img,
@@ -318,7 +418,8 @@ namespace dlib
 
         void make_target_location_image (
             const dlib::vector<double,2>& p,
-            matrix<std::complex<double> >& g
+            matrix<std::complex<double> >& g,
+            impl::correlation_tracker_workspace& ws
         ) const
         {
             g.set_size(get_filter_size(), get_filter_size());
@@ -332,14 +433,15 @@ namespace dlib
                     g(r,c) = std::exp(-dist/3.0);
                 }
             }
-            fft_inplace(g);
+            ws.fft(g, false);
             g = conj(g);
         }
 
 
         void make_scale_target_location_image (
             const double scale,
-            matrix<std::complex<double>,0,1>& g
+            matrix<std::complex<double>,0,1>& g,
+            impl::correlation_tracker_workspace& ws
         ) const
         {
             g.set_size(get_num_scale_levels());
@@ -348,7 +450,7 @@ namespace dlib
                 double dist = std::pow((i-scale),2.0);
                 g(i) = std::exp(-dist/1.000);
             }
-            fft_inplace(g);
+            ws.fft(g, false);
             g = conj(g);
         }
 
@@ -373,20 +475,21 @@ namespace dlib
         }
 
 
-        std::vector<matrix<std::complex<double> > > A, F;
+        std::vector<matrix<std::complex<double> > > A;
         matrix<double> B;
 
-        std::vector<matrix<std::complex<double>,0,1> > As, Fs;
+        std::vector<matrix<std::complex<double>,0,1> > As;
         matrix<double,0,1> Bs;
         drectangle position;
 
         matrix<double> mask;
         std::vector<double> scale_cos_mask;
 
-        // G and Gs do not logically contribute to the state of this object.  They are
-        // here just so we can void reallocating them over and over.
-        matrix<std::complex<double> > G;
-        matrix<std::complex<double>,0,1> Gs;
+        // ws does not logically contribute to the state of this object.  It is here
+        // just so we can avoid reallocating its buffers over and over.  When trackers are
+        // run by a multi_correlation_tracker they use its workspaces instead and this one
+        // stays empty.
+        impl::correlation_tracker_workspace ws;
 
         unsigned long filter_size;
         unsigned long num_scale_levels;
@@ -397,6 +500,251 @@ namespace dlib
         double nu_scale;
         double scale_pyramid_alpha;
     };
+
+// ----------------------------------------------------------------------------------------
+
+    class multi_correlation_tracker : noncopyable
+    {
+    public:
+
+        multi_correlation_tracker (
+        ) : num_threads(1) {}
+
+        explicit multi_correlation_tracker (
+            const correlation_tracker& tracker
+        ) : 
+            // Only copy the settings.  We don't want any of the tracker's state or
+            // buffers getting copied into each new target.
+            prototype(impl::fastlog2(tracker.get_filter_size()),
+                      impl::fastlog2(tracker.get_num_scale_levels()),
+                      tracker.get_scale_window_size(),
+                      tracker.get_regularizer_space(),
+                      tracker.get_nu_space(),
+                      tracker.get_regularizer_scale(),
+                      tracker.get_nu_scale(),
+                      tracker.get_scale_pyramid_alpha()),
+            num_threads(1) 
+        {}
+
+        const correlation_tracker& get_prototype_tracker (
+        ) const { return prototype; }
+
+        void set_num_threads (
+            unsigned long num
+        )
+        {
+            num_threads = std::max<unsigned long>(num, 1);
+            // The pool is created lazily the next time we need it.
+            tp.reset();
+        }
+
+        unsigned long get_num_threads (
+        ) const { return num_threads; }
+
+        unsigned long size (
+        ) const { return trackers.size(); }
+
+        const correlation_tracker& operator[] (
+            unsigned long idx
+        ) const
+        {
+            DLIB_ASSERT(idx < size(),
+                "\t const correlation_tracker& multi_correlation_tracker::operator[]"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t idx:    " << idx
+                << "\n\t size(): " << size()
+            );
+            return trackers[idx];
+        }
+
+        drectangle get_position (
+            unsigned long idx
+        ) const
+        {
+            return (*this)[idx].get_position();
+        }
+
+        std::vector<drectangle> get_positions (
+        ) const
+        {
+            std::vector<drectangle> positions;
+            positions.reserve(trackers.size());
+            for (unsigned long i = 0; i < trackers.size(); ++i)
+                positions.push_back(trackers[i].get_position());
+            return positions;
+        }
+
+        void clear (
+        )
+        {
+            trackers.clear();
+        }
+
+        void stop_track (
+            unsigned long idx
+        )
+        {
+            DLIB_ASSERT(idx < size(),
+                "\t void multi_correlation_tracker::stop_track()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t idx:    " << idx
+                << "\n\t size(): " << size()
+            );
+            trackers.erase(trackers.begin()+idx);
+        }
+
+        template <typename image_type>
+        unsigned long start_track (
+            const image_type& img,
+            const drectangle& p
+        )
+        {
+            DLIB_CASSERT(p.is_empty() == false,
+                "\t unsigned long multi_correlation_tracker::start_track()"
+                << "\n\t You can't give an empty rectangle."
+            );
+            prepare_workspaces();
+            trackers.push_back(prototype);
+            trackers.back().start_track(img, p, workspaces[0]);
+            return trackers.size()-1;
+        }
+
+        template <typename image_type>
+        void start_tracks (
+            const image_type& img,
+            const std::vector<drectangle>& rects
+        )
+        {
+            for (unsigned long i = 0; i < rects.size(); ++i)
+            {
+                DLIB_CASSERT(rects[i].is_empty() == false,
+                    "\t void multi_correlation_tracker::start_tracks()"
+                    << "\n\t You can't give an empty rectangle."
+                    << "\n\t i: " << i
+                );
+            }
+
+            const unsigned long first = trackers.size();
+            trackers.resize(first + rects.size(), prototype);
+            for_each_target(first, trackers.size(), [&](unsigned long i, impl::correlation_tracker_workspace& ws)
+            {
+                trackers[i].start_track(img, rects[i-first], ws);
+            });
+        }
+
+        template <typename image_type>
+        std::vector<double> update (
+            const image_type& img
+        )
+        {
+            return update(img, get_positions());
+        }
+
+        template <typename image_type>
+        std::vector<double> update (
+            const image_type& img,
+            const std::vector<drectangle>& guesses
+        )
+        {
+            DLIB_CASSERT(guesses.size() == size(),
+                "\t std::vector<double> multi_correlation_tracker::update()"
+                << "\n\t You must give one guess for each target."
+                << "\n\t guesses.size(): " << guesses.size()
+                << "\n\t size():         " << size()
+            );
+
+            std::vector<double> psr(trackers.size());
+            for_each_target(0, trackers.size(), [&](unsigned long i, impl::correlation_tracker_workspace& ws)
+            {
+                psr[i] = trackers[i].update(img, guesses[i], ws);
+            });
+            return psr;
+        }
+
+        template <typename image_type>
+        std::vector<double> update_noscale (
+            const image_type& img
+        )
+        {
+            return update_noscale(img, get_positions());
+        }
+
+        template <typename image_type>
+        std::vector<double> update_noscale (
+            const image_type& img,
+            const std::vector<drectangle>& guesses
+        )
+        {
+            DLIB_CASSERT(guesses.size() == size(),
+                "\t std::vector<double> multi_correlation_tracker::update_noscale()"
+                << "\n\t You must give one guess for each target."
+                << "\n\t guesses.size(): " << guesses.size()
+                << "\n\t size():         " << size()
+            );
+
+            std::vector<double> psr(trackers.size());
+            for_each_target(0, trackers.size(), [&](unsigned long i, impl::correlation_tracker_workspace& ws)
+            {
+                psr[i] = trackers[i].update_noscale(img, guesses[i], ws);
+            });
+            return psr;
+        }
+
+    private:
+
+        void prepare_workspaces (
+        )
+        {
+            if (workspaces.size() != num_threads)
+                workspaces.resize(num_threads);
+            if (num_threads > 1 && !tp)
+                tp.reset(new thread_pool(num_threads));
+        }
+
+        template <typename funct>
+        void for_each_target (
+            unsigned long begin,
+            unsigned long end,
+            const funct& f
+        )
+        /*!
+            ensures
+                - calls f(i, ws) for all i in the range [begin, end).  The targets are
+                  split into one contiguous block per thread and each thread uses its own
+                  workspace for its whole block.
+        !*/
+        {
+            prepare_workspaces();
+            const unsigned long num = end-begin;
+            if (num_threads == 1 || num <= 1)
+            {
+                for (unsigned long i = begin; i < end; ++i)
+                    f(i, workspaces[0]);
+                return;
+            }
+
+            const unsigned long num_blocks = std::min(num_threads, num);
+            parallel_for(*tp, 0, num_blocks, [&](long block)
+            {
+                const unsigned long block_begin = begin + num*block/num_blocks;
+                const unsigned long block_end = begin + num*(block+1)/num_blocks;
+                for (unsigned long i = block_begin; i < block_end; ++i)
+                    f(i, workspaces[block]);
+            });
+        }
+
+        correlation_tracker prototype;
+        std::vector<correlation_tracker> trackers;
+
+        // The workspaces hold the temporary image and FFT buffers that all the trackers
+        // share.  There is one per thread.
+        unsigned long num_threads;
+        std::vector<impl::correlation_tracker_workspace> workspaces;
+        std::unique_ptr<thread_pool> tp;
+    };
+
+// ----------------------------------------------------------------------------------------
+
 }
 
 #endif // DLIB_CORRELATION_TrACKER_H_
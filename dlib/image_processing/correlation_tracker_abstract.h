@@ -154,6 +154,242 @@ namespace dlib
         !*/
 
     };
+
+// ----------------------------------------------------------------------------------------
+
+    class multi_correlation_tracker : noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object tracks many objects in the same video stream at once.  It holds
+                one correlation_tracker per target and updates them all from each new video
+                frame, splitting the targets over a set of threads.  
+
+                The targets share the temporary buffers and cached FFT twiddle factors the
+                correlation_tracker needs (one set per thread), rather than each target
+                carrying its own.  So tracking many targets uses much less memory than
+                keeping a std::vector<correlation_tracker>.  Either way, each target
+                produces exactly the same results as a correlation_tracker would.
+
+                Targets are identified by their index in this object, in the order they
+                were added.  Calling stop_track(i) shifts the index of every target after
+                i down by one.
+        !*/
+
+    public:
+
+        multi_correlation_tracker (
+        );
+        /*!
+            ensures
+                - #size() == 0
+                - #get_num_threads() == 1
+                - The targets will be tracked by correlation_tracker objects with the
+                  default settings.
+        !*/
+
+        explicit multi_correlation_tracker (
+            const correlation_tracker& tracker
+        );
+        /*!
+            ensures
+                - #size() == 0
+                - #get_num_threads() == 1
+                - The targets will be tracked by correlation_tracker objects with the same
+                  settings as tracker (e.g. the same filter size, number of scale levels,
+                  and so on).  Anything tracker is currently tracking is ignored.
+        !*/
+
+        const correlation_tracker& get_prototype_tracker (
+        ) const;
+        /*!
+            ensures
+                - returns a correlation_tracker with the settings used for each new target.
+        !*/
+
+        void set_num_threads (
+            unsigned long num
+        );
+        /*!
+            ensures
+                - #get_num_threads() == max(num,1)
+        !*/
+
+        unsigned long get_num_threads (
+        ) const;
+        /*!
+            ensures
+                - returns the number of threads used to update the targets.
+        !*/
+
+        unsigned long size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of targets being tracked.
+        !*/
+
+        const correlation_tracker& operator[] (
+            unsigned long idx
+        ) const;
+        /*!
+            requires
+                - idx < size()
+            ensures
+                - returns the tracker for the idx-th target.
+        !*/
+
+        drectangle get_position (
+            unsigned long idx
+        ) const;
+        /*!
+            requires
+                - idx < size()
+            ensures
+                - returns (*this)[idx].get_position()
+        !*/
+
+        std::vector<drectangle> get_positions (
+        ) const;
+        /*!
+            ensures
+                - returns the positions of all the targets.  That is, returns a vector P
+                  such that:
+                    - P.size() == size()
+                    - for all valid i:
+                        - P[i] == get_position(i)
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - #size() == 0
+        !*/
+
+        void stop_track (
+            unsigned long idx
+        );
+        /*!
+            requires
+                - idx < size()
+            ensures
+                - Removes the idx-th target.
+                - #size() == size()-1
+                - The targets after idx move down one index.
+        !*/
+
+        template <
+            typename image_type
+            >
+        unsigned long start_track (
+            const image_type& img,
+            const drectangle& p
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+                - p.is_empty() == false
+            ensures
+                - Starts tracking the object inside p as a new target.  This is just like
+                  calling correlation_tracker::start_track(img,p).
+                - #size() == size()+1
+                - returns the index of the new target.  That is, returns size().
+        !*/
+
+        template <
+            typename image_type
+            >
+        void start_tracks (
+            const image_type& img,
+            const std::vector<drectangle>& rects
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+                - for all valid i:
+                    - rects[i].is_empty() == false
+            ensures
+                - Starts tracking each rectangle in rects as a new target.  The new targets
+                  are initialized in parallel using get_num_threads() threads.
+                - #size() == size()+rects.size()
+                - for all valid i:
+                    - #get_position(size()+i) == rects[i]
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<double> update (
+            const image_type& img,
+            const std::vector<drectangle>& guesses
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+                - guesses.size() == size()
+            ensures
+                - Updates every target with the next video frame, img, in parallel using
+                  get_num_threads() threads.  Each target is updated just as if
+                  correlation_tracker::update(img, guesses[i]) had been called on it.
+                - returns a vector PSR of the peak to side-lobe ratios.  That is:
+                    - PSR.size() == size()
+                    - PSR[i] == the value returned by update() for the i-th target.
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<double> update (
+            const image_type& img
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+            ensures
+                - performs: return update(img, get_positions())
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<double> update_noscale (
+            const image_type& img,
+            const std::vector<drectangle>& guesses
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+                - guesses.size() == size()
+            ensures
+                - This function is just like update(img, guesses) except the targets are
+                  updated with correlation_tracker::update_noscale().  So only their
+                  positions are tracked, not their scale.
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<double> update_noscale (
+            const image_type& img
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+            ensures
+                - performs: return update_noscale(img, get_positions())
+        !*/
+
+    };
+
+// ----------------------------------------------------------------------------------------
+
 }
 
 #endif // DLIB_CORRELATION_TrACKER_ABSTRACT_H_
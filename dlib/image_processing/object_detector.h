@@ -8,6 +8,7 @@
 #include <vector>
 #include "box_overlap_testing.h"
 #include "full_object_detection.h"
+#include "../threads.h"
 
 namespace dlib
 {
@@ -617,6 +618,54 @@ namespace dlib
         return scanner;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_scanner_type,
+        typename image_array_type
+        >
+    void batch_detect (
+        const object_detector<image_scanner_type>& detector,
+        const image_array_type& images,
+        std::vector<std::vector<rect_detection> >& dets,
+        unsigned long num_threads,
+        double adjust_threshold = 0
+    )
+    {
+        dets.resize(images.size());
+        // object_detector::operator() isn't const since it loads the image into its
+        // scanner.  So each block of images gets its own copy of the detector.
+        parallel_for_blocked(num_threads, 0, images.size(), [&](long begin, long end)
+        {
+            object_detector<image_scanner_type> det(detector);
+            for (long i = begin; i < end; ++i)
+                det(images[i], dets[i], adjust_threshold);
+        });
+    }
+
+    template <
+        typename image_scanner_type,
+        typename image_array_type
+        >
+    std::vector<std::vector<rectangle> > batch_detect (
+        const object_detector<image_scanner_type>& detector,
+        const image_array_type& images,
+        unsigned long num_threads,
+        double adjust_threshold = 0
+    )
+    {
+        std::vector<std::vector<rect_detection> > dets;
+        batch_detect(detector, images, dets, num_threads, adjust_threshold);
+        std::vector<std::vector<rectangle> > results(dets.size());
+        for (unsigned long i = 0; i < dets.size(); ++i)
+        {
+            results[i].reserve(dets[i].size());
+            for (auto&& d : dets[i])
+                results[i].push_back(d.rect);
+        }
+        return results;
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -396,6 +396,56 @@ namespace dlib
         provides deserialization support
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_scanner_type,
+        typename image_array_type
+        >
+    void batch_detect (
+        const object_detector<image_scanner_type>& detector,
+        const image_array_type& images,
+        std::vector<std::vector<rect_detection> >& dets,
+        unsigned long num_threads,
+        double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - image_array_type must be an implementation of dlib/array/array_kernel_abstract.h 
+              or std::vector and it must contain objects which can be accepted by
+              detector's operator().
+        ensures
+            - Runs detector over all the given images using num_threads threads.  Each
+              thread works on its own copy of detector, so detector itself isn't modified.
+            - #dets.size() == images.size()
+            - for all valid i:
+                - #dets[i] == the output of detector(images[i], dets[i], adjust_threshold).
+                  That is, #dets[i] contains the detections for images[i] and is exactly
+                  what you would get by running the detector on images[i] yourself.
+    !*/
+
+    template <
+        typename image_scanner_type,
+        typename image_array_type
+        >
+    std::vector<std::vector<rectangle> > batch_detect (
+        const object_detector<image_scanner_type>& detector,
+        const image_array_type& images,
+        unsigned long num_threads,
+        double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - image_array_type must be an implementation of dlib/array/array_kernel_abstract.h 
+              or std::vector and it must contain objects which can be accepted by
+              detector's operator().
+        ensures
+            - This function is identical to the above batch_detect() routine except that
+              it returns just the rectangles.  That is, it returns a vector R such that
+              R.size() == images.size() and R[i] contains the rectangles detected in
+              images[i], sorted in order of decreasing detection confidence.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -8,6 +8,7 @@
 #include "../image_transforms.h"
 #include "../array.h"
 #include "../array2d.h"
+#include "../threads.h"
 #include "object_detector.h"
 
 namespace dlib
@@ -182,6 +183,13 @@ namespace dlib
         inline unsigned long get_min_pyramid_layer_height (
         ) const;
 
+        void set_num_threads (
+            unsigned long num
+        ) { num_threads = num; }
+
+        unsigned long get_num_threads (
+        ) const { return num_threads; }
+
         void detect (
             const feature_vector_type& w,
             std::vector<std::pair<double, rectangle> >& dets,
@@ -393,6 +401,7 @@ namespace dlib
         unsigned long min_pyramid_layer_width;
         unsigned long min_pyramid_layer_height;
         double nuclear_norm_regularization_strength;
+        unsigned long num_threads;
 
         void init()
         {
@@ -404,6 +413,7 @@ namespace dlib
             min_pyramid_layer_width = 64;
             min_pyramid_layer_height = 64;
             nuclear_norm_regularization_strength = 0;
+            num_threads = 1;
         }
 
     };
@@ -569,7 +579,8 @@ namespace dlib
             int filter_cols_padding,
             unsigned long min_pyramid_layer_width,
             unsigned long min_pyramid_layer_height,
-            unsigned long max_pyramid_levels
+            unsigned long max_pyramid_levels,
+            unsigned long num_threads = 1
         )
         {
             unsigned long levels = 0;
@@ -588,7 +599,38 @@ namespace dlib
                 feats.set_max_size(levels);
             feats.set_size(levels);
 
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            if (num_threads > 1 && feats.size() > 1)
+            {
+                // Each level of the image pyramid is made from the previous level, so the
+                // image pyramid itself has to be built serially.  However, that's cheap
+                // compared to the HOG extraction.  So we build the pyramid on this thread
+                // and hand each level to the thread pool as soon as it exists.  This way
+                // the HOG extraction overlaps with building the rest of the pyramid and
+                // each level is read by the next downsampling step and its feature
+                // extraction while it's still in cache.  The levels are given out largest
+                // first, which keeps the load balanced.
+                array<array2d<pixel_type> > pyramid;
+                pyramid.set_max_size(feats.size()-1);
+                pyramid.set_size(feats.size()-1);
+
+                thread_pool tp(num_threads);
+                tp.add_task_by_value([&](){ fe(img, feats[0], cell_size,filter_rows_padding,filter_cols_padding); });
+                for (unsigned long i = 1; i < feats.size(); ++i)
+                {
+                    if (i == 1)
+                        pyr(img, pyramid[0]);
+                    else
+                        pyr(pyramid[i-2], pyramid[i-1]);
+                    tp.add_task_by_value([&,i](){ fe(pyramid[i-1], feats[i], cell_size,filter_rows_padding,filter_cols_padding); });
+                }
+                tp.wait_for_all_tasks();
 
+                DLIB_ASSERT(feats[0].size() == fe.get_num_planes(), 
+                    "Invalid feature extractor used with dlib::scan_fhog_pyramid.  The output does not have the \n"
+                    "indicated number of planes.");
+                return;
+            }
 
             // build our feature pyramid
             fe(img, feats[0], cell_size,filter_rows_padding,filter_cols_padding);
@@ -598,7 +640,6 @@ namespace dlib
 
             if (feats.size() > 1)
             {
-                typedef typename image_traits<image_type>::pixel_type pixel_type;
                 array2d<pixel_type> temp1, temp2;
                 pyr(img, temp1);
                 fe(temp1, feats[1], cell_size,filter_rows_padding,filter_cols_padding);
@@ -632,7 +673,7 @@ namespace dlib
         compute_fhog_window_size(width,height);
         impl::create_fhog_pyramid<Pyramid_type>(img, fe, feats, cell_size, height,
             width, min_pyramid_layer_width, min_pyramid_layer_height,
-            max_pyramid_levels);
+            max_pyramid_levels, num_threads);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -667,6 +708,7 @@ namespace dlib
         min_pyramid_layer_width = item.min_pyramid_layer_width;
         min_pyramid_layer_height = item.min_pyramid_layer_height;
         nuclear_norm_regularization_strength = item.nuclear_norm_regularization_strength;
+        num_threads = item.num_threads;
         fe = item.fe;
     }
 
@@ -773,16 +815,19 @@ namespace dlib
             const int cell_size,
             const int filter_rows_padding,
             const int filter_cols_padding,
-            std::vector<std::pair<double, rectangle> >& dets
+            std::vector<std::pair<double, rectangle> >& dets,
+            const unsigned long num_threads = 1
         ) 
         {
             dets.clear();
 
-            array2d<float> saliency_image;
             pyramid_type pyr;
 
-            // for all pyramid levels
-            for (unsigned long l = 0; l < feats.size(); ++l)
+            auto detect_in_level = [&](
+                unsigned long l,
+                array2d<float>& saliency_image,
+                std::vector<std::pair<double, rectangle> >& level_dets
+            )
             {
                 const rectangle area = apply_filters_to_fhog(w, feats[l], saliency_image);
 
@@ -797,10 +842,40 @@ namespace dlib
                             rectangle rect = fe.feats_to_image(centered_rect(point(c,r),det_box_width,det_box_height), 
                                 cell_size, filter_rows_padding, filter_cols_padding);
                             rect = pyr.rect_up(rect, l);
-                            dets.push_back(std::make_pair(saliency_image[r][c], rect));
+                            level_dets.push_back(std::make_pair(saliency_image[r][c], rect));
                         }
                     }
                 }
+            };
+
+            if (num_threads > 1 && feats.size() > 1)
+            {
+                // Scan all the pyramid levels at once and then gather up the detections in
+                // level order so the output is exactly what the serial version produces.
+                // The levels shrink geometrically, so the first few hold most of the work.
+                // Therefore, each level is its own task and they are given out largest
+                // first.  That way a thread that finishes a big level picks up the next
+                // one rather than a contiguous block of levels being stuck on one thread.
+                std::vector<std::vector<std::pair<double, rectangle> > > level_dets(feats.size());
+                thread_pool tp(num_threads);
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    tp.add_task_by_value([&,l]()
+                    {
+                        array2d<float> saliency_image;
+                        detect_in_level(l, saliency_image, level_dets[l]);
+                    });
+                }
+                tp.wait_for_all_tasks();
+                for (auto&& d : level_dets)
+                    dets.insert(dets.end(), d.begin(), d.end());
+            }
+            else
+            {
+                array2d<float> saliency_image;
+                // for all pyramid levels
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                    detect_in_level(l, saliency_image, dets);
             }
 
             std::sort(dets.rbegin(), dets.rend(), compare_pair_rect);
@@ -852,7 +927,7 @@ namespace dlib
         compute_fhog_window_size(width,height);
 
         impl::detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh,
-            height-2*padding, width-2*padding, cell_size, height, width, dets);
+            height-2*padding, width-2*padding, cell_size, height, width, dets, num_threads);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -1340,6 +1415,474 @@ namespace dlib
         return out_dets;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename pixel_type>
+        typename enable_if_c<pixel_traits<pixel_type>::rgb,bool>::type fhog_pixel_changed (
+            const pixel_type& a,
+            const pixel_type& b,
+            const double thresh
+        )
+        {
+            return std::abs((double)a.red   - (double)b.red)   > thresh ||
+                   std::abs((double)a.green - (double)b.green) > thresh ||
+                   std::abs((double)a.blue  - (double)b.blue)  > thresh;
+        }
+
+        template <typename pixel_type>
+        typename disable_if_c<pixel_traits<pixel_type>::rgb,bool>::type fhog_pixel_changed (
+            const pixel_type& a,
+            const pixel_type& b,
+            const double thresh
+        )
+        {
+            return std::abs((double)get_pixel_intensity(a) - (double)get_pixel_intensity(b)) > thresh;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type
+        >
+    class fhog_video_state : noncopyable
+    {
+    public:
+
+        fhog_video_state (
+        ) : change_threshold(0) { clear(); }
+
+        explicit fhog_video_state (
+            double change_threshold_
+        ) : change_threshold(change_threshold_) 
+        { 
+            // make sure requires clause is not broken
+            DLIB_ASSERT(change_threshold_ >= 0,
+                "\t fhog_video_state::fhog_video_state()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t change_threshold_: " << change_threshold_
+                );
+            clear(); 
+        }
+
+        double get_change_threshold (
+        ) const { return change_threshold; }
+
+        void set_change_threshold (
+            double thresh
+        ) 
+        { 
+            // make sure requires clause is not broken
+            DLIB_ASSERT(thresh >= 0,
+                "\t void fhog_video_state::set_change_threshold()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t thresh: " << thresh
+                );
+            change_threshold = thresh; 
+        }
+
+        void clear (
+        )
+        {
+            reference.clear();
+            feats.clear();
+            cell_size = 0;
+            filter_rows_padding = 0;
+            filter_cols_padding = 0;
+            fraction_recomputed = 1;
+        }
+
+        double get_fraction_recomputed (
+        ) const { return fraction_recomputed; }
+
+        template <
+            typename Pyramid_type,
+            typename feature_extractor_type,
+            typename image_type
+            >
+        const array<array<array2d<float> > >& update (
+            const scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner,
+            const image_type& frame
+        )
+        {
+            COMPILE_TIME_ASSERT((is_same_type<pixel_type, typename image_traits<image_type>::pixel_type>::value));
+
+            const feature_extractor_type& fe = scanner.get_feature_extractor();
+            const int cs = scanner.get_cell_size();
+            const int rows_padding = scanner.get_fhog_window_height();
+            const int cols_padding = scanner.get_fhog_window_width();
+
+            // figure out how many pyramid levels we should be using based on the image
+            // size.  This is the same as what scan_fhog_pyramid::load() does.
+            Pyramid_type pyr;
+            unsigned long levels = 0;
+            rectangle rect = get_rect(frame);
+            do
+            {
+                rect = pyr.rect_down(rect);
+                ++levels;
+            } while (rect.width() >= scanner.get_min_pyramid_layer_width() &&
+                rect.height() >= scanner.get_min_pyramid_layer_height() &&
+                levels < scanner.get_max_pyramid_levels());
+
+            // We can only reuse the previous frame's features if they were computed the
+            // same way and from an image of the same size.
+            const bool reuse = reference.size() == levels && feats.size() == levels &&
+                cell_size == cs && filter_rows_padding == rows_padding &&
+                filter_cols_padding == cols_padding && 
+                get_rect(reference[0]) == get_rect(frame);
+
+            if (!reuse)
+            {
+                reference.set_max_size(levels);
+                reference.set_size(levels);
+                feats.set_max_size(levels);
+                feats.set_size(levels);
+                cell_size = cs;
+                filter_rows_padding = rows_padding;
+                filter_cols_padding = cols_padding;
+            }
+
+            // The image pyramid is rebuilt since it's cheaper than the HOG extraction and
+            // it lets us find the changed pixels at each level exactly.  When
+            // change_threshold == 0 the reference pixels are always the previous frame's
+            // pixels, so if nothing changed in a level then nothing changed in the levels
+            // above it either and we can stop there.  Otherwise a level can be within the
+            // threshold of its reference while the next level isn't, so we have to check
+            // them all.
+            unsigned long cells_recomputed = 0;
+            unsigned long total_cells = 0;
+            bool level_changed = true;
+            array2d<pixel_type> cur, down;
+            for (unsigned long l = 0; l < levels; ++l)
+            {
+                if (level_changed || change_threshold != 0)
+                {
+                    if (l == 0)
+                    {
+                        assign_image(cur, frame);
+                    }
+                    else
+                    {
+                        pyr(cur, down);
+                        swap(cur, down);
+                    }
+
+                    if (reuse)
+                    {
+                        cells_recomputed += update_level(fe, cur, reference[l], feats[l], level_changed);
+                    }
+                    else
+                    {
+                        fe(cur, feats[l], cell_size, filter_rows_padding, filter_cols_padding);
+                        cells_recomputed += feats[l][0].size();
+                        assign_image(reference[l], cur);
+                    }
+                }
+                total_cells += feats[l][0].size();
+            }
+
+            fraction_recomputed = total_cells == 0 ? 0 : cells_recomputed/(double)total_cells;
+            return feats;
+        }
+
+    private:
+
+        template <
+            typename feature_extractor_type
+            >
+        unsigned long update_level (
+            const feature_extractor_type& fe,
+            const array2d<pixel_type>& cur,
+            array2d<pixel_type>& ref,
+            array<array2d<float> >& level_feats,
+            bool& any_changed
+        )
+        /*!
+            requires
+                - ref holds, for each cell_size*cell_size block of pixels, the pixels
+                  that the features depending on that block were last computed from.
+            ensures
+                - recomputes the parts of level_feats that depend on blocks containing
+                  pixels that differ between cur and ref by more than change_threshold.
+                - copies those changed blocks from cur into #ref.  Every feature that
+                  depends on a changed block is recomputed, so #ref still satisfies the
+                  requires clause.  We don't update the other blocks, even if they were
+                  used to recompute features, since features that weren't recomputed may
+                  depend on them too.  This way a region that changes slowly is compared
+                  to the pixels its features came from rather than to the previous frame,
+                  so small changes can't add up without eventually being noticed.
+                - #any_changed == true if any blocks changed.
+                - returns the number of feature cells that were recomputed.
+        !*/
+        {
+            const long fnr = level_feats[0].nr();
+            const long fnc = level_feats[0].nc();
+
+            // Find which cell_size*cell_size blocks of the image contain changed pixels.
+            const long bnr = (cur.nr()+cell_size-1)/cell_size;
+            const long bnc = (cur.nc()+cell_size-1)/cell_size;
+            matrix<unsigned char> changed(bnr, bnc);
+            changed = 0;
+            any_changed = false;
+            for (long r = 0; r < cur.nr(); ++r)
+            {
+                const long br = r/cell_size;
+                for (long bc = 0; bc < bnc; ++bc)
+                {
+                    if (changed(br,bc))
+                        continue;
+                    const long end = std::min(cur.nc(), (bc+1)*cell_size);
+                    for (long c = bc*cell_size; c < end; ++c)
+                    {
+                        if (impl::fhog_pixel_changed(cur[r][c], ref[r][c], change_threshold))
+                        {
+                            changed(br,bc) = 1;
+                            any_changed = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (!any_changed)
+                return 0;
+
+            // A HOG cell depends on pixels up to a few cells away since the histogram
+            // votes are interpolated between cells and then normalized over 2x2 blocks
+            // of cells.  These margins are comfortably larger than that.
+            const long dependency_margin = 3*cell_size+3;
+            const long crop_margin = 4*cell_size+4;
+            const long tile_size = 16;
+
+            // Now mark all the tiles of level_feats that need to be recomputed.
+            const long tnr = (fnr+tile_size-1)/tile_size;
+            const long tnc = (fnc+tile_size-1)/tile_size;
+            matrix<unsigned char> dirty(tnr, tnc);
+            long num_dirty = 0;
+            for (long tr = 0; tr < tnr; ++tr)
+            {
+                for (long tc = 0; tc < tnc; ++tc)
+                {
+                    const rectangle tile = get_tile(tr, tc, tile_size, fnr, fnc);
+                    rectangle area = grow_rect(fe.feats_to_image(tile, cell_size, filter_rows_padding,
+                            filter_cols_padding), dependency_margin);
+                    area = area.intersect(get_rect(cur));
+                    dirty(tr,tc) = 0;
+                    if (area.is_empty())
+                        continue;
+                    for (long br = area.top()/cell_size; br <= area.bottom()/cell_size && !dirty(tr,tc); ++br)
+                    {
+                        for (long bc = area.left()/cell_size; bc <= area.right()/cell_size; ++bc)
+                        {
+                            if (changed(br,bc))
+                            {
+                                dirty(tr,tc) = 1;
+                                ++num_dirty;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // If most of the image changed it's cheaper to just redo the whole thing.
+            if (num_dirty > tnr*tnc/2)
+            {
+                fe(cur, level_feats, cell_size, filter_rows_padding, filter_cols_padding);
+                assign_image(ref, cur);
+                return fnr*fnc;
+            }
+
+            // Recompute each horizontal run of dirty tiles by extracting features from a
+            // crop of the image that contains everything those tiles depend on.  The crop
+            // is aligned to the cell grid so its HOG cells line up with the full image's.
+            unsigned long cells_recomputed = 0;
+            array<array2d<float> > crop_feats;
+            for (long tr = 0; tr < tnr; ++tr)
+            {
+                for (long tc = 0; tc < tnc; ++tc)
+                {
+                    if (!dirty(tr,tc))
+                        continue;
+                    const long first = tc;
+                    while (tc+1 < tnc && dirty(tr,tc+1))
+                        ++tc;
+                    const rectangle run = get_tile(tr, first, tile_size, fnr, fnc) + get_tile(tr, tc, tile_size, fnr, fnc);
+
+                    const rectangle crop = aligned_crop(grow_rect(fe.feats_to_image(run, cell_size,
+                                filter_rows_padding, filter_cols_padding), crop_margin), get_rect(cur));
+                    fe(sub_image(cur, crop), crop_feats, cell_size, filter_rows_padding, filter_cols_padding);
+
+                    // Find where the crop's features go in level_feats.  We do this by
+                    // mapping a point in the middle of a cell, which avoids any rounding
+                    // issues in image_to_feats().
+                    const rectangle probe(point(4*cell_size + cell_size/2, 4*cell_size + cell_size/2));
+                    const point offset = fe.image_to_feats(translate_rect(probe, crop.tl_corner()), cell_size, 
+                            filter_rows_padding, filter_cols_padding).tl_corner() -
+                        fe.image_to_feats(probe, cell_size, filter_rows_padding, filter_cols_padding).tl_corner();
+                    if (crop_feats.size() != level_feats.size() || 
+                        !get_rect(crop_feats[0]).contains(translate_rect(run, -offset)))
+                    {
+                        // This shouldn't happen for any reasonable feature extractor, but
+                        // if it does we can still give the right answer.
+                        fe(cur, level_feats, cell_size, filter_rows_padding, filter_cols_padding);
+                        assign_image(ref, cur);
+                        return fnr*fnc;
+                    }
+
+                    for (unsigned long k = 0; k < level_feats.size(); ++k)
+                    {
+                        for (long r = run.top(); r <= run.bottom(); ++r)
+                        {
+                            for (long c = run.left(); c <= run.right(); ++c)
+                                level_feats[k][r][c] = crop_feats[k][r-offset.y()][c-offset.x()];
+                        }
+                    }
+                    cells_recomputed += run.area();
+                }
+            }
+
+            for (long r = 0; r < cur.nr(); ++r)
+            {
+                const long br = r/cell_size;
+                for (long c = 0; c < cur.nc(); ++c)
+                {
+                    if (changed(br, c/cell_size))
+                        ref[r][c] = cur[r][c];
+                }
+            }
+            return cells_recomputed;
+        }
+
+        static rectangle get_tile (
+            long tr,
+            long tc,
+            long tile_size,
+            long nr,
+            long nc
+        ) 
+        {
+            return rectangle(tc*tile_size, tr*tile_size, 
+                             std::min(nc, (tc+1)*tile_size)-1,
+                             std::min(nr, (tr+1)*tile_size)-1);
+        }
+
+        rectangle aligned_crop (
+            rectangle rect,
+            const rectangle& img_rect
+        ) const
+        /*!
+            ensures
+                - returns a rectangle that contains rect, is contained in img_rect, and has
+                  its top left corner on the cell grid.  Moreover, the width and height
+                  are multiples of cell_size unless the rectangle runs into the right or
+                  bottom edge of img_rect.
+        !*/
+        {
+            rect = rect.intersect(img_rect);
+            rect.left() = rect.left()/cell_size*cell_size;
+            rect.top() = rect.top()/cell_size*cell_size;
+            rect.right() = rect.left() + (rect.width()+cell_size-1)/cell_size*cell_size - 1;
+            rect.bottom() = rect.top() + (rect.height()+cell_size-1)/cell_size*cell_size - 1;
+            return rect.intersect(img_rect);
+        }
+
+        // The image pyramid the features in feats were computed from.  When
+        // change_threshold != 0 this isn't necessarily the previous frame's pyramid.  See
+        // update_level() for details.
+        array<array2d<pixel_type> > reference;
+        array<array<array2d<float> > > feats;
+        int cell_size;
+        int filter_rows_padding;
+        int filter_cols_padding;
+        double change_threshold;
+        double fraction_recomputed;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_type
+        >
+    void detect_in_video_frame (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+        const image_type& frame,
+        fhog_video_state<typename image_traits<image_type>::pixel_type>& state,
+        std::vector<rect_detection>& dets,
+        const double adjust_threshold = 0
+    )
+    {
+        typedef scan_fhog_pyramid<Pyramid_type,feature_extractor_type> scanner_type;
+        const scanner_type& scanner = detector.get_scanner();
+
+        const array<array<array2d<float> > >& feats = state.update(scanner, frame);
+
+        const unsigned long det_box_width  = scanner.get_fhog_window_width()  - 2*scanner.get_padding();
+        const unsigned long det_box_height = scanner.get_fhog_window_height() - 2*scanner.get_padding();
+        std::vector<std::pair<double, rectangle> > temp_dets;
+        std::vector<rect_detection> dets_accum;
+        for (unsigned long i = 0; i < detector.num_detectors(); ++i)
+        {
+            const double thresh = detector.get_processed_w(i).w(scanner.get_num_dimensions());
+
+            impl::detect_from_fhog_pyramid<Pyramid_type>(feats, scanner.get_feature_extractor(),
+                detector.get_processed_w(i).get_detect_argument(), thresh+adjust_threshold,
+                det_box_height, det_box_width, scanner.get_cell_size(),
+                scanner.get_fhog_window_height(), scanner.get_fhog_window_width(), temp_dets,
+                scanner.get_num_threads());
+
+            for (unsigned long j = 0; j < temp_dets.size(); ++j)
+            {
+                rect_detection temp;
+                temp.detection_confidence = temp_dets[j].first-thresh;
+                temp.weight_index = i;
+                temp.rect = temp_dets[j].second;
+                dets_accum.push_back(temp);
+            }
+        }
+
+        // Do non-max suppression the same way object_detector does.
+        const test_box_overlap tester = detector.get_overlap_tester();
+        dets.clear();
+        if (detector.num_detectors() > 1)
+            std::sort(dets_accum.rbegin(), dets_accum.rend());
+        for (unsigned long i = 0; i < dets_accum.size(); ++i)
+        {
+            bool overlaps = false;
+            for (unsigned long j = 0; j < dets.size() && !overlaps; ++j)
+                overlaps = tester(dets[j].rect, dets_accum[i].rect);
+            if (!overlaps)
+                dets.push_back(dets_accum[i]);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_type
+        >
+    std::vector<rectangle> detect_in_video_frame (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+        const image_type& frame,
+        fhog_video_state<typename image_traits<image_type>::pixel_type>& state,
+        const double adjust_threshold = 0
+    )
+    {
+        std::vector<rect_detection> dets;
+        detect_in_video_frame(detector, frame, state, dets, adjust_threshold);
+        std::vector<rectangle> out_dets;
+        out_dets.reserve(dets.size());
+        for (unsigned long i = 0; i < dets.size(); ++i)
+            out_dets.push_back(dets[i].rect);
+        return out_dets;
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 
@@ -218,6 +218,7 @@ namespace dlib
                 - get_min_pyramid_layer_width()  == 64
                 - get_min_pyramid_layer_height() == 64
                 - get_nuclear_norm_regularization_strength() == 0
+                - get_num_threads() == 1
 
             WHAT THIS OBJECT REPRESENTS
                 This object is a tool for running a fixed sized sliding window classifier
@@ -501,6 +502,27 @@ namespace dlib
                   value returned by this function.
         !*/
 
+        void set_num_threads (
+            unsigned long num
+        );
+        /*!
+            ensures
+                - #get_num_threads() == num
+        !*/
+
+        unsigned long get_num_threads (
+        ) const;
+        /*!
+            ensures
+                - returns the number of threads used by load() and detect().  If this is
+                  greater than 1 then load() extracts the HOG features for all the pyramid
+                  levels in parallel, starting on each level as soon as it has been
+                  downsampled, and detect() scans the pyramid levels in parallel.
+                  The outputs are the same regardless of the number of threads used.
+                - Note that the number of threads is a run time setting and is therefore
+                  not saved by serialize().
+        !*/
+
         fhog_filterbank build_fhog_filterbank (
             const feature_vector_type& weights 
         ) const;
@@ -775,6 +797,193 @@ namespace dlib
               requiring a mutex lock.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type
+        >
+    class fhog_video_state : noncopyable
+    {
+        /*!
+            REQUIREMENTS ON pixel_type
+                pixel_traits<pixel_type> must be defined.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the HOG feature pyramid computed from the previous frames
+                of a video, along with the image pixels those features were computed from.
+                It is used by detect_in_video_frame() to avoid recomputing the HOG features
+                for the parts of each new frame that haven't changed.  
+
+                In particular, each time a new frame is given to update() the image
+                pyramid for it is built and compared, cell by cell, to the pixels the
+                stored features were last computed from.  The HOG features are then
+                recomputed only in tiles that depend on cells containing a pixel which
+                changed by more than get_change_threshold().  For RGB images a pixel
+                changes if any of its color channels does, otherwise the pixel intensities
+                are compared.  Since the HOG features are only locally dependent on the
+                image, when get_change_threshold() == 0 the output is the same as computing
+                the features from scratch.  It is identical bit-for-bit if the cell size is
+                a power of 2, otherwise it's the same up to floating point rounding.
+                Larger thresholds let small amounts of noise in a mostly static scene be
+                ignored, at the cost of using slightly stale features.  However, since
+                each frame is compared to the pixels the features came from, rather than to
+                the previous frame, the staleness doesn't grow over time.  Every feature is
+                computed from pixels that differ from the current frame by at most 2 times
+                get_change_threshold(), even if the scene changes slowly over many frames.
+        !*/
+
+    public:
+
+        fhog_video_state (
+        );
+        /*!
+            ensures
+                - #get_change_threshold() == 0
+                - #get_fraction_recomputed() == 1
+                - This object doesn't hold a previous frame.
+        !*/
+
+        explicit fhog_video_state (
+            double change_threshold
+        );
+        /*!
+            requires
+                - change_threshold >= 0
+            ensures
+                - #get_change_threshold() == change_threshold
+                - #get_fraction_recomputed() == 1
+                - This object doesn't hold a previous frame.
+        !*/
+
+        double get_change_threshold (
+        ) const;
+        /*!
+            ensures
+                - returns the amount by which a pixel must change between frames before we
+                  consider it changed and recompute the HOG features that depend on it.
+        !*/
+
+        void set_change_threshold (
+            double thresh
+        );
+        /*!
+            requires
+                - thresh >= 0
+            ensures
+                - #get_change_threshold() == thresh
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - Forgets the previous frame.  So the next call to update() will compute
+                  all the HOG features from scratch.  You should call this when there is a
+                  cut in the video.
+                - #get_change_threshold() == get_change_threshold()
+        !*/
+
+        double get_fraction_recomputed (
+        ) const;
+        /*!
+            ensures
+                - returns the fraction of HOG cells, out of all the HOG cells in the
+                  feature pyramid, that were recomputed by the last call to update().  So a
+                  value of 1 means everything was recomputed.
+        !*/
+
+        template <
+            typename Pyramid_type,
+            typename feature_extractor_type,
+            typename image_type
+            >
+        const array<array<array2d<float> > >& update (
+            const scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner,
+            const image_type& frame
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+                - image_traits<image_type>::pixel_type == pixel_type
+                - The feature extractor must be translation invariant with respect to the
+                  cell grid.  That is, computing features on a crop of an image whose top
+                  left corner is a multiple of scanner.get_cell_size() must give the same
+                  features, away from the crop's border, as computing them on the whole
+                  image.  default_fhog_feature_extractor has this property.
+            ensures
+                - Computes the HOG feature pyramid for frame, using the feature extraction
+                  and pyramid settings from scanner, and returns it.  This is the same
+                  feature pyramid scanner.load(frame) would compute.  However, if the
+                  previous call to update() used a frame of the same size and a scanner
+                  with the same settings then only the parts of the pyramid that depend on
+                  changed pixels are recomputed. 
+                - #get_fraction_recomputed() == the fraction of the feature pyramid that
+                  had to be recomputed.
+                - The returned reference is valid until the next call to update() or
+                  clear().
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_type
+        >
+    void detect_in_video_frame (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type>>& detector,
+        const image_type& frame,
+        fhog_video_state<typename image_traits<image_type>::pixel_type>& state,
+        std::vector<rect_detection>& dets,
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - state is only used with consecutive frames from one video and with detectors
+              that all have the same scanner settings.  If that isn't the case then call
+              state.clear() first.
+        ensures
+            - Runs detector on frame and stores the detections into #dets.  This is meant
+              to be used on consecutive frames of a video.  It uses state to reuse the HOG
+              features computed for the previous frame in regions of the image that
+              haven't changed (see fhog_video_state for details).  So on mostly static
+              scenes this is much faster than calling detector(frame, dets, adjust_threshold).
+            - If state.get_change_threshold() == 0 and the detector's cell size is a power
+              of 2 then #dets is exactly the same as the output of detector(frame, dets,
+              adjust_threshold).
+            - #state holds frame and its HOG features so it can be used with the next
+              frame.
+            - The features are extracted serially, but the filtering is done using
+              detector.get_scanner().get_num_threads() threads.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_type
+        >
+    std::vector<rectangle> detect_in_video_frame (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type>>& detector,
+        const image_type& frame,
+        fhog_video_state<typename image_traits<image_type>::pixel_type>& state,
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+        ensures
+            - This function just calls the above detect_in_video_frame() routine and
+              copies the output dets into a vector<rectangle> object and returns it.
+              Therefore, this function is provided for convenience.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
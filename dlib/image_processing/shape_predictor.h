@@ -12,6 +12,7 @@
 #include "../console_progress_indicator.h"
 #include "../statistics.h"
 #include "../threads.h"
+#include "../simd.h"
 #include <utility>
 
 namespace dlib
@@ -102,6 +103,245 @@ namespace dlib
             }
         };
 
+    // ------------------------------------------------------------------------------------
+
+        inline void prefetch_for_read (
+            const void* ptr
+        )
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(ptr);
+#elif defined(DLIB_HAVE_SSE2)
+            _mm_prefetch((const char*)ptr, _MM_HINT_T0);
+#else
+            (void)ptr;
+#endif
+        }
+
+        class compiled_forest
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object is a flattened copy of one level of a shape_predictor's
+                    cascade.  All the split nodes of all the trees are stored in one
+                    contiguous array, as are all the leaf vectors, with each leaf padded to
+                    a multiple of 8 floats.  This lets operator() walk several trees in
+                    lockstep, prefetch the leaves they land in, and add those leaves into
+                    the current shape with SIMD instructions.  The result is bit for bit
+                    identical to summing the outputs of the original regression_tree
+                    objects one after another.
+
+                    Only forests where every tree has the same depth can be compiled.
+                    For any other forest is_compiled() returns false and the caller should
+                    use the original trees.  Otherwise the compiled form holds everything
+                    in the original trees, which can be recovered exactly with get_trees().
+                    So the original trees don't need to be kept around.
+            !*/
+        public:
+
+            compiled_forest (
+            ) : depth(0), num_trees(0), dims(0), padded_dims(0) {}
+
+            compiled_forest (
+                const std::vector<regression_tree>& forest
+            ) : depth(0), num_trees(0), dims(0), padded_dims(0)
+            {
+                if (forest.size() == 0)
+                    return;
+
+                const unsigned long num_leaves = forest[0].num_leaves();
+                if (num_leaves == 0 || (num_leaves&(num_leaves-1)) != 0)
+                    return;
+                dims = forest[0].leaf_values[0].size();
+                for (unsigned long i = 0; i < forest.size(); ++i)
+                {
+                    if (forest[i].num_leaves() != num_leaves ||
+                        forest[i].splits.size()+1 != num_leaves)
+                        return;
+                    for (unsigned long j = 0; j < num_leaves; ++j)
+                    {
+                        if (forest[i].leaf_values[j].size() != (long)dims)
+                            return;
+                    }
+                    for (unsigned long j = 0; j+1 < num_leaves; ++j)
+                    {
+                        if (forest[i].splits[j].idx1 > std::numeric_limits<uint32>::max() ||
+                            forest[i].splits[j].idx2 > std::numeric_limits<uint32>::max())
+                            return;
+                    }
+                }
+
+                while ((1UL<<depth) < num_leaves)
+                    ++depth;
+                num_trees = forest.size();
+                padded_dims = (dims+7)/8*8;
+
+                const unsigned long num_splits = num_leaves-1;
+                splits.resize(num_trees*num_splits);
+                leaves.assign(num_trees*num_leaves*padded_dims, 0);
+                for (unsigned long i = 0; i < num_trees; ++i)
+                {
+                    for (unsigned long j = 0; j < num_splits; ++j)
+                    {
+                        node& n = splits[i*num_splits + j];
+                        n.idx1 = forest[i].splits[j].idx1;
+                        n.idx2 = forest[i].splits[j].idx2;
+                        n.thresh = forest[i].splits[j].thresh;
+                    }
+                    for (unsigned long j = 0; j < num_leaves; ++j)
+                    {
+                        float* leaf = &leaves[(i*num_leaves + j)*padded_dims];
+                        for (unsigned long k = 0; k < dims; ++k)
+                            leaf[k] = forest[i].leaf_values[j](k);
+                    }
+                }
+            }
+
+            bool is_compiled (
+            ) const { return num_trees != 0; }
+
+            unsigned long num_leaves (
+            ) const { return 1UL<<depth; }
+
+            unsigned long num_features (
+            ) const { return num_trees*num_leaves(); }
+
+            void get_trees (
+                std::vector<regression_tree>& forest
+            ) const
+            /*!
+                requires
+                    - is_compiled() == true
+                ensures
+                    - #forest == the forest this object was compiled from.
+            !*/
+            {
+                const unsigned long num_splits = num_leaves()-1;
+                forest.resize(num_trees);
+                for (unsigned long i = 0; i < num_trees; ++i)
+                {
+                    forest[i].splits.resize(num_splits);
+                    for (unsigned long j = 0; j < num_splits; ++j)
+                    {
+                        const node& n = splits[i*num_splits + j];
+                        forest[i].splits[j].idx1 = n.idx1;
+                        forest[i].splits[j].idx2 = n.idx2;
+                        forest[i].splits[j].thresh = n.thresh;
+                    }
+                    forest[i].leaf_values.resize(num_leaves());
+                    for (unsigned long j = 0; j < num_leaves(); ++j)
+                    {
+                        const float* leaf = &leaves[(i*num_leaves() + j)*padded_dims];
+                        forest[i].leaf_values[j].set_size(dims);
+                        for (unsigned long k = 0; k < dims; ++k)
+                            forest[i].leaf_values[j](k) = leaf[k];
+                    }
+                }
+            }
+
+            unsigned long padded_shape_size (
+            ) const { return padded_dims; }
+
+            void operator() (
+                const std::vector<float>& feature_pixel_values,
+                float* shape,
+                std::vector<unsigned long>& leaf_idx
+            ) const
+            /*!
+                requires
+                    - is_compiled() == true
+                    - All the index values in the trees are less than feature_pixel_values.size()
+                    - shape points to padded_shape_size() floats.
+                ensures
+                    - adds the leaf vector selected by each tree, in tree order, to shape.
+                      The padding elements of the leaves are 0 so they don't change the
+                      padding elements of shape.
+                    - #leaf_idx.size() == the number of trees in this forest
+                    - #leaf_idx[i] == the leaf index selected by the i-th tree.
+            !*/
+            {
+                const float* fv = &feature_pixel_values[0];
+                const unsigned long num_splits = num_leaves()-1;
+                const unsigned long leaf_stride = num_leaves()*padded_dims;
+                const long lanes = 8;
+
+                // First walk all the trees.  Each tree is an independent chain of
+                // dependent loads so we walk them in groups, in lockstep, to keep the CPU
+                // busy while it waits on the caches.
+                unsigned long idx[lanes];
+                leaf_idx.resize(num_trees);
+                for (unsigned long t = 0; t < num_trees; t += lanes)
+                {
+                    const long n = std::min<long>(lanes, num_trees-t);
+                    const node* tree = &splits[t*num_splits];
+                    for (long l = 0; l < n; ++l)
+                        idx[l] = 0;
+                    for (unsigned long d = 0; d < depth; ++d)
+                    {
+                        for (long l = 0; l < n; ++l)
+                        {
+                            // The split outcomes are essentially random so we avoid
+                            // branching on them.  left_child(i) == right_child(i)-1.
+                            const node& s = tree[l*num_splits + idx[l]];
+                            idx[l] = right_child(idx[l]) - (fv[s.idx1] - fv[s.idx2] > s.thresh);
+                        }
+                    }
+                    for (long l = 0; l < n; ++l)
+                    {
+                        idx[l] -= num_splits;
+                        leaf_idx[t+l] = idx[l];
+                    }
+                }
+
+                // Now sum the selected leaves into shape.  The leaves are where nearly
+                // all the memory traffic is, so we prefetch a few trees ahead of the one
+                // we are adding.  Each element still receives the leaves in tree order so
+                // the floating point results are the same as using the original trees.
+                const unsigned long prefetch_distance = 4;
+                for (unsigned long t = 0; t < std::min(prefetch_distance, num_trees); ++t)
+                    prefetch_leaf(&leaves[t*leaf_stride + leaf_idx[t]*padded_dims]);
+                for (unsigned long t = 0; t < num_trees; ++t)
+                {
+                    if (t+prefetch_distance < num_trees)
+                        prefetch_leaf(&leaves[(t+prefetch_distance)*leaf_stride + leaf_idx[t+prefetch_distance]*padded_dims]);
+                    const float* leaf = &leaves[t*leaf_stride + leaf_idx[t]*padded_dims];
+                    for (unsigned long k = 0; k < padded_dims; k += 8)
+                    {
+                        simd8f acc, val;
+                        acc.load(shape+k);
+                        val.load(leaf+k);
+                        acc += val;
+                        acc.store(shape+k);
+                    }
+                }
+            }
+
+        private:
+
+            void prefetch_leaf (
+                const float* leaf
+            ) const
+            {
+                // pull in every cache line of the leaf
+                for (unsigned long k = 0; k < padded_dims; k += 16)
+                    prefetch_for_read(leaf+k);
+            }
+
+            struct node
+            {
+                uint32 idx1;
+                uint32 idx2;
+                float thresh;
+            };
+
+            unsigned long depth;
+            unsigned long num_trees;
+            unsigned long dims;
+            unsigned long padded_dims;
+            std::vector<node> splits;
+            std::vector<float> leaves;
+        };
+
     // ------------------------------------------------------------------------------------
 
         inline vector<float,2> location (
@@ -319,6 +559,7 @@ namespace dlib
             // their representations relative to the initial shape now and save it.
             for (unsigned long i = 0; i < pixel_coordinates.size(); ++i)
                 impl::create_shape_relative_encoding(initial_shape, pixel_coordinates[i], anchor_idx[i], deltas[i]);
+            compile_forests();
         }
 
         unsigned long num_parts (
@@ -332,8 +573,11 @@ namespace dlib
         {
             unsigned long num = 0;
             for (unsigned long iter = 0; iter < forests.size(); ++iter)
+            {
+                num += compiled[iter].num_features();
                 for (unsigned long i = 0; i < forests[iter].size(); ++i)
                     num += forests[iter][i].num_leaves();
+            }
             return num;
         }
 
@@ -343,25 +587,8 @@ namespace dlib
             const rectangle& rect
         ) const
         {
-            using namespace impl;
-            matrix<float,0,1> current_shape = initial_shape;
-            std::vector<float> feature_pixel_values;
-            for (unsigned long iter = 0; iter < forests.size(); ++iter)
-            {
-                extract_feature_pixel_values(img, rect, current_shape, initial_shape,
-                                             anchor_idx[iter], deltas[iter], feature_pixel_values);
-                unsigned long leaf_idx;
-                // evaluate all the trees at this level of the cascade.
-                for (unsigned long i = 0; i < forests[iter].size(); ++i)
-                    current_shape += forests[iter][i](feature_pixel_values, leaf_idx);
-            }
-
-            // convert the current_shape into a full_object_detection
-            const point_transform_affine tform_to_img = unnormalizing_tform(rect);
-            std::vector<point> parts(current_shape.size()/2);
-            for (unsigned long i = 0; i < parts.size(); ++i)
-                parts[i] = tform_to_img(location(current_shape, i));
-            return full_object_detection(rect, parts);
+            scratch_buffers scratch;
+            return predict(img, rect, 0, scratch);
         }
 
         template <typename image_type, typename T, typename U>
@@ -371,23 +598,165 @@ namespace dlib
             std::vector<std::pair<T,U> >& feats
         ) const
         {
+            scratch_buffers scratch;
+            std::vector<unsigned long> leaves;
+            full_object_detection det = predict(img, rect, &leaves, scratch);
             feats.clear();
+            feats.reserve(leaves.size());
+            for (unsigned long i = 0; i < leaves.size(); ++i)
+                feats.push_back(std::make_pair(leaves[i], 1));
+            return det;
+        }
+
+        template <typename image_type>
+        std::vector<full_object_detection> operator()(
+            const image_type& img,
+            const std::vector<rectangle>& rects,
+            unsigned long num_threads = 1
+        ) const
+        {
+            std::vector<full_object_detection> dets(rects.size());
+            parallel_for_blocked(num_threads, 0, rects.size(), [&](long begin, long end)
+            {
+                scratch_buffers scratch;
+                for (long i = begin; i < end; ++i)
+                    dets[i] = predict(img, rects[i], 0, scratch);
+            });
+            return dets;
+        }
+
+        template <typename image_array_type>
+        std::vector<std::vector<full_object_detection> > operator()(
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& rects,
+            unsigned long num_threads = 1
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(images.size() == rects.size(),
+                "\t std::vector<std::vector<full_object_detection> > shape_predictor::operator()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t images.size(): " << images.size()
+                << "\n\t rects.size():  " << rects.size()
+            );
+
+            // Flatten all the (image, rect) pairs into one list of jobs so the work is
+            // balanced across threads even if the faces are spread unevenly over the
+            // images.
+            std::vector<std::pair<unsigned long,unsigned long> > jobs;
+            std::vector<std::vector<full_object_detection> > dets(rects.size());
+            for (unsigned long i = 0; i < rects.size(); ++i)
+            {
+                dets[i].resize(rects[i].size());
+                for (unsigned long j = 0; j < rects[i].size(); ++j)
+                    jobs.push_back(std::make_pair(i,j));
+            }
+
+            parallel_for_blocked(num_threads, 0, jobs.size(), [&](long begin, long end)
+            {
+                scratch_buffers scratch;
+                for (long k = begin; k < end; ++k)
+                {
+                    const unsigned long i = jobs[k].first;
+                    const unsigned long j = jobs[k].second;
+                    dets[i][j] = predict(images[i], rects[i][j], 0, scratch);
+                }
+            });
+            return dets;
+        }
+
+        friend void serialize (const shape_predictor& item, std::ostream& out);
+
+        friend void deserialize (shape_predictor& item, std::istream& in);
+
+    private:
+
+        void compile_forests (
+        )
+        {
+            compiled.clear();
+            for (unsigned long iter = 0; iter < forests.size(); ++iter)
+                compile_level(iter);
+        }
+
+        void compile_level (
+            unsigned long iter
+        )
+        /*!
+            requires
+                - compiled.size() == iter
+            ensures
+                - appends the compiled form of forests[iter] to compiled.  If it could be
+                  compiled then forests[iter] is freed since the compiled form holds the
+                  same information.
+        !*/
+        {
+            compiled.push_back(impl::compiled_forest(forests[iter]));
+            if (compiled[iter].is_compiled())
+                std::vector<impl::regression_tree>().swap(forests[iter]);
+        }
+
+        struct scratch_buffers
+        {
+            // Working memory for predict().  Reusing it between calls avoids allocating
+            // these vectors again for every face.
+            std::vector<float> feature_pixel_values;
+            std::vector<float> padded_shape;
+            std::vector<unsigned long> leaf_idx;
+        };
+
+        template <typename image_type>
+        full_object_detection predict (
+            const image_type& img,
+            const rectangle& rect,
+            std::vector<unsigned long>* leaves,
+            scratch_buffers& scratch
+        ) const
+        /*!
+            ensures
+                - runs the cascade on the given rect and returns the resulting shape.
+                - if (leaves != 0) then
+                    - #*leaves contains, in tree order, the index of the leaf each tree
+                      selected, offset so that it indexes into the num_features()
+                      dimensional feature space.
+        !*/
+        {
             using namespace impl;
+            if (leaves)
+                leaves->clear();
             matrix<float,0,1> current_shape = initial_shape;
-            std::vector<float> feature_pixel_values;
+            std::vector<float>& feature_pixel_values = scratch.feature_pixel_values;
+            std::vector<float>& padded_shape = scratch.padded_shape;
+            std::vector<unsigned long>& leaf_idx = scratch.leaf_idx;
             unsigned long feat_offset = 0;
             for (unsigned long iter = 0; iter < forests.size(); ++iter)
             {
                 extract_feature_pixel_values(img, rect, current_shape, initial_shape,
                                              anchor_idx[iter], deltas[iter], feature_pixel_values);
                 // evaluate all the trees at this level of the cascade.
-                for (unsigned long i = 0; i < forests[iter].size(); ++i)
+                if (compiled[iter].is_compiled())
                 {
-                    unsigned long leaf_idx;
-                    current_shape += forests[iter][i](feature_pixel_values, leaf_idx);
-
-                    feats.push_back(std::make_pair(feat_offset+leaf_idx, 1));
-                    feat_offset += forests[iter][i].num_leaves();
+                    padded_shape.assign(compiled[iter].padded_shape_size(), 0);
+                    std::copy(current_shape.begin(), current_shape.end(), padded_shape.begin());
+                    compiled[iter](feature_pixel_values, &padded_shape[0], leaf_idx);
+                    for (unsigned long i = 0; i < leaf_idx.size(); ++i)
+                    {
+                        if (leaves)
+                            leaves->push_back(feat_offset + leaf_idx[i]);
+                        feat_offset += compiled[iter].num_leaves();
+                    }
+                    std::copy(padded_shape.begin(), padded_shape.begin()+current_shape.size(), current_shape.begin());
+                }
+                else
+                {
+                    for (unsigned long i = 0; i < forests[iter].size(); ++i)
+                    {
+                        unsigned long idx;
+                        current_shape += forests[iter][i](feature_pixel_values, idx);
+                        if (leaves)
+                            leaves->push_back(feat_offset + idx);
+                        feat_offset += forests[iter][i].num_leaves();
+                    }
                 }
             }
 
@@ -399,15 +768,13 @@ namespace dlib
             return full_object_detection(rect, parts);
         }
 
-        friend void serialize (const shape_predictor& item, std::ostream& out);
-
-        friend void deserialize (shape_predictor& item, std::istream& in);
-
-    private:
         matrix<float,0,1> initial_shape;
+        // Each level of the cascade is stored either in compiled, if it could be
+        // flattened, or in forests.  The other one is empty.
         std::vector<std::vector<impl::regression_tree> > forests;
         std::vector<std::vector<unsigned long> > anchor_idx; 
         std::vector<std::vector<dlib::vector<float,2> > > deltas;
+        std::vector<impl::compiled_forest> compiled;
     };
 
     inline void serialize (const shape_predictor& item, std::ostream& out)
@@ -415,7 +782,24 @@ namespace dlib
         int version = 1;
         dlib::serialize(version, out);
         dlib::serialize(item.initial_shape, out);
-        dlib::serialize(item.forests, out);
+        // This writes the same thing as dlib::serialize(forests, out) would if all the
+        // trees were in forests.  We recover the compiled levels one at a time so we
+        // never hold more than one extra level in memory.
+        const unsigned long num_levels = item.forests.size();
+        dlib::serialize(num_levels, out);
+        std::vector<impl::regression_tree> trees;
+        for (unsigned long iter = 0; iter < num_levels; ++iter)
+        {
+            if (item.compiled[iter].is_compiled())
+            {
+                item.compiled[iter].get_trees(trees);
+                dlib::serialize(trees, out);
+            }
+            else
+            {
+                dlib::serialize(item.forests[iter], out);
+            }
+        }
         dlib::serialize(item.anchor_idx, out);
         dlib::serialize(item.deltas, out);
     }
@@ -427,7 +811,18 @@ namespace dlib
         if (version != 1)
             throw serialization_error("Unexpected version found while deserializing dlib::shape_predictor.");
         dlib::deserialize(item.initial_shape, in);
-        dlib::deserialize(item.forests, in);
+        // Compile each level as soon as it's loaded so we don't need to hold two copies
+        // of the whole model.
+        unsigned long num_levels = 0;
+        dlib::deserialize(num_levels, in);
+        item.forests.clear();
+        item.forests.resize(num_levels);
+        item.compiled.clear();
+        for (unsigned long iter = 0; iter < num_levels; ++iter)
+        {
+            dlib::deserialize(item.forests[iter], in);
+            item.compile_level(iter);
+        }
         dlib::deserialize(item.anchor_idx, in);
         dlib::deserialize(item.deltas, in);
     }
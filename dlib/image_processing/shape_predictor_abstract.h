@@ -111,6 +111,50 @@ namespace dlib
                   where the 3d argument is discarded.
         !*/
 
+        template <typename image_type>
+        std::vector<full_object_detection> operator()(
+            const image_type& img,
+            const std::vector<rectangle>& rects,
+            unsigned long num_threads = 1
+        ) const;
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+            ensures
+                - Runs the shape predictor on each of the given rectangles and returns the
+                  results.  That is, returns a vector DETS such that:
+                    - DETS.size() == rects.size()
+                    - for all valid i:
+                        - DETS[i] == (*this)(img, rects[i])
+                - The rectangles are processed in parallel using num_threads threads.
+                  Each thread reuses its working memory from one rectangle to the next.
+        !*/
+
+        template <typename image_array_type>
+        std::vector<std::vector<full_object_detection> > operator()(
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& rects,
+            unsigned long num_threads = 1
+        ) const;
+        /*!
+            requires
+                - image_array_type == an implementation of array/array_kernel_abstract.h
+                  or std::vector and it must contain image objects that implement the
+                  interface defined in dlib/image_processing/generic_image.h
+                - images.size() == rects.size()
+            ensures
+                - Runs the shape predictor on each rectangle in each image.  That is,
+                  returns a vector DETS such that:
+                    - DETS.size() == images.size()
+                    - for all valid i:
+                        - DETS[i].size() == rects[i].size()
+                        - for all valid j:
+                            - DETS[i][j] == (*this)(images[i], rects[i][j])
+                - All the rectangles, across all the images, are processed in parallel
+                  using num_threads threads.
+        !*/
+
     };
 
     void serialize (const shape_predictor& item, std::ostream& out);
@@ -30,7 +30,9 @@ namespace dlib
             std::vector<unsigned char*>& row_pointers,
             const long width,
             const png_type type,
-            const int bit_depth
+            const int bit_depth,
+            const int compression_level,
+            const png_filter filter
         )
         {
 
@@ -95,6 +97,17 @@ namespace dlib
             /* Set up the output control if you are using standard C streams */
             png_init_io(png_ptr, fp);
 
+            png_set_compression_level(png_ptr, compression_level);
+            switch (filter)
+            {
+                case png_filter_adaptive: break; // libpng's default, it picks a filter for each row
+                case png_filter_none:    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE); break;
+                case png_filter_sub:     png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB); break;
+                case png_filter_up:      png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_UP); break;
+                case png_filter_average: png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_AVG); break;
+                case png_filter_paeth:   png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_PAETH); break;
+            }
+
 
             int png_transforms = PNG_TRANSFORM_IDENTITY;
             byte_orderer bo;
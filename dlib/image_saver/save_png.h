@@ -11,10 +11,23 @@
 #include "../pixel.h"
 #include "../matrix/matrix_exp.h"
 #include "../image_transforms/assign_image.h"
+#include "../matrix/matrix_generic_image.h"
 
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    enum png_filter
+    {
+        png_filter_adaptive,
+        png_filter_none,
+        png_filter_sub,
+        png_filter_up,
+        png_filter_average,
+        png_filter_paeth
+    };
+
 // ----------------------------------------------------------------------------------------
 
     namespace impl
@@ -31,108 +44,149 @@ namespace dlib
             std::vector<unsigned char*>& row_pointers,
             const long width,
             const png_type type,
-            const int bit_depth
+            const int bit_depth,
+            const int compression_level,
+            const png_filter filter
         );
-    }
-
-// ----------------------------------------------------------------------------------------
 
-    template <
-        typename image_type
-        >
-    typename disable_if<is_matrix<image_type> >::type save_png(
-        const image_type& img_,
-        const std::string& file_name
-    )
-    {
-        const_image_view<image_type> img(img_);
+        template <
+            typename image_type
+            >
+        void save_png_image (
+            const image_type& img_,
+            const std::string& file_name,
+            int compression_level,
+            png_filter filter
+        )
+        {
+            const_image_view<image_type> img(img_);
 
-        // make sure requires clause is not broken
-        DLIB_CASSERT(img.size() != 0,
-            "\t save_png()"
-            << "\n\t You can't save an empty image as a PNG"
-            );
+            // make sure requires clause is not broken
+            DLIB_CASSERT(img.size() != 0,
+                "\t save_png()"
+                << "\n\t You can't save an empty image as a PNG"
+                );
+            DLIB_CASSERT(0 <= compression_level && compression_level <= 9,
+                "\t save_png()"
+                << "\n\t Invalid compression level."
+                << "\n\t compression_level: " << compression_level
+                );
 
 
 #ifndef DLIB_PNG_SUPPORT
-            /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-                You are getting this error because you are trying to use save_png() 
-                but you haven't defined DLIB_PNG_SUPPORT.  You must do so to use
-                this function.   You must also make sure you set your build environment
-                to link against the libpng library.
-            !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
-            COMPILE_TIME_ASSERT(sizeof(image_type) == 0);
+                /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+                    You are getting this error because you are trying to use save_png() 
+                    but you haven't defined DLIB_PNG_SUPPORT.  You must do so to use
+                    this function.   You must also make sure you set your build environment
+                    to link against the libpng library.
+                !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
+                COMPILE_TIME_ASSERT(sizeof(image_type) == 0);
 #else
-        std::vector<unsigned char*> row_pointers(img.nr());
-        typedef typename image_traits<image_type>::pixel_type pixel_type;
-
-        if (is_same_type<rgb_pixel,pixel_type>::value)
-        {
-            for (unsigned long i = 0; i < row_pointers.size(); ++i)
-                row_pointers[i] = (unsigned char*)(&img[i][0]);
-
-            impl::impl_save_png(file_name, row_pointers, img.nc(), impl::png_type_rgb, 8);
-        }
-        else if (is_same_type<rgb_alpha_pixel,pixel_type>::value)
-        {
-            for (unsigned long i = 0; i < row_pointers.size(); ++i)
-                row_pointers[i] = (unsigned char*)(&img[i][0]);
-
-            impl::impl_save_png(file_name, row_pointers, img.nc(), impl::png_type_rgb_alpha, 8);
-        }
-        else if (pixel_traits<pixel_type>::lab || pixel_traits<pixel_type>::hsi || pixel_traits<pixel_type>::rgb)
-        {
-            // convert from Lab or HSI to RGB (Or potentially RGB pixels that aren't laid out as R G B)
-            array2d<rgb_pixel> temp_img;
-            assign_image(temp_img, img_);
-            for (unsigned long i = 0; i < row_pointers.size(); ++i)
-                row_pointers[i] = (unsigned char*)(&temp_img[i][0]);
-
-            impl::impl_save_png(file_name, row_pointers, img.nc(), impl::png_type_rgb, 8);
-        }
-        else if (pixel_traits<pixel_type>::rgb_alpha)
-        {
-            // convert from RGBA pixels that aren't laid out as R G B A
-            array2d<rgb_alpha_pixel> temp_img;
-            assign_image(temp_img, img_);
-            for (unsigned long i = 0; i < row_pointers.size(); ++i)
-                row_pointers[i] = (unsigned char*)(&temp_img[i][0]);
-
-            impl::impl_save_png(file_name, row_pointers, img.nc(), impl::png_type_rgb_alpha, 8);
-        }
-        else // this is supposed to be grayscale 
-        {
-            DLIB_CASSERT(pixel_traits<pixel_type>::grayscale, "impossible condition detected");
+            std::vector<unsigned char*> row_pointers(img.nr());
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
 
-            if (pixel_traits<pixel_type>::is_unsigned && sizeof(pixel_type) == 1)
+            if (is_same_type<rgb_pixel,pixel_type>::value)
             {
                 for (unsigned long i = 0; i < row_pointers.size(); ++i)
                     row_pointers[i] = (unsigned char*)(&img[i][0]);
 
-                impl::impl_save_png(file_name, row_pointers, img.nc(), impl::png_type_gray, 8);
+                impl_save_png(file_name, row_pointers, img.nc(), png_type_rgb, 8, compression_level, filter);
             }
-            else if (pixel_traits<pixel_type>::is_unsigned && sizeof(pixel_type) == 2)
+            else if (is_same_type<rgb_alpha_pixel,pixel_type>::value)
             {
                 for (unsigned long i = 0; i < row_pointers.size(); ++i)
                     row_pointers[i] = (unsigned char*)(&img[i][0]);
 
-                impl::impl_save_png(file_name, row_pointers, img.nc(), impl::png_type_gray, 16);
+                impl_save_png(file_name, row_pointers, img.nc(), png_type_rgb_alpha, 8, compression_level, filter);
             }
-            else
+            else if (pixel_traits<pixel_type>::lab || pixel_traits<pixel_type>::hsi || pixel_traits<pixel_type>::rgb)
             {
-                // convert from whatever this is to 16bit grayscale 
-                array2d<dlib::uint16> temp_img;
+                // convert from Lab or HSI to RGB (Or potentially RGB pixels that aren't laid out as R G B)
+                array2d<rgb_pixel> temp_img;
                 assign_image(temp_img, img_);
                 for (unsigned long i = 0; i < row_pointers.size(); ++i)
                     row_pointers[i] = (unsigned char*)(&temp_img[i][0]);
 
-                impl::impl_save_png(file_name, row_pointers, img.nc(), impl::png_type_gray, 16);
+                impl_save_png(file_name, row_pointers, img.nc(), png_type_rgb, 8, compression_level, filter);
+            }
+            else if (pixel_traits<pixel_type>::rgb_alpha)
+            {
+                // convert from RGBA pixels that aren't laid out as R G B A
+                array2d<rgb_alpha_pixel> temp_img;
+                assign_image(temp_img, img_);
+                for (unsigned long i = 0; i < row_pointers.size(); ++i)
+                    row_pointers[i] = (unsigned char*)(&temp_img[i][0]);
+
+                impl_save_png(file_name, row_pointers, img.nc(), png_type_rgb_alpha, 8, compression_level, filter);
+            }
+            else // this is supposed to be grayscale 
+            {
+                DLIB_CASSERT(pixel_traits<pixel_type>::grayscale, "impossible condition detected");
+
+                if (pixel_traits<pixel_type>::is_unsigned && sizeof(pixel_type) == 1)
+                {
+                    for (unsigned long i = 0; i < row_pointers.size(); ++i)
+                        row_pointers[i] = (unsigned char*)(&img[i][0]);
+
+                    impl_save_png(file_name, row_pointers, img.nc(), png_type_gray, 8, compression_level, filter);
+                }
+                else if (pixel_traits<pixel_type>::is_unsigned && sizeof(pixel_type) == 2)
+                {
+                    for (unsigned long i = 0; i < row_pointers.size(); ++i)
+                        row_pointers[i] = (unsigned char*)(&img[i][0]);
+
+                    impl_save_png(file_name, row_pointers, img.nc(), png_type_gray, 16, compression_level, filter);
+                }
+                else
+                {
+                    // convert from whatever this is to 16bit grayscale 
+                    array2d<dlib::uint16> temp_img;
+                    assign_image(temp_img, img_);
+                    for (unsigned long i = 0; i < row_pointers.size(); ++i)
+                        row_pointers[i] = (unsigned char*)(&temp_img[i][0]);
+
+                    impl_save_png(file_name, row_pointers, img.nc(), png_type_gray, 16, compression_level, filter);
+                }
             }
-        }
 
 
 #endif
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    typename disable_if<is_matrix<image_type> >::type save_png(
+        const image_type& img,
+        const std::string& file_name,
+        int compression_level = 6,
+        png_filter filter = png_filter_adaptive
+    )
+    {
+        impl::save_png_image(img, file_name, compression_level, filter);
+    }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename T, 
+        long NR, 
+        long NC, 
+        typename MM
+        >
+    void save_png(
+        const matrix<T,NR,NC,MM>& img,
+        const std::string& file_name,
+        int compression_level = 6,
+        png_filter filter = png_filter_adaptive
+    )
+    {
+        // A matrix is also a generic image, so its rows can be handed to libpng
+        // without copying it into an array2d first.
+        impl::save_png_image(img, file_name, compression_level, filter);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -142,12 +196,14 @@ namespace dlib
         >
     void save_png(
         const matrix_exp<EXP>& img,
-        const std::string& file_name
+        const std::string& file_name,
+        int compression_level = 6,
+        png_filter filter = png_filter_adaptive
     )
     {
         array2d<typename EXP::type> temp;
         assign_image(temp, img);
-        save_png(temp, file_name);
+        save_png(temp, file_name, compression_level, filter);
     }
 
 // ----------------------------------------------------------------------------------------
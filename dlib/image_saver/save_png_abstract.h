@@ -9,6 +9,25 @@
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    enum png_filter
+    {
+        /*!
+            These are the row filters a PNG encoder can apply before compressing the
+            image.  png_filter_adaptive lets libpng choose the best filter for each row,
+            which usually gives the smallest files.  The others use the same filter for
+            every row and are faster.  For example, png_filter_none with a low
+            compression level is a good choice for quickly writing binary masks.
+        !*/
+        png_filter_adaptive,
+        png_filter_none,
+        png_filter_sub,
+        png_filter_up,
+        png_filter_average,
+        png_filter_paeth
+    };
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -16,13 +35,16 @@ namespace dlib
         >
     void save_png (
         const image_type& image,
-        const std::string& file_name
+        const std::string& file_name,
+        int compression_level = 6,
+        png_filter filter = png_filter_adaptive
     );
     /*!
         requires
             - image_type == an image object that implements the interface defined in
               dlib/image_processing/generic_image.h or a matrix expression
             - image.size() != 0
+            - 0 <= compression_level <= 9
         ensures
             - writes the image to the file indicated by file_name in the PNG (Portable Network Graphics) 
               format.
@@ -32,7 +54,14 @@ namespace dlib
             - This routine can save images containing any type of pixel.  However, save_png() can
               only natively store the following pixel types: rgb_pixel, rgb_alpha_pixel, uint8, 
               and uint16.  All other pixel types will be converted into one of these types as 
-              appropriate before being saved to disk.
+              appropriate before being saved to disk.  Images with one of the native pixel
+              types, including dlib::matrix objects, are passed to libpng without being
+              copied.
+            - compression_level is the zlib compression level.  0 means no compression, 1
+              is the fastest, and 9 gives the smallest files.  The default of 6 is zlib's
+              default.
+            - Each row of the image is filtered with the given filter before it is
+              compressed.
         throws
             - image_save_error
                 This exception is thrown if there is an error that prevents us from saving 
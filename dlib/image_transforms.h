@@ -11,6 +11,7 @@
 #include "image_transforms/assign_image.h"
 #include "image_transforms/equalize_histogram.h"
 #include "image_transforms/morphological_operations.h"
+#include "image_transforms/packed_binary_image.h"
 #include "image_transforms/spatial_filtering.h"
 #include "image_transforms/thresholding.h"
 #include "image_transforms/edge_detector.h"
@@ -379,6 +379,186 @@ namespace dlib
         
         // ------------------------------------------------------------------------------------
 
+        inline simd8i snap_to_orientation (
+            const simd8f& grad_x,
+            const simd8f& grad_y
+        )
+        /*!
+            ensures
+                - returns the index of the orientation, out of the 18 used by the HOG
+                  features, which is closest to each of the 8 given gradients.
+        !*/
+        {
+            // The cos and sin of 0, 20, 40, 60, and 80 degrees.  The other 4 of the 9
+            // directions are mirror images of these, i.e. direction 9-o is (-dx[o], dy[o]).
+            // So we only need to compute half the products.
+            const float dx[5] = {1.0000, 0.9397, 0.7660, 0.500,  0.1736};
+            const float dy[5] = {0.0000, 0.3420, 0.6428, 0.8660, 0.9848};
+            simd8f px[5], py[5];
+            for (int o = 0; o < 5; ++o)
+            {
+                px[o] = grad_x*dx[o];
+                py[o] = grad_y*dy[o];
+            }
+
+            const simd8f zero = 0;
+            simd8f best_dot = 0;
+            simd8f best_o = 0;
+            for (int o = 0; o < 9; o++)
+            {
+                const simd8f dot = o < 5 ? px[o]+py[o] : py[9-o]-px[9-o];
+                // Checking |dot| is the same as checking both the direction and its
+                // opposite, which is direction o+9.
+                const simd8f abs_dot = max(dot, zero-dot);
+                const simd8f_bool cmp = abs_dot > best_dot;
+                best_dot = select(cmp, abs_dot, best_dot);
+                best_o = select(cmp, select(dot > zero, simd8f(o), simd8f(o+9)), best_o);
+            }
+            return simd8i(best_o);
+        }
+
+        // ------------------------------------------------------------------------------------
+
+        template <typename image_type>
+        class gradient_row_buffer
+        {
+            /*!
+                This object holds 3 consecutive rows of an image with each pixel converted
+                into int32 values (one plane per color channel).  This way the simd8f
+                version of get_gradient() can be computed with contiguous SIMD loads rather
+                than by gathering each pixel into a register one at a time, which also
+                means each pixel is converted only once rather than 4 times.  The gradients
+                are exactly the same as the ones computed by get_gradient().
+            !*/
+        public:
+            typedef typename image_type::pixel_type pixel_type;
+            static const long num_channels = pixel_traits<pixel_type>::rgb ? 3 : 1;
+
+            explicit gradient_row_buffer (
+                const image_type& img_
+            ) : img(img_), nc(img_.nc()), center_row(-10), buf(3*num_channels*img_.nc())
+            {
+                for (int i = 0; i < 3; ++i)
+                    rows[i] = &buf[i*num_channels*nc];
+            }
+
+            void set_center_row (
+                long r
+            )
+            /*!
+                requires
+                    - 1 <= r < img.nr()-1
+                ensures
+                    - loads rows r-1, r, and r+1 into this object.
+            !*/
+            {
+                if (r == center_row+1)
+                {
+                    // We are moving down one row so only the new bottom row needs to be
+                    // loaded.
+                    std::rotate(rows, rows+1, rows+3);
+                    load_row(r+1, rows[2]);
+                }
+                else if (r != center_row)
+                {
+                    for (int i = 0; i < 3; ++i)
+                        load_row(r-1+i, rows[i]);
+                }
+                center_row = r;
+            }
+
+            void get_gradient (
+                long c,
+                simd8f& grad_x,
+                simd8f& grad_y,
+                simd8f& len
+            ) const
+            /*!
+                requires
+                    - 1 <= c && c+8 < img.nc()
+                ensures
+                    - computes the gradients for the 8 pixels starting at column c of the
+                      center row.
+            !*/
+            {
+                simd8i gx, gy, l;
+                channel_gradient(0, c, gx, gy, l);
+                // For color images we pick the color channel with the strongest gradient.
+                for (long k = 1; k < num_channels; ++k)
+                {
+                    simd8i tgx, tgy, tl;
+                    channel_gradient(k, c, tgx, tgy, tl);
+                    simd8i cmp = l > tl;
+                    gx = select(cmp, gx, tgx);
+                    gy = select(cmp, gy, tgy);
+                    l = select(cmp, l, tl);
+                }
+                grad_x = gx;
+                grad_y = gy;
+                len = l;
+            }
+
+        private:
+
+            void channel_gradient (
+                long k,
+                long c,
+                simd8i& grad_x,
+                simd8i& grad_y,
+                simd8i& len
+            ) const
+            {
+                const int32* top_row = rows[0] + k*nc;
+                const int32* center = rows[1] + k*nc;
+                const int32* bottom_row = rows[2] + k*nc;
+                simd8i left, right, top, bottom;
+                left.load(center + c - 1);
+                right.load(center + c + 1);
+                top.load(top_row + c);
+                bottom.load(bottom_row + c);
+                grad_x = right - left;
+                grad_y = bottom - top;
+                len = grad_x*grad_x + grad_y*grad_y;
+            }
+
+            template <typename P>
+            typename enable_if_c<pixel_traits<P>::rgb>::type convert_pixel (
+                const P& p,
+                int32* out
+            ) const
+            {
+                out[0] = p.red;
+                out[nc] = p.green;
+                out[2*nc] = p.blue;
+            }
+
+            template <typename P>
+            typename disable_if_c<pixel_traits<P>::rgb>::type convert_pixel (
+                const P& p,
+                int32* out
+            ) const
+            {
+                out[0] = (int)get_pixel_intensity(p);
+            }
+
+            void load_row (
+                long r,
+                int32* out
+            )
+            {
+                for (long c = 0; c < nc; ++c)
+                    convert_pixel(img[r][c], out + c);
+            }
+
+            const image_type& img;
+            const long nc;
+            long center_row;
+            std::vector<int32> buf;
+            int32* rows[3];
+        };
+
+        // ------------------------------------------------------------------------------------
+
         template <typename T, typename mm1, typename mm2>
         inline void set_hog (
             dlib::array<array2d<T,mm1>,mm2>& hog,
@@ -557,36 +737,27 @@ namespace dlib
             const int visible_nr = img.nr()-1;
             const int visible_nc = img.nc()-1;
 
+            gradient_row_buffer<const_image_view<image_type> > grad_rows(img);
+
             // First populate the gradient histograms
             for (int y = 1; y < visible_nr; y++) 
             {
+                if (visible_nc > 8)
+                    grad_rows.set_center_row(y);
                 int x;
                 for (x = 1; x < visible_nc - 7; x += 8)
                 {
                     // v will be the length of the gradient vectors.
                     simd8f grad_x, grad_y, v;
-                    get_gradient(y, x, img, grad_x, grad_y, v);
+                    grad_rows.get_gradient(x, grad_x, grad_y, v);
 
                     float _vv[8];
                     v.store(_vv);
 
                     // Now snap the gradient to one of 18 orientations
-                    simd8f best_dot = 0;
-                    simd8f best_o = 0;
-                    for (int o = 0; o < 9; o++)
-                    {
-                        simd8f dot = grad_x*directions[o](0) + grad_y*directions[o](1);
-                        simd8f_bool cmp = dot>best_dot;
-                        best_dot = select(cmp, dot, best_dot);
-                        dot *= -1;
-                        best_o = select(cmp, o, best_o);
-
-                        cmp = dot > best_dot;
-                        best_dot = select(cmp, dot, best_dot);
-                        best_o = select(cmp, o + 9, best_o);
-                    }
+                    const simd8i best_o = snap_to_orientation(grad_x, grad_y);
 
-                    int32 _best_o[8]; simd8i(best_o).store(_best_o);
+                    int32 _best_o[8]; best_o.store(_best_o);
 
                     norm[y][x + 0] = _vv[0];
                     norm[y][x + 1] = _vv[1];
@@ -818,6 +989,11 @@ namespace dlib
             const int visible_nr = std::min((long)cells_nr*cell_size,img.nr())-1;
             const int visible_nc = std::min((long)cells_nc*cell_size,img.nc())-1;
 
+            gradient_row_buffer<const_image_view<image_type> > grad_rows(img);
+            // The histogram votes from the current image row, before they are split
+            // between the two rows of hist they belong to.
+            std::vector<float> row_hist(hist.nc()*18);
+
             // First populate the gradient histograms
             for (int y = 1; y < visible_nr; y++) 
             {
@@ -825,13 +1001,21 @@ namespace dlib
                 const int iyp = (int)std::floor(yp);
                 const float vy0 = yp - iyp;
                 const float vy1 = 1.0 - vy0;
+                if (visible_nc > 8)
+                    grad_rows.set_center_row(y);
+                bool row_hist_used = false;
                 int x;
                 for (x = 1; x < visible_nc - 7; x += 8)
                 {
+                    if (!row_hist_used)
+                    {
+                        row_hist_used = true;
+                        std::fill(row_hist.begin(), row_hist.end(), 0);
+                    }
                     simd8f xx(x, x + 1, x + 2, x + 3, x + 4, x + 5, x + 6, x + 7);
                     // v will be the length of the gradient vectors.
                     simd8f grad_x, grad_y, v;
-                    get_gradient(y, x, img, grad_x, grad_y, v);
+                    grad_rows.get_gradient(x, grad_x, grad_y, v);
 
                     // We will use bilinear interpolation to add into the histogram bins.
                     // So first we precompute the values needed to determine how much each
@@ -844,79 +1028,47 @@ namespace dlib
                     v = sqrt(v);
 
                     // Now snap the gradient to one of 18 orientations
-                    simd8f best_dot = 0;
-                    simd8f best_o = 0;
-                    for (int o = 0; o < 9; o++)
-                    {
-                        simd8f dot = grad_x*directions[o](0) + grad_y*directions[o](1);
-                        simd8f_bool cmp = dot>best_dot;
-                        best_dot = select(cmp, dot, best_dot);
-                        dot *= -1;
-                        best_o = select(cmp, o, best_o);
-
-                        cmp = dot > best_dot;
-                        best_dot = select(cmp, dot, best_dot);
-                        best_o = select(cmp, o + 9, best_o);
-                    }
-
-
-                    // Add the gradient magnitude, v, to 4 histograms around pixel using
-                    // bilinear interpolation.
+                    const simd8i best_o = snap_to_orientation(grad_x, grad_y);
+
+
+                    // Add the gradient magnitude, v, to the 2 histograms to the left and
+                    // right of each pixel using linear interpolation.  The vertical part of
+                    // the bilinear interpolation is the same for every pixel in this row, so
+                    // it's applied to the whole row_hist at once when we finish the row.
+                    // This halves the number of scattered writes into the histograms.
+                    // Note that computing vy*(sum of votes) rather than the sum of vy*vote
+                    // rounds differently, so the histograms, and therefore the features,
+                    // can differ from the scalar code path in the last few bits.  They
+                    // agree to within about 1e-6.
                     vx1 *= v;
                     vx0 *= v;
-                    // The amounts for each bin
-                    simd8f v11 = vy1*vx1;
-                    simd8f v01 = vy0*vx1;
-                    simd8f v10 = vy1*vx0;
-                    simd8f v00 = vy0*vx0;
 
-                    int32 _best_o[8]; simd8i(best_o).store(_best_o);
+                    int32 _best_o[8]; best_o.store(_best_o);
                     int32 _ixp[8];    ixp.store(_ixp);
-                    float _v11[8];    v11.store(_v11);
-                    float _v01[8];    v01.store(_v01);
-                    float _v10[8];    v10.store(_v10);
-                    float _v00[8];    v00.store(_v00);
-
-                    hist[iyp + 1][_ixp[0]](_best_o[0]) += _v11[0];
-                    hist[iyp + 1 + 1][_ixp[0]](_best_o[0]) += _v01[0];
-                    hist[iyp + 1][_ixp[0] + 1](_best_o[0]) += _v10[0];
-                    hist[iyp + 1 + 1][_ixp[0] + 1](_best_o[0]) += _v00[0];
-
-                    hist[iyp + 1][_ixp[1]](_best_o[1]) += _v11[1];
-                    hist[iyp + 1 + 1][_ixp[1]](_best_o[1]) += _v01[1];
-                    hist[iyp + 1][_ixp[1] + 1](_best_o[1]) += _v10[1];
-                    hist[iyp + 1 + 1][_ixp[1] + 1](_best_o[1]) += _v00[1];
-
-                    hist[iyp + 1][_ixp[2]](_best_o[2]) += _v11[2];
-                    hist[iyp + 1 + 1][_ixp[2]](_best_o[2]) += _v01[2];
-                    hist[iyp + 1][_ixp[2] + 1](_best_o[2]) += _v10[2];
-                    hist[iyp + 1 + 1][_ixp[2] + 1](_best_o[2]) += _v00[2];
-
-                    hist[iyp + 1][_ixp[3]](_best_o[3]) += _v11[3];
-                    hist[iyp + 1 + 1][_ixp[3]](_best_o[3]) += _v01[3];
-                    hist[iyp + 1][_ixp[3] + 1](_best_o[3]) += _v10[3];
-                    hist[iyp + 1 + 1][_ixp[3] + 1](_best_o[3]) += _v00[3];
-
-                    hist[iyp + 1][_ixp[4]](_best_o[4]) += _v11[4];
-                    hist[iyp + 1 + 1][_ixp[4]](_best_o[4]) += _v01[4];
-                    hist[iyp + 1][_ixp[4] + 1](_best_o[4]) += _v10[4];
-                    hist[iyp + 1 + 1][_ixp[4] + 1](_best_o[4]) += _v00[4];
-
-                    hist[iyp + 1][_ixp[5]](_best_o[5]) += _v11[5];
-                    hist[iyp + 1 + 1][_ixp[5]](_best_o[5]) += _v01[5];
-                    hist[iyp + 1][_ixp[5] + 1](_best_o[5]) += _v10[5];
-                    hist[iyp + 1 + 1][_ixp[5] + 1](_best_o[5]) += _v00[5];
-
-                    hist[iyp + 1][_ixp[6]](_best_o[6]) += _v11[6];
-                    hist[iyp + 1 + 1][_ixp[6]](_best_o[6]) += _v01[6];
-                    hist[iyp + 1][_ixp[6] + 1](_best_o[6]) += _v10[6];
-                    hist[iyp + 1 + 1][_ixp[6] + 1](_best_o[6]) += _v00[6];
-
-                    hist[iyp + 1][_ixp[7]](_best_o[7]) += _v11[7];
-                    hist[iyp + 1 + 1][_ixp[7]](_best_o[7]) += _v01[7];
-                    hist[iyp + 1][_ixp[7] + 1](_best_o[7]) += _v10[7];
-                    hist[iyp + 1 + 1][_ixp[7] + 1](_best_o[7]) += _v00[7];
+                    float _v1[8];     vx1.store(_v1);
+                    float _v0[8];     vx0.store(_v0);
+
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        float* h = &row_hist[_ixp[i]*18 + _best_o[i]];
+                        h[0]  += _v1[i];
+                        h[18] += _v0[i];
+                    }
                 }
+                if (row_hist_used)
+                {
+                    // finish the bilinear interpolation for the SIMD part of this row.
+                    for (int c = 0; c < hist.nc(); ++c)
+                    {
+                        const float* h = &row_hist[c*18];
+                        for (int o = 0; o < 18; ++o)
+                        {
+                            hist[iyp+1][c](o) += vy1*h[o];
+                            hist[iyp+1+1][c](o) += vy0*h[o];
+                        }
+                    }
+                }
+
                 // Now process the right columns that don't fit into simd registers.
                 for (; x < visible_nc; x++) 
                 {
@@ -956,15 +1108,20 @@ namespace dlib
                 }
             }
 
-            // compute energy in each block by summing over orientations
+            // compute energy in each block by summing over orientations.  The 18 bins of
+            // a cell are stored contiguously so the first 8 of the 9 orientation pairs
+            // are done in one SIMD step.
             for (int r = 0; r < cells_nr; ++r)
             {
                 for (int c = 0; c < cells_nc; ++c)
                 {
-                    for (int o = 0; o < 9; o++) 
-                    {
-                        norm[r][c] += (hist[r+1][c+1](o) + hist[r+1][c+1](o+9)) * (hist[r+1][c+1](o) + hist[r+1][c+1](o+9));
-                    }
+                    const float* h = &hist[r+1][c+1](0);
+                    simd8f lo, hi;
+                    lo.load(h);
+                    hi.load(h+9);
+                    const simd8f both = lo+hi;
+                    const float last = h[8] + h[17];
+                    norm[r][c] = sum(both*both) + last*last;
                 }
             }
 
@@ -995,53 +1152,74 @@ namespace dlib
                                     norm[y+2][x+1],
                                     norm[y+1][x+1]);
 
-                    const simd4f nn = 0.2*sqrt(z1+z2+z3+z4+eps);
-                    const simd4f n = 0.1/nn;
-
-                    simd4f t = 0;
+                    // nn[k] and n[k] are the clipping threshold and scale for the k-th
+                    // of the 4 blocks this cell belongs to.
+                    const simd4f nn4 = 0.2*sqrt(z1+z2+z3+z4+eps);
+                    const simd4f n4 = 0.1/nn4;
+                    float nn[4], n[4];
+                    nn4.store(nn);
+                    n4.store(n);
 
                     const int xx = x+padding_cols_offset; 
+                    const float* h = &hist[y+1+1][x+1+1](0);
+
+                    // The features are computed 8 orientations at a time.  Each SIMD lane
+                    // holds one orientation and the 4 block normalizations are summed
+                    // across registers.  t[k] collects the texture feature of block k.
+                    simd8f t[4] = {0, 0, 0, 0};
+                    float feat[8];
 
                     // contrast-sensitive features
-                    for (int o = 0; o < 18; o+=3) 
+                    for (int o = 0; o < 16; o += 8)
                     {
-                        simd4f temp0(hist[y+1+1][x+1+1](o));
-                        simd4f temp1(hist[y+1+1][x+1+1](o+1));
-                        simd4f temp2(hist[y+1+1][x+1+1](o+2));
-                        simd4f h0 = min(temp0,nn)*n;
-                        simd4f h1 = min(temp1,nn)*n;
-                        simd4f h2 = min(temp2,nn)*n;
-                        set_hog(hog,o,xx,yy,   sum(h0));
-                        set_hog(hog,o+1,xx,yy, sum(h1));
-                        set_hog(hog,o+2,xx,yy, sum(h2));
-                        t += h0+h1+h2;
+                        simd8f v;
+                        v.load(h+o);
+                        simd8f f = 0;
+                        for (int k = 0; k < 4; ++k)
+                        {
+                            const simd8f hk = min(v,nn[k])*n[k];
+                            t[k] += hk;
+                            f += hk;
+                        }
+                        f.store(feat);
+                        for (int i = 0; i < 8; ++i)
+                            set_hog(hog,o+i,xx,yy, feat[i]);
                     }
-
-                    t *= 2*0.2357;
+                    float f16 = 0, f17 = 0, t_tail[4];
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        const float h16 = std::min(h[16],nn[k])*n[k];
+                        const float h17 = std::min(h[17],nn[k])*n[k];
+                        f16 += h16;
+                        f17 += h17;
+                        t_tail[k] = h16 + h17;
+                    }
+                    set_hog(hog,16,xx,yy, f16);
+                    set_hog(hog,17,xx,yy, f17);
 
                     // contrast-insensitive features
-                    for (int o = 0; o < 9; o+=3) 
                     {
-                        simd4f temp0 = hist[y+1+1][x+1+1](o)   + hist[y+1+1][x+1+1](o+9);
-                        simd4f temp1 = hist[y+1+1][x+1+1](o+1) + hist[y+1+1][x+1+1](o+9+1);
-                        simd4f temp2 = hist[y+1+1][x+1+1](o+2) + hist[y+1+1][x+1+1](o+9+2);
-                        simd4f h0 = min(temp0,nn)*n;
-                        simd4f h1 = min(temp1,nn)*n;
-                        simd4f h2 = min(temp2,nn)*n;
-                        set_hog(hog,o+18,xx,yy, sum(h0));
-                        set_hog(hog,o+18+1,xx,yy, sum(h1));
-                        set_hog(hog,o+18+2,xx,yy, sum(h2));
+                        simd8f lo, hi;
+                        lo.load(h);
+                        hi.load(h+9);
+                        const simd8f v = lo+hi;
+                        simd8f f = 0;
+                        for (int k = 0; k < 4; ++k)
+                            f += min(v,nn[k])*n[k];
+                        f.store(feat);
+                        for (int i = 0; i < 8; ++i)
+                            set_hog(hog,18+i,xx,yy, feat[i]);
+
+                        const float v8 = h[8] + h[17];
+                        float f8 = 0;
+                        for (int k = 0; k < 4; ++k)
+                            f8 += std::min(v8,nn[k])*n[k];
+                        set_hog(hog,26,xx,yy, f8);
                     }
 
-
-                    float temp[4];
-                    t.store(temp);
-
                     // texture features
-                    set_hog(hog,27,xx,yy, temp[0]);
-                    set_hog(hog,28,xx,yy, temp[1]);
-                    set_hog(hog,29,xx,yy, temp[2]);
-                    set_hog(hog,30,xx,yy, temp[3]);
+                    for (int k = 0; k < 4; ++k)
+                        set_hog(hog,27+k,xx,yy, (sum(t[k]) + t_tail[k])*(2*0.2357f));
                 }
             }
         }
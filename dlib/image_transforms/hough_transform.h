@@ -8,7 +8,10 @@
 #include "../geometry.h"
 #include "../algs.h"
 #include "assign_image.h"
+#include "../threads/parallel_for_extension.h"
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 namespace dlib
 {
@@ -45,17 +48,20 @@ namespace dlib
             }
             const double offset = scale*even_size/4.0 + 0.5;
 
-            for (unsigned long c = 0; c < size_; ++c)
-            {
-                const long x = c - cent.x();
-                for (unsigned long t = 0; t < size_; ++t)
-                    xcos_theta(c,t) = static_cast<int32>(x*cos_theta[t] + offset);
-            }
-            for (unsigned long r = 0; r < size_; ++r)
+            // The tables are indexed by theta first so that the voting loop, which
+            // works on one theta at a time, reads them from a single row.
+            for (unsigned long t = 0; t < size_; ++t)
             {
-                const long y = r - cent.y();
-                for (unsigned long t = 0; t < size_; ++t)
-                    ysin_theta(r,t) = static_cast<int32>(y*sin_theta[t] + offset);
+                for (unsigned long c = 0; c < size_; ++c)
+                {
+                    const long x = c - cent.x();
+                    xcos_theta(t,c) = static_cast<int32>(x*cos_theta[t] + offset);
+                }
+                for (unsigned long r = 0; r < size_; ++r)
+                {
+                    const long y = r - cent.y();
+                    ysin_theta(t,r) = static_cast<int32>(y*sin_theta[t] + offset);
+                }
             }
         }
 
@@ -127,113 +133,16 @@ namespace dlib
             point best_point;
 
 
-            const long max_n8 = (himg.nc()/8)*8;
-            const long max_n4 = (himg.nc()/4)*4;
             const long r = p.y();
             const long c = p.x();
-
-            const int32* ysin = &ysin_theta(r,0);
-            const int32* xcos = &xcos_theta(c,0);
-            long t = 0;
-            while(t < max_n8)
+            for (long t = 0; t < himg.nc(); ++t)
             {
-                long rr0 = (*xcos++ + *ysin++)>>16;
-                long rr1 = (*xcos++ + *ysin++)>>16;
-                long rr2 = (*xcos++ + *ysin++)>>16;
-                long rr3 = (*xcos++ + *ysin++)>>16;
-                long rr4 = (*xcos++ + *ysin++)>>16;
-                long rr5 = (*xcos++ + *ysin++)>>16;
-                long rr6 = (*xcos++ + *ysin++)>>16;
-                long rr7 = (*xcos++ + *ysin++)>>16;
-
-                if (himg[rr0][t++] > best_val)
-                {
-                    best_val = himg[rr0][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr0;
-                }
-                if (himg[rr1][t++] > best_val)
-                {
-                    best_val = himg[rr1][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr1;
-                }
-                if (himg[rr2][t++] > best_val)
+                const long rr = (xcos_theta(t,c) + ysin_theta(t,r))>>16;
+                if (himg[rr][t] > best_val)
                 {
-                    best_val = himg[rr2][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr2;
-                }
-                if (himg[rr3][t++] > best_val)
-                {
-                    best_val = himg[rr3][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr3;
-                }
-                if (himg[rr4][t++] > best_val)
-                {
-                    best_val = himg[rr4][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr4;
-                }
-                if (himg[rr5][t++] > best_val)
-                {
-                    best_val = himg[rr5][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr5;
-                }
-                if (himg[rr6][t++] > best_val)
-                {
-                    best_val = himg[rr6][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr6;
-                }
-                if (himg[rr7][t++] > best_val)
-                {
-                    best_val = himg[rr7][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr7;
-                }
-            }
-            while(t < max_n4)
-            {
-                long rr0 = (*xcos++ + *ysin++)>>16;
-                long rr1 = (*xcos++ + *ysin++)>>16;
-                long rr2 = (*xcos++ + *ysin++)>>16;
-                long rr3 = (*xcos++ + *ysin++)>>16;
-                if (himg[rr0][t++] > best_val)
-                {
-                    best_val = himg[rr0][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr0;
-                }
-                if (himg[rr1][t++] > best_val)
-                {
-                    best_val = himg[rr1][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr1;
-                }
-                if (himg[rr2][t++] > best_val)
-                {
-                    best_val = himg[rr2][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr2;
-                }
-                if (himg[rr3][t++] > best_val)
-                {
-                    best_val = himg[rr3][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr3;
-                }
-            }
-            while(t < himg.nc())
-            {
-                long rr0 = (*xcos++ + *ysin++)>>16;
-                if (himg[rr0][t++] > best_val)
-                {
-                    best_val = himg[rr0][t-1];
-                    best_point.x() = t-1;
-                    best_point.y() = rr0;
+                    best_val = himg[rr][t];
+                    best_point.x() = t;
+                    best_point.y() = rr;
                 }
             }
 
@@ -247,14 +156,15 @@ namespace dlib
         void operator() (
             const in_image_type& img_,
             const rectangle& box,
-            out_image_type& himg_
+            out_image_type& himg,
+            unsigned long num_threads = 1
         ) const
         {
             typedef typename image_traits<in_image_type>::pixel_type in_pixel_type;
             typedef typename image_traits<out_image_type>::pixel_type out_pixel_type;
 
             DLIB_CASSERT(box.width() == size() && box.height() == size(),
-                "\t hough_transform::hough_transform(size_)"
+                "\t void hough_transform::operator()"
                 << "\n\t Invalid arguments given to this function."
                 << "\n\t box.width():  " << box.width()
                 << "\n\t box.height(): " << box.height()
@@ -265,89 +175,160 @@ namespace dlib
             COMPILE_TIME_ASSERT(pixel_traits<out_pixel_type>::grayscale == true);
 
             const_image_view<in_image_type> img(img_);
-            image_view<out_image_type> himg(himg_);
-
-            himg.set_size(size(), size());
-            assign_all_pixels(himg, 0);
 
+            // Find the pixels that vote.
+            std::vector<hough_vote<out_pixel_type> > votes;
             const rectangle area = box.intersect(get_rect(img));
-
-            const long max_n8 = (himg.nc()/8)*8;
-            const long max_n4 = (himg.nc()/4)*4;
             for (long r = area.top(); r <= area.bottom(); ++r)
             {
-                const int32* ysin_base = &ysin_theta(r-box.top(),0);
                 for (long c = area.left(); c <= area.right(); ++c)
                 {
                     const out_pixel_type val = static_cast<out_pixel_type>(img[r][c]);
                     if (val != 0)
-                    {
-                        /*
-                        // The code in this comment is equivalent to the more complex but
-                        // faster code below.  We keep this simple version of the Hough
-                        // transform implementation here just to document what it's doing
-                        // more clearly.
-                        const point cent = center(box);
-                        const long x = c - cent.x();
-                        const long y = r - cent.y();
-                        for (long t = 0; t < himg.nc(); ++t)
-                        {
-                            double theta = t*pi/even_size;
-                            double radius = (x*std::cos(theta) + y*std::sin(theta))/sqrt_2 + even_size/2 + 0.5;
-                            long rr = static_cast<long>(radius);
-                            himg[rr][t] += val;
-                        }
-                        continue;
-                        */
-
-                        // Run the speed optimized version of the code in the above
-                        // comment.
-                        const int32* ysin = ysin_base;
-                        const int32* xcos = &xcos_theta(c-box.left(),0);
-                        long t = 0;
-                        while(t < max_n8)
-                        {
-                            long rr0 = (*xcos++ + *ysin++)>>16;
-                            long rr1 = (*xcos++ + *ysin++)>>16;
-                            long rr2 = (*xcos++ + *ysin++)>>16;
-                            long rr3 = (*xcos++ + *ysin++)>>16;
-                            long rr4 = (*xcos++ + *ysin++)>>16;
-                            long rr5 = (*xcos++ + *ysin++)>>16;
-                            long rr6 = (*xcos++ + *ysin++)>>16;
-                            long rr7 = (*xcos++ + *ysin++)>>16;
-
-                            himg[rr0][t++] += val;
-                            himg[rr1][t++] += val;
-                            himg[rr2][t++] += val;
-                            himg[rr3][t++] += val;
-                            himg[rr4][t++] += val;
-                            himg[rr5][t++] += val;
-                            himg[rr6][t++] += val;
-                            himg[rr7][t++] += val;
-                        }
-                        while(t < max_n4)
-                        {
-                            long rr0 = (*xcos++ + *ysin++)>>16;
-                            long rr1 = (*xcos++ + *ysin++)>>16;
-                            long rr2 = (*xcos++ + *ysin++)>>16;
-                            long rr3 = (*xcos++ + *ysin++)>>16;
-                            himg[rr0][t++] += val;
-                            himg[rr1][t++] += val;
-                            himg[rr2][t++] += val;
-                            himg[rr3][t++] += val;
-                        }
-                        while(t < himg.nc())
-                        {
-                            long rr0 = (*xcos++ + *ysin++)>>16;
-                            himg[rr0][t++] += val;
-                        }
-                    }
+                        votes.push_back(hough_vote<out_pixel_type>(c-box.left(), r-box.top(), val));
                 }
             }
+
+            accumulate_votes(votes, himg, num_threads);
+        }
+
+        template <
+            typename out_image_type
+            >
+        void operator() (
+            const std::vector<point>& points,
+            const rectangle& box,
+            out_image_type& himg,
+            unsigned long num_threads = 1
+        ) const
+        {
+            typedef typename image_traits<out_image_type>::pixel_type out_pixel_type;
+
+            DLIB_CASSERT(box.width() == size() && box.height() == size(),
+                "\t void hough_transform::operator()"
+                << "\n\t Invalid arguments given to this function."
+                << "\n\t box.width():  " << box.width()
+                << "\n\t box.height(): " << box.height()
+                << "\n\t size():       " << size()
+                );
+
+            COMPILE_TIME_ASSERT(pixel_traits<out_pixel_type>::grayscale == true);
+
+            std::vector<hough_vote<out_pixel_type> > votes;
+            votes.reserve(points.size());
+            for (unsigned long i = 0; i < points.size(); ++i)
+            {
+                if (box.contains(points[i]))
+                    votes.push_back(hough_vote<out_pixel_type>(points[i].x()-box.left(), points[i].y()-box.top(), 1));
+            }
+
+            accumulate_votes(votes, himg, num_threads);
         }
 
     private:
 
+        template <typename T>
+        struct hough_vote
+        {
+            hough_vote(long x_, long y_, const T& val_) : x(x_), y(y_), val(val_) {}
+            int32 x;
+            int32 y;
+            T val;
+        };
+
+        template <
+            typename T,
+            typename out_image_type
+            >
+        void accumulate_votes (
+            const std::vector<hough_vote<T> >& votes,
+            out_image_type& himg_,
+            unsigned long num_threads
+        ) const
+        /*!
+            ensures
+                - adds each vote into the Hough accumulator bins of the lines passing
+                  through it.  The x and y of each vote are relative to the box.
+        !*/
+        {
+            /*
+            // The code in this comment is equivalent to the more complex but faster code
+            // below.  We keep this simple version of the Hough transform implementation
+            // here just to document what it's doing more clearly.
+            const point cent = center(rectangle(0,0,size()-1,size()-1));
+            for (unsigned long i = 0; i < votes.size(); ++i)
+            {
+                const long x = votes[i].x - cent.x();
+                const long y = votes[i].y - cent.y();
+                for (long t = 0; t < himg.nc(); ++t)
+                {
+                    double theta = t*pi/even_size;
+                    double radius = (x*std::cos(theta) + y*std::sin(theta))/sqrt_2 + even_size/2 + 0.5;
+                    long rr = static_cast<long>(radius);
+                    himg[rr][t] += votes[i].val;
+                }
+            }
+            */
+
+            // The votes for one theta value all land in a single column of himg.  So we
+            // accumulate into a transposed copy of himg, one theta at a time, which keeps
+            // the row being voted into and the rows of the trig tables in the L1 cache.
+            // Consecutive votes often hit the same bin, so they alternate between two
+            // copies of the row, which lets the CPU overlap the additions.  Each thread
+            // handles a different range of theta values and so writes to different rows
+            // of the transposed accumulator.
+            //
+            // Splitting the votes into two lanes changes the order in which they are
+            // summed.  That doesn't matter for integer pixel types, but for floating point
+            // types the output can differ from a straight scan in the last bits.  The
+            // split doesn't depend on num_threads, so the output never does.
+            //
+            // Memory use, on top of himg and the votes vector, is the size()*size()
+            // accumulator plus one size() long lane per thread.
+            const long num = size();
+            std::vector<T> acc(num*num, T(0));
+
+            auto vote_thetas = [&](long t_begin, long t_end) {
+                std::vector<T> lane(num);
+                const unsigned long num_pairs = votes.size()/2;
+                for (long t = t_begin; t < t_end; ++t)
+                {
+                    const int32* const xcos = &xcos_theta(t,0);
+                    const int32* const ysin = &ysin_theta(t,0);
+                    T* const acc_row = &acc[t*num];
+                    T* const lane_row = &lane[0];
+                    std::fill(lane.begin(), lane.end(), T(0));
+                    for (unsigned long i = 0; i < num_pairs; ++i)
+                    {
+                        const hough_vote<T>& v0 = votes[2*i];
+                        const hough_vote<T>& v1 = votes[2*i+1];
+                        acc_row[(xcos[v0.x] + ysin[v0.y])>>16] += v0.val;
+                        lane_row[(xcos[v1.x] + ysin[v1.y])>>16] += v1.val;
+                    }
+                    if (votes.size()%2 == 1)
+                    {
+                        const hough_vote<T>& v = votes.back();
+                        acc_row[(xcos[v.x] + ysin[v.y])>>16] += v.val;
+                    }
+                    for (long rr = 0; rr < num; ++rr)
+                        acc_row[rr] += lane_row[rr];
+                }
+            };
+
+            if (num_threads <= 1)
+                vote_thetas(0, num);
+            else
+                parallel_for_blocked(num_threads, 0, num, vote_thetas, 1);
+
+            image_view<out_image_type> himg(himg_);
+            himg.set_size(num, num);
+            for (long rr = 0; rr < num; ++rr)
+            {
+                for (long t = 0; t < num; ++t)
+                    himg[rr][t] = acc[t*num + rr];
+            }
+        }
+
         unsigned long _size;
         unsigned long even_size; // equal to _size if _size is even, otherwise equal to _size-1.
         matrix<int32> xcos_theta, ysin_theta;
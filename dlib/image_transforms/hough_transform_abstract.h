@@ -5,6 +5,7 @@
 
 #include "../geometry.h"
 #include "../image_processing/generic_image.h"
+#include <vector>
 
 namespace dlib
 {
@@ -108,7 +109,8 @@ namespace dlib
         void operator() (
             const in_image_type& img,
             const rectangle& box,
-            out_image_type& himg
+            out_image_type& himg,
+            unsigned long num_threads = 1
         ) const;
         /*!
             requires
@@ -135,6 +137,47 @@ namespace dlib
                   the line for #himg[y][x] is given by get_line(point(x,y)).  Also, when
                   viewing the #himg image, the x-axis gives the angle of the line and the
                   y-axis the distance of the line from the center of the box.
+                - Uses num_threads threads to do the computation.  Each thread accumulates
+                  the votes for a different range of angles, so the output is the same
+                  regardless of the number of threads used.
+                - If himg contains integer pixels then #himg is exactly the sum of the
+                  votes.  If it contains floating point pixels then the votes are not
+                  summed in raster order, so #himg can differ from a simple
+                  pixel-by-pixel accumulation by floating point rounding.
+                - Besides #himg, this routine allocates a list of the non-zero pixels in
+                  box, which takes about 8+sizeof(pixel type of himg) bytes per pixel,
+                  and a size()*size() accumulator of himg's pixel type.  Each thread also
+                  allocates a scratch row of size() values.
+        !*/
+
+        template <
+            typename out_image_type
+            >
+        void operator() (
+            const std::vector<point>& points,
+            const rectangle& box,
+            out_image_type& himg,
+            unsigned long num_threads = 1
+        ) const;
+        /*!
+            requires
+                - out_image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h and it must contain grayscale pixels.
+                - box.width() == size()
+                - box.height() == size()
+            ensures
+                - This routine is a sparse version of the above operator().  It treats
+                  points as the list of non-zero pixels in an image, each with a value of 1.
+                  That is, it computes the Hough transform of an image which is 1 at each
+                  location in points and 0 everywhere else.  Points outside box are
+                  ignored.  So when you already have a list of edge locations this routine
+                  avoids scanning every pixel of an image to find them.
+                - #himg.nr() == size()
+                - #himg.nc() == size()
+                - Uses num_threads threads to do the computation.  The output is the same
+                  regardless of the number of threads used.
+                - The rounding and memory use are as described for the above operator(),
+                  except that the list of voting pixels only holds the points inside box.
         !*/
 
     };
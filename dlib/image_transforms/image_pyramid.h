@@ -146,6 +146,463 @@ namespace dlib
 
     namespace impl
     {
+        // These functions give the size of the image each pyramid_down object outputs
+        // when applied to an image with nr rows and nc columns.  The pyramid operators
+        // below size their outputs with them, and so does impl::pyramid_down_size(),
+        // which create_tiled_pyramid() uses to lay out the pyramid before building it.
+        inline void pyramid_down_2_1_size (
+            long nr,
+            long nc,
+            long& out_nr,
+            long& out_nc
+        )
+        {
+            if (nr <= 8 || nc <= 8)
+            {
+                out_nr = 0;
+                out_nc = 0;
+                return;
+            }
+            out_nr = (nr-3)/2;
+            out_nc = (nc-3)/2;
+        }
+
+        inline void pyramid_down_3_2_size (
+            long nr,
+            long nc,
+            long& out_nr,
+            long& out_nc
+        )
+        {
+            if (nr <= 8 || nc <= 8)
+            {
+                out_nr = 0;
+                out_nc = 0;
+                return;
+            }
+            out_nr = (2*(nr-2))/3;
+            out_nc = (2*(nc-2))/3;
+        }
+
+        template <unsigned int N>
+        void pyramid_down_n_size (
+            long nr,
+            long nc,
+            long& out_nr,
+            long& out_nc
+        )
+        {
+            out_nr = ((N-1)*nr)/N;
+            out_nc = ((N-1)*nc)/N;
+        }
+
+    // ----------------------------------------------------------------------------------
+
+        template <typename in_image_type, typename out_image_type>
+        struct pyramid_down_fast_path
+        {
+            /*!
+                The row streaming pyramid_down kernels below work directly on the pixel
+                memory.  So we only use them when the input and output images contain the
+                same kind of pixel and it's a type we know how to vectorize.
+            !*/
+            typedef typename image_traits<in_image_type>::pixel_type in_pixel_type;
+            typedef typename image_traits<out_image_type>::pixel_type out_pixel_type;
+            const static bool value = is_same_type<in_pixel_type,out_pixel_type>::value &&
+                                      (is_same_type<in_pixel_type,unsigned char>::value ||
+                                       is_same_type<in_pixel_type,float>::value ||
+                                       is_same_type<in_pixel_type,rgb_pixel>::value ||
+                                       is_same_type<in_pixel_type,bgr_pixel>::value);
+        };
+
+    // ----------------------------------------------------------------------------------------
+
+        template <typename T>
+        inline void pyramid_down_2_1_hfilter (
+            const T* even,
+            const T* odd,
+            T* out,
+            long n
+        )
+        {
+            for (long c = 0; c < n; ++c)
+                out[c] = even[c] + odd[c]*4 + even[c+1]*6 + odd[c+1]*4 + even[c+2];
+        }
+
+        template <typename T>
+        inline void pyramid_down_2_1_vfilter (
+            const T* r2,
+            const T* r1,
+            const T* r0,
+            T* out,
+            long n
+        )
+        {
+            for (long c = 0; c < n; ++c)
+                out[c] = r2[c] + r1[c]*4 + r0[c]*6 + r1[c]*4 + r2[c];
+        }
+
+        template <
+            typename in_image_type,
+            typename out_image_type
+            >
+        typename enable_if<is_float_type<typename pixel_traits<typename image_traits<in_image_type>::pixel_type>::basic_pixel_type> >::type 
+        pyramid_down_2_1_fast (
+            const in_image_type& original_,
+            out_image_type& down_
+        )
+        /*!
+            requires
+                - pyramid_down_fast_path<in_image_type,out_image_type>::value == true
+                - num_rows(original_) > 8 && num_columns(original_) > 8
+            ensures
+                - Computes exactly the same thing as the generic pyramid_down_2_1 code.
+                  However, rather than filtering the whole image into a temporary image,
+                  this function keeps only the 3 row filtered rows the column filter needs.
+                  The row filter is split into even and odd columns so that it can be
+                  vectorized.
+        !*/
+        {
+            typedef typename image_traits<in_image_type>::pixel_type pixel_type;
+            typedef typename pixel_traits<pixel_type>::basic_pixel_type bp_type;
+            typedef typename promote<bp_type>::type ptype;
+
+            const_image_view<in_image_type> original(original_);
+            image_view<out_image_type> down(down_);
+
+            long nr, nc;
+            pyramid_down_2_1_size(original.nr(), original.nc(), nr, nc);
+            down.set_size(nr, nc);
+
+            std::vector<ptype> even(nc+2), odd(nc+1), sums(nc);
+            // row filtered rows, indexed by input row%3
+            std::vector<ptype> rows[3];
+            for (long i = 0; i < 3; ++i)
+                rows[i].resize(nc);
+
+            auto filter_row = [&](long r)
+            {
+                const bp_type* in = &original[r][0];
+                for (long c = 0; c < nc+2; ++c)
+                    even[c] = in[2*c];
+                for (long c = 0; c < nc+1; ++c)
+                    odd[c] = in[2*c+1];
+                pyramid_down_2_1_hfilter(&even[0], &odd[0], &rows[r%3][0], nc);
+            };
+
+            filter_row(0);
+            long dr = 0;
+            for (long r = 2; r < original.nr()-2; r += 2)
+            {
+                filter_row(r-1);
+                filter_row(r);
+                pyramid_down_2_1_vfilter(&rows[(r-2)%3][0], &rows[(r-1)%3][0], &rows[r%3][0], &sums[0], nc);
+                bp_type* out = &down[dr][0];
+                for (long c = 0; c < nc; ++c)
+                    assign_pixel(out[c], sums[c]/256);
+                ++dr;
+            }
+        }
+
+        template <
+            typename in_image_type,
+            typename out_image_type
+            >
+        typename disable_if<is_float_type<typename pixel_traits<typename image_traits<in_image_type>::pixel_type>::basic_pixel_type> >::type 
+        pyramid_down_2_1_fast (
+            const in_image_type& original_,
+            out_image_type& down_
+        )
+        /*!
+            requires
+                - pyramid_down_fast_path<in_image_type,out_image_type>::value == true
+                - num_rows(original_) > 8 && num_columns(original_) > 8
+            ensures
+                - Computes exactly the same thing as the generic pyramid_down_2_1 code.
+                  Since integer arithmetic doesn't depend on the order in which the
+                  filter taps are summed, this version applies the column filter first.
+                  That works directly on the interleaved color channels of each row and
+                  vectorizes well.  The row filter is then applied to just the one
+                  column filtered row.
+        !*/
+        {
+            typedef typename image_traits<in_image_type>::pixel_type pixel_type;
+            typedef typename pixel_traits<pixel_type>::basic_pixel_type bp_type;
+            const long K = pixel_traits<pixel_type>::num;
+
+            const_image_view<in_image_type> original(original_);
+            image_view<out_image_type> down(down_);
+
+            long nr, nc;
+            pyramid_down_2_1_size(original.nr(), original.nc(), nr, nc);
+            down.set_size(nr, nc);
+
+            const long width = original.nc()*K;
+            std::vector<int32> col(width);
+
+            long dr = 0;
+            for (long r = 2; r < original.nr()-2; r += 2)
+            {
+                const bp_type* r2 = reinterpret_cast<const bp_type*>(&original[r-2][0]);
+                const bp_type* r1 = reinterpret_cast<const bp_type*>(&original[r-1][0]);
+                const bp_type* r0 = reinterpret_cast<const bp_type*>(&original[r][0]);
+                for (long x = 0; x < width; ++x)
+                    col[x] = r2[x]*2 + r1[x]*8 + r0[x]*6;
+
+                bp_type* out = reinterpret_cast<bp_type*>(&down[dr][0]);
+                const int32* in = &col[0];
+                for (long c = 0; c < nc; ++c)
+                {
+                    for (long k = 0; k < K; ++k)
+                    {
+                        const int32 temp = in[k] + in[K+k]*4 + in[2*K+k]*6 + in[3*K+k]*4 + in[4*K+k];
+                        out[k] = temp/256;
+                    }
+                    in += 2*K;
+                    out += K;
+                }
+                ++dr;
+            }
+        }
+
+    // ----------------------------------------------------------------------------------------
+
+        template <typename T, bool is_float = is_float_type<T>::value>
+        struct pyramid_down_3_2_row_type { typedef typename promote<T>::type type; };
+        template <typename T>
+        struct pyramid_down_3_2_row_type<T,true> { typedef T type; };
+
+        template <typename T, typename U>
+        inline void pyramid_down_3_2_hfilter (
+            const T* in,
+            U* out,
+            long n
+        )
+        {
+            for (long c = 1; c < n-1; ++c)
+                out[c] = in[c-1]*2 + in[c]*12 + in[c+1]*2;
+        }
+
+        inline void pyramid_down_3_2_hfilter (
+            const int32* in,
+            int32* out,
+            long n
+        )
+        {
+            long c = 1;
+            for (; c < n-8; c += 8)
+            {
+                simd8i a, b, d;
+                a.load(in+c-1);
+                b.load(in+c);
+                d.load(in+c+1);
+                simd8i temp = (a<<1) + b*12 + (d<<1);
+                temp.store(out+c);
+            }
+            for (; c < n-1; ++c)
+                out[c] = in[c-1]*2 + in[c]*12 + in[c+1]*2;
+        }
+
+        template <typename T>
+        inline void pyramid_down_3_2_vfilter (
+            const T* r0,
+            const T* r1,
+            const T* r2,
+            T* out,
+            long n
+        )
+        {
+            for (long c = 1; c < n-1; ++c)
+                out[c] = r0[c]*2 + r1[c]*12 + r2[c]*2;
+        }
+
+        inline void pyramid_down_3_2_vfilter (
+            const int32* r0,
+            const int32* r1,
+            const int32* r2,
+            int32* out,
+            long n
+        )
+        {
+            long c = 1;
+            for (; c < n-8; c += 8)
+            {
+                simd8i a, b, d;
+                a.load(r0+c);
+                b.load(r1+c);
+                d.load(r2+c);
+                simd8i temp = (a<<1) + b*12 + (d<<1);
+                temp.store(out+c);
+            }
+            for (; c < n-1; ++c)
+                out[c] = r0[c]*2 + r1[c]*12 + r2[c]*2;
+        }
+
+        template <
+            typename in_image_type,
+            typename out_image_type
+            >
+        void pyramid_down_3_2_fast (
+            const in_image_type& original_,
+            out_image_type& down_
+        )
+        /*!
+            requires
+                - pyramid_down_fast_path<in_image_type,out_image_type>::value == true
+                - num_rows(original_) > 8 && num_columns(original_) > 8
+            ensures
+                - Computes exactly the same thing as the generic pyramid_down_3_2 code.
+                  However, instead of filtering each 3x3 block separately, which
+                  recomputes the row filter for overlapping rows and columns, this
+                  function filters whole rows at a time, one color channel at a time, so
+                  the filters can be computed with SIMD instructions.  Only the 5 most
+                  recent row filtered rows are kept around.
+        !*/
+        {
+            typedef typename image_traits<in_image_type>::pixel_type pixel_type;
+            typedef typename pixel_traits<pixel_type>::basic_pixel_type bp_type;
+            typedef typename promote<bp_type>::type ptype;
+            // The generic code computes the row filter using the pixel's own type for
+            // floating point pixels, so we do the same to get identical outputs.
+            typedef typename pyramid_down_3_2_row_type<bp_type>::type itype;
+            const long K = pixel_traits<pixel_type>::num;
+
+            const_image_view<in_image_type> original(original_);
+            image_view<out_image_type> down(down_);
+
+            const long size_in = 3;
+            const long size_out = 2;
+
+            const long full_nr =  size_out*((original.nr()-2)/size_in);
+            const long full_nc =  size_out*((original.nc()-2)/size_in);
+            long part_nr, part_nc;
+            pyramid_down_3_2_size(original.nr(), original.nc(), part_nr, part_nc);
+            down.set_size(part_nr, part_nc);
+
+            const long nc = original.nc();
+            std::vector<itype> in_row(nc);
+            // row filtered rows, indexed by [input row%5][channel]
+            std::vector<ptype> hrows[5][K];
+            // the 3x3 filtered rows for the current block row, indexed by [row][channel]
+            std::vector<ptype> brows[3][K];
+            for (long k = 0; k < K; ++k)
+            {
+                for (long i = 0; i < 5; ++i)
+                    hrows[i][k].resize(nc);
+                for (long i = 0; i < 3; ++i)
+                    brows[i][k].resize(nc);
+            }
+
+            long next_row = 0;
+            auto filter_rows_until = [&](long last)
+            {
+                for (; next_row <= last; ++next_row)
+                {
+                    const bp_type* in = reinterpret_cast<const bp_type*>(&original[next_row][0]);
+                    for (long k = 0; k < K; ++k)
+                    {
+                        for (long c = 0; c < nc; ++c)
+                            in_row[c] = in[c*K+k];
+                        pyramid_down_3_2_hfilter(&in_row[0], &hrows[next_row%5][k][0], nc);
+                    }
+                }
+            };
+
+            auto filter_block_row = [&](long rr, long num)
+            {
+                filter_rows_until(rr+num);
+                for (long i = 0; i < num; ++i)
+                {
+                    const long r = rr+i;
+                    for (long k = 0; k < K; ++k)
+                    {
+                        pyramid_down_3_2_vfilter(&hrows[(r-1)%5][k][0], &hrows[r%5][k][0],
+                            &hrows[(r+1)%5][k][0], &brows[i][k][0], nc);
+                    }
+                }
+            };
+
+            long rr = 1;
+            long r;
+            for (r = 0; r < full_nr; r+=size_out)
+            {
+                filter_block_row(rr, 3);
+                bp_type* out0 = reinterpret_cast<bp_type*>(&down[r][0]);
+                bp_type* out1 = reinterpret_cast<bp_type*>(&down[r+1][0]);
+                for (long k = 0; k < K; ++k)
+                {
+                    const ptype* b0 = &brows[0][k][0];
+                    const ptype* b1 = &brows[1][k][0];
+                    const ptype* b2 = &brows[2][k][0];
+                    long cc = 1;
+                    long c;
+                    for (c = 0; c < full_nc; c+=size_out)
+                    {
+                        // bi-linearly interpolate block 
+                        assign_pixel(out0[c*K+k]    , (b0[cc]*9   + b1[cc]*3   + b0[cc+1]*3 + b1[cc+1])/(16*256));
+                        assign_pixel(out0[(c+1)*K+k], (b0[cc+2]*9 + b1[cc+2]*3 + b0[cc+1]*3 + b1[cc+1])/(16*256));
+                        assign_pixel(out1[c*K+k]    , (b2[cc]*9   + b1[cc]*3   + b2[cc+1]*3 + b1[cc+1])/(16*256));
+                        assign_pixel(out1[(c+1)*K+k], (b2[cc+2]*9 + b1[cc+2]*3 + b2[cc+1]*3 + b1[cc+1])/(16*256));
+                        cc += size_in;
+                    }
+                    if (part_nc - full_nc == 1)
+                    {
+                        // bi-linearly interpolate partial block 
+                        assign_pixel(out0[c*K+k]    , (b0[cc]*9   + b1[cc]*3   + b0[cc+1]*3 + b1[cc+1])/(16*256));
+                        assign_pixel(out1[c*K+k]    , (b2[cc]*9   + b1[cc]*3   + b2[cc+1]*3 + b1[cc+1])/(16*256));
+                    }
+                }
+                rr += size_in;
+            }
+            if (part_nr - full_nr == 1)
+            {
+                filter_block_row(rr, 2);
+                bp_type* out0 = reinterpret_cast<bp_type*>(&down[r][0]);
+                for (long k = 0; k < K; ++k)
+                {
+                    const ptype* b0 = &brows[0][k][0];
+                    const ptype* b1 = &brows[1][k][0];
+                    long cc = 1;
+                    long c;
+                    for (c = 0; c < full_nc; c+=size_out)
+                    {
+                        // bi-linearly interpolate partial block 
+                        assign_pixel(out0[c*K+k]    , (b0[cc]*9   + b1[cc]*3   + b0[cc+1]*3 + b1[cc+1])/(16*256));
+                        assign_pixel(out0[(c+1)*K+k], (b0[cc+2]*9 + b1[cc+2]*3 + b0[cc+1]*3 + b1[cc+1])/(16*256));
+                        cc += size_in;
+                    }
+                    if (part_nc - full_nc == 1)
+                    {
+                        // bi-linearly interpolate partial block 
+                        assign_pixel(out0[c*K+k]    , (b0[cc]*9   + b1[cc]*3   + b0[cc+1]*3 + b1[cc+1])/(16*256));
+                    }
+                }
+            }
+        }
+
+    // ----------------------------------------------------------------------------------------
+
+        template <typename in_image_type, typename out_image_type>
+        typename enable_if<pyramid_down_fast_path<in_image_type,out_image_type>,bool>::type 
+        try_pyramid_down_2_1_fast (const in_image_type& original, out_image_type& down) 
+        { pyramid_down_2_1_fast(original, down); return true; }
+
+        template <typename in_image_type, typename out_image_type>
+        typename disable_if<pyramid_down_fast_path<in_image_type,out_image_type>,bool>::type 
+        try_pyramid_down_2_1_fast (const in_image_type& , out_image_type& ) 
+        { return false; }
+
+        template <typename in_image_type, typename out_image_type>
+        typename enable_if<pyramid_down_fast_path<in_image_type,out_image_type>,bool>::type 
+        try_pyramid_down_3_2_fast (const in_image_type& original, out_image_type& down) 
+        { pyramid_down_3_2_fast(original, down); return true; }
+
+        template <typename in_image_type, typename out_image_type>
+        typename disable_if<pyramid_down_fast_path<in_image_type,out_image_type>,bool>::type 
+        try_pyramid_down_3_2_fast (const in_image_type& , out_image_type& ) 
+        { return false; }
+
+    // ----------------------------------------------------------------------------------------
 
         class pyramid_down_2_1 : noncopyable
         {
@@ -263,17 +720,22 @@ namespace dlib
                 const_image_view<in_image_type> original(original_);
                 image_view<out_image_type> down(down_);
 
-                if (original.nr() <= 8 || original.nc() <= 8)
+                long down_nr, down_nc;
+                pyramid_down_2_1_size(original.nr(), original.nc(), down_nr, down_nc);
+                if (down_nr*down_nc == 0)
                 {
                     down.clear();
                     return;
                 }
 
+                if (try_pyramid_down_2_1_fast(original_, down_))
+                    return;
+
                 typedef typename pixel_traits<in_pixel_type>::basic_pixel_type bp_type;
                 typedef typename promote<bp_type>::type ptype;
                 array2d<ptype> temp_img;
-                temp_img.set_size(original.nr(), (original.nc()-3)/2);
-                down.set_size((original.nr()-3)/2, (original.nc()-3)/2);
+                temp_img.set_size(original.nr(), down_nc);
+                down.set_size(down_nr, down_nc);
 
 
                 // This function applies a 5x5 Gaussian filter to the image.  It
@@ -364,15 +826,20 @@ namespace dlib
                 const_image_view<in_image_type> original(original_);
                 image_view<out_image_type> down(down_);
 
-                if (original.nr() <= 8 || original.nc() <= 8)
+                long down_nr, down_nc;
+                pyramid_down_2_1_size(original.nr(), original.nc(), down_nr, down_nc);
+                if (down_nr*down_nc == 0)
                 {
                     down.clear();
                     return;
                 }
 
+                if (try_pyramid_down_2_1_fast(original_, down_))
+                    return;
+
                 array2d<rgbptype> temp_img;
-                temp_img.set_size(original.nr(), (original.nc()-3)/2);
-                down.set_size((original.nr()-3)/2, (original.nc()-3)/2);
+                temp_img.set_size(original.nr(), down_nc);
+                down.set_size(down_nr, down_nc);
 
 
                 // This function applies a 5x5 Gaussian filter to the image.  It
@@ -604,21 +1071,24 @@ namespace dlib
                 const_image_view<in_image_type> original(original_);
                 image_view<out_image_type> down(down_);
 
-                if (original.nr() <= 8 || original.nc() <= 8)
+                long part_nr, part_nc;
+                pyramid_down_3_2_size(original.nr(), original.nc(), part_nr, part_nc);
+                if (part_nr*part_nc == 0)
                 {
                     down.clear();
                     return;
                 }
 
+                if (try_pyramid_down_3_2_fast(original_, down_))
+                    return;
+
                 const long size_in = 3;
                 const long size_out = 2;
 
                 typedef typename pixel_traits<in_pixel_type>::basic_pixel_type bp_type;
                 typedef typename promote<bp_type>::type ptype;
                 const long full_nr =  size_out*((original.nr()-2)/size_in);
-                const long part_nr = (size_out*(original.nr()-2))/size_in;
                 const long full_nc =  size_out*((original.nc()-2)/size_in);
-                const long part_nc = (size_out*(original.nc()-2))/size_in;
                 down.set_size(part_nr, part_nc);
 
 
@@ -715,19 +1185,22 @@ namespace dlib
                 const_image_view<in_image_type> original(original_);
                 image_view<out_image_type> down(down_);
 
-                if (original.nr() <= 8 || original.nc() <= 8)
+                long part_nr, part_nc;
+                pyramid_down_3_2_size(original.nr(), original.nc(), part_nr, part_nc);
+                if (part_nr*part_nc == 0)
                 {
                     down.clear();
                     return;
                 }
 
+                if (try_pyramid_down_3_2_fast(original_, down_))
+                    return;
+
                 const long size_in = 3;
                 const long size_out = 2;
 
                 const long full_nr =  size_out*((original.nr()-2)/size_in);
-                const long part_nr = (size_out*(original.nr()-2))/size_in;
                 const long full_nc =  size_out*((original.nc()-2)/size_in);
-                const long part_nc = (size_out*(original.nc()-2))/size_in;
                 down.set_size(part_nr, part_nc);
 
 
@@ -941,7 +1414,9 @@ namespace dlib
             COMPILE_TIME_ASSERT( pixel_traits<out_pixel_type>::has_alpha == false );
 
 
-            set_image_size(down, ((N-1)*num_rows(original))/N+0.5, ((N-1)*num_columns(original))/N+0.5);
+            long down_nr, down_nc;
+            impl::pyramid_down_n_size<N>(num_rows(original), num_columns(original), down_nr, down_nc);
+            set_image_size(down, down_nr, down_nc);
             resize_image(original, down);
         }
 
@@ -977,6 +1452,71 @@ namespace dlib
         return (N-1.0)/N;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        // These functions report the size of the image the given pyramid_down object
+        // outputs when applied to an image with nr rows and nc columns.  They use the
+        // same size functions as the operator() implementations above.
+        template <unsigned int N>
+        void pyramid_down_size (
+            const pyramid_down<N>&,
+            long nr,
+            long nc,
+            long& out_nr,
+            long& out_nc
+        )
+        {
+            pyramid_down_n_size<N>(nr, nc, out_nr, out_nc);
+        }
+
+        inline void pyramid_down_size (
+            const pyramid_disable&,
+            long ,
+            long ,
+            long& out_nr,
+            long& out_nc
+        )
+        {
+            out_nr = 0;
+            out_nc = 0;
+        }
+
+        inline void pyramid_down_size (
+            const pyramid_down<1>& pyr,
+            long nr,
+            long nc,
+            long& out_nr,
+            long& out_nc
+        )
+        {
+            pyramid_down_size(static_cast<const pyramid_disable&>(pyr), nr, nc, out_nr, out_nc);
+        }
+
+        inline void pyramid_down_size (
+            const pyramid_down<2>&,
+            long nr,
+            long nc,
+            long& out_nr,
+            long& out_nc
+        )
+        {
+            pyramid_down_2_1_size(nr, nc, out_nr, out_nc);
+        }
+
+        inline void pyramid_down_size (
+            const pyramid_down<3>&,
+            long nr,
+            long nc,
+            long& out_nr,
+            long& out_nc
+        )
+        {
+            pyramid_down_3_2_size(nr, nc, out_nr, out_nc);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1002,24 +1542,23 @@ namespace dlib
 
         const long min_height = 5;
         pyramid_type pyr;
-        std::vector<matrix<rgb_pixel>> pyramid;
-        matrix<rgb_pixel> temp;
-        assign_image(temp, img);
-        pyramid.push_back(std::move(temp));
-        // build the whole pyramid
+        // Figure out the sizes of all the pyramid levels.  We don't build them yet since
+        // we are going to downsample each level directly into its place in out_img.
+        std::vector<rectangle> pyramid;
+        pyramid.push_back(get_rect(img));
         while(true)
         {
-            matrix<rgb_pixel> temp;
-            pyr(pyramid.back(), temp);
-            if (temp.size() == 0 || temp.nr() < min_height)
+            long nr, nc;
+            impl::pyramid_down_size(pyr, pyramid.back().height(), pyramid.back().width(), nr, nc);
+            if (nr*nc == 0 || nr < min_height)
                 break;
-            pyramid.push_back(std::move(temp));
+            pyramid.push_back(rectangle(nc,nr));
         }
 
         // figure out output image size
         long total_height = 0;
         for (auto&& i : pyramid)
-            total_height += i.nr()+padding;
+            total_height += i.height()+padding;
         total_height -= padding*2; // don't add unnecessary padding to the very right side.
         long height = 0;
         long prev_width = 0;
@@ -1028,48 +1567,55 @@ namespace dlib
             // Figure out how far we go on the first column.  We go until the next image can
             // fit next to the previous one, which means we can double back for the second
             // column of images.
-            if (i.nc() <= img.nc()-prev_width-(long)padding && 
-                (height-img.nr())*2 >= (total_height-img.nr()))
+            if ((long)i.width() <= num_columns(img)-prev_width-(long)padding && 
+                (height-num_rows(img))*2 >= (total_height-num_rows(img)))
             {
                 break;
             }
-            height += i.nr() + padding;
-            prev_width = i.nc();
+            height += i.height() + padding;
+            prev_width = i.width();
         }
         height -= padding; // don't add unnecessary padding to the very right side.
 
-        set_image_size(out_img,height,img.nc());
+        set_image_size(out_img,height,num_columns(img));
         assign_all_pixels(out_img, 0);
 
         long y = 0;
         size_t i = 0;
         while(y < height)
         {
-            rectangle rect = translate_rect(get_rect(pyramid[i]),point(0,y));
+            rectangle rect = translate_rect(pyramid[i],point(0,y));
             DLIB_ASSERT(get_rect(out_img).contains(rect));
             rects.push_back(rect);
-            auto si = sub_image(out_img, rect);
-            assign_image(si, pyramid[i]);
-            y += pyramid[i].nr()+padding;
+            y += pyramid[i].height()+padding;
             ++i;
         }
         y -= padding;
         while (i < pyramid.size())
         {
-            point p1(img.nc()-1,y-1);
-            point p2 = p1 - get_rect(pyramid[i]).br_corner();
+            point p1(num_columns(img)-1,y-1);
+            point p2 = p1 - pyramid[i].br_corner();
             rectangle rect(p1,p2);
             DLIB_ASSERT(get_rect(out_img).contains(rect));
             // don't keep going on the last row if it would intersect the original image.
             if (!get_rect(img).intersect(rect).is_empty())
                 break;
             rects.push_back(rect);
-            auto si = sub_image(out_img, rect);
-            assign_image(si, pyramid[i]);
-            y -= pyramid[i].nr()+padding;
+            y -= pyramid[i].height()+padding;
             ++i;
         }
 
+        // Now fill in the pyramid levels.  Each level is made by downsampling the
+        // previous level, which has just been written into out_img, so we avoid making a
+        // separate copy of each level and then copying it into out_img.
+        auto si = sub_image(out_img, rects[0]);
+        assign_image(si, img);
+        for (size_t j = 1; j < rects.size(); ++j)
+        {
+            auto prev = sub_image(out_img, rects[j-1]);
+            auto cur = sub_image(out_img, rects[j]);
+            pyr(prev, cur);
+        }
     }
 
 // ----------------------------------------------------------------------------------------
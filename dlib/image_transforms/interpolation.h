@@ -10,6 +10,8 @@
 #include "image_pyramid.h"
 #include "../simd.h"
 #include "../image_processing/full_object_detection.h"
+#include "../threads/parallel_for_extension.h"
+#include "../numeric_constants.h"
 
 namespace dlib
 {
@@ -1007,6 +1009,383 @@ namespace dlib
         resize_image(in_img, out_img, interpolate_bilinear());
     }
 
+// ----------------------------------------------------------------------------------------
+
+    class interpolate_area {};
+    class interpolate_lanczos3 {};
+
+    namespace impl
+    {
+        struct resize_coefficients
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds the filter taps used to resample one image axis.
+                    Output sample i is the sum, for t in [0,taps), of
+                    weights[i*taps+t] times input sample first[i]+t.
+            !*/
+            long taps = 0;
+            std::vector<long> first;
+            std::vector<float> weights;
+        };
+
+        template <typename kernel_type>
+        resize_coefficients compute_resize_coefficients (
+            long in_size,
+            long out_size,
+            double radius,
+            const kernel_type& kernel
+        )
+        /*!
+            requires
+                - in_size > 0
+                - out_size > 0
+            ensures
+                - Uses pixel center alignment to map the out_size output samples onto the
+                  in_size input samples.  Each output sample takes a weighted average of
+                  the input samples within radius of its location, where the weights are
+                  given by kernel(distance).  When downsampling, the kernel is stretched
+                  by the downsampling factor so that it acts as a low pass filter.
+                - Samples that fall outside the input are clamped to the nearest border
+                  sample and the weights of each output sample sum to 1.
+        !*/
+        {
+            const double scale = in_size/(double)out_size;
+            const double support = std::max(scale, 1.0);
+            const double r = radius*support;
+
+            resize_coefficients coef;
+            coef.taps = std::min<long>(in_size, static_cast<long>(std::ceil(2*r))+1);
+            coef.first.resize(out_size);
+            coef.weights.assign(out_size*coef.taps, 0);
+            for (long i = 0; i < out_size; ++i)
+            {
+                const double center = (i+0.5)*scale - 0.5;
+                const long lo = static_cast<long>(std::ceil(center - r));
+                const long hi = static_cast<long>(std::floor(center + r));
+                const long first = std::max(0L, std::min(lo, in_size-coef.taps));
+                coef.first[i] = first;
+
+                float* w = &coef.weights[i*coef.taps];
+                double total = 0;
+                for (long j = lo; j <= hi; ++j)
+                {
+                    const double val = kernel((j-center)/support);
+                    // There are at most taps samples in [lo,hi] so, after clamping to
+                    // the image, they all land inside the window starting at first.
+                    const long idx = std::max(0L, std::min(j, in_size-1)) - first;
+                    w[idx] += val;
+                    total += val;
+                }
+                if (total != 0)
+                {
+                    for (long t = 0; t < coef.taps; ++t)
+                        w[t] /= total;
+                }
+            }
+            return coef;
+        }
+
+        struct resize_area_kernel
+        {
+            // Area averaging is only used when downsampling.  When upsampling an axis
+            // we fall back to this triangle kernel, i.e. bilinear interpolation.
+            double operator() (double x) const
+            {
+                x = std::abs(x);
+                return x < 1 ? 1-x : 0;
+            }
+        };
+
+        struct resize_lanczos3_kernel
+        {
+            double operator() (double x) const
+            {
+                x = std::abs(x);
+                if (x < 1e-8)
+                    return 1;
+                if (x >= 3)
+                    return 0;
+                const double px = pi*x;
+                return 3*std::sin(px)*std::sin(px/3)/(px*px);
+            }
+        };
+
+        inline resize_coefficients compute_resize_coefficients (
+            long in_size,
+            long out_size,
+            interpolate_area
+        )
+        {
+            // When downsampling, each output pixel covers scale input pixels and its
+            // value is the average of them, weighted by how much of each one it covers.
+            const double scale = in_size/(double)out_size;
+            if (scale <= 1)
+                return compute_resize_coefficients(in_size, out_size, 1, resize_area_kernel());
+
+            struct box_overlap
+            {
+                double scale;
+                double operator() (double x) const
+                {
+                    // x is in units of output pixels here.  Return how much of the
+                    // input pixel at distance x overlaps the output pixel.
+                    const double half_in = 0.5/scale;
+                    const double lo = std::max(x-half_in, -0.5);
+                    const double hi = std::min(x+half_in, 0.5);
+                    return std::max(hi-lo, 0.0);
+                }
+            } kernel;
+            kernel.scale = scale;
+            return compute_resize_coefficients(in_size, out_size, 0.5+0.5/scale, kernel);
+        }
+
+        inline resize_coefficients compute_resize_coefficients (
+            long in_size,
+            long out_size,
+            interpolate_lanczos3
+        )
+        {
+            return compute_resize_coefficients(in_size, out_size, 3, resize_lanczos3_kernel());
+        }
+
+    // ----------------------------------------------------------------------------------------
+
+        template <typename T>
+        inline void resize_accumulate_row (
+            const T* row,
+            float w,
+            float* acc,
+            long n
+        )
+        {
+            for (long i = 0; i < n; ++i)
+                acc[i] += w*row[i];
+        }
+
+        inline void resize_accumulate_row (
+            const float* row,
+            float w,
+            float* acc,
+            long n
+        )
+        {
+            const simd8f ww = w;
+            long i = 0;
+            for (; i < n-7; i += 8)
+            {
+                simd8f a, r;
+                a.load(acc+i);
+                r.load(row+i);
+                a += ww*r;
+                a.store(acc+i);
+            }
+            for (; i < n; ++i)
+                acc[i] += w*row[i];
+        }
+
+        template <typename T>
+        inline typename enable_if<is_float_type<T> >::type resize_store_channel (
+            T& out,
+            float val
+        )
+        {
+            out = val;
+        }
+
+        template <typename T>
+        inline typename disable_if<is_float_type<T> >::type resize_store_channel (
+            T& out,
+            float val
+        )
+        {
+            // Round to nearest and saturate to the range of T.
+            assign_pixel(out, std::floor(val+0.5f));
+        }
+
+        template <
+            typename image_type1,
+            typename image_type2
+            >
+        void separable_resize_image (
+            const image_type1& in_img_,
+            image_type2& out_img_,
+            const resize_coefficients& xcoef,
+            const resize_coefficients& ycoef,
+            unsigned long num_threads
+        )
+        /*!
+            requires
+                - xcoef maps num_columns(in_img_) samples to num_columns(out_img_) samples
+                - ycoef maps num_rows(in_img_) samples to num_rows(out_img_) samples
+            ensures
+                - Resamples in_img_ into out_img_.  Each output row is made by first
+                  combining the input rows it needs with SIMD instructions, then applying
+                  the horizontal taps to that one row, also with SIMD instructions.  So no
+                  intermediate image is allocated.  If num_threads > 1 the output rows
+                  are split between num_threads threads.
+        !*/
+        {
+            typedef typename image_traits<image_type1>::pixel_type in_pixel_type;
+            typedef typename pixel_traits<in_pixel_type>::basic_pixel_type bp_type;
+            const long K = pixel_traits<in_pixel_type>::num;
+
+            // The channels of each pixel are processed as an array of bp_type.
+            COMPILE_TIME_ASSERT(sizeof(in_pixel_type) == K*sizeof(bp_type));
+
+            const_image_view<image_type1> in_img(in_img_);
+            image_view<image_type2> out_img(out_img_);
+
+            const long in_nc = in_img.nc();
+            const long out_nc = out_img.nc();
+            const long width = in_nc*K;
+
+            // The horizontal taps are applied as dot products 8 taps at a time, so we pad
+            // each output sample's weights with zeros out to a multiple of 8.
+            const long xtaps = (xcoef.taps+7)/8*8;
+            std::vector<float> xweights(out_nc*xtaps, 0);
+            for (long c = 0; c < out_nc; ++c)
+            {
+                for (long t = 0; t < xcoef.taps; ++t)
+                    xweights[c*xtaps+t] = xcoef.weights[c*xcoef.taps+t];
+            }
+
+            auto process_rows = [&](long begin, long end)
+            {
+                // acc is padded with xtaps zeros so the padded dot products never read
+                // past its end.  For color images the channels in acc are split out into
+                // planes, which are padded the same way, so each dot product reads
+                // contiguous memory.
+                std::vector<float> acc(width+xtaps, 0), row(width);
+                std::vector<float> planes(K == 1 ? 0 : K*(in_nc+xtaps), 0);
+                for (long r = begin; r < end; ++r)
+                {
+                    std::fill(acc.begin(), acc.begin()+width, 0);
+                    const float* wy = &ycoef.weights[r*ycoef.taps];
+                    for (long t = 0; t < ycoef.taps; ++t)
+                    {
+                        if (wy[t] == 0)
+                            continue;
+                        const bp_type* in = reinterpret_cast<const bp_type*>(&in_img[ycoef.first[r]+t][0]);
+                        if (is_same_type<bp_type,float>::value)
+                        {
+                            resize_accumulate_row(in, wy[t], &acc[0], width);
+                        }
+                        else
+                        {
+                            for (long i = 0; i < width; ++i)
+                                row[i] = in[i];
+                            resize_accumulate_row(&row[0], wy[t], &acc[0], width);
+                        }
+                    }
+
+                    const float* plane = &acc[0];
+                    const long plane_stride = in_nc+xtaps;
+                    if (K != 1)
+                    {
+                        for (long k = 0; k < K; ++k)
+                        {
+                            for (long c = 0; c < in_nc; ++c)
+                                planes[k*plane_stride+c] = acc[c*K+k];
+                        }
+                        plane = &planes[0];
+                    }
+
+                    for (long c = 0; c < out_nc; ++c)
+                    {
+                        const float* wx = &xweights[c*xtaps];
+                        in_pixel_type p;
+                        bp_type* pp = reinterpret_cast<bp_type*>(&p);
+                        for (long k = 0; k < K; ++k)
+                        {
+                            const float* a = plane + k*plane_stride + xcoef.first[c];
+                            simd8f val = 0, w, v;
+                            for (long t = 0; t < xtaps; t += 8)
+                            {
+                                w.load(wx+t);
+                                v.load(a+t);
+                                val += w*v;
+                            }
+                            resize_store_channel(pp[k], sum(val));
+                        }
+                        assign_pixel(out_img[r][c], p);
+                    }
+                }
+            };
+
+            if (num_threads <= 1)
+                process_rows(0, out_img.nr());
+            else
+                parallel_for_blocked(num_threads, 0, out_img.nr(), process_rows, 1);
+        }
+
+        template <
+            typename image_type1,
+            typename image_type2,
+            typename interpolation_type
+            >
+        void separable_resize_image (
+            const image_type1& in_img,
+            image_type2& out_img,
+            interpolation_type interp,
+            unsigned long num_threads
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT( is_same_object(in_img, out_img) == false ,
+                "\t void resize_image()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t is_same_object(in_img, out_img):  " << is_same_object(in_img, out_img)
+                );
+            typedef typename image_traits<image_type1>::pixel_type in_pixel_type;
+            COMPILE_TIME_ASSERT(pixel_traits<in_pixel_type>::has_alpha == false);
+
+            if (num_rows(out_img)*num_columns(out_img) == 0)
+                return;
+            if (num_rows(in_img)*num_columns(in_img) == 0)
+            {
+                assign_all_pixels(out_img, 0);
+                return;
+            }
+
+            const resize_coefficients xcoef = compute_resize_coefficients(num_columns(in_img), num_columns(out_img), interp);
+            const resize_coefficients ycoef = compute_resize_coefficients(num_rows(in_img), num_rows(out_img), interp);
+            separable_resize_image(in_img, out_img, xcoef, ycoef, num_threads);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type1,
+        typename image_type2
+        >
+    void resize_image (
+        const image_type1& in_img,
+        image_type2& out_img,
+        interpolate_area interp,
+        unsigned long num_threads = 1
+    )
+    {
+        impl::separable_resize_image(in_img, out_img, interp, num_threads);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type1,
+        typename image_type2
+        >
+    void resize_image (
+        const image_type1& in_img,
+        image_type2& out_img,
+        interpolate_lanczos3 interp,
+        unsigned long num_threads = 1
+    )
+    {
+        impl::separable_resize_image(in_img, out_img, interp, num_threads);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1746,6 +2125,163 @@ namespace dlib
                 }
             }
         }
+
+        inline bool bilinear_chip_footprint_inside (
+            const long x,
+            const long y,
+            const long nr,
+            const long nc
+        )
+        /*!
+            ensures
+                - returns true if the 2x2 block of pixels with top left corner (x,y), which
+                  is what bilinear_affine_warp_u8() blends, is inside an nr by nc image.
+        !*/
+        {
+            return x >= 0 && y >= 0 && x+1 < nc && y+1 < nr;
+        }
+
+        template <long channels>
+        void bilinear_affine_warp_u8 (
+            const unsigned char* in,
+            const long in_nr,
+            const long in_nc,
+            const long in_width_step,
+            unsigned char* out,
+            const long out_nr,
+            const long out_nc,
+            const long out_width_step,
+            const point_transform_affine& trns
+        )
+        /*!
+            requires
+                - in and out point to images with channels bytes per pixel.  That is, images
+                  of unsigned char or rgb_pixel.
+            ensures
+                - This is a fast version of transform_image(in, out, interpolate_bilinear(),
+                  trns).  It does exactly the same arithmetic as interpolate_bilinear so
+                  the outputs are identical.  It is faster because it works directly on the
+                  raw pixel buffers and processes blocks of 8 pixels with loops the compiler
+                  can vectorize.
+        !*/
+        {
+            const matrix<double,2,2>& m = trns.get_m();
+            const dlib::vector<double,2>& b = trns.get_b();
+            const long block = 8;
+            double px[block], py[block], lr_frac[block], tb_frac[block];
+            double tl[channels][block], tr[channels][block], bl[channels][block], br[channels][block];
+            double vals[channels][block];
+            bool inside[block];
+            for (long r = 0; r < out_nr; ++r)
+            {
+                // These are the same operations point_transform_affine performs for the
+                // point (c,r), just with the parts that only depend on r pulled out.
+                const double rx = m(0,1)*r;
+                const double ry = m(1,1)*r;
+                unsigned char* out_row = out + r*out_width_step;
+                for (long c = 0; c < out_nc; c += block)
+                {
+                    // The loops over the block are simple enough that the compiler can
+                    // vectorize them.
+                    for (long i = 0; i < block; ++i)
+                    {
+                        px[i] = (m(0,0)*(c+i) + rx) + b.x();
+                        py[i] = (m(1,0)*(c+i) + ry) + b.y();
+                    }
+                    for (long i = 0; i < block; ++i)
+                    {
+                        lr_frac[i] = std::floor(px[i]);
+                        tb_frac[i] = std::floor(py[i]);
+                    }
+
+                    const long num = std::min(block, out_nc-c);
+                    for (long i = 0; i < block; ++i)
+                    {
+                        const long left = static_cast<long>(lr_frac[i]);
+                        const long top = static_cast<long>(tb_frac[i]);
+                        inside[i] = i < num && bilinear_chip_footprint_inside(left, top, in_nr, in_nc);
+                        if (inside[i])
+                        {
+                            const unsigned char* t = in + top*in_width_step + left*channels;
+                            const unsigned char* bt = t + in_width_step;
+                            for (long k = 0; k < channels; ++k)
+                            {
+                                tl[k][i] = t[k];
+                                tr[k][i] = t[k+channels];
+                                bl[k][i] = bt[k];
+                                br[k][i] = bt[k+channels];
+                            }
+                        }
+                        else
+                        {
+                            for (long k = 0; k < channels; ++k)
+                                tl[k][i] = tr[k][i] = bl[k][i] = br[k][i] = 0;
+                        }
+                    }
+
+                    for (long i = 0; i < block; ++i)
+                    {
+                        lr_frac[i] = px[i] - lr_frac[i];
+                        tb_frac[i] = py[i] - tb_frac[i];
+                    }
+                    for (long k = 0; k < channels; ++k)
+                    {
+                        for (long i = 0; i < block; ++i)
+                        {
+                            vals[k][i] = (1-tb_frac[i])*((1-lr_frac[i])*tl[k][i] + lr_frac[i]*tr[k][i]) + 
+                                             tb_frac[i]*((1-lr_frac[i])*bl[k][i] + lr_frac[i]*br[k][i]);
+                        }
+                    }
+
+                    unsigned char* o = out_row + c*channels;
+                    for (long i = 0; i < num; ++i)
+                    {
+                        // Outside pixels are 0, just like with transform_image().
+                        for (long k = 0; k < channels; ++k)
+                            *o++ = inside[i] ? static_cast<unsigned char>(std::min(vals[k][i], 255.0)) : 0;
+                    }
+                }
+            }
+        }
+
+        template <typename image_type1, typename image_type2>
+        struct use_fast_chip_warp
+        {
+            typedef typename image_traits<image_type1>::pixel_type in_pixel_type;
+            typedef typename image_traits<image_type2>::pixel_type out_pixel_type;
+            const static bool value = is_same_type<in_pixel_type,out_pixel_type>::value &&
+                (is_same_type<in_pixel_type,unsigned char>::value || is_same_type<in_pixel_type,rgb_pixel>::value);
+        };
+
+        template <
+            typename image_type1,
+            typename image_type2
+            >
+        typename enable_if<use_fast_chip_warp<image_type1,image_type2> >::type warp_image_chip (
+            const image_type1& img,
+            image_type2& chip,
+            const point_transform_affine& trns
+        )
+        {
+            typedef typename image_traits<image_type1>::pixel_type pixel_type;
+            bilinear_affine_warp_u8<sizeof(pixel_type)>(
+                (const unsigned char*)image_data(img), num_rows(img), num_columns(img), width_step(img),
+                (unsigned char*)image_data(chip), num_rows(chip), num_columns(chip), width_step(chip),
+                trns);
+        }
+
+        template <
+            typename image_type1,
+            typename image_type2
+            >
+        typename disable_if<use_fast_chip_warp<image_type1,image_type2> >::type warp_image_chip (
+            const image_type1& img,
+            image_type2& chip,
+            const point_transform_affine& trns
+        )
+        {
+            transform_image(img,chip,interpolate_bilinear(),trns);
+        }
     }
 
 // ----------------------------------------------------------------------------------------
@@ -1757,7 +2293,8 @@ namespace dlib
     void extract_image_chips (
         const image_type1& img,
         const std::vector<chip_details>& chip_locations,
-        dlib::array<image_type2>& chips
+        dlib::array<image_type2>& chips,
+        unsigned long num_threads = 1
     )
     {
         // make sure requires clause is not broken
@@ -1815,11 +2352,9 @@ namespace dlib
         for (unsigned long i = 1; i < levels.size(); ++i)
             pyr(levels[i-1],levels[i]);
 
-        std::vector<dlib::vector<double,2> > from, to;
-
         // now pull out the chips
         chips.resize(chip_locations.size());
-        for (unsigned long i = 0; i < chips.size(); ++i)
+        auto extract_chip = [&](long i)
         {
             // If the chip doesn't have any rotation or scaling then use the basic version
             // of chip extraction that just does a fast copy.
@@ -1844,8 +2379,7 @@ namespace dlib
 
                 // find the appropriate transformation that maps from the chip to the input
                 // image
-                from.clear();
-                to.clear();
+                std::vector<dlib::vector<double,2> > from, to;
                 from.push_back(get_rect(chips[i]).tl_corner());  to.push_back(rotate_point<double>(center(rect),rect.tl_corner(),chip_locations[i].angle));
                 from.push_back(get_rect(chips[i]).tr_corner());  to.push_back(rotate_point<double>(center(rect),rect.tr_corner(),chip_locations[i].angle));
                 from.push_back(get_rect(chips[i]).bl_corner());  to.push_back(rotate_point<double>(center(rect),rect.bl_corner(),chip_locations[i].angle));
@@ -1853,10 +2387,22 @@ namespace dlib
 
                 // now extract the actual chip
                 if (level == -1)
-                    transform_image(sub_image(img,bounding_box),chips[i],interpolate_bilinear(),trns);
+                    impl::warp_image_chip(sub_image(img,bounding_box),chips[i],trns);
                 else
-                    transform_image(levels[level],chips[i],interpolate_bilinear(),trns);
+                    impl::warp_image_chip(levels[level],chips[i],trns);
             }
+        };
+
+        if (num_threads > 1)
+        {
+            // The chips are all independent of each other, so they can be extracted in
+            // parallel.
+            parallel_for(num_threads, 0, chips.size(), extract_chip);
+        }
+        else
+        {
+            for (unsigned long i = 0; i < chips.size(); ++i)
+                extract_chip(i);
         }
     }
 
@@ -414,6 +414,89 @@ namespace dlib
             - Uses the bilinear interpolation to perform the necessary pixel interpolation.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    class interpolate_area {};
+    class interpolate_lanczos3 {};
+    /*!
+        WHAT THESE OBJECTS REPRESENT
+            These are tag types that select a resampling method for resize_image().
+            Unlike the interpolate_* objects above, they do not interpolate at
+            arbitrary points and so can't be used with the other routines in this
+            file.
+            
+            interpolate_area averages all the input pixels covered by each output
+            pixel, weighting each one by how much of it is covered.  This is the
+            right choice for shrinking images since it doesn't alias.  When an axis is
+            enlarged it behaves like bilinear interpolation.
+
+            interpolate_lanczos3 uses a Lanczos windowed sinc filter with 3 lobes.  It
+            gives sharper results than bilinear interpolation in both directions and,
+            when shrinking, the filter is stretched to avoid aliasing.
+    !*/
+
+    template <
+        typename image_type1,
+        typename image_type2
+        >
+    void resize_image (
+        const image_type1& in_img,
+        image_type2& out_img,
+        interpolate_area interp,
+        unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - image_type1 == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - image_type2 == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - pixel_traits<typename image_traits<image_type1>::pixel_type>::has_alpha == false
+            - is_same_object(in_img, out_img) == false
+        ensures
+            - #out_img == A copy of in_img which has been stretched so that it 
+              fits exactly into out_img.   
+            - The size of out_img is not modified.  I.e. 
+                - #out_img.nr() == out_img.nr()
+                - #out_img.nc() == out_img.nc()
+            - Pixels are resampled using area averaging (see interpolate_area above).
+              Pixel centers are aligned, so shrinking an image by an integer factor N
+              makes each output pixel the mean of an NxN block of input pixels.
+            - The output is computed in the pixel type of in_img, rounded to the
+              nearest value if it is an integer type, and then copied into out_img
+              with assign_pixel().
+            - The image is resampled one output row at a time with SIMD instructions,
+              so no intermediate image is allocated.  If num_threads > 1 then the rows
+              are split among num_threads threads.  The results do not depend on
+              num_threads.
+            - If in_img is empty then all pixels in #out_img are set to 0.
+    !*/
+
+    template <
+        typename image_type1,
+        typename image_type2
+        >
+    void resize_image (
+        const image_type1& in_img,
+        image_type2& out_img,
+        interpolate_lanczos3 interp,
+        unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - image_type1 == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - image_type2 == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - pixel_traits<typename image_traits<image_type1>::pixel_type>::has_alpha == false
+            - is_same_object(in_img, out_img) == false
+        ensures
+            - This function is identical to the interpolate_area version of
+              resize_image() defined above except that the pixels are resampled with a
+              Lanczos-3 filter (see interpolate_lanczos3 above).  Values outside the
+              image are taken from the nearest border pixel.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1117,7 +1200,8 @@ namespace dlib
     void extract_image_chips (
         const image_type1& img,
         const std::vector<chip_details>& chip_locations,
-        dlib::array<image_type2>& chips
+        dlib::array<image_type2>& chips,
+        unsigned long num_threads = 1
     );
     /*!
         requires
@@ -1145,6 +1229,13 @@ namespace dlib
                   chip_locations[i].angle radians, around the center of
                   chip_locations[i].rect, before the chip was extracted. 
             - Any pixels in an image chip that go outside img are set to 0 (i.e. black).
+            - The chips are extracted using num_threads threads.  Since each chip is
+              independent this gives a near linear speedup when extracting many chips.
+            - When img and the chips both contain unsigned char or rgb_pixel pixels the
+              scaled and rotated chips are extracted with an optimized version of
+              bilinear interpolation that works directly on the pixel buffers.  It gives
+              exactly the same pixel values as transform_image() with
+              interpolate_bilinear.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -5,6 +5,9 @@
 
 #include "label_connected_blobs_abstract.h"
 #include "../geometry.h"
+#include "../array2d.h"
+#include "../threads/parallel_for_extension.h"
+#include <algorithm>
 #include <stack>
 #include <vector>
 
@@ -105,81 +108,547 @@ namespace dlib
 
 // ----------------------------------------------------------------------------------------
 
-    template <
-        typename image_type,
-        typename label_image_type,
-        typename background_functor_type,
-        typename neighbors_functor_type,
-        typename connected_functor_type
-        >
-    unsigned long label_connected_blobs (
-        const image_type& img_,
-        const background_functor_type& is_background,
-        const neighbors_functor_type&  get_neighbors,
-        const connected_functor_type&  is_connected,
-        label_image_type& label_img_
-    )
+    struct blob_stats
     {
-        // make sure requires clause is not broken
-        DLIB_ASSERT(is_same_object(img_, label_img_) == false,
-            "\t unsigned long label_connected_blobs()"
-            << "\n\t The input image and output label image can't be the same object."
-            );
+        blob_stats() : area(0) {}
 
-        const_image_view<image_type> img(img_);
-        image_view<label_image_type> label_img(label_img_);
+        unsigned long area;
+        rectangle rect;
+        dpoint centroid;
+    };
 
-        std::stack<point> neighbors;
-        label_img.set_size(img.nr(), img.nc());
-        assign_all_pixels(label_img, 0);
-        unsigned long next = 1;
+// ----------------------------------------------------------------------------------------
 
-        if (img.size() == 0)
-            return 0;
+    namespace impl
+    {
+        struct blob_accumulator
+        {
+            blob_accumulator (
+            ) : area(0), sum_x(0), sum_y(0), left(0), top(0), right(-1), bottom(-1) {}
 
-        const rectangle area = get_rect(img);
+            void add (
+                long x,
+                long y
+            )
+            {
+                if (area == 0)
+                {
+                    left = right = x;
+                    top = bottom = y;
+                }
+                else
+                {
+                    left = std::min(left, x);
+                    right = std::max(right, x);
+                    top = std::min(top, y);
+                    bottom = std::max(bottom, y);
+                }
+                ++area;
+                sum_x += x;
+                sum_y += y;
+            }
+
+            void add (
+                const blob_accumulator& item
+            )
+            {
+                if (item.area == 0)
+                    return;
+                if (area == 0)
+                {
+                    *this = item;
+                    return;
+                }
+                area += item.area;
+                sum_x += item.sum_x;
+                sum_y += item.sum_y;
+                left = std::min(left, item.left);
+                right = std::max(right, item.right);
+                top = std::min(top, item.top);
+                bottom = std::max(bottom, item.bottom);
+            }
+
+            blob_stats get_stats (
+            ) const
+            {
+                blob_stats temp;
+                temp.area = area;
+                if (area != 0)
+                {
+                    temp.rect = rectangle(left, top, right, bottom);
+                    temp.centroid = dpoint(sum_x/area, sum_y/area);
+                }
+                return temp;
+            }
+
+            unsigned long area;
+            double sum_x, sum_y;
+            long left, top, right, bottom;
+        };
+
+        // A union-find forest where every node's parent has a smaller label than the node
+        // itself.  So the root of a set is always its smallest label.
+        inline uint32 find_blob_root (
+            std::vector<uint32>& parent,
+            uint32 x
+        )
+        {
+            while (parent[x] != x)
+            {
+                parent[x] = parent[parent[x]];
+                x = parent[x];
+            }
+            return x;
+        }
 
-        std::vector<point> window;
+        inline uint32 join_blobs (
+            std::vector<uint32>& parent,
+            uint32 a,
+            uint32 b
+        )
+        {
+            a = find_blob_root(parent, a);
+            b = find_blob_root(parent, b);
+            if (a < b)
+            {
+                parent[b] = a;
+                return a;
+            }
+            parent[a] = b;
+            return b;
+        }
 
-        for (long r = 0; r < img.nr(); ++r)
+        template <
+            typename in_image_type,
+            typename prov_image_type,
+            typename background_functor_type,
+            typename connected_functor_type
+            >
+        void label_blob_band (
+            const in_image_type& img,
+            const background_functor_type& is_background,
+            const connected_functor_type& is_connected,
+            const bool use_8_neighbors,
+            const long row_begin,
+            const long row_end,
+            prov_image_type& prov,
+            std::vector<uint32>& parent,
+            std::vector<blob_accumulator>* stats
+        )
+        /*!
+            ensures
+                - This is the first pass of the two pass connected components algorithm,
+                  run on the rows [row_begin, row_end) without looking outside them.
+                  Each pixel gets a provisional label in prov and parent records which
+                  provisional labels belong to the same blob.  Label 0 is the
+                  background.
+                - Labels are created in raster order.
+                - if (stats) then (*stats)[l] accumulates the pixels given label l.
+        !*/
         {
-            for (long c = 0; c < img.nc(); ++c)
+            parent.assign(1, 0);
+            if (stats)
+                stats->assign(1, blob_accumulator());
+
+            for (long r = row_begin; r < row_end; ++r)
             {
-                // skip already labeled pixels or background pixels
-                if (label_img[r][c] != 0 || is_background(img,point(c,r)))
-                    continue;
+                for (long c = 0; c < img.nc(); ++c)
+                {
+                    const point p(c,r);
+                    if (is_background(img, p))
+                    {
+                        prov[r][c] = 0;
+                        if (stats)
+                            (*stats)[0].add(c,r);
+                        continue;
+                    }
 
-                label_img[r][c] = next;
+                    // Look at the neighbors that have already been labeled.  Background
+                    // pixels have label 0 so they are skipped without calling
+                    // is_background() again.
+                    uint32 label = 0;
+                    const long num_prev = use_8_neighbors ? 4 : 2;
+                    const long dx[4] = {-1, 0, -1, 1};
+                    const long dy[4] = { 0,-1, -1,-1};
+                    for (long i = 0; i < num_prev; ++i)
+                    {
+                        const long x = c + dx[i];
+                        const long y = r + dy[i];
+                        if (x < 0 || x >= img.nc() || y < row_begin)
+                            continue;
+                        const uint32 q = prov[y][x];
+                        if (q != 0 && is_connected(img, point(x,y), p))
+                        {
+                            if (label == 0)
+                                label = find_blob_root(parent, q);
+                            else
+                                label = join_blobs(parent, label, q);
+                        }
+                    }
+
+                    if (label == 0)
+                    {
+                        label = parent.size();
+                        parent.push_back(label);
+                        if (stats)
+                            stats->push_back(blob_accumulator());
+                    }
+                    prov[r][c] = label;
+                    if (stats)
+                        (*stats)[label].add(c,r);
+                }
+            }
+        }
 
-                // label all the neighbors of this point 
-                neighbors.push(point(c,r));
-                while (neighbors.size() > 0)
+        template <
+            typename image_type,
+            typename label_image_type,
+            typename prov_image_type,
+            typename background_functor_type,
+            typename connected_functor_type
+            >
+        unsigned long label_blobs_union_find (
+            const image_type& img_,
+            const background_functor_type& is_background,
+            const bool use_8_neighbors,
+            const connected_functor_type& is_connected,
+            label_image_type& label_img_,
+            prov_image_type& prov,
+            std::vector<blob_stats>* stats,
+            unsigned long num_threads
+        )
+        /*!
+            ensures
+                - labels the blobs with the two pass union-find algorithm.  The image is
+                  split into horizontal bands, one per thread, which are labeled
+                  independently and then stitched together.  prov holds the provisional
+                  labels and may be the same object as label_img_.
+        !*/
+        {
+            const_image_view<image_type> img(img_);
+            image_view<label_image_type> label_img(label_img_);
+
+            const long num_bands = std::max<long>(1, std::min<long>(num_threads, img.nr()));
+            std::vector<long> band_begin(num_bands+1);
+            for (long b = 0; b <= num_bands; ++b)
+                band_begin[b] = img.nr()*b/num_bands;
+
+            std::vector<std::vector<uint32> > band_parent(num_bands);
+            std::vector<std::vector<blob_accumulator> > band_stats(stats ? num_bands : 0);
+            auto first_pass = [&](long b) {
+                label_blob_band(img, is_background, is_connected, use_8_neighbors,
+                    band_begin[b], band_begin[b+1], prov, band_parent[b], stats ? &band_stats[b] : 0);
+            };
+            if (num_bands == 1)
+                first_pass(0);
+            else
+                parallel_for(num_threads, 0, num_bands, first_pass);
+
+            // Put all the provisional labels into one forest.  Band b's labels are
+            // offset by band_offset[b].
+            std::vector<uint32> band_offset(num_bands);
+            std::vector<uint32> parent(1, 0);
+            for (long b = 0; b < num_bands; ++b)
+            {
+                band_offset[b] = parent.size()-1;
+                for (unsigned long i = 1; i < band_parent[b].size(); ++i)
+                    parent.push_back(band_offset[b] + band_parent[b][i]);
+            }
+
+            // Join the blobs that cross the band boundaries.
+            for (long b = 1; b < num_bands; ++b)
+            {
+                const long r = band_begin[b];
+                for (long c = 0; c < img.nc(); ++c)
                 {
-                    const point p = neighbors.top();
-                    neighbors.pop();
+                    const uint32 label = prov[r][c];
+                    if (label == 0)
+                        continue;
+                    for (long x = std::max(0L, c - (use_8_neighbors ? 1 : 0));
+                         x <= std::min(img.nc()-1, c + (use_8_neighbors ? 1 : 0)); ++x)
+                    {
+                        const uint32 q = prov[r-1][x];
+                        if (q != 0 && is_connected(img, point(x,r-1), point(c,r)))
+                            join_blobs(parent, band_offset[b] + label, band_offset[b-1] + q);
+                    }
+                }
+            }
 
-                    window.clear();
-                    get_neighbors(p, window);
+            // Every parent has a smaller label than its child so one forward pass finds
+            // all the roots.  A blob's root is the label made at its first pixel in
+            // raster order, so numbering the roots in order gives the same labels as
+            // the flood fill did.
+            std::vector<uint32> final_label(parent.size(), 0);
+            uint32 next = 1;
+            for (unsigned long i = 1; i < parent.size(); ++i)
+            {
+                if (parent[i] == i)
+                    final_label[i] = next++;
+                else
+                    final_label[i] = final_label[parent[i]];
+            }
 
-                    for (unsigned long i = 0; i < window.size(); ++i)
+            auto second_pass = [&](long b) {
+                for (long r = band_begin[b]; r < band_begin[b+1]; ++r)
+                {
+                    for (long c = 0; c < img.nc(); ++c)
                     {
-                        if (area.contains(window[i]) &&                     // point in image.
-                            !is_background(img,window[i]) &&                // isn't background.
-                            label_img[window[i].y()][window[i].x()] == 0 && // haven't already labeled it.
-                            is_connected(img, p, window[i]))                // it's connected.
+                        const uint32 label = prov[r][c];
+                        label_img[r][c] = label == 0 ? 0 : final_label[band_offset[b] + label];
+                    }
+                }
+            };
+            if (num_bands == 1)
+                second_pass(0);
+            else
+                parallel_for(num_threads, 0, num_bands, second_pass);
+
+            if (stats)
+            {
+                std::vector<blob_accumulator> acc(next);
+                for (long b = 0; b < num_bands; ++b)
+                {
+                    acc[0].add(band_stats[b][0]);
+                    for (unsigned long i = 1; i < band_stats[b].size(); ++i)
+                        acc[final_label[band_offset[b] + i]].add(band_stats[b][i]);
+                }
+                stats->resize(next);
+                for (unsigned long i = 0; i < acc.size(); ++i)
+                    (*stats)[i] = acc[i].get_stats();
+            }
+
+            return next;
+        }
+
+        template <
+            typename image_type,
+            typename label_image_type,
+            typename background_functor_type,
+            typename connected_functor_type
+            >
+        unsigned long label_blobs (
+            const image_type& img,
+            const background_functor_type& is_background,
+            const bool use_8_neighbors,
+            const connected_functor_type& is_connected,
+            label_image_type& label_img,
+            std::vector<blob_stats>* stats,
+            unsigned long num_threads
+        )
+        {
+            typedef typename image_traits<label_image_type>::pixel_type label_type;
+            image_view<label_image_type> label_view(label_img);
+            label_view.set_size(num_rows(img), num_columns(img));
+            if (label_view.size() == 0)
+            {
+                if (stats)
+                    stats->clear();
+                return 0;
+            }
+
+            // The provisional labels can outnumber the final ones so they are only kept
+            // in label_img if its pixels are unsigned integers of at least 32 bits.  A
+            // float label image, for instance, can't hold every uint32 exactly.
+            if (is_unsigned_type<label_type>::value && sizeof(label_type) >= sizeof(uint32))
+            {
+                return label_blobs_union_find(img, is_background, use_8_neighbors, is_connected,
+                    label_img, label_view, stats, num_threads);
+            }
+            else
+            {
+                array2d<uint32> prov(label_view.nr(), label_view.nc());
+                return label_blobs_union_find(img, is_background, use_8_neighbors, is_connected,
+                    label_img, prov, stats, num_threads);
+            }
+        }
+
+        template <
+            typename image_type,
+            typename label_image_type,
+            typename background_functor_type,
+            typename connected_functor_type
+            >
+        unsigned long label_blobs (
+            const image_type& img,
+            const background_functor_type& is_background,
+            const neighbors_8& ,
+            const connected_functor_type& is_connected,
+            label_image_type& label_img,
+            std::vector<blob_stats>* stats,
+            unsigned long num_threads
+        )
+        {
+            return label_blobs(img, is_background, true, is_connected, label_img, stats, num_threads);
+        }
+
+        template <
+            typename image_type,
+            typename label_image_type,
+            typename background_functor_type,
+            typename connected_functor_type
+            >
+        unsigned long label_blobs (
+            const image_type& img,
+            const background_functor_type& is_background,
+            const neighbors_4& ,
+            const connected_functor_type& is_connected,
+            label_image_type& label_img,
+            std::vector<blob_stats>* stats,
+            unsigned long num_threads
+        )
+        {
+            return label_blobs(img, is_background, false, is_connected, label_img, stats, num_threads);
+        }
+
+        template <
+            typename image_type,
+            typename label_image_type,
+            typename background_functor_type,
+            typename neighbors_functor_type,
+            typename connected_functor_type
+            >
+        unsigned long label_blobs (
+            const image_type& img_,
+            const background_functor_type& is_background,
+            const neighbors_functor_type&  get_neighbors,
+            const connected_functor_type&  is_connected,
+            label_image_type& label_img_,
+            std::vector<blob_stats>* stats,
+            unsigned long 
+        )
+        /*!
+            ensures
+                - labels the blobs with a flood fill.  This is used for user supplied
+                  neighborhoods since the union-find version only knows about
+                  neighbors_4 and neighbors_8.
+        !*/
+        {
+            const_image_view<image_type> img(img_);
+            image_view<label_image_type> label_img(label_img_);
+
+            std::stack<point> neighbors;
+            label_img.set_size(img.nr(), img.nc());
+            assign_all_pixels(label_img, 0);
+            unsigned long next = 1;
+
+            if (img.size() == 0)
+            {
+                if (stats)
+                    stats->clear();
+                return 0;
+            }
+
+            const rectangle area = get_rect(img);
+
+            std::vector<point> window;
+
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                for (long c = 0; c < img.nc(); ++c)
+                {
+                    // skip already labeled pixels or background pixels
+                    if (label_img[r][c] != 0 || is_background(img,point(c,r)))
+                        continue;
+
+                    label_img[r][c] = next;
+
+                    // label all the neighbors of this point 
+                    neighbors.push(point(c,r));
+                    while (neighbors.size() > 0)
+                    {
+                        const point p = neighbors.top();
+                        neighbors.pop();
+
+                        window.clear();
+                        get_neighbors(p, window);
+
+                        for (unsigned long i = 0; i < window.size(); ++i)
                         {
-                            label_img[window[i].y()][window[i].x()] = next;
-                            neighbors.push(window[i]);
+                            if (area.contains(window[i]) &&                     // point in image.
+                                !is_background(img,window[i]) &&                // isn't background.
+                                label_img[window[i].y()][window[i].x()] == 0 && // haven't already labeled it.
+                                is_connected(img, p, window[i]))                // it's connected.
+                            {
+                                label_img[window[i].y()][window[i].x()] = next;
+                                neighbors.push(window[i]);
+                            }
                         }
                     }
+
+                    ++next;
                 }
+            }
 
-                ++next;
+            if (stats)
+            {
+                std::vector<blob_accumulator> acc(next);
+                for (long r = 0; r < label_img.nr(); ++r)
+                    for (long c = 0; c < label_img.nc(); ++c)
+                        acc[label_img[r][c]].add(c,r);
+                stats->resize(next);
+                for (unsigned long i = 0; i < acc.size(); ++i)
+                    (*stats)[i] = acc[i].get_stats();
             }
+
+            return next;
         }
+    }
 
-        return next;
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type,
+        typename label_image_type,
+        typename background_functor_type,
+        typename neighbors_functor_type,
+        typename connected_functor_type
+        >
+    unsigned long label_connected_blobs (
+        const image_type& img,
+        const background_functor_type& is_background,
+        const neighbors_functor_type&  get_neighbors,
+        const connected_functor_type&  is_connected,
+        label_image_type& label_img,
+        unsigned long num_threads = 1
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_same_object(img, label_img) == false,
+            "\t unsigned long label_connected_blobs()"
+            << "\n\t The input image and output label image can't be the same object."
+            );
+
+        return impl::label_blobs(img, is_background, get_neighbors, is_connected, label_img, 0, num_threads);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type,
+        typename label_image_type,
+        typename background_functor_type,
+        typename neighbors_functor_type,
+        typename connected_functor_type
+        >
+    unsigned long label_connected_blobs (
+        const image_type& img,
+        const background_functor_type& is_background,
+        const neighbors_functor_type&  get_neighbors,
+        const connected_functor_type&  is_connected,
+        label_image_type& label_img,
+        std::vector<blob_stats>& stats,
+        unsigned long num_threads = 1
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_same_object(img, label_img) == false,
+            "\t unsigned long label_connected_blobs()"
+            << "\n\t The input image and output label image can't be the same object."
+            );
+
+        return impl::label_blobs(img, is_background, get_neighbors, is_connected, label_img, &stats, num_threads);
     }
+
 // ----------------------------------------------------------------------------------------
 
 }
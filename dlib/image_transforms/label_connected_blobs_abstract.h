@@ -143,7 +143,8 @@ namespace dlib
         const background_functor_type& is_background,
         const neighbors_functor_type&  get_neighbors,
         const connected_functor_type&  is_connected,
-        label_image_type& label_img
+        label_image_type& label_img,
+        unsigned long num_threads = 1
     );
     /*!
         requires
@@ -189,6 +190,61 @@ namespace dlib
               the number of blobs in the image (including the background blob).
             - It is guaranteed that is_connected() and is_background() will never be 
               called with points outside the image.
+            - If get_neighbors is a neighbors_4 or neighbors_8 object then the blobs are
+              found with a two pass union-find algorithm.  In this case the image is split
+              into num_threads horizontal bands which are labeled in parallel.  So if
+              num_threads > 1 then is_background() and is_connected() must be safe to
+              call from multiple threads at the same time.  For any other get_neighbors
+              a single threaded flood fill is used and num_threads is ignored.  Both
+              methods produce identical label images.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    struct blob_stats
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds some simple statistics describing one of the blobs
+                found by label_connected_blobs().
+        !*/
+
+        blob_stats() : area(0) {}
+
+        unsigned long area;  // The number of pixels in the blob.
+        rectangle rect;      // The smallest rectangle that contains all the blob's pixels.
+        dpoint centroid;     // The average location of the blob's pixels.
+    };
+
+    template <
+        typename image_type,
+        typename label_image_type,
+        typename background_functor_type,
+        typename neighbors_functor_type,
+        typename connected_functor_type
+        >
+    unsigned long label_connected_blobs (
+        const image_type& img,
+        const background_functor_type& is_background,
+        const neighbors_functor_type&  get_neighbors,
+        const connected_functor_type&  is_connected,
+        label_image_type& label_img,
+        std::vector<blob_stats>& stats,
+        unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - The requirements are the same as for the above label_connected_blobs()
+              routine.
+        ensures
+            - performs: return label_connected_blobs(img, is_background, get_neighbors,
+              is_connected, label_img, num_threads);
+              and in the same pass also records the statistics of each blob.  That is:
+            - #stats.size() == the returned value
+            - for all valid i:
+                - #stats[i] describes the pixels p for which #label_img[p.y()][p.x()] == i.
+                  So #stats[0] describes the background pixels.  Note that if no pixels
+                  are background then #stats[0].area == 0 and #stats[0].rect is empty.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -7,6 +7,9 @@
 #include "thresholding.h"
 #include "morphological_operations_abstract.h"
 #include "assign_image.h"
+#include "packed_binary_image.h"
+#include <algorithm>
+#include <vector>
 
 namespace dlib
 {
@@ -66,6 +69,211 @@ namespace dlib
             return true;
         }
 
+        // Returns word j of the row that has in's pixel c+64*q+b at pixel c.  Pixels
+        // outside the row are off.
+        inline uint64 shifted_word (
+            const uint64* in,
+            long words,
+            long j,
+            long b
+        )
+        {
+            const uint64 lo = (j >= 0 && j < words) ? in[j] : 0;
+            if (b == 0)
+                return lo;
+            const uint64 hi = (j+1 >= 0 && j+1 < words) ? in[j+1] : 0;
+            return (lo >> b) | (hi << (64-b));
+        }
+
+        template <bool dilate>
+        inline void combine_shifted (
+            const uint64* in,
+            long in_words,
+            uint64* out,
+            long out_words,
+            long s
+        )
+        /*!
+            requires
+                - in and out don't overlap
+            ensures
+                - ORs (if dilate) or ANDs (otherwise) pixel c+s of in into pixel c of out,
+                  for every pixel in out.  So this handles 64 pixels at a time.
+        !*/
+        {
+            const long q = s >= 0 ? s/64 : -((-s+63)/64);
+            const long b = s - q*64;
+            for (long i = 0; i < out_words; ++i)
+            {
+                const uint64 w = shifted_word(in, in_words, i+q, b);
+                if (dilate)
+                    out[i] |= w;
+                else
+                    out[i] &= w;
+            }
+        }
+
+        template <bool dilate>
+        void packed_rect_morphology (
+            const packed_binary_image& in,
+            packed_binary_image& out,
+            long se_nr,
+            long se_nc
+        )
+        /*!
+            ensures
+                - does the dilation or erosion with a se_nr by se_nc rectangle of on
+                  pixels.  The rectangle is separable so this is a horizontal pass followed
+                  by a vertical pass.
+        !*/
+        {
+            const long words = in.words_per_row();
+            packed_binary_image horz(in.nr(), in.nc());
+            if (words == 0)
+            {
+                out.swap(horz);
+                return;
+            }
+
+            // The horizontal pass.  Put each row into a buffer padded with k off pixels
+            // on each side, then make a(c) combine the padded pixels c through c+se_nc-1
+            // by combining a with copies of itself shifted by doubling amounts.  So
+            // a(c) is the output for pixel c and this takes O(log(se_nc)) word
+            // operations per 64 pixels.
+            const long k = se_nc/2;
+            const long padded_words = (in.nc()+2*k+63)/64;
+            std::vector<uint64> a(padded_words), t(padded_words);
+            for (long r = 0; r < in.nr(); ++r)
+            {
+                std::fill(a.begin(), a.end(), 0);
+                combine_shifted<true>(in.row(r), words, &a[0], padded_words, -k);
+                long len = 1;
+                while (len < se_nc)
+                {
+                    const long step = std::min(len, se_nc-len);
+                    t = a;
+                    combine_shifted<dilate>(&t[0], padded_words, &a[0], padded_words, step);
+                    len += step;
+                }
+                uint64* out_row = horz.row(r);
+                std::copy(a.begin(), a.begin()+words, out_row);
+                out_row[words-1] &= in.last_word_mask();
+            }
+
+            const long h = se_nr/2;
+            if (h == 0)
+            {
+                out.swap(horz);
+                return;
+            }
+
+            // The vertical pass uses the van Herk/Gil-Werman algorithm.  Think of the
+            // rows as padded with h off rows on each end and split into blocks of se_nr
+            // rows.  prefix[e] combines the rows from the start of e's block through e,
+            // suffix[e] combines e through the end of its block.  So the window of rows
+            // [e, e+se_nr-1] is suffix[e] combined with prefix[e+se_nr-1], which is 3
+            // word operations per word regardless of se_nr.
+            const long len_padded = in.nr() + 2*h;
+            std::vector<uint64> prefix(len_padded*words), suffix(len_padded*words);
+            const std::vector<uint64> zeros(words, 0);
+            for (long b = 0; b < len_padded; b += se_nr)
+            {
+                const long end = std::min(b+se_nr, len_padded);
+                for (long e = b; e < end; ++e)
+                {
+                    const uint64* x = (e-h >= 0 && e-h < in.nr()) ? horz.row(e-h) : &zeros[0];
+                    uint64* p = &prefix[e*words];
+                    if (e == b)
+                    {
+                        std::copy(x, x+words, p);
+                    }
+                    else
+                    {
+                        const uint64* prev = p - words;
+                        for (long i = 0; i < words; ++i)
+                            p[i] = dilate ? (prev[i] | x[i]) : (prev[i] & x[i]);
+                    }
+                }
+                for (long e = end-1; e >= b; --e)
+                {
+                    const uint64* x = (e-h >= 0 && e-h < in.nr()) ? horz.row(e-h) : &zeros[0];
+                    uint64* p = &suffix[e*words];
+                    if (e == end-1)
+                    {
+                        std::copy(x, x+words, p);
+                    }
+                    else
+                    {
+                        const uint64* next = p + words;
+                        for (long i = 0; i < words; ++i)
+                            p[i] = dilate ? (next[i] | x[i]) : (next[i] & x[i]);
+                    }
+                }
+            }
+
+            out.set_size(in.nr(), in.nc());
+            for (long r = 0; r < in.nr(); ++r)
+            {
+                const uint64* s = &suffix[r*words];
+                const uint64* p = &prefix[(r+se_nr-1)*words];
+                uint64* out_row = out.row(r);
+                for (long i = 0; i < words; ++i)
+                    out_row[i] = dilate ? (s[i] | p[i]) : (s[i] & p[i]);
+            }
+        }
+
+
+        template <
+            bool dilate,
+            long M,
+            long N
+            >
+        void packed_morphology (
+            const packed_binary_image& in,
+            packed_binary_image& out,
+            const unsigned char (&structuring_element)[M][N]
+        )
+        {
+            bool is_rect = true;
+            for (long m = 0; m < M; ++m)
+                for (long n = 0; n < N; ++n)
+                    is_rect = is_rect && structuring_element[m][n] == on_pixel;
+            if (is_rect)
+            {
+                packed_rect_morphology<dilate>(in, out, M, N);
+                return;
+            }
+
+            out.set_size(in.nr(), in.nc());
+            const long words = in.words_per_row();
+            if (words == 0)
+                return;
+
+            for (long r = 0; r < in.nr(); ++r)
+            {
+                uint64* out_row = out.row(r);
+                std::fill(out_row, out_row+words, dilate ? uint64(0) : ~uint64(0));
+                for (long m = 0; m < M; ++m)
+                {
+                    const long rr = r+m-M/2;
+                    for (long n = 0; n < N; ++n)
+                    {
+                        if (structuring_element[m][n] != on_pixel)
+                            continue;
+
+                        if (rr < 0 || rr >= in.nr())
+                        {
+                            // Pixels outside the image are off.
+                            if (!dilate)
+                                std::fill(out_row, out_row+words, 0);
+                            continue;
+                        }
+                        combine_shifted<dilate>(in.row(rr), words, out_row, words, n-N/2);
+                    }
+                }
+                out_row[words-1] &= in.last_word_mask();
+            }
+        }
     }
 
 // ----------------------------------------------------------------------------------------
@@ -115,33 +323,12 @@ namespace dlib
             return;
         }
 
-        out_img.set_size(in_img.nr(),in_img.nc());
-
-        // apply the filter to the image
-        for (long r = 0; r < in_img.nr(); ++r)
-        {
-            for (long c = 0; c < in_img.nc(); ++c)
-            {
-                unsigned char out_pixel = off_pixel;
-                for (long m = 0; m < M && out_pixel == off_pixel; ++m)
-                {
-                    for (long n = 0; n < N && out_pixel == off_pixel; ++n)
-                    {
-                        if (structuring_element[m][n] == on_pixel)
-                        {
-                            // if this pixel is inside the image then get it from the image
-                            // but if it isn't just pretend it was an off_pixel value
-                            if (r+m >= M/2 && c+n >= N/2 &&
-                                r+m-M/2 < in_img.nr() && c+n-N/2 < in_img.nc())
-                            {
-                                out_pixel = in_img[r+m-M/2][c+n-N/2];
-                            }
-                        }
-                    }
-                }
-                assign_pixel(out_img[r][c], out_pixel);
-            }
-        }
+        // Do the work on bit packed copies of the images so that 64 pixels are handled
+        // by each word operation.
+        packed_binary_image in_packed, out_packed;
+        pack_binary_image(in_img_, in_packed);
+        packed_morphology<true>(in_packed, out_packed, structuring_element);
+        unpack_binary_image(out_packed, out_img_);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -191,37 +378,12 @@ namespace dlib
             return;
         }
 
-        out_img.set_size(in_img.nr(),in_img.nc());
-
-        // apply the filter to the image
-        for (long r = 0; r < in_img.nr(); ++r)
-        {
-            for (long c = 0; c < in_img.nc(); ++c)
-            {
-                unsigned char out_pixel = on_pixel;
-                for (long m = 0; m < M && out_pixel == on_pixel; ++m)
-                {
-                    for (long n = 0; n < N && out_pixel == on_pixel; ++n)
-                    {
-                        if (structuring_element[m][n] == on_pixel)
-                        {
-                            // if this pixel is inside the image then get it from the image
-                            // but if it isn't just pretend it was an off_pixel value
-                            if (r+m >= M/2 && c+n >= N/2 &&
-                                r+m-M/2 < in_img.nr() && c+n-N/2 < in_img.nc())
-                            {
-                                out_pixel = in_img[r+m-M/2][c+n-N/2];
-                            }
-                            else
-                            {
-                                out_pixel = off_pixel;
-                            }
-                        }
-                    }
-                }
-                assign_pixel(out_img[r][c], out_pixel);
-            }
-        }
+        // Do the work on bit packed copies of the images so that 64 pixels are handled
+        // by each word operation.
+        packed_binary_image in_packed, out_packed;
+        pack_binary_image(in_img_, in_packed);
+        packed_morphology<false>(in_packed, out_packed, structuring_element);
+        unpack_binary_image(out_packed, out_img_);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -387,6 +549,236 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        long M,
+        long N
+        >
+    void binary_dilation (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        const unsigned char (&structuring_element)[M][N]
+    )
+    {
+        using namespace morphological_operations_helpers;
+        COMPILE_TIME_ASSERT(M%2 == 1);
+        COMPILE_TIME_ASSERT(N%2 == 1);
+        DLIB_ASSERT(is_same_object(in_img,out_img) == false,
+            "\tvoid binary_dilation()"
+            << "\n\tYou must give two different image objects"
+            );
+        DLIB_ASSERT(is_binary_image(structuring_element) ,
+            "\tvoid binary_dilation()"
+            << "\n\tthe structuring_element must be a binary image"
+            );
+
+        packed_morphology<true>(in_img, out_img, structuring_element);
+    }
+
+    template <
+        long M,
+        long N
+        >
+    void binary_erosion (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        const unsigned char (&structuring_element)[M][N]
+    )
+    {
+        using namespace morphological_operations_helpers;
+        COMPILE_TIME_ASSERT(M%2 == 1);
+        COMPILE_TIME_ASSERT(N%2 == 1);
+        DLIB_ASSERT(is_same_object(in_img,out_img) == false,
+            "\tvoid binary_erosion()"
+            << "\n\tYou must give two different image objects"
+            );
+        DLIB_ASSERT(is_binary_image(structuring_element) ,
+            "\tvoid binary_erosion()"
+            << "\n\tthe structuring_element must be a binary image"
+            );
+
+        packed_morphology<false>(in_img, out_img, structuring_element);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline void binary_dilation (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        long se_nr,
+        long se_nc
+    )
+    {
+        DLIB_ASSERT(is_same_object(in_img,out_img) == false && 
+                    se_nr > 0 && se_nc > 0 && se_nr%2 == 1 && se_nc%2 == 1,
+            "\tvoid binary_dilation()"
+            << "\n\tInvalid inputs were given to this function."
+            << "\n\tis_same_object(in_img,out_img): " << is_same_object(in_img,out_img)
+            << "\n\tse_nr: " << se_nr
+            << "\n\tse_nc: " << se_nc
+            );
+
+        morphological_operations_helpers::packed_rect_morphology<true>(in_img, out_img, se_nr, se_nc);
+    }
+
+    inline void binary_erosion (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        long se_nr,
+        long se_nc
+    )
+    {
+        DLIB_ASSERT(is_same_object(in_img,out_img) == false && 
+                    se_nr > 0 && se_nc > 0 && se_nr%2 == 1 && se_nc%2 == 1,
+            "\tvoid binary_erosion()"
+            << "\n\tInvalid inputs were given to this function."
+            << "\n\tis_same_object(in_img,out_img): " << is_same_object(in_img,out_img)
+            << "\n\tse_nr: " << se_nr
+            << "\n\tse_nc: " << se_nc
+            );
+
+        morphological_operations_helpers::packed_rect_morphology<false>(in_img, out_img, se_nr, se_nc);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace morphological_operations_helpers
+    {
+        template <typename structuring_element_type>
+        void packed_open (
+            const packed_binary_image& in_img,
+            packed_binary_image& out_img,
+            const structuring_element_type& se,
+            unsigned long iter
+        )
+        {
+            packed_binary_image temp1, temp2;
+            temp1 = in_img;
+            for (unsigned long i = 0; i < iter; ++i)
+            {
+                swap(temp1, temp2);
+                se.erode(temp2, temp1);
+            }
+            for (unsigned long i = 0; i < iter; ++i)
+            {
+                swap(temp1, temp2);
+                se.dilate(temp2, temp1);
+            }
+            swap(out_img, temp1);
+        }
+
+        template <typename structuring_element_type>
+        void packed_close (
+            const packed_binary_image& in_img,
+            packed_binary_image& out_img,
+            const structuring_element_type& se,
+            unsigned long iter
+        )
+        {
+            packed_binary_image temp1, temp2;
+            temp1 = in_img;
+            for (unsigned long i = 0; i < iter; ++i)
+            {
+                swap(temp1, temp2);
+                se.dilate(temp2, temp1);
+            }
+            for (unsigned long i = 0; i < iter; ++i)
+            {
+                swap(temp1, temp2);
+                se.erode(temp2, temp1);
+            }
+            swap(out_img, temp1);
+        }
+
+        template <long M, long N>
+        struct array_structuring_element
+        {
+            array_structuring_element(const unsigned char (&se_)[M][N]) : se(se_) {}
+            const unsigned char (&se)[M][N];
+            void dilate(const packed_binary_image& in, packed_binary_image& out) const { binary_dilation(in, out, se); }
+            void erode(const packed_binary_image& in, packed_binary_image& out) const { binary_erosion(in, out, se); }
+        };
+
+        struct rect_structuring_element
+        {
+            rect_structuring_element(long nr_, long nc_) : nr(nr_), nc(nc_) {}
+            long nr, nc;
+            void dilate(const packed_binary_image& in, packed_binary_image& out) const { binary_dilation(in, out, nr, nc); }
+            void erode(const packed_binary_image& in, packed_binary_image& out) const { binary_erosion(in, out, nr, nc); }
+        };
+    }
+
+    template <
+        long M,
+        long N
+        >
+    void binary_open (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        const unsigned char (&structuring_element)[M][N],
+        const unsigned long iter = 1
+    )
+    {
+        using namespace morphological_operations_helpers;
+        DLIB_ASSERT(is_same_object(in_img,out_img) == false,
+            "\tvoid binary_open()"
+            << "\n\tYou must give two different image objects"
+            );
+        packed_open(in_img, out_img, array_structuring_element<M,N>(structuring_element), iter);
+    }
+
+    template <
+        long M,
+        long N
+        >
+    void binary_close (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        const unsigned char (&structuring_element)[M][N],
+        const unsigned long iter = 1
+    )
+    {
+        using namespace morphological_operations_helpers;
+        DLIB_ASSERT(is_same_object(in_img,out_img) == false,
+            "\tvoid binary_close()"
+            << "\n\tYou must give two different image objects"
+            );
+        packed_close(in_img, out_img, array_structuring_element<M,N>(structuring_element), iter);
+    }
+
+    inline void binary_open (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        long se_nr,
+        long se_nc,
+        const unsigned long iter = 1
+    )
+    {
+        using namespace morphological_operations_helpers;
+        DLIB_ASSERT(is_same_object(in_img,out_img) == false,
+            "\tvoid binary_open()"
+            << "\n\tYou must give two different image objects"
+            );
+        packed_open(in_img, out_img, rect_structuring_element(se_nr, se_nc), iter);
+    }
+
+    inline void binary_close (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        long se_nr,
+        long se_nc,
+        const unsigned long iter = 1
+    )
+    {
+        using namespace morphological_operations_helpers;
+        DLIB_ASSERT(is_same_object(in_img,out_img) == false,
+            "\tvoid binary_close()"
+            << "\n\tYou must give two different image objects"
+            );
+        packed_close(in_img, out_img, rect_structuring_element(se_nr, se_nc), iter);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
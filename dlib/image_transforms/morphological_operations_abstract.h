@@ -6,6 +6,7 @@
 #include "../pixel.h"
 #include "thresholding_abstract.h"
 #include "../image_processing/generic_image.h"
+#include "packed_binary_image_abstract.h"
 
 namespace dlib
 {
@@ -150,6 +151,153 @@ namespace dlib
             - #out_img.nr() == in_img.nr()
     !*/
 
+// ----------------------------------------------------------------------------------------
+//                         Morphology on bit packed binary images
+// ----------------------------------------------------------------------------------------
+
+    template <
+        long M,
+        long N
+        >
+    void binary_dilation (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        const unsigned char (&structuring_element)[M][N]
+    );
+    /*!
+        requires
+            - is_same_object(in_img,out_img) == false
+            - M % 2 == 1  (i.e. M must be odd)
+            - N % 2 == 1  (i.e. N must be odd)
+            - all pixels in structuring_element are set to either on_pixel or off_pixel
+              (i.e. it must be a binary image)
+        ensures
+            - Does the same binary dilation as the above binary_dilation() but on bit
+              packed images.  Each row is built by combining shifted copies of the input
+              rows, 64 pixels at a time.  If all of structuring_element is on then the
+              rectangle version of binary_dilation() defined below is used instead.
+            - #out_img.nc() == in_img.nc()
+            - #out_img.nr() == in_img.nr()
+    !*/
+
+    template <
+        long M,
+        long N
+        >
+    void binary_erosion (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        const unsigned char (&structuring_element)[M][N]
+    );
+    /*!
+        requires
+            - is_same_object(in_img,out_img) == false
+            - M % 2 == 1  (i.e. M must be odd)
+            - N % 2 == 1  (i.e. N must be odd)
+            - all pixels in structuring_element are set to either on_pixel or off_pixel
+              (i.e. it must be a binary image)
+        ensures
+            - Does the same binary erosion as the above binary_erosion() but on bit
+              packed images.
+            - #out_img.nc() == in_img.nc()
+            - #out_img.nr() == in_img.nr()
+    !*/
+
+    void binary_dilation (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        long se_nr,
+        long se_nc
+    );
+    /*!
+        requires
+            - is_same_object(in_img,out_img) == false
+            - se_nr > 0 && se_nr % 2 == 1
+            - se_nc > 0 && se_nc % 2 == 1
+        ensures
+            - Does a binary dilation of in_img using a se_nr by se_nc structuring element
+              with all its pixels on.  The result is the same as using the array version
+              of binary_dilation() but this one is much faster for large elements.  The
+              vertical part uses the van Herk/Gil-Werman algorithm so its cost doesn't
+              depend on se_nr and the horizontal part costs O(log(se_nc)) word
+              operations per 64 pixels.
+            - #out_img.nc() == in_img.nc()
+            - #out_img.nr() == in_img.nr()
+    !*/
+
+    void binary_erosion (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        long se_nr,
+        long se_nc
+    );
+    /*!
+        requires
+            - is_same_object(in_img,out_img) == false
+            - se_nr > 0 && se_nr % 2 == 1
+            - se_nc > 0 && se_nc % 2 == 1
+        ensures
+            - Does a binary erosion of in_img using a se_nr by se_nc structuring element
+              with all its pixels on.  Like the above binary_dilation(), this takes time
+              that depends only weakly on the element size.
+            - #out_img.nc() == in_img.nc()
+            - #out_img.nr() == in_img.nr()
+    !*/
+
+    template <
+        long M,
+        long N
+        >
+    void binary_open (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        const unsigned char (&structuring_element)[M][N],
+        const unsigned long iter = 1
+    );
+    void binary_open (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        long se_nr,
+        long se_nc,
+        const unsigned long iter = 1
+    );
+    /*!
+        requires
+            - is_same_object(in_img,out_img) == false
+            - The structuring element must meet the requirements of the corresponding
+              binary_erosion() routine.
+        ensures
+            - Applies iter iterations of binary_erosion() and then iter iterations of
+              binary_dilation() to in_img and stores the result in out_img.
+    !*/
+
+    template <
+        long M,
+        long N
+        >
+    void binary_close (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        const unsigned char (&structuring_element)[M][N],
+        const unsigned long iter = 1
+    );
+    void binary_close (
+        const packed_binary_image& in_img,
+        packed_binary_image& out_img,
+        long se_nr,
+        long se_nc,
+        const unsigned long iter = 1
+    );
+    /*!
+        requires
+            - is_same_object(in_img,out_img) == false
+            - The structuring element must meet the requirements of the corresponding
+              binary_dilation() routine.
+        ensures
+            - Applies iter iterations of binary_dilation() and then iter iterations of
+              binary_erosion() to in_img and stores the result in out_img.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -0,0 +1,232 @@
+// Copyright (C) 2017  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_PACKED_BINARY_IMAGe_H_
+#define DLIB_PACKED_BINARY_IMAGe_H_
+
+#include "packed_binary_image_abstract.h"
+#include "../pixel.h"
+#include "../uintn.h"
+#include "../algs.h"
+#include "../assert.h"
+#include "../image_processing/generic_image.h"
+#include "thresholding.h"
+#include <algorithm>
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class packed_binary_image
+    {
+    public:
+
+        packed_binary_image (
+        ) : num_rows(0), num_cols(0), row_words(0) {}
+
+        packed_binary_image (
+            long nr_,
+            long nc_
+        ) : num_rows(0), num_cols(0), row_words(0)
+        {
+            set_size(nr_, nc_);
+        }
+
+        long nr (
+        ) const { return num_rows; }
+
+        long nc (
+        ) const { return num_cols; }
+
+        long size (
+        ) const { return num_rows*num_cols; }
+
+        long words_per_row (
+        ) const { return row_words; }
+
+        void set_size (
+            long nr_,
+            long nc_
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(nr_ >= 0 && nc_ >= 0,
+                "\t void packed_binary_image::set_size()"
+                << "\n\t The image dimensions can't be negative."
+                << "\n\t nr_: " << nr_
+                << "\n\t nc_: " << nc_
+                );
+
+            num_rows = nr_;
+            num_cols = nc_;
+            row_words = (nc_+63)/64;
+            data.assign(num_rows*row_words, 0);
+        }
+
+        void clear (
+        )
+        {
+            num_rows = 0;
+            num_cols = 0;
+            row_words = 0;
+            data.clear();
+        }
+
+        bool operator() (
+            long r,
+            long c
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(0 <= r && r < nr() && 0 <= c && c < nc(),
+                "\t bool packed_binary_image::operator()"
+                << "\n\t You have asked for a pixel outside the image."
+                << "\n\t r:    " << r
+                << "\n\t c:    " << c
+                << "\n\t nr(): " << nr()
+                << "\n\t nc(): " << nc()
+                );
+
+            return (data[r*row_words + c/64] >> (c%64))&1;
+        }
+
+        void set (
+            long r,
+            long c,
+            bool value
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(0 <= r && r < nr() && 0 <= c && c < nc(),
+                "\t void packed_binary_image::set()"
+                << "\n\t You have asked for a pixel outside the image."
+                << "\n\t r:    " << r
+                << "\n\t c:    " << c
+                << "\n\t nr(): " << nr()
+                << "\n\t nc(): " << nc()
+                );
+
+            const uint64 mask = uint64(1) << (c%64);
+            if (value)
+                data[r*row_words + c/64] |= mask;
+            else
+                data[r*row_words + c/64] &= ~mask;
+        }
+
+        uint64* row (
+            long r
+        )
+        {
+            DLIB_ASSERT(0 <= r && r < nr(),
+                "\t uint64* packed_binary_image::row()"
+                << "\n\t r:    " << r
+                << "\n\t nr(): " << nr()
+                );
+            return data.data() + r*row_words;
+        }
+
+        const uint64* row (
+            long r
+        ) const
+        {
+            DLIB_ASSERT(0 <= r && r < nr(),
+                "\t const uint64* packed_binary_image::row()"
+                << "\n\t r:    " << r
+                << "\n\t nr(): " << nr()
+                );
+            return data.data() + r*row_words;
+        }
+
+        uint64 last_word_mask (
+        ) const
+        {
+            if (num_cols%64 == 0)
+                return ~uint64(0);
+            return (uint64(1) << (num_cols%64)) - 1;
+        }
+
+        void swap (
+            packed_binary_image& item
+        )
+        {
+            std::swap(num_rows, item.num_rows);
+            std::swap(num_cols, item.num_cols);
+            std::swap(row_words, item.row_words);
+            data.swap(item.data);
+        }
+
+    private:
+
+        long num_rows;
+        long num_cols;
+        long row_words;
+        std::vector<uint64> data;
+    };
+
+    inline void swap (
+        packed_binary_image& a,
+        packed_binary_image& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void pack_binary_image (
+        const image_type& img_,
+        packed_binary_image& out
+    )
+    {
+        typedef typename image_traits<image_type>::pixel_type pixel_type;
+        COMPILE_TIME_ASSERT(pixel_traits<pixel_type>::grayscale);
+
+        const_image_view<image_type> img(img_);
+        out.set_size(img.nr(), img.nc());
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            uint64* out_row = out.row(r);
+            for (long w = 0; w < out.words_per_row(); ++w)
+            {
+                const long cend = std::min<long>(img.nc(), (w+1)*64);
+                uint64 word = 0;
+                for (long c = w*64; c < cend; ++c)
+                    word |= uint64(img[r][c] != off_pixel) << (c%64);
+                out_row[w] = word;
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void unpack_binary_image (
+        const packed_binary_image& img,
+        image_type& out_
+    )
+    {
+        typedef typename image_traits<image_type>::pixel_type pixel_type;
+        COMPILE_TIME_ASSERT( pixel_traits<pixel_type>::has_alpha == false );
+
+        image_view<image_type> out(out_);
+        out.set_size(img.nr(), img.nc());
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            const uint64* in_row = img.row(r);
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                const unsigned char pix = ((in_row[c/64] >> (c%64))&1) ? on_pixel : off_pixel;
+                assign_pixel(out[r][c], pix);
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_PACKED_BINARY_IMAGe_H_
+
@@ -0,0 +1,228 @@
+// Copyright (C) 2017  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_PACKED_BINARY_IMAGe_ABSTRACT_H_
+#ifdef DLIB_PACKED_BINARY_IMAGe_ABSTRACT_H_
+
+#include "../uintn.h"
+#include "../image_processing/generic_image.h"
+#include "thresholding_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class packed_binary_image
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is a binary image that stores one bit per pixel.  So it uses
+                8 times less memory than an unsigned char image and the morphological
+                operations in dlib/image_transforms/morphological_operations.h can
+                process 64 pixels with each machine word operation.
+
+                Each row is stored in words_per_row() uint64 words.  Pixel (r,c) is bit
+                c%64 of row(r)[c/64].  The bits past the end of each row, i.e. bits
+                nc()%64 and up of the last word, are always 0.
+
+                Note that this object does not implement the generic image interface
+                since its pixels are not addressable objects.  Use pack_binary_image() and
+                unpack_binary_image() to convert to and from normal images.
+        !*/
+
+    public:
+
+        packed_binary_image (
+        );
+        /*!
+            ensures
+                - #nr() == 0
+                - #nc() == 0
+        !*/
+
+        packed_binary_image (
+            long nr,
+            long nc
+        );
+        /*!
+            requires
+                - nr >= 0
+                - nc >= 0
+            ensures
+                - #nr() == nr
+                - #nc() == nc
+                - all the pixels are off.
+        !*/
+
+        long nr (
+        ) const;
+        /*!
+            ensures
+                - returns the number of rows in this image.
+        !*/
+
+        long nc (
+        ) const;
+        /*!
+            ensures
+                - returns the number of columns in this image.
+        !*/
+
+        long size (
+        ) const;
+        /*!
+            ensures
+                - returns nr()*nc()
+        !*/
+
+        long words_per_row (
+        ) const;
+        /*!
+            ensures
+                - returns (nc()+63)/64, the number of words used to store each row.
+        !*/
+
+        void set_size (
+            long nr,
+            long nc
+        );
+        /*!
+            requires
+                - nr >= 0
+                - nc >= 0
+            ensures
+                - #nr() == nr
+                - #nc() == nc
+                - all the pixels are off.
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - #nr() == 0
+                - #nc() == 0
+        !*/
+
+        bool operator() (
+            long r,
+            long c
+        ) const;
+        /*!
+            requires
+                - 0 <= r < nr()
+                - 0 <= c < nc()
+            ensures
+                - returns true if pixel (r,c) is on and false otherwise.
+        !*/
+
+        void set (
+            long r,
+            long c,
+            bool value
+        );
+        /*!
+            requires
+                - 0 <= r < nr()
+                - 0 <= c < nc()
+            ensures
+                - #(*this)(r,c) == value
+        !*/
+
+        uint64* row (
+            long r
+        );
+        /*!
+            requires
+                - 0 <= r < nr()
+            ensures
+                - returns a pointer to the words_per_row() words holding row r.  If you
+                  write to them you must keep the bits past nc() set to 0.
+        !*/
+
+        const uint64* row (
+            long r
+        ) const;
+        /*!
+            requires
+                - 0 <= r < nr()
+            ensures
+                - returns a pointer to the words_per_row() words holding row r.
+        !*/
+
+        uint64 last_word_mask (
+        ) const;
+        /*!
+            ensures
+                - returns a word with the bits set which are used by the last word of
+                  each row.
+        !*/
+
+        void swap (
+            packed_binary_image& item
+        );
+        /*!
+            ensures
+                - swaps *this and item
+        !*/
+    };
+
+    void swap (
+        packed_binary_image& a,
+        packed_binary_image& b
+    );
+    /*!
+        provides a global swap function
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void pack_binary_image (
+        const image_type& img,
+        packed_binary_image& out
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h
+            - img must contain a grayscale pixel type.
+        ensures
+            - #out.nr() == num_rows(img)
+            - #out.nc() == num_columns(img)
+            - for all valid r and c:
+                - #out(r,c) == (img[r][c] != off_pixel)
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void unpack_binary_image (
+        const packed_binary_image& img,
+        image_type& out
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h
+            - out must contain pixels with no alpha channel.
+        ensures
+            - #out.nr() == img.nr()
+            - #out.nc() == img.nc()
+            - for all valid r and c:
+                - if (img(r,c)) then
+                    - #out[r][c] == on_pixel
+                - else
+                    - #out[r][c] == off_pixel
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_PACKED_BINARY_IMAGe_ABSTRACT_H_
+
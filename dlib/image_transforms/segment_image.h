@@ -9,6 +9,9 @@
 #include "../geometry.h"
 #include "../disjoint_subsets.h"
 #include "../set.h"
+#include "../threads/parallel_for_extension.h"
+#include <algorithm>
+#include <cstring>
 
 namespace dlib
 {
@@ -123,6 +126,116 @@ namespace dlib
             T diff;
         };
 
+    // ------------------------------------------------------------------------------------
+
+        template <typename T>
+        void parallel_for_segment_image (
+            unsigned long num_threads,
+            long begin,
+            long end,
+            const T& funct
+        )
+        {
+            if (num_threads <= 1)
+            {
+                for (long i = begin; i < end; ++i)
+                    funct(i);
+            }
+            else
+            {
+                parallel_for(num_threads, begin, end, funct, 1);
+            }
+        }
+
+        // The edges are enumerated in a fixed order: first the edges of the pixels on the
+        // image border and then the interior pixels in raster order.  Each interior pixel
+        // contributes its edges to the right, up-right, down-right, and down neighbors.
+        // The interior rows are split into bands so that the edges of different bands can
+        // be made in parallel.
+
+        template <typename in_image_type, typename visitor_type>
+        void visit_border_pixel_edges (
+            const in_image_type& in_img,
+            visitor_type& visit
+        )
+        {
+            typedef typename in_image_type::pixel_type ptype;
+            edge_diff_funct<ptype> edge_diff;
+            const rectangle area = get_rect(in_img);
+            border_enumerator be(area, 1);
+            while (be.move_next())
+            {
+                const point p = be.element();
+                const long r = p.y();
+                const long c = p.x();
+                const ptype& pix = in_img[r][c];
+                if (area.contains(c-1,r))   visit(p, point(c-1,r), edge_diff(pix, in_img[r  ][c-1]));
+                if (area.contains(c+1,r))   visit(p, point(c+1,r), edge_diff(pix, in_img[r  ][c+1]));
+                if (area.contains(c  ,r-1)) visit(p, point(c,r-1), edge_diff(pix, in_img[r-1][c  ]));
+                if (area.contains(c  ,r+1)) visit(p, point(c,r+1), edge_diff(pix, in_img[r+1][c  ]));
+            }
+        }
+
+        template <typename in_image_type, typename visitor_type>
+        void visit_interior_pixel_edges (
+            const in_image_type& in_img,
+            long row_begin,
+            long row_end,
+            visitor_type& visit
+        )
+        {
+            typedef typename in_image_type::pixel_type ptype;
+            edge_diff_funct<ptype> edge_diff;
+            // This loop doesn't need the bounds checks used in the above border loop.
+            for (long r = row_begin; r < row_end; ++r)
+            {
+                for (long c = 1; c+1 < in_img.nc(); ++c)
+                {
+                    const point p(c,r);
+                    const ptype& pix = in_img[r][c];
+                    visit(p, point(c+1,r  ), edge_diff(pix, in_img[r  ][c+1]));
+                    visit(p, point(c+1,r-1), edge_diff(pix, in_img[r-1][c+1]));
+                    visit(p, point(c+1,r+1), edge_diff(pix, in_img[r+1][c+1]));
+                    visit(p, point(c  ,r+1), edge_diff(pix, in_img[r+1][c  ]));
+                }
+            }
+        }
+
+        template <typename in_image_type, typename visitor_type>
+        void visit_pixel_edges (
+            const in_image_type& in_img,
+            long num_bands,
+            long band,
+            visitor_type& visit
+        )
+        /*!
+            ensures
+                - Band 0 is the image border and bands 1 through num_bands-1 split up the
+                  interior rows.  This function calls visit() on each edge in the given
+                  band.
+        !*/
+        {
+            if (band == 0)
+            {
+                visit_border_pixel_edges(in_img, visit);
+            }
+            else
+            {
+                const long num_rows = in_img.nr()-2;
+                visit_interior_pixel_edges(in_img,
+                    1 + num_rows*(band-1)/(num_bands-1),
+                    1 + num_rows*band/(num_bands-1), visit);
+            }
+        }
+
+        inline long num_pixel_edge_bands (
+            long nr,
+            unsigned long num_threads
+        )
+        {
+            return 1 + std::max<long>(1, std::min<long>(num_threads, nr-2));
+        }
+
     // ------------------------------------------------------------------------------------
 
         template <typename image_view_type>
@@ -133,6 +246,31 @@ namespace dlib
                 is_same_type<pixel_type,uint16>::value;
         };
 
+        struct count_pixel_edges
+        {
+            count_pixel_edges(unsigned long* counts_) : counts(counts_) {}
+            unsigned long* const counts;
+
+            template <typename T>
+            void operator() (const point&, const point&, const T& diff) { ++counts[diff]; }
+        };
+
+        template <typename T>
+        struct place_pixel_edges
+        {
+            place_pixel_edges(
+                const rectangle& area_,
+                segment_image_edge_data_T<T>* edges_,
+                unsigned long* pos_
+            ) : area(area_), edges(edges_), pos(pos_) {}
+            const rectangle area;
+            segment_image_edge_data_T<T>* const edges;
+            unsigned long* const pos;
+
+            void operator() (const point& p1, const point& p2, const T& diff) 
+            { edges[pos[diff]++] = segment_image_edge_data_T<T>(area,p1,p2,diff); }
+        };
+
         // This is an overload of get_pixel_edges() that is optimized to segment images
         // with 8bit or 16bit  pixels very quickly.  We do this by using a radix sort
         // instead of quicksort.
@@ -140,186 +278,231 @@ namespace dlib
         typename enable_if<uint8_or_uint16_pixels<in_image_type> >::type 
         get_pixel_edges (
             const in_image_type& in_img,
-            std::vector<segment_image_edge_data_T<T> >& sorted_edges
+            std::vector<segment_image_edge_data_T<T> >& sorted_edges,
+            unsigned long num_threads
         )
         {
             typedef typename in_image_type::pixel_type ptype;
-            typedef T diff_type;
-            std::vector<unsigned long> counts(std::numeric_limits<ptype>::max()+1, 0);
-
-            edge_diff_funct<ptype> edge_diff;
+            const long num_bands = num_pixel_edge_bands(in_img.nr(), num_threads);
 
-            border_enumerator be(get_rect(in_img), 1);
             // we are going to do a radix sort on the edge weights.  So the first step
-            // is to accumulate them into count.
-            const rectangle area = get_rect(in_img);
-            while (be.move_next())
-            {
-                const long r = be.element().y();
-                const long c = be.element().x();
-                const ptype pix = in_img[r][c];
-                if (area.contains(c-1,r))   counts[edge_diff(pix, in_img[r  ][c-1])] += 1;
-                if (area.contains(c+1,r))   counts[edge_diff(pix, in_img[r  ][c+1])] += 1;
-                if (area.contains(c  ,r-1)) counts[edge_diff(pix, in_img[r-1][c  ])] += 1;
-                if (area.contains(c  ,r+1)) counts[edge_diff(pix, in_img[r+1][c  ])] += 1;
-            }
-            for (long r = 1; r+1 < in_img.nr(); ++r)
+            // is to accumulate them into counts, one histogram per band.
+            std::vector<std::vector<unsigned long> > counts(num_bands);
+            parallel_for_segment_image(num_threads, 0, num_bands, [&](long band) {
+                counts[band].assign(std::numeric_limits<ptype>::max()+1, 0);
+                count_pixel_edges visit(&counts[band][0]);
+                visit_pixel_edges(in_img, num_bands, band, visit);
+            });
+
+            // integrate counts.  The idea is to have sorted_edges[counts[band][i]] be the
+            // location the first edge from band with an edge_diff of i goes.  Within each
+            // edge_diff value the bands are laid out in order, so the result is the same
+            // as a single threaded radix sort.
+            unsigned long num_edges = 0;
+            for (unsigned long i = 0; i < counts[0].size(); ++i)
             {
-                for (long c = 1; c+1 < in_img.nc(); ++c)
+                for (long band = 0; band < num_bands; ++band)
                 {
-                    const ptype pix = in_img[r][c];
-                    counts[edge_diff(pix, in_img[r-1][c+1])] += 1;
-                    counts[edge_diff(pix, in_img[r  ][c+1])] += 1;
-                    counts[edge_diff(pix, in_img[r+1][c  ])] += 1;
-                    counts[edge_diff(pix, in_img[r+1][c+1])] += 1;
+                    const unsigned long temp = counts[band][i];
+                    counts[band][i] = num_edges;
+                    num_edges += temp;
                 }
             }
 
-            const unsigned long num_edges = shrink_rect(area,1).area()*4 + in_img.nr()*2*3 - 4 + (in_img.nc()-2)*2*3;
-            typedef segment_image_edge_data_T<T> segment_image_edge_data;
+            // now build a sorted list of all the edges
             sorted_edges.resize(num_edges);
+            parallel_for_segment_image(num_threads, 0, num_bands, [&](long band) {
+                place_pixel_edges<T> visit(get_rect(in_img), &sorted_edges[0], &counts[band][0]);
+                visit_pixel_edges(in_img, num_bands, band, visit);
+            });
+        }
+        
+    // ----------------------------------------------------------------------------------------
+
+        template <typename T>
+        struct collect_pixel_edges
+        {
+            collect_pixel_edges(
+                const rectangle& area_,
+                std::vector<segment_image_edge_data_T<T> >& edges_
+            ) : area(area_), edges(edges_) {}
+            const rectangle area;
+            std::vector<segment_image_edge_data_T<T> >& edges;
+
+            void operator() (const point& p1, const point& p2, const T& diff) 
+            { edges.push_back(segment_image_edge_data_T<T>(area,p1,p2,diff)); }
+        };
 
-            // integrate counts.  The idea is to have sorted_edges[counts[i]] be the location that edges
-            // with an edge_diff of i go.  So counts[0] == 0, counts[1] == number of 0 edge diff edges, etc.
-            unsigned long prev = counts[0];
-            for (unsigned long i = 1; i < counts.size(); ++i)
+        // The diff values of the edges are never negative, and non-negative doubles
+        // sort in the same order as their bit patterns.
+        inline uint64 edge_sort_key (double diff) { uint64 key; std::memcpy(&key, &diff, sizeof(key)); return key; }
+        inline uint64 edge_sort_key (uint32 diff) { return diff; }
+
+        template <typename T>
+        void radix_sort_edges (
+            std::vector<segment_image_edge_data_T<T> >& edges
+        )
+        /*!
+            ensures
+                - stably sorts edges by their diff values with a least significant digit
+                  radix sort using 16 bit digits.
+        !*/
+        {
+            const int num_passes = (sizeof(T)*8+15)/16;
+            std::vector<std::vector<unsigned long> > counts(num_passes, std::vector<unsigned long>(65536,0));
+            for (unsigned long i = 0; i < edges.size(); ++i)
             {
-                const unsigned long temp = counts[i];
-                counts[i] += counts[i-1];
-                counts[i-1] -= prev;
-                prev = temp;
+                const uint64 key = edge_sort_key(edges[i].diff);
+                for (int pass = 0; pass < num_passes; ++pass)
+                    ++counts[pass][(key>>(16*pass))&0xFFFF];
             }
-            counts[counts.size()-1] -= prev;
-
 
-            // now build a sorted list of all the edges
-            be.reset();
-            while(be.move_next())
+            std::vector<segment_image_edge_data_T<T> > temp(edges.size());
+            for (int pass = 0; pass < num_passes && edges.size() != 0; ++pass)
             {
-                const point p = be.element();
-                const long r = p.y();
-                const long c = p.x();
-                const ptype pix = in_img[r][c];
-                if (area.contains(c-1,r))
-                {
-                    const diff_type diff = edge_diff(pix, in_img[r  ][c-1]);
-                    sorted_edges[counts[diff]++] = segment_image_edge_data(area,p,point(c-1,r),diff);
-                }
+                std::vector<unsigned long>& pos = counts[pass];
+                // Skip this digit if all the edges have the same value for it.
+                if (pos[(edge_sort_key(edges[0].diff)>>(16*pass))&0xFFFF] == edges.size())
+                    continue;
 
-                if (area.contains(c+1,r))
+                unsigned long total = 0;
+                for (unsigned long i = 0; i < pos.size(); ++i)
                 {
-                    const diff_type diff = edge_diff(pix, in_img[r  ][c+1]);
-                    sorted_edges[counts[diff]++] = segment_image_edge_data(area,p,point(c+1,r),diff);
+                    const unsigned long temp_count = pos[i];
+                    pos[i] = total;
+                    total += temp_count;
                 }
+                for (unsigned long i = 0; i < edges.size(); ++i)
+                    temp[pos[(edge_sort_key(edges[i].diff)>>(16*pass))&0xFFFF]++] = edges[i];
+                edges.swap(temp);
+            }
+        }
 
-                if (area.contains(c  ,r-1))
-                {
-                    const diff_type diff = edge_diff(pix, in_img[r-1][c  ]);
-                    sorted_edges[counts[diff]++] = segment_image_edge_data(area,p,point(c  ,r-1),diff);
-                }
+        template <typename T>
+        void merge_sorted_edge_bands (
+            const std::vector<std::vector<segment_image_edge_data_T<T> > >& bands,
+            std::vector<segment_image_edge_data_T<T> >& sorted_edges,
+            unsigned long num_threads
+        )
+        /*!
+            requires
+                - each element of bands is sorted by edge_sort_key(diff).
+            ensures
+                - #sorted_edges == the concatenation of all the bands, stably sorted by
+                  edge_sort_key(diff).  That is, edges with equal keys are ordered by
+                  band and then by their position in the band.
+                - The output is split into num_threads chunks by key value and the chunks
+                  are merged in parallel.
+        !*/
+        {
+            typedef segment_image_edge_data_T<T> edge_type;
+            const long num_bands = bands.size();
+            const long num_chunks = std::max<long>(1, num_threads);
+
+            // Pick the keys that split the output into chunks from the biggest band.
+            // Every chunk gets all the edges with keys in [splitters[j], splitters[j+1])
+            // from every band, so equal keys never straddle two chunks.
+            long biggest = 0;
+            for (long band = 1; band < num_bands; ++band)
+            {
+                if (bands[band].size() > bands[biggest].size())
+                    biggest = band;
+            }
+            std::vector<uint64> splitters(num_chunks-1);
+            for (long j = 1; j < num_chunks; ++j)
+            {
+                const std::vector<edge_type>& b = bands[biggest];
+                splitters[j-1] = b.size() == 0 ? 0 : edge_sort_key(b[j*b.size()/num_chunks].diff);
+            }
 
-                if (area.contains(c  ,r+1))
+            // pos[band][j] is where chunk j starts in band.
+            auto key_less = [](const edge_type& e, uint64 key) { return edge_sort_key(e.diff) < key; };
+            std::vector<std::vector<unsigned long> > pos(num_bands, std::vector<unsigned long>(num_chunks+1));
+            std::vector<unsigned long> chunk_offsets(num_chunks+1, 0);
+            for (long band = 0; band < num_bands; ++band)
+            {
+                pos[band][0] = 0;
+                pos[band][num_chunks] = bands[band].size();
+                for (long j = 1; j < num_chunks; ++j)
                 {
-                    const diff_type diff = edge_diff(pix, in_img[r+1][c  ]);
-                    sorted_edges[counts[diff]++] = segment_image_edge_data(area,p,point(c  ,r+1),diff);
+                    pos[band][j] = std::lower_bound(bands[band].begin(), bands[band].end(),
+                        splitters[j-1], key_less) - bands[band].begin();
                 }
+                for (long j = 0; j < num_chunks; ++j)
+                    chunk_offsets[j+1] += pos[band][j+1]-pos[band][j];
             }
-            // same thing as the above loop but now we do it on the interior of the image and therefore
-            // don't have to include the boundary checking if statements used above.
-            for (long r = 1; r+1 < in_img.nr(); ++r)
-            {
-                for (long c = 1; c+1 < in_img.nc(); ++c)
+            for (long j = 0; j < num_chunks; ++j)
+                chunk_offsets[j+1] += chunk_offsets[j];
+
+            sorted_edges.resize(chunk_offsets[num_chunks]);
+            parallel_for_segment_image(num_threads, 0, num_chunks, [&](long j) {
+                // Merge the pieces of each band that belong to this chunk.  On ties the
+                // lower band wins, which keeps the merge stable.
+                std::vector<unsigned long> next(num_bands);
+                for (long band = 0; band < num_bands; ++band)
+                    next[band] = pos[band][j];
+                for (unsigned long i = chunk_offsets[j]; i < chunk_offsets[j+1]; ++i)
                 {
-                    const point p(c,r);
-                    const ptype pix = in_img[r][c];
-                    diff_type diff;
-
-                    diff = edge_diff(pix, in_img[r  ][c+1]);
-                    sorted_edges[counts[diff]++] = segment_image_edge_data(area,p,point(c+1,r),diff);
-                    diff = edge_diff(pix, in_img[r-1][c+1]);
-                    sorted_edges[counts[diff]++] = segment_image_edge_data(area,p,point(c+1,r-1),diff);
-                    diff = edge_diff(pix, in_img[r+1][c+1]);
-                    sorted_edges[counts[diff]++] = segment_image_edge_data(area,p,point(c+1,r+1),diff);
-                    diff = edge_diff(pix, in_img[r+1][c  ]);
-                    sorted_edges[counts[diff]++] = segment_image_edge_data(area,p,point(c  ,r+1),diff);
+                    long best = -1;
+                    uint64 best_key = 0;
+                    for (long band = 0; band < num_bands; ++band)
+                    {
+                        if (next[band] == pos[band][j+1])
+                            continue;
+                        const uint64 key = edge_sort_key(bands[band][next[band]].diff);
+                        if (best == -1 || key < best_key)
+                        {
+                            best = band;
+                            best_key = key;
+                        }
+                    }
+                    sorted_edges[i] = bands[best][next[best]++];
                 }
-            }
+            });
         }
-        
-    // ----------------------------------------------------------------------------------------
 
-        // This is the general purpose version of get_pixel_edges().  It handles all pixel types.
+        // This is the general purpose version of get_pixel_edges().  It handles all pixel
+        // types.  The edges of each band are made and radix sorted in parallel, and then
+        // the sorted bands are merged in parallel.  Since the sorts and the merge are
+        // stable the output doesn't depend on the number of threads.
         template <typename in_image_type, typename T>
         typename disable_if<uint8_or_uint16_pixels<in_image_type> >::type 
         get_pixel_edges (
             const in_image_type& in_img,
-            std::vector<segment_image_edge_data_T<T> >& sorted_edges
+            std::vector<segment_image_edge_data_T<T> >& sorted_edges,
+            unsigned long num_threads
         )
         {   
-            const rectangle area = get_rect(in_img);
-            sorted_edges.reserve(area.area()*4);
-
-            typedef typename in_image_type::pixel_type ptype;
-            edge_diff_funct<ptype> edge_diff;
-            typedef T diff_type;
-            typedef segment_image_edge_data_T<T> segment_image_edge_data;
-
-            border_enumerator be(get_rect(in_img), 1);
-
-            // now build a sorted list of all the edges
-            be.reset();
-            while(be.move_next())
+            typedef std::vector<segment_image_edge_data_T<T> > edge_vector;
+            const long num_bands = num_pixel_edge_bands(in_img.nr(), num_threads);
+
+            std::vector<edge_vector> bands(num_bands);
+            parallel_for_segment_image(num_threads, 0, num_bands, [&](long band) {
+                if (band != 0)
+                    bands[band].reserve(4*in_img.nc()*((in_img.nr()-2)/(num_bands-1)+1));
+                collect_pixel_edges<T> visit(get_rect(in_img), bands[band]);
+                visit_pixel_edges(in_img, num_bands, band, visit);
+                if (num_threads > 1)
+                    radix_sort_edges(bands[band]);
+            });
+
+            if (num_threads > 1)
             {
-                const point p = be.element();
-                const long r = p.y();
-                const long c = p.x();
-                const ptype& pix = in_img[r][c];
-                if (area.contains(c-1,r))
-                {
-                    const diff_type diff = edge_diff(pix, in_img[r  ][c-1]);
-                    sorted_edges.push_back(segment_image_edge_data(area,p,point(c-1,r),diff));
-                }
-
-                if (area.contains(c+1,r))
-                {
-                    const diff_type diff = edge_diff(pix, in_img[r  ][c+1]);
-                    sorted_edges.push_back(segment_image_edge_data(area,p,point(c+1,r),diff));
-                }
-
-                if (area.contains(c  ,r-1))
-                {
-                    const diff_type diff = edge_diff(pix, in_img[r-1][c  ]);
-                    sorted_edges.push_back( segment_image_edge_data(area,p,point(c  ,r-1),diff));
-                }
-                if (area.contains(c  ,r+1))
-                {
-                    const diff_type diff = edge_diff(pix, in_img[r+1][c  ]);
-                    sorted_edges.push_back( segment_image_edge_data(area,p,point(c  ,r+1),diff));
-                }
+                merge_sorted_edge_bands(bands, sorted_edges, num_threads);
+                return;
             }
-            // same thing as the above loop but now we do it on the interior of the image and therefore
-            // don't have to include the boundary checking if statements used above.
-            for (long r = 1; r+1 < in_img.nr(); ++r)
+
+            std::vector<unsigned long> offsets(num_bands+1, 0);
+            for (long band = 0; band < num_bands; ++band)
+                offsets[band+1] = offsets[band] + bands[band].size();
+            sorted_edges.resize(offsets[num_bands]);
+            for (long band = 0; band < num_bands; ++band)
             {
-                for (long c = 1; c+1 < in_img.nc(); ++c)
-                {
-                    const point p(c,r);
-                    const ptype& pix = in_img[r][c];
-                    diff_type diff;
-
-                    diff = edge_diff(pix, in_img[r  ][c+1]);
-                    sorted_edges.push_back( segment_image_edge_data(area,p,point(c+1,r),diff));
-                    diff = edge_diff(pix, in_img[r+1][c+1]);
-                    sorted_edges.push_back( segment_image_edge_data(area,p,point(c+1,r+1),diff));
-                    diff = edge_diff(pix, in_img[r+1][c  ]);
-                    sorted_edges.push_back( segment_image_edge_data(area,p,point(c  ,r+1),diff));
-                    diff = edge_diff(pix, in_img[r-1][c+1]);
-                    sorted_edges.push_back( segment_image_edge_data(area,p,point(c+1,r-1),diff));
-                }
+                std::copy(bands[band].begin(), bands[band].end(), sorted_edges.begin()+offsets[band]);
+                edge_vector().swap(bands[band]);
             }
 
-            std::sort(sorted_edges.begin(), sorted_edges.end());
-
+            radix_sort_edges(sorted_edges);
         }
 
     // ------------------------------------------------------------------------------------
@@ -329,46 +512,99 @@ namespace dlib
 // ----------------------------------------------------------------------------------------
 
     template <
-        typename in_image_type,
+        typename pixel_type
+        >
+    class segmentation_edges
+    {
+    public:
+        typedef typename impl::edge_diff_funct<pixel_type>::diff_type diff_type;
+        typedef impl::segment_image_edge_data_T<diff_type> edge_type;
+
+        segmentation_edges (
+        ) : num_rows(0), num_cols(0) {}
+
+        template <
+            typename image_type
+            >
+        explicit segmentation_edges (
+            const image_type& img_,
+            unsigned long num_threads = 1
+        ) 
+        {
+            COMPILE_TIME_ASSERT((is_same_type<pixel_type, typename image_traits<image_type>::pixel_type>::value));
+
+            const_image_view<image_type> img(img_);
+            num_rows = img.nr();
+            num_cols = img.nc();
+            // images this small aren't segmented so they don't need any edges.
+            if (num_rows >= 2 && num_cols >= 2)
+                impl::get_pixel_edges(img, edges, num_threads);
+        }
+
+        long nr (
+        ) const { return num_rows; }
+
+        long nc (
+        ) const { return num_cols; }
+
+        const std::vector<edge_type>& get_sorted_edges (
+        ) const { return edges; }
+
+        void swap (
+            segmentation_edges& item
+        )
+        {
+            std::swap(num_rows, item.num_rows);
+            std::swap(num_cols, item.num_cols);
+            edges.swap(item.edges);
+        }
+
+    private:
+        long num_rows;
+        long num_cols;
+        std::vector<edge_type> edges;
+    };
+
+    template <typename pixel_type>
+    void swap (
+        segmentation_edges<pixel_type>& a,
+        segmentation_edges<pixel_type>& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type,
         typename out_image_type
         >
     void segment_image (
-        const in_image_type& in_img_,
+        const segmentation_edges<pixel_type>& graph,
         out_image_type& out_img_,
         const double k = 200,
         const unsigned long min_size = 10
     )
     {
         using namespace dlib::impl;
-        typedef typename image_traits<in_image_type>::pixel_type ptype;
-        typedef typename edge_diff_funct<ptype>::diff_type diff_type;
-
-        // make sure requires clause is not broken
-        DLIB_ASSERT(is_same_object(in_img_, out_img_) == false,
-            "\t void segment_image()"
-            << "\n\t The input images can't be the same object."
-            );
+        typedef typename segmentation_edges<pixel_type>::diff_type diff_type;
 
         COMPILE_TIME_ASSERT(is_unsigned_type<typename image_traits<out_image_type>::pixel_type>::value);
 
-        const_image_view<in_image_type> in_img(in_img_);
         image_view<out_image_type> out_img(out_img_);
 
-        out_img.set_size(in_img.nr(), in_img.nc());
+        out_img.set_size(graph.nr(), graph.nc());
         // don't bother doing anything if the image is too small
-        if (in_img.nr() < 2 || in_img.nc() < 2)
+        if (graph.nr() < 2 || graph.nc() < 2)
         {
             assign_all_pixels(out_img,0);
             return;
         }
 
         disjoint_subsets sets;
-        sets.set_size(in_img.size());
+        sets.set_size(out_img.size());
 
-        std::vector<segment_image_edge_data_T<diff_type> > sorted_edges;
-        get_pixel_edges(in_img, sorted_edges);
+        const std::vector<segment_image_edge_data_T<diff_type> >& sorted_edges = graph.get_sorted_edges();
 
-        std::vector<graph_image_segmentation_data_T<diff_type> > data(in_img.size());
+        std::vector<graph_image_segmentation_data_T<diff_type> > data(out_img.size());
 
         // now start connecting blobs together to make a minimum spanning tree.
         for (unsigned long i = 0; i < sorted_edges.size(); ++i)
@@ -424,6 +660,30 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename in_image_type,
+        typename out_image_type
+        >
+    void segment_image (
+        const in_image_type& in_img,
+        out_image_type& out_img,
+        const double k = 200,
+        const unsigned long min_size = 10,
+        const unsigned long num_threads = 1
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_same_object(in_img, out_img) == false,
+            "\t void segment_image()"
+            << "\n\t The input images can't be the same object."
+            );
+
+        typedef typename image_traits<in_image_type>::pixel_type ptype;
+        segment_image(segmentation_edges<ptype>(in_img, num_threads), out_img, k, min_size);
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 //                     Candidate object location generation code.
@@ -444,11 +704,11 @@ namespace dlib
         };
 
         template <
-            typename in_image_type,
             typename diff_type
             >
         void find_basic_candidate_object_locations (
-            const in_image_type& in_img,
+            const long nr,
+            const long nc,
             const std::vector<dlib::impl::segment_image_edge_data_T<diff_type> >& sorted_edges,
             std::vector<rectangle>& out_rects,
             std::vector<edge_data>& edges,
@@ -465,16 +725,16 @@ namespace dlib
             edges.clear();
 
             // don't bother doing anything if the image is too small
-            if (in_img.nr() < 2 || in_img.nc() < 2)
+            if (nr < 2 || nc < 2)
             {
                 return;
             }
 
             disjoint_subsets sets;
-            sets.set_size(in_img.size());
+            sets.set_size(nr*nc);
 
 
-            std::vector<graph_image_segmentation_data_T<diff_type> > data(in_img.size());
+            std::vector<graph_image_segmentation_data_T<diff_type> > data(nr*nc);
 
 
 
@@ -541,9 +801,9 @@ namespace dlib
             std::map<unsigned long, rectangle> boxes;
             std::map<unsigned long, unsigned long> box_id_map;
             unsigned long idx = 0;
-            for (long r = 0; r < in_img.nr(); ++r)
+            for (long r = 0; r < nr; ++r)
             {
-                for (long c = 0; c < in_img.nc(); ++c)
+                for (long c = 0; c < nc; ++c)
                 {
                     const unsigned long id = sets.find_set(idx++);
                     // Accumulate the current point into its box and if it is the first point
@@ -615,15 +875,16 @@ namespace dlib
 // ----------------------------------------------------------------------------------------
 
     template <
-        typename in_image_type,
+        typename pixel_type,
         typename EXP
         >
     void find_candidate_object_locations (
-        const in_image_type& in_img_,
+        const segmentation_edges<pixel_type>& graph,
         std::vector<rectangle>& rects,
         const matrix_exp<EXP>& kvals,
         const unsigned long min_size = 20,
-        const unsigned long max_merging_iterations = 50
+        const unsigned long max_merging_iterations = 50,
+        const unsigned long num_threads = 1
     )
     {
         // make sure requires clause is not broken
@@ -638,30 +899,31 @@ namespace dlib
         typedef dlib::set<rectangle, mm_type>::kernel_1a set_of_rects;
 
         using namespace dlib::impl;
-        typedef typename image_traits<in_image_type>::pixel_type ptype;
-        typedef typename edge_diff_funct<ptype>::diff_type diff_type;
-
-        const_image_view<in_image_type> in_img(in_img_);
 
         // don't bother doing anything if the image is too small
-        if (in_img.nr() < 2 || in_img.nc() < 2)
+        if (graph.nr() < 2 || graph.nc() < 2)
         {
             return;
         }
 
-        std::vector<edge_data> edges;
-        std::vector<rectangle> working_rects;
-        std::vector<segment_image_edge_data_T<diff_type> > sorted_edges;
-        get_pixel_edges(in_img, sorted_edges);
+        std::vector<double> ks(kvals.size());
+        for (long j = 0; j < kvals.size(); ++j)
+            ks[j] = kvals(j);
 
-        disjoint_subsets sets;
+        // Each k value is processed independently, possibly in parallel, and then the
+        // results are appended to rects in the order of kvals.
+        std::vector<std::vector<rectangle> > k_rects(ks.size());
+        parallel_for_segment_image(num_threads, 0, ks.size(), [&](long j) {
+            const double k = ks[j];
+            std::vector<rectangle>& out_rects = k_rects[j];
 
-        for (long j = 0; j < kvals.size(); ++j)
-        {
-            const double k = kvals(j);
+            std::vector<edge_data> edges;
+            std::vector<rectangle> working_rects;
+            disjoint_subsets sets;
 
-            find_basic_candidate_object_locations(in_img, sorted_edges, working_rects, edges, k, min_size);
-            rects.insert(rects.end(), working_rects.begin(), working_rects.end());
+            find_basic_candidate_object_locations(graph.nr(), graph.nc(), graph.get_sorted_edges(), 
+                working_rects, edges, k, min_size);
+            out_rects.insert(out_rects.end(), working_rects.begin(), working_rects.end());
 
 
             // Now iteratively merge all the rectangles we have and record the results.
@@ -696,7 +958,7 @@ namespace dlib
                         if (!detected_rects.is_member(merged_rect))
                         {
                             const unsigned long new_set = sets.merge_sets(temp.set1, temp.set2);
-                            rects.push_back(merged_rect);
+                            out_rects.push_back(merged_rect);
                             working_rects[new_set] = merged_rect;
                             did_merge = true;
                             detected_rects.add(merged_rect);
@@ -704,11 +966,42 @@ namespace dlib
                     }
                 }
             }
-        }
+        });
+
+        for (unsigned long j = 0; j < k_rects.size(); ++j)
+            rects.insert(rects.end(), k_rects[j].begin(), k_rects[j].end());
 
         remove_duplicates(rects);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename in_image_type,
+        typename EXP
+        >
+    void find_candidate_object_locations (
+        const in_image_type& in_img,
+        std::vector<rectangle>& rects,
+        const matrix_exp<EXP>& kvals,
+        const unsigned long min_size = 20,
+        const unsigned long max_merging_iterations = 50,
+        const unsigned long num_threads = 1
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_vector(kvals) && kvals.size() > 0,
+            "\t void find_candidate_object_locations()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t is_vector(kvals): " << is_vector(kvals)
+            << "\n\t kvals.size():     " << kvals.size()
+            );
+
+        typedef typename image_traits<in_image_type>::pixel_type ptype;
+        find_candidate_object_locations(segmentation_edges<ptype>(in_img, num_threads), 
+            rects, kvals, min_size, max_merging_iterations, num_threads);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -20,7 +20,8 @@ namespace dlib
         const in_image_type& in_img,
         out_image_type& out_img,
         const double k = 200,
-        const unsigned long min_size = 10
+        const unsigned long min_size = 10,
+        const unsigned long num_threads = 1
     );
     /*!
         requires
@@ -49,6 +50,115 @@ namespace dlib
               guaranteed that all output segments will have at least min_size pixels in
               them (unless the whole image contains fewer than min_size pixels, in this
               case the entire image will be put into a single segment).
+            - The graph of pixel edges used by the algorithm is built and sorted using
+              num_threads threads.  The output doesn't depend on num_threads.
+            - This function is equivalent to:
+                segment_image(segmentation_edges<pixel_type>(in_img,num_threads), out_img, k, min_size);
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type
+        >
+    class segmentation_edges
+    {
+        /*!
+            REQUIREMENTS ON pixel_type
+                pixel_type can be any pixel type with a pixel_traits specialization or a
+                dlib matrix object representing a row or column vector.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the edges between neighboring pixels of an image, sorted
+                by how different the pixels are.  Building this list is a large part of
+                the work done by segment_image() and find_candidate_object_locations().
+                So if you want to run them on the same image several times, e.g. with
+                different parameters, you can make a segmentation_edges once and give it
+                to each call instead of the image.
+        !*/
+
+    public:
+        typedef implementation_defined edge_type;
+
+        segmentation_edges (
+        );
+        /*!
+            ensures
+                - #nr() == 0
+                - #nc() == 0
+        !*/
+
+        template <
+            typename image_type
+            >
+        explicit segmentation_edges (
+            const image_type& img,
+            unsigned long num_threads = 1
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h and contains pixel_type pixels.
+            ensures
+                - #nr() == num_rows(img)
+                - #nc() == num_columns(img)
+                - Finds and sorts the edges of img using num_threads threads.  The result
+                  doesn't depend on num_threads.
+        !*/
+
+        long nr (
+        ) const;
+        /*!
+            ensures
+                - returns the number of rows in the image this object was made from.
+        !*/
+
+        long nc (
+        ) const;
+        /*!
+            ensures
+                - returns the number of columns in the image this object was made from.
+        !*/
+
+        const std::vector<edge_type>& get_sorted_edges (
+        ) const;
+        /*!
+            ensures
+                - returns the edges, sorted by increasing pixel difference.  This is
+                  used by segment_image() and find_candidate_object_locations().
+        !*/
+
+        void swap (
+            segmentation_edges& item
+        );
+        /*!
+            ensures
+                - swaps *this and item
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type,
+        typename out_image_type
+        >
+    void segment_image (
+        const segmentation_edges<pixel_type>& graph,
+        out_image_type& out_img,
+        const double k = 200,
+        const unsigned long min_size = 10
+    );
+    /*!
+        requires
+            - out_image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - out_image_type must contain an unsigned integer pixel type.
+        ensures
+            - Performs the same segmentation as the above segment_image() routine would on
+              the image graph was made from.
+            - #out_img.nr() == graph.nr()
+            - #out_img.nc() == graph.nc()
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -64,7 +174,8 @@ namespace dlib
         std::vector<rectangle>& rects,
         const matrix_exp<EXP>& kvals = linspace(50, 200, 3),
         const unsigned long min_size = 20,
-        const unsigned long max_merging_iterations = 50
+        const unsigned long max_merging_iterations = 50,
+        const unsigned long num_threads = 1
     );
     /*!
         requires
@@ -100,6 +211,33 @@ namespace dlib
               rectangles.  That is, for all valid i and j where i != j it will be true
               that:
                 - #rects[i] != rects[j]
+            - The edge graph is built using num_threads threads and the segmentations for
+              the different kvals are run in parallel on num_threads threads.  The output
+              doesn't depend on num_threads.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type,
+        typename EXP
+        >
+    void find_candidate_object_locations (
+        const segmentation_edges<pixel_type>& graph,
+        std::vector<rectangle>& rects,
+        const matrix_exp<EXP>& kvals = linspace(50, 200, 3),
+        const unsigned long min_size = 20,
+        const unsigned long max_merging_iterations = 50,
+        const unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - is_vector(kvals) == true
+            - kvals.size() > 0
+        ensures
+            - Does the same thing as the above find_candidate_object_locations() routine
+              would on the image graph was made from, except the edge graph doesn't need
+              to be built again.
     !*/
 
 // ----------------------------------------------------------------------------------------
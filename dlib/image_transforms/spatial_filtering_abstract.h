@@ -69,6 +69,16 @@ namespace dlib
             - if (use_abs == false && all images and filers contain float types) then
                 - This function will use SIMD instructions and is particularly fast.  So if
                   you can use this form of the function it can give a decent speed boost.
+            - if (in_img contains grayscale pixels, out_img contains float or double
+              pixels, and EXP::type is float or double) then
+                - For large filters this function automatically switches from direct
+                  filtering to FFT based filtering, which is much faster.  In this case the
+                  outputs may differ from direct filtering by floating point rounding error.
+                  This error is on the order of 1e-6 times the magnitude of the outputs
+                  for float images.  Filters with fewer than 100 elements are always
+                  applied directly.
+                - Output images with integer pixels are always filtered directly, so they
+                  are never affected by this rounding.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -87,7 +97,8 @@ namespace dlib
         const matrix_exp<EXP2>& col_filter,
         T scale = 1,
         bool use_abs = false,
-        bool add_to = false
+        bool add_to = false,
+        unsigned long num_threads = 1
     );
     /*!
         requires
@@ -105,8 +116,9 @@ namespace dlib
             - is_vector(row_filter) == true
             - is_vector(col_filter) == true
             - if (in_img doesn't contain grayscale pixels) then
-                - use_abs == false && add_to == false
-                  (i.e. You can only use the use_abs and add_to options with grayscale images)
+                - The use_abs and add_to arguments are not available.  That is, for color
+                  images this function is called as
+                  spatially_filter_image_separable(in_img,out_img,row_filter,col_filter,scale,num_threads).
         ensures
             - Applies the given separable spatial filter to in_img and stores the result in out_img.  
               Also divides each resulting pixel by scale.  Calling this function has the same
@@ -138,6 +150,13 @@ namespace dlib
             - if (use_abs == false && all images and filers contain float types) then
                 - This function will use SIMD instructions and is particularly fast.  So if
                   you can use this form of the function it can give a decent speed boost.
+            - The row filter outputs are streamed through a small buffer of
+              col_filter.size() rows rather than being stored in a temporary image the
+              size of in_img.
+            - if (num_threads > 1) then
+                - The image is split into horizontal bands which are filtered in parallel
+                  using num_threads threads.  The output is identical to the output
+                  obtained when num_threads == 1.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -154,7 +173,8 @@ namespace dlib
         const matrix_exp<EXP1>& row_filter,
         const matrix_exp<EXP2>& col_filter,
         out_image_type& scratch,
-        bool add_to = false
+        bool add_to = false,
+        unsigned long num_threads = 1
     );
     /*!
         requires
@@ -180,6 +200,13 @@ namespace dlib
               image as input.  This allows you to reuse the same scratch image for many
               calls to float_spatially_filter_image_separable() and thereby avoid having it
               allocated and freed for each call.
+            - if (num_threads <= 1) then
+                - #scratch.nr() == col_filter.size()
+                  (i.e. scratch only holds the row filtered rows currently needed by the
+                  column filter, not a copy of the whole image.)
+            - else
+                - The filtering is done in parallel using num_threads threads, each of
+                  which allocates its own row buffer, so scratch is not used.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -357,7 +384,8 @@ namespace dlib
         const in_image_type& in_img,
         out_image_type& out_img,
         double sigma = 1,
-        int max_size = 1001
+        int max_size = 1001,
+        unsigned long num_threads = 1
     );
     /*!
         requires
@@ -386,6 +414,8 @@ namespace dlib
             - #out_img.nr() == in_img.nr()
             - returns a rectangle which indicates what pixels in #out_img are considered 
               non-border pixels and therefore contain output from the filter.
+            - The filtering is done by spatially_filter_image_separable() using num_threads
+              threads.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -7,6 +7,13 @@
 #include "matrix_utilities.h"
 #include "../hash.h"
 #include "../algs.h"
+#include "../numeric_constants.h"
+#include "../simd/simd_check.h"
+#include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 
 // No using FFTW until it becomes thread safe!
@@ -38,363 +45,713 @@ namespace dlib
 
     // ------------------------------------------------------------------------------------
 
-        /*
-            The next few functions related to doing FFTs are derived from Stefan
-            Gustavson's (stegu@itn.liu.se) public domain 2D Fourier transformation code.
-            The code has a long history, originally a FORTRAN implementation published in:
-            Programming for Digital Signal Processing, IEEE Press 1979, Section 1, by G. D.
-            Bergland and M. T. Dolan.  In 2003 it was cleaned up and turned into modern C
-            by Steven Gustavson.  Davis King then rewrote it in modern C++ in 2014 and also
-            changed the transform so that the outputs are identical to those given from FFTW.
-        */
-
-    // ------------------------------------------------------------------------------------
-
-        /* Get binary log of integer argument - exact if n is a power of 2 */
-        inline long fastlog2(long n)
+        class fft_complex
         {
-            long log = -1;
-            while(n) {
-                log++;
-                n >>= 1;
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is a std::complex<double> held in a single SSE2 register when
+                    available.  The FFT butterflies are written in terms of it so every
+                    complex value is loaded and stored as one 16 byte unit.  Letting the
+                    compiler pick apart std::complex values on its own tends to produce
+                    mixed scalar and vector memory accesses, which stall the CPU's store
+                    forwarding and made the butterflies several times slower.
+            !*/
+        public:
+#ifdef DLIB_HAVE_SSE2
+            explicit fft_complex (const std::complex<double>& v) : x(_mm_loadu_pd(reinterpret_cast<const double*>(&v))) {}
+            void store (std::complex<double>* p) const { _mm_storeu_pd(reinterpret_cast<double*>(p), x); }
+
+            fft_complex operator+ (const fft_complex& rhs) const { return fft_complex(_mm_add_pd(x, rhs.x)); }
+            fft_complex operator- (const fft_complex& rhs) const { return fft_complex(_mm_sub_pd(x, rhs.x)); }
+            fft_complex operator* (double rhs) const { return fft_complex(_mm_mul_pd(x, _mm_set1_pd(rhs))); }
+            fft_complex operator* (const fft_complex& rhs) const 
+            { 
+                // (a+bi)*(c+di) == a*(c+di) + b*(-d+ci)
+                const __m128d re = _mm_unpacklo_pd(x,x);
+                const __m128d im = _mm_unpackhi_pd(x,x);
+                const __m128d swapped = _mm_shuffle_pd(rhs.x, rhs.x, 1);
+                return fft_complex(_mm_add_pd(_mm_mul_pd(re, rhs.x), 
+                                              _mm_mul_pd(im, _mm_xor_pd(swapped, _mm_set_pd(0.0,-0.0)))));
             }
-            return log ;
-        }
-
-    // ------------------------------------------------------------------------------------
-
-        /* Radix-2 iteration subroutine */
-        template <typename T>
-        void R2TX(int nthpo, std::complex<T> *c0, std::complex<T> *c1)
-        {
-            for(int k=0; k<nthpo; k+=2) 
-            {
-                std::complex<T> temp = c0[k] + c1[k];
-                c1[k] = c0[k] - c1[k];
-                c0[k] = temp;
+            fft_complex times_i (
+            ) const 
+            { 
+                // (a+bi)*i == -b+ai
+                return fft_complex(_mm_xor_pd(_mm_shuffle_pd(x, x, 1), _mm_set_pd(0.0,-0.0)));
             }
-        }
-
-    // ------------------------------------------------------------------------------------
+            fft_complex conj (
+            ) const { return fft_complex(_mm_xor_pd(x, _mm_set_pd(-0.0,0.0))); }
 
-        /* Radix-4 iteration subroutine */
-        template <typename T>
-        void R4TX(int nthpo, std::complex<T> *c0, std::complex<T> *c1,
-            std::complex<T> *c2, std::complex<T> *c3)
-        {
-            for(int k=0;k<nthpo;k+=4) 
-            {
-                std::complex<T> t1, t2, t3, t4;
-                t1 = c0[k] + c2[k];
-                t2 = c0[k] - c2[k];
-                t3 = c1[k] + c3[k];
-                t4 = c1[k] - c3[k];
-
-                c0[k] = t1 + t3;
-                c1[k] = t1 - t3;
-                c2[k] = std::complex<T>(t2.real()-t4.imag(), t2.imag()+t4.real());
-                c3[k] = std::complex<T>(t2.real()+t4.imag(), t2.imag()-t4.real());
+        private:
+            explicit fft_complex (__m128d v) : x(v) {}
+            __m128d x;
+#else
+            explicit fft_complex (const std::complex<double>& v) : re(v.real()), im(v.imag()) {}
+            void store (std::complex<double>* p) const { *p = std::complex<double>(re,im); }
+
+            fft_complex operator+ (const fft_complex& rhs) const { return fft_complex(re+rhs.re, im+rhs.im); }
+            fft_complex operator- (const fft_complex& rhs) const { return fft_complex(re-rhs.re, im-rhs.im); }
+            fft_complex operator* (double rhs) const { return fft_complex(re*rhs, im*rhs); }
+            fft_complex operator* (const fft_complex& rhs) const 
+            { 
+                // Spelled out since std::complex's operator* does a lot of extra work to
+                // deal with NaNs and infinities.
+                return fft_complex(re*rhs.re - im*rhs.im, re*rhs.im + im*rhs.re);
             }
-        }
+            fft_complex times_i (
+            ) const { return fft_complex(-im, re); }
+            fft_complex conj (
+            ) const { return fft_complex(re, -im); }
+
+        private:
+            fft_complex (double r, double i) : re(r), im(i) {}
+            double re, im;
+#endif
+        };
 
     // ------------------------------------------------------------------------------------
 
-        template <typename T>
-        class twiddles
+        class fft_plan
         {
             /*!
-                The point of this object is to cache the twiddle values so we don't
-                recompute them over and over inside R8TX().
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds everything needed to compute a 1D complex FFT of one
+                    particular size and direction.  That is, the factorization of the size
+                    into radices and a table of twiddle factors.  Making a plan costs about
+                    as much as running it, so plans are cached and shared by get_fft_plan().
+
+                    The transform is a mixed radix, decimation in time FFT in the style of
+                    Mark Borgerding's KISS FFT.  There are specialized butterflies for
+                    radix 2, 3, 4, and 5 and a generic O(p^2) butterfly for any other prime
+                    factor p.  The generic butterfly costs O(n*p) for the whole transform,
+                    so if n has a prime factor bigger than max_direct_prime we instead use
+                    Bluestein's algorithm.  It writes the transform as a convolution, which
+                    is computed with FFTs of a size m >= 2*n-1 whose prime factors are all
+                    2, 3, or 5.  So any size works and the cost is always O(n*log(n)), but
+                    sizes whose prime factors are all 2, 3, or 5 are several times faster
+                    than the others.
+
+                    execute() can run a batch of transforms at once, where element j of
+                    every transform is stored contiguously.  The butterflies then sweep
+                    over contiguous memory, which is what makes the column pass of a 2D FFT
+                    cache friendly.
             !*/
         public:
 
-            twiddles()
+            // Prime factors bigger than this are handled with Bluestein's algorithm.
+            static const long max_direct_prime = 13;
+
+            fft_plan (
+                long n_,
+                bool inverse_
+            ) : n(n_), inverse(inverse_)
             {
-                data.resize(64);
+                DLIB_ASSERT(n > 0, "");
+                // compute the twiddle factors
+                const double phase = (inverse ? 2 : -2)*pi/n;
+                twiddles.resize(n);
+                for (long i = 0; i < n; ++i)
+                    twiddles[i] = std::polar(1.0, phase*i);
+
+                // Factor n.  We pull out all the 4s first, then 2s, then 3s, 5s, and so on.
+                long p = 4;
+                long rest = n;
+                const long floor_sqrt = static_cast<long>(std::floor(std::sqrt((double)n)));
+                do
+                {
+                    while (rest%p != 0)
+                    {
+                        if (p == 4)       p = 2;
+                        else if (p == 2)  p = 3;
+                        else              p += 2;
+                        if (p > floor_sqrt)
+                            p = rest;
+                    }
+                    rest /= p;
+                    factors.push_back(p);
+                    factors.push_back(rest);
+                } while (rest > 1);
+
+                // The factors are found in increasing order so the first one of the last
+                // pair is the largest.
+                if (factors[factors.size()-2] > max_direct_prime)
+                    setup_bluestein();
+            }
+
+            long size (
+            ) const { return n; }
+
+            bool is_inverse (
+            ) const { return inverse; }
+
+            const std::complex<double>& twiddle (
+                long i
+            ) const
+            /*!
+                requires
+                    - 0 <= i < size()
+                ensures
+                    - returns exp(-2*pi*sqrt(-1)*i/size()) if this is a forward plan and the
+                      conjugate of that if it's an inverse plan.
+            !*/
+            { 
+                return twiddles[i]; 
             }
-            
-            const std::complex<T>* get_twiddles (
-                int p 
-            ) 
+
+            void execute (
+                const std::complex<double>* in,
+                std::complex<double>* out,
+                long batch
+            ) const
             /*!
                 requires
-                    - 0 <= p <= 64
+                    - in and out each point to size()*batch elements and don't overlap.
+                    - batch > 0
                 ensures
-                    - returns a pointer to the twiddle factors needed by R8TX if nxtlt == 2^p
+                    - Computes batch independent FFTs.  Element j of the b-th transform is
+                      in[j*batch+b] and the output is written to out with the same layout.
+                    - Forward transforms use exp(-2*pi*sqrt(-1)*j*k/size()) and inverse
+                      transforms use exp(+2*pi*sqrt(-1)*j*k/size()).  Neither is scaled.
             !*/
             {
-                // Compute the twiddle factors for this p value if we haven't done so
-                // already.
-                if (data[p].size() == 0)
-                {
-                    const int nxtlt = 0x1 << p;
-                    data[p].reserve(nxtlt*7);
-                    const T twopi = 6.2831853071795865; /* 2.0 * pi */
-                    const T scale = twopi/(nxtlt*8.0);
-                    std::complex<T> cs[7];
-                    for (int j = 0; j < nxtlt; ++j)
-                    {
-                        const T arg = j*scale;
-                        cs[0] = std::complex<T>(std::cos(arg),std::sin(arg));
-                        cs[1] = cs[0]*cs[0];
-                        cs[2] = cs[1]*cs[0];
-                        cs[3] = cs[1]*cs[1];
-                        cs[4] = cs[2]*cs[1];
-                        cs[5] = cs[2]*cs[2];
-                        cs[6] = cs[3]*cs[2];
-                        data[p].insert(data[p].end(), cs, cs+7);
-                    }
-                }
-
-                return &data[p][0];
+                if (n == 1)
+                    std::copy(in, in+batch, out);
+                else if (conv_forward)
+                    execute_bluestein(in, out, batch);
+                else if (batch == 1)
+                    work<true>(out, in, 1, &factors[0], 1);
+                else
+                    work<false>(out, in, 1, &factors[0], batch);
             }
 
         private:
-            std::vector<std::vector<std::complex<T> > > data;
-        };
 
-    // ----------------------------------------------------------------------------------------
+            typedef std::complex<double> cd;
 
-        /* Radix-8 iteration subroutine */
-        template <typename T>
-        void R8TX(int nxtlt, int nthpo, int length, const std::complex<T>* cs,
-            std::complex<T> *cc0, std::complex<T> *cc1, std::complex<T> *cc2, std::complex<T> *cc3,
-            std::complex<T> *cc4, std::complex<T> *cc5, std::complex<T> *cc6, std::complex<T> *cc7)
-        {
-            const T irt2 = 0.707106781186548;  /* 1.0/sqrt(2.0) */
+            template <bool single>
+            void work (
+                cd* out,
+                const cd* in,
+                const long fstride,
+                const long* f,
+                const long batch_
+            ) const
+            {
+                // When single is true the compiler knows batch == 1 and drops the inner
+                // loops over the batch.  This matters a lot for plain 1D transforms.
+                const long batch = single ? 1 : batch_;
+                const long p = f[0];
+                const long m = f[1];
+                const long step = fstride*batch;
+
+                // First do the m point sub-transforms of each of the p decimated subsequences.
+                if (m == 1)
+                {
+                    for (long q = 0; q < p; ++q, in += step)
+                        std::copy(in, in+batch, out+q*batch);
+                }
+                else
+                {
+                    for (long q = 0; q < p; ++q, in += step)
+                        work<single>(out+q*m*batch, in, fstride*p, f+2, batch);
+                }
+
+                // Then combine them with radix p butterflies.
+                switch (p)
+                {
+                    case 2: bfly2<single>(out, fstride, m, batch); break;
+                    case 3: bfly3<single>(out, fstride, m, batch); break;
+                    case 4: bfly4<single>(out, fstride, m, batch); break;
+                    case 5: bfly5<single>(out, fstride, m, batch); break;
+                    default: bfly_generic<single>(out, fstride, m, p, batch); break;
+                }
+            }
 
-            for(int j=0; j<nxtlt; j++) 
+            template <bool single>
+            void bfly2 (
+                cd* out,
+                const long fstride,
+                const long m,
+                const long batch_
+            ) const
             {
-                for(int k=j;k<nthpo;k+=length) 
+                const long batch = single ? 1 : batch_;
+                cd* out1 = out + m*batch;
+                for (long k = 0; k < m; ++k, out += batch, out1 += batch)
                 {
-                    std::complex<T> a0, a1, a2, a3, a4, a5, a6, a7;
-                    std::complex<T> b0, b1, b2, b3, b4, b5, b6, b7;
-                    a0 = cc0[k] + cc4[k];
-                    a1 = cc1[k] + cc5[k];
-                    a2 = cc2[k] + cc6[k];
-                    a3 = cc3[k] + cc7[k];
-                    a4 = cc0[k] - cc4[k];
-                    a5 = cc1[k] - cc5[k];
-                    a6 = cc2[k] - cc6[k];
-                    a7 = cc3[k] - cc7[k];
-
-                    b0 = a0 + a2;
-                    b1 = a1 + a3;
-                    b2 = a0 - a2;
-                    b3 = a1 - a3;
-
-                    b4 = std::complex<T>(a4.real()-a6.imag(), a4.imag()+a6.real());
-                    b5 = std::complex<T>(a5.real()-a7.imag(), a5.imag()+a7.real());
-                    b6 = std::complex<T>(a4.real()+a6.imag(), a4.imag()-a6.real());
-                    b7 = std::complex<T>(a5.real()+a7.imag(), a5.imag()-a7.real());
-
-                    const std::complex<T> tmp0(-b3.imag(), b3.real());
-                    const std::complex<T> tmp1(irt2*(b5.real()-b5.imag()), irt2*(b5.real()+b5.imag()));
-                    const std::complex<T> tmp2(-irt2*(b7.real()+b7.imag()), irt2*(b7.real()-b7.imag()));
-
-                    cc0[k] = b0 + b1;
-                    cc1[k] = b0 - b1;
-                    cc2[k] = b2 + tmp0;
-                    cc3[k] = b2 - tmp0;
-                    cc4[k] = b4 + tmp1;
-                    cc5[k] = b4 - tmp1;
-                    cc6[k] = b6 + tmp2;
-                    cc7[k] = b6 - tmp2;
-                    if(j>0) 
+                    const fft_complex w(twiddles[k*fstride]);
+                    for (long b = 0; b < batch; ++b)
                     {
-                        cc1[k] *= cs[3];
-                        cc2[k] *= cs[1];
-                        cc3[k] *= cs[5];
-                        cc4[k] *= cs[0];
-                        cc5[k] *= cs[4];
-                        cc6[k] *= cs[2];
-                        cc7[k] *= cs[6];
+                        const fft_complex a(out[b]);
+                        const fft_complex t = fft_complex(out1[b])*w;
+                        (a - t).store(out1+b);
+                        (a + t).store(out+b);
                     }
                 }
-
-                cs += 7;
             }
-        }
 
-    // ------------------------------------------------------------------------------------
-
-        template <typename T, long NR, long NC, typename MM, typename layout>
-        void fft1d_inplace(matrix<std::complex<T>,NR,NC,MM,layout>& data, bool do_backward_fft, twiddles<T>& cs)
-        /*!
-            requires
-                - is_vector(data) == true
-                - is_power_of_two(data.size()) == true
-            ensures
-                - This routine replaces the input std::complex<double> vector by its finite
-                  discrete complex fourier transform if do_backward_fft==true.  It replaces
-                  the input std::complex<double> vector by its finite discrete complex
-                  inverse fourier transform if do_backward_fft==false.
-
-                  The implementation is a radix-2 FFT, but with faster shortcuts for
-                  radix-4 and radix-8. It performs as many radix-8 iterations as possible,
-                  and then finishes with a radix-2 or -4 iteration if needed.
-        !*/
-        {
-            if (data.size() == 0)
-                return;
-
-            std::complex<T>* const b = &data(0);
-            int L[16],L1,L2,L3,L4,L5,L6,L7,L8,L9,L10,L11,L12,L13,L14,L15;
-            int j1,j2,j3,j4,j5,j6,j7,j8,j9,j10,j11,j12,j13,j14;
-            int j, ij, ji;
-            int n2pow, n8pow, nthpo, ipass, nxtlt, length;
-
-            n2pow = fastlog2(data.size());
-            nthpo = data.size();
+            template <bool single>
+            void bfly3 (
+                cd* out,
+                const long fstride,
+                const long m,
+                const long batch_
+            ) const
+            {
+                const long batch = single ? 1 : batch_;
+                const long m1 = m*batch;
+                const long m2 = 2*m*batch;
+                const double epi3 = twiddles[fstride*m].imag();
+                for (long k = 0; k < m; ++k, out += batch)
+                {
+                    const fft_complex w1(twiddles[k*fstride]);
+                    const fft_complex w2(twiddles[2*k*fstride]);
+                    for (long b = 0; b < batch; ++b)
+                    {
+                        const fft_complex s0(out[b]);
+                        const fft_complex s1 = fft_complex(out[m1+b])*w1;
+                        const fft_complex s2 = fft_complex(out[m2+b])*w2;
+                        const fft_complex s3 = s1 + s2;
+                        const fft_complex s4 = ((s1 - s2)*epi3).times_i();
+                        const fft_complex a = s0 - s3*0.5;
+                        (s0 + s3).store(out+b);
+                        (a + s4).store(out+m1+b);
+                        (a - s4).store(out+m2+b);
+                    }
+                }
+            }
 
-            n8pow = n2pow/3;
+            template <bool single>
+            void bfly4 (
+                cd* out,
+                const long fstride,
+                const long m,
+                const long batch_
+            ) const
+            {
+                const long batch = single ? 1 : batch_;
+                const long m1 = m*batch;
+                const long m2 = 2*m*batch;
+                const long m3 = 3*m*batch;
+                // The forward and inverse transforms differ only in the direction of this
+                // rotation by 90 degrees.
+                const double sign = inverse ? 1 : -1;
+                for (long k = 0; k < m; ++k, out += batch)
+                {
+                    const fft_complex w1(twiddles[k*fstride]);
+                    const fft_complex w2(twiddles[2*k*fstride]);
+                    const fft_complex w3(twiddles[3*k*fstride]);
+                    for (long b = 0; b < batch; ++b)
+                    {
+                        const fft_complex s0(out[b]);
+                        const fft_complex s1 = fft_complex(out[m1+b])*w1;
+                        const fft_complex s2 = fft_complex(out[m2+b])*w2;
+                        const fft_complex s3 = fft_complex(out[m3+b])*w3;
+                        const fft_complex s5 = s0 - s2;
+                        const fft_complex s6 = s0 + s2;
+                        const fft_complex s7 = s1 + s3;
+                        const fft_complex s8 = ((s1 - s3)*sign).times_i();
+                        (s6 + s7).store(out+b);
+                        (s6 - s7).store(out+m2+b);
+                        (s5 + s8).store(out+m1+b);
+                        (s5 - s8).store(out+m3+b);
+                    }
+                }
+            }
 
-            if(n8pow)
+            template <bool single>
+            void bfly5 (
+                cd* out,
+                const long fstride,
+                const long m,
+                const long batch_
+            ) const
             {
-                /* Radix 8 iterations */
-                for(ipass=1;ipass<=n8pow;ipass++) 
+                const long batch = single ? 1 : batch_;
+                const long m1 = m*batch;
+                const long m2 = 2*m*batch;
+                const long m3 = 3*m*batch;
+                const long m4 = 4*m*batch;
+                const cd ya = twiddles[fstride*m];
+                const cd yb = twiddles[2*fstride*m];
+                for (long k = 0; k < m; ++k, out += batch)
                 {
-                    const int p = n2pow - 3*ipass;
-                    nxtlt = 0x1 << p;
-                    length = 8*nxtlt;
-                    R8TX(nxtlt, nthpo, length, cs.get_twiddles(p),
-                        b, b+nxtlt, b+2*nxtlt, b+3*nxtlt,
-                        b+4*nxtlt, b+5*nxtlt, b+6*nxtlt, b+7*nxtlt);
+                    const fft_complex w1(twiddles[k*fstride]);
+                    const fft_complex w2(twiddles[2*k*fstride]);
+                    const fft_complex w3(twiddles[3*k*fstride]);
+                    const fft_complex w4(twiddles[4*k*fstride]);
+                    for (long b = 0; b < batch; ++b)
+                    {
+                        const fft_complex s0(out[b]);
+                        const fft_complex s1 = fft_complex(out[m1+b])*w1;
+                        const fft_complex s2 = fft_complex(out[m2+b])*w2;
+                        const fft_complex s3 = fft_complex(out[m3+b])*w3;
+                        const fft_complex s4 = fft_complex(out[m4+b])*w4;
+
+                        const fft_complex s7 = s1 + s4;
+                        const fft_complex s10 = s1 - s4;
+                        const fft_complex s8 = s2 + s3;
+                        const fft_complex s9 = s2 - s3;
+
+                        (s0 + s7 + s8).store(out+b);
+
+                        const fft_complex s5 = s0 + s7*ya.real() + s8*yb.real();
+                        const fft_complex s6 = (s10*ya.imag() + s9*yb.imag()).times_i();
+                        (s5 + s6).store(out+m1+b);
+                        (s5 - s6).store(out+m4+b);
+
+                        const fft_complex s11 = s0 + s7*yb.real() + s8*ya.real();
+                        const fft_complex s12 = (s10*yb.imag() - s9*ya.imag()).times_i();
+                        (s11 + s12).store(out+m2+b);
+                        (s11 - s12).store(out+m3+b);
+                    }
                 }
             }
 
-            if(n2pow%3 == 1) 
+            template <bool single>
+            void bfly_generic (
+                cd* out,
+                const long fstride,
+                const long m,
+                const long p,
+                const long batch_
+            ) const
             {
-                /* A final radix 2 iteration is needed */
-                R2TX(nthpo, b, b+1); 
+                const long batch = single ? 1 : batch_;
+                std::vector<cd> scratch(p);
+                for (long u = 0; u < m; ++u)
+                {
+                    for (long b = 0; b < batch; ++b)
+                    {
+                        for (long q = 0; q < p; ++q)
+                            scratch[q] = out[(u+q*m)*batch + b];
+
+                        for (long q1 = 0; q1 < p; ++q1)
+                        {
+                            const long k = u + q1*m;
+                            const long tw_step = fstride*k;
+                            long twidx = 0;
+                            fft_complex sum(scratch[0]);
+                            for (long q = 1; q < p; ++q)
+                            {
+                                twidx += tw_step;
+                                if (twidx >= n)
+                                    twidx %= n;
+                                sum = sum + fft_complex(scratch[q])*fft_complex(twiddles[twidx]);
+                            }
+                            sum.store(out + k*batch + b);
+                        }
+                    }
+                }
             }
 
-            if(n2pow%3 == 2)  
+            void setup_bluestein (
+            )
             {
-                /* A final radix 4 iteration is needed */
-                R4TX(nthpo, b, b+1, b+2, b+3); 
+                // The transform is X(k) == c(k)*sum_j (x(j)*c(j))*conj(c(k-j)), where
+                // c(j) == exp(+-pi*sqrt(-1)*j*j/n).  The sum is a convolution, which we do
+                // with FFTs of size m.  It needs m >= 2*n-1 so the cyclic convolution
+                // doesn't wrap around onto the part we want.
+                long m = 2*n-1;
+                while (!is_smooth(m))
+                    ++m;
+
+                const double phase = (inverse ? 1 : -1)*pi/n;
+                chirp.resize(n);
+                for (long j = 0; j < n; ++j)
+                {
+                    // j*j can be huge, so reduce it mod 2*n, the period of c(j), to keep
+                    // the phase accurate.
+                    const long jj = static_cast<long>((static_cast<unsigned long long>(j)*j)%(2*n));
+                    chirp[j] = std::polar(1.0, phase*jj);
+                }
+
+                conv_forward.reset(new fft_plan(m, false));
+                conv_inverse.reset(new fft_plan(m, true));
+                std::vector<cd> temp(m);
+                temp[0] = std::conj(chirp[0]);
+                for (long j = 1; j < n; ++j)
+                    temp[j] = temp[m-j] = std::conj(chirp[j]);
+                conv_filter.resize(m);
+                conv_forward->execute(&temp[0], &conv_filter[0], 1);
+                // Fold the scaling of the inverse FFT into the filter.
+                for (long k = 0; k < m; ++k)
+                    conv_filter[k] /= m;
             }
 
-            for(j=1;j<=15;j++) 
+            static bool is_smooth (
+                long m
+            )
             {
-                L[j] = 1;
-                if(j-n2pow <= 0) L[j] = 0x1 << (n2pow + 1 - j);
+                for (long p = 2; p <= 5; ++p)
+                {
+                    while (m%p == 0)
+                        m /= p;
+                }
+                return m == 1;
             }
 
-            L15=L[1];L14=L[2];L13=L[3];L12=L[4];L11=L[5];L10=L[6];L9=L[7];
-            L8=L[8];L7=L[9];L6=L[10];L5=L[11];L4=L[12];L3=L[13];L2=L[14];L1=L[15];
-
-            ij = 0;
-
-            for(j1=0;j1<L1;j1++)
-                for(j2=j1;j2<L2;j2+=L1)
-                    for(j3=j2;j3<L3;j3+=L2)
-                        for(j4=j3;j4<L4;j4+=L3)
-                            for(j5=j4;j5<L5;j5+=L4)
-                                for(j6=j5;j6<L6;j6+=L5)
-                                    for(j7=j6;j7<L7;j7+=L6)
-                                        for(j8=j7;j8<L8;j8+=L7)
-                                            for(j9=j8;j9<L9;j9+=L8)
-                                                for(j10=j9;j10<L10;j10+=L9)
-                                                    for(j11=j10;j11<L11;j11+=L10)
-                                                        for(j12=j11;j12<L12;j12+=L11)
-                                                            for(j13=j12;j13<L13;j13+=L12)
-                                                                for(j14=j13;j14<L14;j14+=L13)
-                                                                    for(ji=j14;ji<L15;ji+=L14) 
-                                                                    {
-                                                                        if(ij<ji)
-                                                                            swap(b[ij], b[ji]);
-                                                                        ij++;
-                                                                    }
-
-
-            // unscramble outputs
-            if(!do_backward_fft) 
+            void execute_bluestein (
+                const cd* in,
+                cd* out,
+                const long batch
+            ) const
             {
-                for(long i=1, j=data.size()-1; i<data.size()/2; i++,j--)
+                const long m = conv_filter.size();
+                std::vector<cd> a(m), fa(m);
+                for (long b = 0; b < batch; ++b)
                 {
-                    swap(b[j], b[i]);
+                    for (long j = 0; j < n; ++j)
+                        (fft_complex(in[j*batch+b])*fft_complex(chirp[j])).store(&a[j]);
+                    std::fill(a.begin()+n, a.end(), cd(0));
+                    conv_forward->execute(&a[0], &fa[0], 1);
+                    for (long k = 0; k < m; ++k)
+                        (fft_complex(fa[k])*fft_complex(conv_filter[k])).store(&fa[k]);
+                    conv_inverse->execute(&fa[0], &a[0], 1);
+                    for (long k = 0; k < n; ++k)
+                        (fft_complex(a[k])*fft_complex(chirp[k])).store(out + k*batch + b);
                 }
             }
-        }
+
+            long n;
+            bool inverse;
+            std::vector<long> factors;
+            std::vector<cd> twiddles;
+
+            // These are only used by Bluestein's algorithm.
+            std::vector<cd> chirp;
+            std::vector<cd> conv_filter;
+            std::unique_ptr<fft_plan> conv_forward;
+            std::unique_ptr<fft_plan> conv_inverse;
+        };
 
     // ------------------------------------------------------------------------------------
 
-        template < typename T, long NR, long NC, typename MM, typename L >
-        void fft2d_inplace(
-            matrix<std::complex<T>,NR,NC,MM,L>& data,
-            bool do_backward_fft
+        inline std::shared_ptr<const fft_plan> get_shared_fft_plan (
+            long n,
+            bool inverse
         )
+        /*!
+            requires
+                - n > 0
+            ensures
+                - returns a plan for FFTs of size n in the given direction from a cache
+                  shared by all threads.  
+        !*/
         {
-            if (data.size() == 0)
-                return;
-
-            matrix<std::complex<double> > buff;
-            twiddles<double> cs;
-
-            // Compute transform row by row
-            for(long r=0; r<data.nr(); ++r) 
+            // The cache holds at most this many plans.  When it's full we just empty it.
+            // Plans that are still being used aren't freed until their users are done
+            // with them, and the caller will usually have the plans it needs in its
+            // thread's cache anyway.
+            const unsigned long max_plans = 64;
+            typedef std::map<std::pair<long,bool>, std::shared_ptr<const fft_plan> > plan_map;
+            static std::mutex m;
+            static plan_map plans;
+
+            const std::pair<long,bool> key(n, inverse);
             {
-                buff = matrix_cast<std::complex<double> >(rowm(data,r));
-                fft1d_inplace(buff, do_backward_fft, cs);
-                set_rowm(data,r) = matrix_cast<std::complex<T> >(buff);
+                std::lock_guard<std::mutex> lock(m);
+                plan_map::iterator i = plans.find(key);
+                if (i != plans.end())
+                    return i->second;
             }
 
-            // Compute transform column by column
-            for(long c=0; c<data.nc(); ++c) 
+            // Make the plan without holding the lock so other threads aren't held up.
+            std::shared_ptr<const fft_plan> plan(new fft_plan(n, inverse));
+            std::lock_guard<std::mutex> lock(m);
+            if (plans.size() >= max_plans)
+                plans.clear();
+            // If another thread made the same plan in the meantime then use theirs.
+            return plans.insert(std::make_pair(key, plan)).first->second;
+        }
+
+        inline std::shared_ptr<const fft_plan> get_fft_plan (
+            long n,
+            bool inverse
+        )
+        /*!
+            requires
+                - n > 0
+            ensures
+                - returns a plan for FFTs of size n in the given direction.  
+                - This function is threadsafe and the returned plan may be used by many
+                  threads at once.
+                - Plans are cached since making one costs about as much as running it.
+                  Each thread keeps the last 8 plans it used in a cache that doesn't need
+                  any locking, so repeatedly transforming the same few sizes is cheap.
+                  Behind those is a mutex protected cache, shared by all threads, of up
+                  to 64 plans.  A plan uses about 16*n bytes, or up to about 150*n bytes
+                  if it uses Bluestein's algorithm.  So the caches only use a lot of
+                  memory if you transform very large sizes, and in any case they never
+                  hold more than 64 plans plus 8 per thread.
+        !*/
+        {
+            struct cache_entry
+            {
+                cache_entry() : n(0), inverse(false) {}
+                long n;
+                bool inverse;
+                std::shared_ptr<const fft_plan> plan;
+            };
+            const long cache_size = 8;
+            thread_local cache_entry cache[cache_size];
+            thread_local long next = 0;
+
+            for (long i = 0; i < cache_size; ++i)
             {
-                buff = matrix_cast<std::complex<double> >(colm(data,c));
-                fft1d_inplace(buff, do_backward_fft, cs);
-                set_colm(data,c) = matrix_cast<std::complex<T> >(buff);
+                if (cache[i].n == n && cache[i].inverse == inverse)
+                    return cache[i].plan;
             }
+
+            cache_entry& e = cache[next];
+            next = (next+1)%cache_size;
+            e.plan = get_shared_fft_plan(n, inverse);
+            e.n = n;
+            e.inverse = inverse;
+            return e.plan;
         }
-        
-    // ----------------------------------------------------------------------------------------
-
-        template <
-            typename EXP, 
-            typename T
-            >
-        void fft2d(
-            const matrix_exp<EXP>& data, 
-            matrix<std::complex<T> >& data_out,
-            bool do_backward_fft
+
+    // ------------------------------------------------------------------------------------
+
+        inline void fft2d (
+            const std::complex<double>* in,
+            std::complex<double>* out,
+            long nr,
+            long nc,
+            bool inverse,
+            std::vector<std::complex<double> >& temp
         )
+        /*!
+            requires
+                - in and out point to nr*nc element, row major, matrices.  They must
+                  either be the same matrix or not overlap at all.
+            ensures
+                - #out == the unscaled forward or inverse FFT of in.  If in is a row or
+                  column vector then this is a 1D FFT, otherwise it's a 2D FFT.
+                - temp is used as scratch space.
+        !*/
         {
-            // make sure requires clause is not broken
-            DLIB_CASSERT(is_power_of_two(data.nr()) && is_power_of_two(data.nc()),
-                "\t matrix fft(data)"
-                << "\n\t The number of rows and columns must be powers of two."
-                << "\n\t data.nr(): "<< data.nr()
-                << "\n\t data.nc(): "<< data.nc()
-                << "\n\t is_power_of_two(data.nr()): " << is_power_of_two(data.nr())
-                << "\n\t is_power_of_two(data.nc()): " << is_power_of_two(data.nc())
-            );
+            if (nr*nc == 0)
+                return;
 
-            if (data.size() == 0)
+            if (nr == 1 || nc == 1)
+            {
+                if (in == out)
+                {
+                    temp.assign(in, in+nr*nc);
+                    in = &temp[0];
+                }
+                get_fft_plan(nr*nc, inverse)->execute(in, out, 1);
                 return;
+            }
 
-            matrix<std::complex<double> > buff;
-            data_out.set_size(data.nr(), data.nc());
-            twiddles<double> cs;
+            // Transform each row and then all the columns at once.
+            temp.resize(nr*nc);
+            const std::shared_ptr<const fft_plan> row_plan = get_fft_plan(nc, inverse);
+            for (long r = 0; r < nr; ++r)
+                row_plan->execute(in + r*nc, &temp[r*nc], 1);
+            get_fft_plan(nr, inverse)->execute(&temp[0], out, nc);
+        }
 
-            // Compute transform row by row
-            for(long r=0; r<data.nr(); ++r) 
+    // ------------------------------------------------------------------------------------
+
+        inline void real_fft (
+            const double* in,
+            std::complex<double>* out,
+            const fft_plan& half_plan,
+            const fft_plan& full_plan,
+            std::vector<std::complex<double> >& temp
+        )
+        /*!
+            requires
+                - full_plan is a forward plan of some even size n and half_plan is a
+                  forward plan of size n/2.
+                - in points to n values and out to n/2+1 values.
+            ensures
+                - #out == the first n/2+1 values of the FFT of in.  The rest of the FFT
+                  follows from these since the FFT of a real signal is conjugate symmetric.
+        !*/
+        {
+            // Treat the even and odd samples as the real and imaginary parts of a complex
+            // signal of half the length, transform that, and then untangle the result.
+            const long half = half_plan.size();
+            temp.resize(half);
+            std::complex<double>* zf = &temp[0];
+            half_plan.execute(reinterpret_cast<const std::complex<double>*>(in), zf, 1);
+
+            for (long k = 0; k <= half; ++k)
             {
-                buff = matrix_cast<std::complex<double> >(rowm(data,r));
-                fft1d_inplace(buff, do_backward_fft, cs);
-                set_rowm(data_out,r) = matrix_cast<std::complex<T> >(buff);
+                const fft_complex a(zf[k == half ? 0 : k]);
+                const fft_complex b = fft_complex(zf[k == 0 ? 0 : half-k]).conj();
+                const fft_complex even = (a + b)*0.5;
+                // odd == (a-b)/(2i)
+                const fft_complex odd = ((a - b)*-0.5).times_i();
+                (even + fft_complex(full_plan.twiddle(k))*odd).store(out+k);
             }
+        }
 
-            // Compute transform column by column
-            for(long c=0; c<data_out.nc(); ++c) 
+        inline void real_ifft (
+            const std::complex<double>* in,
+            double* out,
+            const fft_plan& half_plan,
+            const fft_plan& full_plan,
+            std::vector<std::complex<double> >& temp
+        )
+        /*!
+            requires
+                - full_plan is an inverse plan of some even size n and half_plan is an
+                  inverse plan of size n/2.
+                - in points to n/2+1 values and out to n values.
+            ensures
+                - This is the inverse of real_fft(), including the scaling.  That is, it
+                  interprets in as the first half of the FFT of a real signal and writes
+                  that signal into out.
+        !*/
+        {
+            const long half = half_plan.size();
+            temp.resize(half);
+            std::complex<double>* zf = &temp[0];
+            for (long k = 0; k < half; ++k)
             {
-                buff = matrix_cast<std::complex<double> >(colm(data_out,c));
-                fft1d_inplace(buff, do_backward_fft, cs);
-                set_colm(data_out,c) = matrix_cast<std::complex<T> >(buff);
+                const fft_complex a(in[k]);
+                const fft_complex b = fft_complex(in[half-k]).conj();
+                const fft_complex even = a + b;
+                const fft_complex odd = (a - b)*fft_complex(full_plan.twiddle(k));
+                (even + odd.times_i()).store(zf+k);
             }
+            std::complex<double>* z = reinterpret_cast<std::complex<double>*>(out);
+            half_plan.execute(zf, z, 1);
+            const double scale = 0.5/half;
+            for (long j = 0; j < half; ++j)
+                (fft_complex(z[j])*scale).store(z+j);
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        template <long NR, long NC, typename MM>
+        void fft_inplace (
+            matrix<std::complex<double>,NR,NC,MM,row_major_layout>& data,
+            bool inverse
+        )
+        {
+            if (data.size() == 0)
+                return;
+            std::vector<std::complex<double> > temp;
+            fft2d(&data(0,0), &data(0,0), data.nr(), data.nc(), inverse, temp);
         }
-        
+
+        template <typename T, long NR, long NC, typename MM, typename L>
+        void fft_inplace (
+            matrix<std::complex<T>,NR,NC,MM,L>& data,
+            bool inverse
+        )
+        {
+            // Everything is computed in double precision so convert to that first.
+            matrix<std::complex<double> > temp(matrix_cast<std::complex<double> >(data));
+            fft_inplace(temp, inverse);
+            data = matrix_cast<std::complex<T> >(temp);
+        }
+
     // ------------------------------------------------------------------------------------
 
     } // end namespace impl
@@ -406,29 +763,9 @@ namespace dlib
     {
         // You have to give a complex matrix
         COMPILE_TIME_ASSERT(is_complex<typename EXP::type>::value);
-        // make sure requires clause is not broken
-        DLIB_CASSERT(is_power_of_two(data.nr()) && is_power_of_two(data.nc()),
-            "\t matrix fft(data)"
-            << "\n\t The number of rows and columns must be powers of two."
-            << "\n\t data.nr(): "<< data.nr()
-            << "\n\t data.nc(): "<< data.nc()
-            << "\n\t is_power_of_two(data.nr()): " << is_power_of_two(data.nr())
-            << "\n\t is_power_of_two(data.nc()): " << is_power_of_two(data.nc())
-            );
-
-        if (data.nr() == 1 || data.nc() == 1)
-        {
-            matrix<typename EXP::type> temp(data);
-            impl::twiddles<typename EXP::type::value_type> cs;
-            impl::fft1d_inplace(temp, false, cs);
-            return temp;
-        }
-        else
-        {
-            matrix<typename EXP::type> temp;
-            impl::fft2d(data, temp, false);
-            return temp;
-        }
+        matrix<typename EXP::type> temp(data);
+        impl::fft_inplace(temp, false);
+        return temp;
     }
 
     template <typename EXP>
@@ -436,31 +773,10 @@ namespace dlib
     {
         // You have to give a complex matrix
         COMPILE_TIME_ASSERT(is_complex<typename EXP::type>::value);
-        // make sure requires clause is not broken
-        DLIB_CASSERT(is_power_of_two(data.nr()) && is_power_of_two(data.nc()),
-            "\t matrix ifft(data)"
-            << "\n\t The number of rows and columns must be powers of two."
-            << "\n\t data.nr(): "<< data.nr()
-            << "\n\t data.nc(): "<< data.nc()
-            << "\n\t is_power_of_two(data.nr()): " << is_power_of_two(data.nr())
-            << "\n\t is_power_of_two(data.nc()): " << is_power_of_two(data.nc())
-            );
-
-        matrix<typename EXP::type> temp;
-        if (data.size() == 0)
-            return temp;
-
-        if (data.nr() == 1 || data.nc() == 1)
-        {
-            temp = data;
-            impl::twiddles<typename EXP::type::value_type> cs;
-            impl::fft1d_inplace(temp, true, cs);
-        }
-        else
-        {
-            impl::fft2d(data, temp, true);
-        }
-        temp /= data.size();
+        matrix<typename EXP::type> temp(data);
+        impl::fft_inplace(temp, true);
+        if (data.size() != 0)
+            temp /= data.size();
         return temp;
     }
 
@@ -470,49 +786,111 @@ namespace dlib
     void fft_inplace (matrix<std::complex<T>,NR,NC,MM,L>& data)
     // Note that we don't divide the outputs by data.size() so this isn't quite the inverse.
     {
+        impl::fft_inplace(data, false);
+    }
+
+    template < typename T, long NR, long NC, typename MM, typename L >
+    void ifft_inplace (matrix<std::complex<T>,NR,NC,MM,L>& data)
+    {
+        impl::fft_inplace(data, true);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename EXP>
+    matrix<std::complex<typename EXP::type> > fftr (const matrix_exp<EXP>& data)
+    {
+        typedef typename EXP::type T;
+        // You have to give a real matrix
+        COMPILE_TIME_ASSERT(is_complex<T>::value == false);
+        const bool is_col = data.nc() == 1 && data.nr() > 1;
+        const long len = is_col ? data.nr() : data.nc();
         // make sure requires clause is not broken
-        DLIB_CASSERT(is_power_of_two(data.nr()) && is_power_of_two(data.nc()),
-            "\t void fft_inplace(data)"
-            << "\n\t The number of rows and columns must be powers of two."
+        DLIB_CASSERT(len%2 == 0,
+            "\t matrix fftr(data)"
+            << "\n\t The length of the dimension being transformed must be even."
             << "\n\t data.nr(): "<< data.nr()
             << "\n\t data.nc(): "<< data.nc()
-            << "\n\t is_power_of_two(data.nr()): " << is_power_of_two(data.nr())
-            << "\n\t is_power_of_two(data.nc()): " << is_power_of_two(data.nc())
             );
 
-        if (data.nr() == 1 || data.nc() == 1)
+        const long nr = is_col ? 1 : data.nr();
+        const long out_nc = len/2+1;
+        matrix<std::complex<T> > result;
+        if (data.size() == 0)
         {
-            impl::twiddles<T> cs;
-            impl::fft1d_inplace(data, false, cs);
+            result.set_size(data.nr(), data.nc() == 0 ? 0 : out_nc);
+            return result;
         }
+
+        const matrix<double> in = matrix_cast<double>(data);
+        matrix<std::complex<double> > rows(nr, out_nc), out(nr, out_nc);
+        std::vector<std::complex<double> > temp;
+        const std::shared_ptr<const impl::fft_plan> half_plan = impl::get_fft_plan(len/2, false);
+        const std::shared_ptr<const impl::fft_plan> full_plan = impl::get_fft_plan(len, false);
+        for (long r = 0; r < nr; ++r)
+            impl::real_fft(&in(0,0) + r*len, &rows(r,0), *half_plan, *full_plan, temp);
+        if (nr > 1)
+            impl::get_fft_plan(nr, false)->execute(&rows(0,0), &out(0,0), out_nc);
         else
-        {
-            impl::fft2d_inplace(data, false);
-        }
+            out.swap(rows);
+
+        if (is_col)
+            return matrix_cast<std::complex<T> >(trans(out));
+        else
+            return matrix_cast<std::complex<T> >(out);
     }
 
-    template < typename T, long NR, long NC, typename MM, typename L >
-    void ifft_inplace (matrix<std::complex<T>,NR,NC,MM,L>& data)
+    template <typename EXP>
+    matrix<typename EXP::type::value_type> ifftr (const matrix_exp<EXP>& data)
     {
+        typedef typename EXP::type::value_type T;
+        // You have to give a complex matrix
+        COMPILE_TIME_ASSERT(is_complex<typename EXP::type>::value);
+        const bool is_col = data.nc() == 1 && data.nr() > 1;
+        const long len = is_col ? data.nr() : data.nc();
         // make sure requires clause is not broken
-        DLIB_CASSERT(is_power_of_two(data.nr()) && is_power_of_two(data.nc()),
-            "\t void ifft_inplace(data)"
-            << "\n\t The number of rows and columns must be powers of two."
+        DLIB_CASSERT(len >= 2 || data.size() == 0,
+            "\t matrix ifftr(data)"
+            << "\n\t The dimension being transformed must have at least 2 elements."
             << "\n\t data.nr(): "<< data.nr()
             << "\n\t data.nc(): "<< data.nc()
-            << "\n\t is_power_of_two(data.nr()): " << is_power_of_two(data.nr())
-            << "\n\t is_power_of_two(data.nc()): " << is_power_of_two(data.nc())
             );
 
-        if (data.nr() == 1 || data.nc() == 1)
+        matrix<T> result;
+        if (data.size() == 0)
         {
-            impl::twiddles<T> cs;
-            impl::fft1d_inplace(data, true, cs);
+            result.set_size(data.nr(), 0);
+            return result;
+        }
+
+        const long nr = is_col ? 1 : data.nr();
+        const long out_len = 2*(len-1);
+        matrix<std::complex<double> > in(nr, len), cols(nr, len);
+        if (is_col)
+            in = matrix_cast<std::complex<double> >(trans(data));
+        else
+            in = matrix_cast<std::complex<double> >(data);
+        if (nr > 1)
+        {
+            impl::get_fft_plan(nr, true)->execute(&in(0,0), &cols(0,0), len);
+            cols /= nr;
         }
         else
         {
-            impl::fft2d_inplace(data, true);
+            cols.swap(in);
         }
+
+        matrix<double> out(nr, out_len);
+        std::vector<std::complex<double> > temp;
+        const std::shared_ptr<const impl::fft_plan> half_plan = impl::get_fft_plan(out_len/2, true);
+        const std::shared_ptr<const impl::fft_plan> full_plan = impl::get_fft_plan(out_len, true);
+        for (long r = 0; r < nr; ++r)
+            impl::real_ifft(&cols(r,0), &out(r,0), *half_plan, *full_plan, temp);
+
+        if (is_col)
+            return matrix_cast<T>(trans(out));
+        else
+            return matrix_cast<T>(out);
     }
 
 // ----------------------------------------------------------------------------------------
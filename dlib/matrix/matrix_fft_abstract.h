@@ -29,8 +29,6 @@ namespace dlib
     /*!
         requires
             - data contains elements of type std::complex<>
-            - is_power_of_two(data.nr()) == true
-            - is_power_of_two(data.nc()) == true
         ensures
             - Computes the 1 or 2 dimensional discrete Fourier transform of the given data
               matrix and returns it.  In particular, we return a matrix D such that:
@@ -40,6 +38,15 @@ namespace dlib
                 - starting with D(0,0), D contains progressively higher frequency components
                   of the input data.
                 - ifft(D) == D
+            - Any size of matrix is allowed and the runtime is always O(N*log(N)), where
+              N == data.size().  However, the FFT is fastest when data.nr() and data.nc()
+              are products of small primes, especially 2, 3, and 5.  Sizes with a prime
+              factor bigger than 13 use Bluestein's algorithm, which is several times
+              slower than a nearby size with only small factors.
+            - The twiddle factors and other precomputed tables for each size are cached.
+              The cache holds the tables for at most 64 sizes, plus the last 8 sizes
+              used by each thread, so it only uses a lot of memory if you transform very
+              large matrices.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -51,8 +58,6 @@ namespace dlib
     /*!
         requires
             - data contains elements of type std::complex<>
-            - is_power_of_two(data.nr()) == true
-            - is_power_of_two(data.nc()) == true
         ensures
             - Computes the 1 or 2 dimensional inverse discrete Fourier transform of the
               given data vector and returns it.  In particular, we return a matrix D such
@@ -77,8 +82,6 @@ namespace dlib
     /*!
         requires
             - data contains elements of type std::complex<>
-            - is_power_of_two(data.nr()) == true
-            - is_power_of_two(data.nc()) == true
         ensures
             - This function is identical to fft() except that it does the FFT in-place.
               That is, after this function executes we will have:
@@ -100,8 +103,6 @@ namespace dlib
     /*!
         requires
             - data contains elements of type std::complex<>
-            - is_power_of_two(data.nr()) == true
-            - is_power_of_two(data.nc()) == true
         ensures
             - This function is identical to ifft() except that it does the inverse FFT
               in-place.  That is, after this function executes we will have:
@@ -110,6 +111,60 @@ namespace dlib
                   inverse transformation.  
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename EXP>
+    matrix<std::complex<typename EXP::type> > fftr (
+        const matrix_exp<EXP>& data
+    );
+    /*!
+        requires
+            - data contains real numbers (i.e. float, double, or long double)
+            - if (data is a column vector with more than one row) then
+                - data.nr() is even
+            - else
+                - data.nc() is even
+        ensures
+            - Computes the discrete Fourier transform of real valued data.  Since the
+              transform of a real signal is conjugate symmetric we only compute and return
+              the non-redundant half of it.  This takes about half the time and memory of
+              fft(matrix_cast<std::complex<T> >(data)).
+            - if (data is a column vector with more than one row) then
+                - returns a data.nr()/2+1 by 1 column vector D such that D == 
+                  rowm(fft(matrix_cast<std::complex<T> >(data)), range(0,data.nr()/2))
+            - else
+                - returns a data.nr() by data.nc()/2+1 matrix D such that D == 
+                  colm(fft(matrix_cast<std::complex<T> >(data)), range(0,data.nc()/2))
+                  (i.e. the half of the 1D or 2D FFT with non-negative column frequencies)
+            - ifftr(D) == data
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename EXP>
+    matrix<typename EXP::type::value_type> ifftr (
+        const matrix_exp<EXP>& data
+    );
+    /*!
+        requires
+            - data contains elements of type std::complex<>
+            - if (data is a column vector with more than one row) then
+                - data.nr() >= 2
+            - else
+                - data.nc() >= 2 or data.size() == 0
+        ensures
+            - This is the inverse of fftr().  It interprets data as the output of fftr()
+              for some real valued matrix and returns that real matrix.  In particular:
+                - if (data is a column vector with more than one row) then
+                    - returns a 2*(data.nr()-1) by 1 column vector
+                - else
+                    - returns a data.nr() by 2*(data.nc()-1) matrix
+                - ifftr(fftr(M)) == M, for any M with an even number of columns (or rows if
+                  M is a column vector).
+            - Like ifft(), the output is normalized.  That is, it is divided by the number
+              of elements in the returned matrix.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -80,6 +80,82 @@ namespace
                 DLIB_TEST(rect_confidence >= 0.97);
                 print_spinner();
             }
+
+            test_multi_correlation_tracker(frames, sizeof(frames)/sizeof(frames[0]));
+        }
+
+        template <typename frame_fn_type>
+        void test_multi_correlation_tracker (
+            const frame_fn_type* frames,
+            const unsigned long num_frames
+        )
+        {
+            // A multi_correlation_tracker should give exactly the same results as a set of
+            // individual correlation_trackers, no matter how many threads it uses.
+            std::vector<drectangle> rects;
+            rects.push_back(centered_rect(point(93, 110), 38, 86));
+            rects.push_back(centered_rect(point(60, 60), 40, 40));
+            rects.push_back(centered_rect(point(150, 90), 50, 30));
+            rects.push_back(centered_rect(point(120, 140), 30, 60));
+
+            array2d<unsigned char> img;
+            std::istringstream sin(frames[0]());
+            load_bmp(img, sin);
+
+            std::vector<correlation_tracker> trackers(rects.size(), correlation_tracker(5));
+            for (unsigned long i = 0; i < trackers.size(); ++i)
+                trackers[i].start_track(img, rects[i]);
+
+            multi_correlation_tracker mt1(correlation_tracker(5)), mt3(correlation_tracker(5));
+            mt3.set_num_threads(3);
+            DLIB_TEST(mt3.get_num_threads() == 3);
+            DLIB_TEST(mt1.get_prototype_tracker().get_filter_size() == 32);
+            DLIB_TEST(mt1.start_track(img, rects[0]) == 0);
+            mt1.start_tracks(img, std::vector<drectangle>(rects.begin()+1, rects.end()));
+            mt3.start_tracks(img, rects);
+            DLIB_TEST(mt1.size() == rects.size());
+            DLIB_TEST(mt3.size() == rects.size());
+            for (unsigned long i = 0; i < rects.size(); ++i)
+            {
+                DLIB_TEST(mt1.get_position(i) == rects[i]);
+                DLIB_TEST(mt3.get_position(i) == rects[i]);
+            }
+
+            for (unsigned long f = 1; f < num_frames; ++f)
+            {
+                print_spinner();
+                std::istringstream sin(frames[f]());
+                load_bmp(img, sin);
+
+                std::vector<double> psr1, psr3;
+                if (f == 2)
+                {
+                    psr1 = mt1.update_noscale(img);
+                    psr3 = mt3.update_noscale(img, mt3.get_positions());
+                }
+                else
+                {
+                    psr1 = mt1.update(img);
+                    psr3 = mt3.update(img, mt3.get_positions());
+                }
+                DLIB_TEST(psr1.size() == trackers.size());
+                DLIB_TEST(psr3.size() == trackers.size());
+                for (unsigned long i = 0; i < trackers.size(); ++i)
+                {
+                    const double psr = (f == 2) ? trackers[i].update_noscale(img) : trackers[i].update(img);
+                    DLIB_TEST(psr1[i] == psr);
+                    DLIB_TEST(psr3[i] == psr);
+                    DLIB_TEST(mt1.get_position(i) == trackers[i].get_position());
+                    DLIB_TEST(mt3[i].get_position() == trackers[i].get_position());
+                }
+            }
+
+            mt3.stop_track(1);
+            DLIB_TEST(mt3.size() == rects.size()-1);
+            DLIB_TEST(mt3.get_position(1) == mt1.get_position(2));
+            mt3.clear();
+            DLIB_TEST(mt3.size() == 0);
+            DLIB_TEST(mt3.update(img).size() == 0);
         }
 
     // ------------------------------------------------------------------------------------
@@ -5,9 +5,13 @@
 #include <dlib/svm_threaded.h>
 #include <dlib/data_io.h>
 #include <dlib/sparse_vector.h>
+#include <dlib/image_io.h>
+#include <dlib/rand.h>
 #include "create_iris_datafile.h"
 #include <vector>
 #include <sstream>
+#include <fstream>
+#include <locale>
 
 namespace  
 {
@@ -16,6 +20,12 @@ namespace
     using namespace std;
     dlib::logger dlog("test.data_io");
 
+    // A numpunct facet for locales that write 0.5 as 0,5
+    struct comma_decimal_point : std::numpunct<char>
+    {
+        char do_decimal_point() const { return ','; }
+    };
+
 
     class test_data_io : public tester
     {
@@ -205,6 +215,424 @@ namespace
         }
 
 
+        void test_parallel_image_dataset_loading (
+        )
+        {
+            print_spinner();
+            dlib::rand rnd;
+            image_dataset_metadata::dataset data;
+            for (int i = 0; i < 9; ++i)
+            {
+                matrix<unsigned char> img(40+i*7, 50+i*3);
+                for (long r = 0; r < img.nr(); ++r)
+                    for (long c = 0; c < img.nc(); ++c)
+                        img(r,c) = rnd.get_random_8bit_number();
+                image_dataset_metadata::image info("test_dataset_" + cast_to_string(i) + ".bmp");
+                save_bmp(img, info.filename);
+                image_dataset_metadata::box b(rectangle(5,5,5+20+i,5+25));
+                b.parts["nose"] = point(10,12);
+                info.boxes.push_back(b);
+                if (i%3 == 0)
+                {
+                    b.ignore = true;
+                    info.boxes.push_back(b);
+                }
+                data.images.push_back(info);
+            }
+            save_image_dataset_metadata(data, "test_dataset.xml");
+
+            const image_dataset_file serial = image_dataset_file("test_dataset.xml").shrink_big_images(10*10);
+            const image_dataset_file parallel = serial.load_in_parallel(3);
+            DLIB_TEST(serial.get_num_threads() == 1);
+            DLIB_TEST(parallel.get_num_threads() == 3);
+
+            // The threaded loaders must give exactly what the serial ones give.
+            std::vector<matrix<unsigned char> > images1, images2;
+            std::vector<std::vector<rectangle> > rects1, rects2;
+            DLIB_TEST(load_image_dataset(images1, rects1, serial) == load_image_dataset(images2, rects2, parallel));
+            DLIB_TEST(images1.size() == 9 && images1 == images2);
+            DLIB_TEST(rects1 == rects2);
+
+            dlib::array<array2d<unsigned char> > arrays1, arrays2;
+            std::vector<std::vector<mmod_rect> > mmod1, mmod2;
+            load_image_dataset(arrays1, mmod1, serial);
+            load_image_dataset(arrays2, mmod2, parallel);
+            DLIB_TEST(arrays1.size() == 9 && arrays2.size() == 9);
+            for (unsigned long i = 0; i < arrays1.size(); ++i)
+            {
+                DLIB_TEST(mat(arrays1[i]) == mat(images1[i]));
+                DLIB_TEST(mat(arrays2[i]) == mat(images1[i]));
+                DLIB_TEST(mmod1[i].size() == mmod2[i].size());
+                for (unsigned long j = 0; j < mmod1[i].size(); ++j)
+                    DLIB_TEST(mmod1[i][j].rect == mmod2[i][j].rect && mmod1[i][j].ignore == mmod2[i][j].ignore);
+            }
+
+            std::vector<std::vector<full_object_detection> > dets1, dets2;
+            std::vector<std::string> parts1, parts2;
+            DLIB_TEST(load_image_dataset(images1, dets1, serial, parts1) == load_image_dataset(images2, dets2, parallel, parts2));
+            DLIB_TEST(images1 == images2);
+            DLIB_TEST(parts1 == parts2 && parts1.size() == 1);
+            for (unsigned long i = 0; i < dets1.size(); ++i)
+            {
+                DLIB_TEST(dets1[i].size() == 1 && dets2[i].size() == 1);
+                DLIB_TEST(dets1[i][0].get_rect() == dets2[i][0].get_rect());
+                DLIB_TEST(dets1[i][0].part(0) == dets2[i][0].part(0));
+            }
+        }
+
+        void test_image_dataset_cache (
+        )
+        {
+            print_spinner();
+            dlib::rand rnd;
+            image_dataset_metadata::dataset data;
+            for (int i = 0; i < 8; ++i)
+            {
+                matrix<unsigned char> img(60+i*5, 70+i*4);
+                for (long r = 0; r < img.nr(); ++r)
+                    for (long c = 0; c < img.nc(); ++c)
+                        img(r,c) = rnd.get_random_8bit_number();
+                image_dataset_metadata::image info("test_cache_" + cast_to_string(i) + ".bmp");
+                save_bmp(img, info.filename);
+                // Image 5 has no boxes and image 6 only has boxes with the wrong label.
+                if (i != 5)
+                {
+                    image_dataset_metadata::box b(rectangle(3,4,3+20+2*i,4+30));
+                    b.label = (i == 6) ? "b" : "a";
+                    b.parts["nose"] = point(10,12);
+                    info.boxes.push_back(b);
+                    if (i%3 == 0)
+                    {
+                        b.ignore = true;
+                        b.rect = translate_rect(b.rect, point(5,7));
+                        info.boxes.push_back(b);
+                    }
+                }
+                data.images.push_back(info);
+            }
+            save_image_dataset_metadata(data, "test_cache.xml");
+            create_image_dataset_cache<unsigned char>("test_cache.xml", "test_cache.dat");
+
+            image_dataset_cache cache("test_cache.dat");
+            DLIB_TEST(cache.size() == data.images.size());
+            DLIB_TEST(!cache.is_color());
+            DLIB_TEST(cache.get_filename() == "test_cache.dat");
+
+            std::vector<matrix<unsigned char> > originals(data.images.size());
+            matrix<unsigned char> cached;
+            matrix<rgb_pixel> rgb;
+            for (long i = cache.size()-1; i >= 0; --i)
+            {
+                load_image(originals[i], data.images[i].filename);
+                cache.get_image(i, cached);
+                DLIB_TEST(originals[i] == cached);
+                cache.get_image(i, rgb);
+                DLIB_TEST(rgb.nr() == cached.nr() && rgb.nc() == cached.nc());
+                DLIB_TEST(rgb(3,4).red == cached(3,4) && rgb(3,4).blue == cached(3,4));
+
+                const image_dataset_metadata::image& meta = cache.get_metadata().images[i];
+                DLIB_TEST(meta.filename == data.images[i].filename);
+                DLIB_TEST(meta.boxes.size() == data.images[i].boxes.size());
+                for (unsigned long j = 0; j < meta.boxes.size(); ++j)
+                {
+                    DLIB_TEST(meta.boxes[j].rect == data.images[i].boxes[j].rect);
+                    DLIB_TEST(meta.boxes[j].label == data.images[i].boxes[j].label);
+                    DLIB_TEST(meta.boxes[j].parts == data.images[i].boxes[j].parts);
+                    DLIB_TEST(meta.boxes[j].ignore == data.images[i].boxes[j].ignore);
+                }
+            }
+
+            // Many threads reading from the cache at once must all get the right pixels.
+            std::vector<matrix<unsigned char> > threaded(4*cache.size());
+            parallel_for(4, 0, threaded.size(), [&](long k) { cache.get_image(k%cache.size(), threaded[k]); });
+            for (unsigned long k = 0; k < threaded.size(); ++k)
+                DLIB_TEST(threaded[k] == originals[k%cache.size()]);
+
+            // Loading from the cache must apply the image_dataset_file options exactly the
+            // way loading from the XML file does.
+            std::vector<image_dataset_file> sources;
+            sources.push_back(image_dataset_file("test_cache.xml"));
+            sources.push_back(sources[0].skip_empty_images());
+            sources.push_back(sources[0].boxes_match_label("a").skip_empty_images());
+            sources.push_back(sources[0].boxes_match_label("a").shrink_big_images(12*12));
+            sources.push_back(sources[3].load_in_parallel(3));
+            for (unsigned long s = 0; s < sources.size(); ++s)
+            {
+                std::vector<matrix<unsigned char> > images1, images2;
+                std::vector<std::vector<mmod_rect> > rects1, rects2;
+                load_image_dataset(images1, rects1, sources[s]);
+                load_image_dataset(images2, rects2, cache, sources[s]);
+                DLIB_TEST(images1.size() == images2.size());
+                DLIB_TEST(images1 == images2);
+                DLIB_TEST(rects1.size() == rects2.size());
+                for (unsigned long i = 0; i < rects1.size(); ++i)
+                {
+                    DLIB_TEST(rects1[i].size() == rects2[i].size());
+                    for (unsigned long j = 0; j < rects1[i].size(); ++j)
+                        DLIB_TEST(rects1[i][j].rect == rects2[i][j].rect && rects1[i][j].ignore == rects2[i][j].ignore);
+                }
+
+                std::vector<std::vector<rectangle> > boxes1, boxes2, ignored1, ignored2;
+                ignored1 = load_image_dataset(images1, boxes1, sources[s]);
+                ignored2 = load_image_dataset(images2, boxes2, cache, sources[s]);
+                DLIB_TEST(images1 == images2);
+                DLIB_TEST(boxes1 == boxes2);
+                DLIB_TEST(ignored1 == ignored2);
+
+                std::vector<std::vector<full_object_detection> > dets1, dets2;
+                std::vector<std::string> parts1, parts2;
+                ignored1 = load_image_dataset(images1, dets1, sources[s], parts1);
+                ignored2 = load_image_dataset(images2, dets2, cache, sources[s], parts2);
+                DLIB_TEST(images1 == images2);
+                DLIB_TEST(ignored1 == ignored2);
+                DLIB_TEST(parts1 == parts2 && parts2.size() == 1 && parts2[0] == "nose");
+                DLIB_TEST(dets1.size() == dets2.size());
+                for (unsigned long i = 0; i < dets1.size(); ++i)
+                {
+                    DLIB_TEST(dets1[i].size() == dets2[i].size());
+                    for (unsigned long j = 0; j < dets1[i].size(); ++j)
+                    {
+                        DLIB_TEST(dets1[i][j].get_rect() == dets2[i][j].get_rect());
+                        DLIB_TEST(dets2[i][j].num_parts() == 1 && dets1[i][j].part(0) == dets2[i][j].part(0));
+                    }
+                }
+
+                if (s == 0)
+                {
+                    // The options free overloads load everything.
+                    load_image_dataset(images2, rects2, cache);
+                    DLIB_TEST(images2.size() == cache.size() && images1 == images2);
+                    DLIB_TEST(load_image_dataset(images2, boxes2, cache) == ignored1);
+                    DLIB_TEST(boxes1 == boxes2);
+                    DLIB_TEST(load_image_dataset(images2, dets2, cache) == ignored1);
+                    DLIB_TEST(dets2.size() == cache.size() && images1 == images2);
+                }
+                if (s == 1)
+                    DLIB_TEST(images2.size() == cache.size()-1);
+                if (s == 2)
+                    DLIB_TEST(images2.size() == cache.size()-2);
+                if (s == 3)
+                    DLIB_TEST(images2.size() == cache.size() && images2[0].size() < originals[0].size());
+            }
+
+            bool threw = false;
+            try { image_dataset_cache bad("test_cache.xml"); }
+            catch (serialization_error&) { threw = true; }
+            DLIB_TEST(threw);
+
+            // Truncated or damaged cache files must be rejected when they are opened.
+            const std::string contents = read_text_file("test_cache.dat");
+            const unsigned long truncated_sizes[] = {40, contents.size()/2, contents.size()-3};
+            for (auto size : truncated_sizes)
+            {
+                write_text_file("test_cache_bad.dat", contents.substr(0, size));
+                threw = false;
+                try { image_dataset_cache bad("test_cache_bad.dat"); }
+                catch (serialization_error&) { threw = true; }
+                DLIB_TEST(threw);
+            }
+            std::string bad_offset = contents;
+            bad_offset[bad_offset.size()-3] = 0x7f;
+            write_text_file("test_cache_bad.dat", bad_offset);
+            threw = false;
+            try { image_dataset_cache bad("test_cache_bad.dat"); }
+            catch (serialization_error&) { threw = true; }
+            DLIB_TEST(threw);
+        }
+
+        void write_text_file (
+            const std::string& filename,
+            const std::string& contents
+        )
+        {
+            std::ofstream fout(filename.c_str(), std::ios::binary);
+            fout << contents;
+        }
+
+        std::string read_text_file (
+            const std::string& filename
+        )
+        {
+            std::ifstream fin(filename.c_str(), std::ios::binary);
+            std::ostringstream sout;
+            sout << fin.rdbuf();
+            return sout.str();
+        }
+
+        std::string dataset_load_error (
+            const std::string& contents
+        )
+        {
+            write_text_file("test_metadata_bad.xml", contents);
+            try
+            {
+                image_dataset_metadata::dataset data;
+                load_image_dataset_metadata(data, "test_metadata_bad.xml");
+            }
+            catch (dlib::error& e)
+            {
+                return e.what();
+            }
+            return "";
+        }
+
+        void test_dataset_metadata_io (
+        )
+        {
+            print_spinner();
+            using namespace image_dataset_metadata;
+
+            dataset data;
+            data.name = "some name";
+            data.comment = "some comment";
+            for (int i = 0; i < 20; ++i)
+            {
+                image img("img" + cast_to_string(i) + ".jpg");
+                for (int j = 0; j < i%4; ++j)
+                {
+                    box b(rectangle(i, j, i+10+j, 2*i+5));
+                    b.difficult = (j == 0);
+                    b.truncated = (i%2 == 0);
+                    b.occluded = (j == 2);
+                    b.ignore = (i%5 == 0);
+                    b.angle = 0.25*j;
+                    b.pose = i;
+                    b.detection_score = -1.5*j;
+                    if (j == 1)
+                        b.label = "lab" + cast_to_string(i);
+                    if (i%3 == 0)
+                    {
+                        b.parts["left eye"] = point(i, j);
+                        b.parts["nose"] = point(-i, 7);
+                    }
+                    img.boxes.push_back(b);
+                }
+                data.images.push_back(img);
+            }
+            save_image_dataset_metadata(data, "test_metadata.xml");
+
+            // The streaming writer must produce the same file.
+            {
+                dataset_writer writer("test_metadata2.xml", data.name, data.comment);
+                for (unsigned long i = 0; i < data.images.size(); ++i)
+                    writer.write(data.images[i]);
+            }
+            DLIB_TEST(read_text_file("test_metadata.xml") == read_text_file("test_metadata2.xml"));
+
+            // The files must be written and read the same way whatever the global locale
+            // is.
+            {
+                const std::locale old = std::locale::global(std::locale(std::locale::classic(), new comma_decimal_point));
+                dataset data3;
+                try
+                {
+                    save_image_dataset_metadata(data, "test_metadata_locale.xml");
+                    load_image_dataset_metadata(data3, "test_metadata.xml");
+                }
+                catch (...)
+                {
+                    std::locale::global(old);
+                    throw;
+                }
+                std::locale::global(old);
+                DLIB_TEST(read_text_file("test_metadata.xml") == read_text_file("test_metadata_locale.xml"));
+                DLIB_TEST(data3.images.size() == data.images.size());
+                for (unsigned long i = 0; i < data.images.size(); ++i)
+                {
+                    for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
+                    {
+                        const box& a = data.images[i].boxes[j];
+                        const box& b = data3.images[i].boxes[j];
+                        DLIB_TEST(a.angle == b.angle && a.pose == b.pose && a.detection_score == b.detection_score);
+                    }
+                }
+            }
+
+            dataset data2;
+            load_image_dataset_metadata(data2, "test_metadata.xml");
+            DLIB_TEST(data2.name == data.name);
+            DLIB_TEST(data2.comment == data.comment);
+            DLIB_TEST(data2.images.size() == data.images.size());
+            for (unsigned long i = 0; i < data.images.size(); ++i)
+            {
+                DLIB_TEST(data2.images[i].filename == data.images[i].filename);
+                DLIB_TEST(data2.images[i].boxes.size() == data.images[i].boxes.size());
+                for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
+                {
+                    const box& a = data.images[i].boxes[j];
+                    const box& b = data2.images[i].boxes[j];
+                    DLIB_TEST(a.rect == b.rect);
+                    DLIB_TEST(a.parts == b.parts);
+                    DLIB_TEST(a.label == b.label);
+                    DLIB_TEST(a.difficult == b.difficult && a.truncated == b.truncated);
+                    DLIB_TEST(a.occluded == b.occluded && a.ignore == b.ignore);
+                    DLIB_TEST(a.angle == b.angle && a.pose == b.pose && a.detection_score == b.detection_score);
+                }
+            }
+
+            // Read the images one at a time.
+            dataset_reader reader("test_metadata.xml");
+            image img;
+            unsigned long count = 0;
+            while (reader.read(img))
+            {
+                DLIB_TEST(img.filename == data.images[count].filename);
+                DLIB_TEST(img.boxes.size() == data.images[count].boxes.size());
+                DLIB_TEST(reader.get_name() == data.name);
+                ++count;
+            }
+            DLIB_TEST(count == data.images.size());
+            DLIB_TEST(!reader.read(img));
+
+            // Hand written XML using features save_image_dataset_metadata() doesn't.
+            write_text_file("test_metadata_misc.xml",
+                "<?xml version='1.0'?>\r\n"
+                "<!DOCTYPE dataset [ <!ELEMENT dataset ANY> ]>\n"
+                "<!-- a comment with <tags> -- and dashes --->\n"
+                "<dataset><name> a &lt;b&gt; &amp; &#65;&#x42; </name>\n"
+                "<comment><![CDATA[x < y & z]]></comment>\n"
+                "<unknown a=\"1\"><images/></unknown>\n"
+                "<images>\n"
+                "  <image file=\"a &quot;b&quot; &apos;c&apos;.jpg\" extra='x'/>\n"
+                "  <image file='b.jpg'><box top='1' left=\"2\" width='0x10' height='4' ignore='TRUE'>\n"
+                "    <label>  car  </label><part x='1' y='2' name='p'></part><!-- <box/> -->\n"
+                "  </box >\n"
+                "  </image>\n"
+                "</images>\n"
+                "</dataset>\n");
+            load_image_dataset_metadata(data2, "test_metadata_misc.xml");
+            DLIB_TEST_MSG(data2.name == "a <b> & AB", data2.name);
+            DLIB_TEST(data2.comment == "x < y & z");
+            DLIB_TEST(data2.images.size() == 2);
+            DLIB_TEST(data2.images[0].filename == "a \"b\" 'c'.jpg");
+            DLIB_TEST(data2.images[0].boxes.size() == 0);
+            DLIB_TEST(data2.images[1].filename == "b.jpg");
+            DLIB_TEST(data2.images[1].boxes.size() == 1);
+            DLIB_TEST(data2.images[1].boxes[0].rect == rectangle(2,1,17,4));
+            DLIB_TEST(data2.images[1].boxes[0].ignore);
+            DLIB_TEST(data2.images[1].boxes[0].label == "car");
+            DLIB_TEST(data2.images[1].boxes[0].parts["p"] == point(1,2));
+
+            string err;
+            err = dataset_load_error("<images></images>");
+            DLIB_TEST_MSG(err == "Error on line 1: Invalid XML document.  Root tag must be <dataset>.  Found <images> instead.", err);
+            err = dataset_load_error("<dataset>\n<images>\n<image file='a'>\n<box top='1' left='2' height='3'/>");
+            DLIB_TEST_MSG(err == "Error on line 4: <box> missing required attribute 'width'", err);
+            err = dataset_load_error("<dataset>\n<images><image file='a'><box top='1' left='2' width='x' height='3'/>");
+            DLIB_TEST_MSG(err == "Error on line 2: string cast error: invalid string = 'x'", err);
+            err = dataset_load_error("<dataset><images><image file='a'><box top='1' left='2' width='1' height='3'>"
+                                     "<part x='1' y='2' name='a'/><part x='1' y='2' name='a'/>");
+            DLIB_TEST_MSG(err == "Error on line 1: <part> with name 'a' is defined more than one time in a single box.", err);
+            err = dataset_load_error("<dataset>\n<images>\n</image>");
+            DLIB_TEST_MSG(err == "There is a fatal error on line 3 so parsing will now halt.", err);
+            err = dataset_load_error("<dataset>\n<images>\n");
+            DLIB_TEST_MSG(err == "There is a fatal error on line 3 so parsing will now halt.", err);
+            err = dataset_load_error("<dataset><name>&bogus;</name></dataset>");
+            DLIB_TEST(err == "There is a fatal error on line 1 so parsing will now halt.");
+            err = dataset_load_error("<dataset><images></images></dataset>");
+            DLIB_TEST(err == "");
+        }
+
         void perform_test (
         )
         {
@@ -212,6 +640,9 @@ namespace
             create_iris_datafile();
 
             test_sparse_to_dense();
+            test_parallel_image_dataset_loading();
+            test_image_dataset_cache();
+            test_dataset_metadata_io();
 
             run_test<std::map<unsigned int, double> >();
             run_test<std::map<unsigned int, float> >();
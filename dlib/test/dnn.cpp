@@ -1700,6 +1700,183 @@ namespace
         error = memcmp(g3.host(), b3g.host(), b3g.size());
         DLIB_TEST(error == 0);
     }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_cascaded_detection()
+    {
+        print_spinner();
+
+        using gate_type = loss_mmod<con<1,3,3,1,1,con<2,3,3,2,2,input_rgb_image_pyramid<pyramid_down<2>>>>>;
+        using net_type  = loss_mmod<con<1,3,3,1,1,relu<con<4,3,3,1,1,con<4,3,3,2,2,input_rgb_image_pyramid<pyramid_down<2>>>>>>>;
+
+        mmod_options options;
+        options.detector_width = 12;
+        options.detector_height = 12;
+        gate_type gate(options);
+        net_type net(options);
+
+        dlib::rand rnd;
+        std::vector<matrix<rgb_pixel>> images(9);
+        for (auto&& img : images)
+        {
+            img.set_size(40,50);
+            for (auto&& p : img)
+                p = rgb_pixel(rnd.get_random_8bit_number(), rnd.get_random_8bit_number(), rnd.get_random_8bit_number());
+        }
+
+        // Find the max gate output for each image so we can pick a threshold that rejects
+        // some of them.
+        std::vector<double> gate_scores;
+        for (auto&& img : images)
+        {
+            resizable_tensor temp;
+            gate.to_tensor(&img, &img+1, temp);
+            gate.subnet().forward(temp);
+            gate_scores.push_back(max(mat(gate.subnet().get_output())));
+        }
+        std::vector<double> sorted_scores = gate_scores;
+        std::sort(sorted_scores.begin(), sorted_scores.end());
+        const double gate_threshold = (sorted_scores[4]+sorted_scores[5])/2;
+
+        const double adjust_threshold = -1e10;
+        auto dets = cascaded_detection(gate, net, images, gate_threshold, adjust_threshold, 4);
+        DLIB_TEST(dets.size() == images.size());
+        int num_rejected = 0;
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            auto single = cascaded_detection(gate, net, images[i], gate_threshold, adjust_threshold);
+            DLIB_TEST(single.size() == dets[i].size());
+            if (gate_scores[i] > gate_threshold)
+            {
+                std::vector<mmod_rect> truth;
+                resizable_tensor temp;
+                net.to_tensor(&images[i], &images[i]+1, temp);
+                net.subnet().forward(temp);
+                net.loss_details().to_label(temp, net.subnet(), &truth, adjust_threshold);
+                DLIB_TEST(truth.size() != 0);
+                DLIB_TEST(truth.size() == dets[i].size());
+                for (size_t j = 0; j < truth.size(); ++j)
+                {
+                    DLIB_TEST(truth[j].rect == dets[i][j].rect);
+                    DLIB_TEST(std::abs(truth[j].detection_confidence - dets[i][j].detection_confidence) < 1e-5);
+                }
+            }
+            else
+            {
+                ++num_rejected;
+                DLIB_TEST(dets[i].size() == 0);
+            }
+        }
+        DLIB_TEST(num_rejected == 5);
+
+        // Nothing gets through an infinitely high gate.
+        dets = cascaded_detection(gate, net, images, std::numeric_limits<double>::infinity());
+        for (auto&& d : dets)
+            DLIB_TEST(d.size() == 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_detect_in_rois()
+    {
+        print_spinner();
+
+        {
+            using net_type = con<1,3,3,1,1,relu<con<2,5,5,2,2,input<matrix<float>>>>>;
+            net_type net;
+            DLIB_TEST(output_tensor_receptive_field(net, point(0,0)) == rectangle(-2,-2,6,6));
+            DLIB_TEST(output_tensor_receptive_field(net, point(3,1)) == rectangle(4,0,12,8));
+            DLIB_TEST(center(output_tensor_receptive_field(net, point(3,1))) == output_tensor_to_input_tensor(net, point(3,1)));
+        }
+
+        using net_type = loss_mmod<con<1,3,3,1,1,relu<con<4,3,3,1,1,con<4,3,3,2,2,input_rgb_image_pyramid<pyramid_down<2>>>>>>>;
+        mmod_options options;
+        options.detector_width = 12;
+        options.detector_height = 12;
+        // Turn off non-max suppression so we can compare all the detections to the ones
+        // from the whole image.  Otherwise a detection inside a ROI can be suppressed by
+        // one outside it when net is run on the whole image.
+        options.overlaps_nms = test_box_overlap(1,1);
+        net_type net(options);
+
+        dlib::rand rnd;
+        matrix<rgb_pixel> img(100,160);
+        for (auto&& p : img)
+            p = rgb_pixel(rnd.get_random_8bit_number(), rnd.get_random_8bit_number(), rnd.get_random_8bit_number());
+
+        const double adjust_threshold = -1e10;
+        std::vector<mmod_rect> truth;
+        resizable_tensor temp;
+        net.to_tensor(&img, &img+1, temp);
+        net.subnet().forward(temp);
+        net.loss_details().to_label(temp, net.subnet(), &truth, adjust_threshold);
+
+        // The detections inside each ROI should be exactly what running net on the whole
+        // image gives, including the ones from the coarse pyramid levels.
+        const std::vector<rectangle> rois = {get_rect(img), rectangle(0,0,30,39), rectangle(71,43,103,70), rectangle(130,60,159,99)};
+        std::vector<mmod_rect> dets;
+        for (auto&& roi : rois)
+        {
+            // detect_in_rois() only outputs boxes centered inside the ROIs.
+            std::vector<mmod_rect> roi_truth;
+            for (auto&& d : truth)
+            {
+                if (roi.contains(center(d.rect)))
+                    roi_truth.push_back(d);
+            }
+            DLIB_TEST(roi_truth.size() != 0);
+
+            dets = detect_in_rois(net, img, {roi}, adjust_threshold);
+            DLIB_TEST(dets.size() == roi_truth.size());
+            for (size_t i = 0; i < dets.size() && i < roi_truth.size(); ++i)
+            {
+                DLIB_TEST(dets[i].rect == roi_truth[i].rect);
+                DLIB_TEST(std::abs(dets[i].detection_confidence - roi_truth[i].detection_confidence) < 1e-5);
+            }
+        }
+
+        // Overlapping ROIs don't produce duplicates and ROIs outside the image are ignored.
+        const rectangle roi1(10,10,29,29), roi2(20,15,70,50);
+        dets = detect_in_rois(net, img, {roi1, roi2, rectangle(200,200,300,300)}, adjust_threshold);
+        long num_in_rois = 0;
+        for (auto&& d : truth)
+        {
+            if (roi1.contains(center(d.rect)) || roi2.contains(center(d.rect)))
+                ++num_in_rois;
+        }
+        DLIB_TEST(dets.size() == (size_t)num_in_rois);
+        for (size_t i = 0; i < dets.size(); ++i)
+        {
+            DLIB_TEST(roi1.contains(center(dets[i].rect)) || roi2.contains(center(dets[i].rect)));
+            if (i > 0)
+                DLIB_TEST(dets[i-1].detection_confidence >= dets[i].detection_confidence);
+        }
+
+        DLIB_TEST(detect_in_rois(net, img, std::vector<rectangle>(), adjust_threshold).size() == 0);
+
+        // Any image type works, not just matrices.
+        using net_type2 = loss_mmod<con<1,3,3,1,1,relu<con<4,3,3,1,1,con<4,3,3,2,2,input<array2d<unsigned char>>>>>>>;
+        net_type2 net2(options);
+        array2d<unsigned char> img2(30,40);
+        for (long r = 0; r < img2.nr(); ++r)
+            for (long c = 0; c < img2.nc(); ++c)
+                img2[r][c] = rnd.get_random_8bit_number();
+        net2.to_tensor(&img2, &img2+1, temp);
+        net2.subnet().forward(temp);
+        net2.loss_details().to_label(temp, net2.subnet(), &truth, adjust_threshold);
+        const rectangle roi3(5,7,20,22);
+        truth.erase(std::remove_if(truth.begin(), truth.end(), 
+                [&](const mmod_rect& r){ return !roi3.contains(center(r.rect)); }), truth.end());
+        dets = detect_in_rois(net2, img2, {roi3}, adjust_threshold);
+        DLIB_TEST(dets.size() == truth.size());
+        for (size_t i = 0; i < dets.size() && i < truth.size(); ++i)
+        {
+            DLIB_TEST(dets[i].rect == truth[i].rect);
+            DLIB_TEST(std::abs(dets[i].detection_confidence - truth[i].detection_confidence) < 1e-5);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class dnn_tester : public tester
@@ -1767,6 +1944,8 @@ namespace
             test_visit_funcions();
             test_copy_tensor_cpu();
             test_concat();
+            test_cascaded_detection();
+            test_detect_in_rois();
         }
 
         void perform_test()
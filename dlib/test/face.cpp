@@ -48,8 +48,183 @@ namespace
             deserialize(objects[0], sin);
         }
 
+        void make_random_forests (
+            dlib::rand& rnd,
+            const long num_parts,
+            const long num_cascades,
+            const long num_trees,
+            const long feature_pool_size,
+            matrix<float,0,1>& initial_shape,
+            std::vector<std::vector<impl::regression_tree> >& forests,
+            std::vector<std::vector<dlib::vector<float,2> > >& pixel_coordinates
+        )
+        {
+            initial_shape.set_size(num_parts*2);
+            for (long i = 0; i < initial_shape.size(); ++i)
+                initial_shape(i) = 0.1 + 0.8*rnd.get_random_float();
+            forests.assign(num_cascades, std::vector<impl::regression_tree>(num_trees));
+            pixel_coordinates.assign(num_cascades, std::vector<dlib::vector<float,2> >());
+            for (long c = 0; c < num_cascades; ++c)
+            {
+                for (long i = 0; i < feature_pool_size; ++i)
+                    pixel_coordinates[c].push_back(dlib::vector<float,2>(1.2*rnd.get_random_float()-0.1, 1.2*rnd.get_random_float()-0.1));
+                for (long t = 0; t < num_trees; ++t)
+                {
+                    // Give the last cascade trees of different depths so it can't be
+                    // flattened and has to be run in its original form.
+                    const long depth = (c+1 == num_cascades) ? 1 + t%4 : 3;
+                    impl::regression_tree& tree = forests[c][t];
+                    tree.splits.resize((1<<depth)-1);
+                    for (unsigned long i = 0; i < tree.splits.size(); ++i)
+                    {
+                        tree.splits[i].idx1 = rnd.get_random_32bit_number()%feature_pool_size;
+                        tree.splits[i].idx2 = rnd.get_random_32bit_number()%feature_pool_size;
+                        tree.splits[i].thresh = 40*(rnd.get_random_float()-0.5);
+                    }
+                    tree.leaf_values.resize(tree.splits.size()+1);
+                    for (unsigned long i = 0; i < tree.leaf_values.size(); ++i)
+                    {
+                        tree.leaf_values[i].set_size(num_parts*2);
+                        for (long j = 0; j < tree.leaf_values[i].size(); ++j)
+                            tree.leaf_values[i](j) = 0.01*(rnd.get_random_float()-0.5);
+                    }
+                }
+            }
+        }
+
+        void test_shape_predictor_inference (
+        )
+        {
+            dlib::rand rnd;
+            matrix<float,0,1> initial_shape;
+            std::vector<std::vector<impl::regression_tree> > forests;
+            std::vector<std::vector<dlib::vector<float,2> > > pixel_coordinates;
+            // 5 parts gives a shape vector whose length isn't a multiple of 8.
+            make_random_forests(rnd, 5, 4, 21, 50, initial_shape, forests, pixel_coordinates);
+            shape_predictor sp(initial_shape, forests, pixel_coordinates);
+
+            std::vector<std::vector<unsigned long> > anchor_idx(forests.size());
+            std::vector<std::vector<dlib::vector<float,2> > > deltas(forests.size());
+            for (unsigned long c = 0; c < forests.size(); ++c)
+                impl::create_shape_relative_encoding(initial_shape, pixel_coordinates[c], anchor_idx[c], deltas[c]);
+
+            array2d<unsigned char> img(100,120);
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                for (long c = 0; c < img.nc(); ++c)
+                    img[r][c] = rnd.get_random_8bit_number();
+            }
+
+            ostringstream sout;
+            serialize(sp, sout);
+            istringstream sin(sout.str());
+            shape_predictor sp2;
+            deserialize(sp2, sin);
+
+            // The predictor only keeps the flattened form of most levels, so make sure the
+            // original trees are recovered exactly when it's saved.
+            {
+                ostringstream sout2, sout3;
+                serialize(1, sout2);
+                serialize(initial_shape, sout2);
+                serialize(forests, sout2);
+                serialize(anchor_idx, sout2);
+                serialize(deltas, sout2);
+                DLIB_TEST(sout.str() == sout2.str());
+                serialize(sp2, sout3);
+                DLIB_TEST(sout.str() == sout3.str());
+            }
+
+            for (int round = 0; round < 20; ++round)
+            {
+                print_spinner();
+                const rectangle rect = centered_rect(point(rnd.get_random_32bit_number()%120, rnd.get_random_32bit_number()%100),
+                                                     20+rnd.get_random_32bit_number()%80,
+                                                     20+rnd.get_random_32bit_number()%80);
+
+                // Run the cascade by hand using the original trees.
+                matrix<float,0,1> current_shape = initial_shape;
+                std::vector<float> feature_pixel_values;
+                std::vector<std::pair<unsigned long,double> > true_feats;
+                unsigned long feat_offset = 0;
+                for (unsigned long c = 0; c < forests.size(); ++c)
+                {
+                    impl::extract_feature_pixel_values(img, rect, current_shape, initial_shape,
+                                                       anchor_idx[c], deltas[c], feature_pixel_values);
+                    for (unsigned long t = 0; t < forests[c].size(); ++t)
+                    {
+                        unsigned long leaf_idx;
+                        current_shape += forests[c][t](feature_pixel_values, leaf_idx);
+                        true_feats.push_back(make_pair(feat_offset+leaf_idx, 1.0));
+                        feat_offset += forests[c][t].num_leaves();
+                    }
+                }
+                DLIB_TEST(feat_offset == sp.num_features());
+
+                std::vector<std::pair<unsigned long,double> > feats;
+                const full_object_detection det = sp(img, rect, feats);
+                const full_object_detection det2 = sp2(img, rect);
+                DLIB_TEST(feats == true_feats);
+                DLIB_TEST(det.num_parts() == 5);
+                DLIB_TEST(det2.num_parts() == 5);
+                const point_transform_affine tform_to_img = impl::unnormalizing_tform(rect);
+                for (unsigned long i = 0; i < det.num_parts(); ++i)
+                {
+                    const point p = tform_to_img(impl::location(current_shape, i));
+                    DLIB_TEST(det.part(i) == p);
+                    DLIB_TEST(det2.part(i) == p);
+                }
+            }
+
+            // The batch versions should give exactly the same outputs as predicting one
+            // rectangle at a time.
+            print_spinner();
+            std::vector<array2d<unsigned char> > images(3);
+            std::vector<std::vector<rectangle> > rects(images.size());
+            for (unsigned long k = 0; k < images.size(); ++k)
+            {
+                images[k].set_size(80+k*10, 90);
+                for (long r = 0; r < images[k].nr(); ++r)
+                {
+                    for (long c = 0; c < images[k].nc(); ++c)
+                        images[k][r][c] = rnd.get_random_8bit_number();
+                }
+                // leave one image without any rectangles
+                for (unsigned long j = 0; j < 7*k; ++j)
+                    rects[k].push_back(centered_rect(point(rnd.get_random_32bit_number()%90, rnd.get_random_32bit_number()%80), 30+j, 40));
+            }
+            for (unsigned long num_threads = 1; num_threads <= 3; ++num_threads)
+            {
+                const std::vector<full_object_detection> dets = sp(images[2], rects[2], num_threads);
+                DLIB_TEST(dets.size() == rects[2].size());
+                for (unsigned long j = 0; j < dets.size(); ++j)
+                {
+                    const full_object_detection truth = sp(images[2], rects[2][j]);
+                    DLIB_TEST(dets[j].get_rect() == rects[2][j]);
+                    for (unsigned long i = 0; i < truth.num_parts(); ++i)
+                        DLIB_TEST(dets[j].part(i) == truth.part(i));
+                }
+
+                const std::vector<std::vector<full_object_detection> > all_dets = sp(images, rects, num_threads);
+                DLIB_TEST(all_dets.size() == images.size());
+                for (unsigned long k = 0; k < images.size(); ++k)
+                {
+                    DLIB_TEST(all_dets[k].size() == rects[k].size());
+                    for (unsigned long j = 0; j < rects[k].size(); ++j)
+                    {
+                        const full_object_detection truth = sp(images[k], rects[k][j]);
+                        DLIB_TEST(all_dets[k][j].get_rect() == rects[k][j]);
+                        for (unsigned long i = 0; i < truth.num_parts(); ++i)
+                            DLIB_TEST(all_dets[k][j].part(i) == truth.part(i));
+                    }
+                }
+            }
+        }
+
         void perform_test()
         {
+            test_shape_predictor_inference();
+
             print_spinner();
             dlib::array<array2d<unsigned char> > images;
             std::vector<std::vector<full_object_detection> > objects;
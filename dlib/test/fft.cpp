@@ -128,6 +128,159 @@ namespace
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    matrix<complex<double> > naive_dft (
+        const matrix<complex<double> >& m
+    )
+    {
+        // Direct O(n^2) evaluation of the 2D DFT definition.
+        matrix<complex<double> > result(m.nr(), m.nc());
+        for (long k1 = 0; k1 < m.nr(); ++k1)
+        {
+            for (long k2 = 0; k2 < m.nc(); ++k2)
+            {
+                complex<double> sum = 0;
+                for (long r = 0; r < m.nr(); ++r)
+                {
+                    for (long c = 0; c < m.nc(); ++c)
+                    {
+                        const double phase = -2*pi*((double)k1*r/m.nr() + (double)k2*c/m.nc());
+                        sum += m(r,c)*std::polar(1.0, phase);
+                    }
+                }
+                result(k1,k2) = sum;
+            }
+        }
+        return result;
+    }
+
+    void test_mixed_radix_ffts()
+    {
+        // Sizes that aren't powers of two, including ones with prime factors bigger than
+        // 5 so the generic butterfly gets used.
+        const long sizes[] = {1, 2, 3, 5, 6, 7, 9, 10, 12, 15, 25, 30, 45, 49, 77};
+        const long num = sizeof(sizes)/sizeof(sizes[0]);
+        for (long i = 0; i < num; ++i)
+        {
+            print_spinner();
+            for (long j = 0; j < num; j += 3)
+            {
+                const long nr = sizes[i];
+                const long nc = sizes[j];
+                const matrix<complex<double> > m1 = rand_complex(nr,nc);
+                const matrix<complex<float> > fm1 = matrix_cast<complex<float> >(m1);
+                const matrix<complex<double> > truth = naive_dft(m1);
+
+                DLIB_TEST_MSG(max(norm(fft(m1)-truth))/m1.size() < 1e-18, nr << " " << nc);
+                DLIB_TEST(max(norm(fft(trans(m1))-trans(truth)))/m1.size() < 1e-18);
+                DLIB_TEST(max(norm(ifft(fft(m1))-m1)) < 1e-16);
+                DLIB_TEST(max(norm(ifft(fft(fm1))-fm1)) < 1e-7);
+
+                matrix<complex<double> > temp = m1;
+                fft_inplace(temp);
+                DLIB_TEST(max(norm(temp-fft(m1))) == 0);
+                ifft_inplace(temp);
+                DLIB_TEST(max(norm(temp/temp.size()-m1)) < 1e-16);
+            }
+        }
+    }
+
+    void test_bluestein_ffts()
+    {
+        // Sizes with a prime factor too big for the generic butterfly.
+        const long sizes[] = {17, 67, 134, 257, 3*101, 4*19*5, 1009};
+        const long num = sizeof(sizes)/sizeof(sizes[0]);
+        for (long i = 0; i < num; ++i)
+        {
+            print_spinner();
+            const long n = sizes[i];
+            for (long nr = 1; nr <= 3; nr += 2)
+            {
+                const matrix<complex<double> > m1 = rand_complex(nr,n);
+                const matrix<complex<double> > truth = naive_dft(m1);
+
+                DLIB_TEST_MSG(max(norm(fft(m1)-truth))/m1.size() < 1e-18, nr << " " << n);
+                DLIB_TEST_MSG(max(norm(fft(trans(m1))-trans(truth)))/m1.size() < 1e-18, nr << " " << n);
+                DLIB_TEST(max(norm(ifft(fft(m1))-m1)) < 1e-16);
+                if (n%2 == 0)
+                {
+                    const matrix<double> rm = real(m1);
+                    DLIB_TEST(max(squared(ifftr(fftr(rm)) - rm)) < 1e-16);
+                }
+            }
+        }
+    }
+
+    void test_fft_plan_cache()
+    {
+        // Use more sizes than the plan cache holds so plans get thrown out and remade,
+        // and make sure we still get the right answers.
+        for (int iter = 0; iter < 2; ++iter)
+        {
+            print_spinner();
+            for (long n = 1; n <= 100; ++n)
+            {
+                const matrix<complex<double> > m1 = rand_complex(1,n);
+                DLIB_TEST_MSG(max(norm(fft(m1)-naive_dft(m1)))/m1.size() < 1e-18, n);
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_fftr()
+    {
+        dlib::rand rnd;
+        for (int iter = 0; iter < 3; ++iter)
+        {
+            print_spinner();
+            const long sizes[] = {1, 2, 3, 4, 6, 10, 12, 16, 30, 64};
+            const long num = sizeof(sizes)/sizeof(sizes[0]);
+            for (long i = 0; i < num; ++i)
+            {
+                for (long j = 1; j < num; ++j)
+                {
+                    const long nr = sizes[i];
+                    const long nc = sizes[j];
+                    if (nc%2 != 0)
+                        continue;
+
+                    matrix<double> m(nr,nc);
+                    for (long r = 0; r < m.nr(); ++r)
+                    {
+                        for (long c = 0; c < m.nc(); ++c)
+                            m(r,c) = rnd.get_random_gaussian()*10;
+                    }
+                    const matrix<float> fm = matrix_cast<float>(m);
+
+                    const matrix<complex<double> > full = fft(complex_matrix(m));
+                    const matrix<complex<double> > half = fftr(m);
+                    DLIB_TEST(half.nr() == nr);
+                    DLIB_TEST(half.nc() == nc/2+1);
+                    DLIB_TEST(max(norm(half - colm(full,range(0,nc/2)))) < 1e-16);
+                    DLIB_TEST(max(squared(ifftr(half) - m)) < 1e-16);
+
+                    const matrix<complex<float> > fhalf = fftr(fm);
+                    DLIB_TEST(max(norm(fhalf - colm(matrix_cast<complex<float> >(full),range(0,nc/2)))) < 1e-4);
+                    DLIB_TEST(max(squared(ifftr(fhalf) - fm)) < 1e-7);
+
+                    // Column vectors are transformed along their length.
+                    if (nr == 1)
+                    {
+                        const matrix<double,0,1> v = trans(m);
+                        const matrix<complex<double>,0,1> vhalf = fftr(v);
+                        DLIB_TEST(vhalf.nr() == nc/2+1 && vhalf.nc() == 1);
+                        DLIB_TEST(max(norm(vhalf - trans(half))) < 1e-16);
+                        const matrix<double> v2 = ifftr(vhalf);
+                        DLIB_TEST(v2.nr() == nc && v2.nc() == 1);
+                        DLIB_TEST(max(squared(v2 - v)) < 1e-16);
+                    }
+                }
+            }
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class test_fft : public tester
@@ -145,6 +298,10 @@ namespace
             test_against_saved_good_ffts();
             test_random_ffts();
             test_random_real_ffts();
+            test_mixed_radix_ffts();
+            test_bluestein_ffts();
+            test_fft_plan_cache();
+            test_fftr();
         }
     } a;
 
@@ -153,12 +153,305 @@ namespace
         }
 
 
+        template <typename image_type>
+        void ref_extract_fhog_features (
+            const image_type& img_,
+            dlib::array<array2d<float> >& hog,
+            const int cell_size
+        )
+        /*!
+            A plain scalar version of extract_fhog_features() that adds each pixel's
+            votes into the 4 neighbouring histograms one at a time.
+        !*/
+        {
+            const_image_view<image_type> img(img_);
+            matrix<float,2,1> directions[9];
+            directions[0] =  1.0000, 0.0000;
+            directions[1] =  0.9397, 0.3420;
+            directions[2] =  0.7660, 0.6428;
+            directions[3] =  0.500,  0.8660;
+            directions[4] =  0.1736, 0.9848;
+            directions[5] = -0.1736, 0.9848;
+            directions[6] = -0.5000, 0.8660;
+            directions[7] = -0.7660, 0.6428;
+            directions[8] = -0.9397, 0.3420;
+
+            const int cells_nr = (int)((float)img.nr()/(float)cell_size + 0.5);
+            const int cells_nc = (int)((float)img.nc()/(float)cell_size + 0.5);
+            const int hog_nr = std::max(cells_nr-2, 0);
+            const int hog_nc = std::max(cells_nc-2, 0);
+            hog.resize(31);
+            for (unsigned long i = 0; i < hog.size(); ++i)
+                hog[i].clear();
+            if (hog_nr == 0 || hog_nc == 0)
+                return;
+            for (unsigned long i = 0; i < hog.size(); ++i)
+                hog[i].set_size(hog_nr, hog_nc);
+
+            array2d<matrix<float,18,1> > hist(cells_nr+2, cells_nc+2);
+            for (long r = 0; r < hist.nr(); ++r)
+                for (long c = 0; c < hist.nc(); ++c)
+                    hist[r][c] = 0;
+
+            const int visible_nr = std::min((long)cells_nr*cell_size,img.nr())-1;
+            const int visible_nc = std::min((long)cells_nc*cell_size,img.nc())-1;
+            for (int y = 1; y < visible_nr; y++)
+            {
+                const float yp = ((float)y+0.5)/(float)cell_size - 0.5;
+                const int iyp = (int)std::floor(yp);
+                const float vy0 = yp - iyp;
+                const float vy1 = 1.0 - vy0;
+                for (int x = 1; x < visible_nc; x++)
+                {
+                    matrix<float,2,1> grad;
+                    float v;
+                    impl_fhog::get_gradient(y,x,img,grad,v);
+
+                    float best_dot = 0;
+                    int best_o = 0;
+                    for (int o = 0; o < 9; o++)
+                    {
+                        const float dot = dlib::dot(directions[o], grad);
+                        if (dot > best_dot)
+                        {
+                            best_dot = dot;
+                            best_o = o;
+                        }
+                        else if (-dot > best_dot)
+                        {
+                            best_dot = -dot;
+                            best_o = o+9;
+                        }
+                    }
+
+                    v = std::sqrt(v);
+                    const float xp = ((double)x + 0.5) / (double)cell_size - 0.5;
+                    const int ixp = (int)std::floor(xp);
+                    const float vx0 = xp - ixp;
+                    const float vx1 = 1.0 - vx0;
+
+                    hist[iyp+1][ixp+1](best_o) += vy1*vx1*v;
+                    hist[iyp+1+1][ixp+1](best_o) += vy0*vx1*v;
+                    hist[iyp+1][ixp+1+1](best_o) += vy1*vx0*v;
+                    hist[iyp+1+1][ixp+1+1](best_o) += vy0*vx0*v;
+                }
+            }
+
+            array2d<float> norm(cells_nr, cells_nc);
+            for (int r = 0; r < cells_nr; ++r)
+            {
+                for (int c = 0; c < cells_nc; ++c)
+                {
+                    norm[r][c] = 0;
+                    for (int o = 0; o < 9; o++)
+                        norm[r][c] += std::pow(hist[r+1][c+1](o) + hist[r+1][c+1](o+9), 2);
+                }
+            }
+
+            const float eps = 0.0001;
+            for (int y = 0; y < hog_nr; y++)
+            {
+                for (int x = 0; x < hog_nc; x++)
+                {
+                    // The 4 blocks of 2x2 cells that contain cell (y+1,x+1).
+                    float nn[4], n[4];
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        const int by = y + 1 - k%2;
+                        const int bx = x + 1 - k/2;
+                        nn[k] = 0.2*std::sqrt(norm[by][bx] + norm[by][bx+1] + norm[by+1][bx] + norm[by+1][bx+1] + eps);
+                        n[k] = 0.1/nn[k];
+                    }
+
+                    const matrix<float,18,1>& h = hist[y+2][x+2];
+                    float t[4] = {0,0,0,0};
+                    for (int o = 0; o < 18; ++o)
+                    {
+                        hog[o][y][x] = 0;
+                        for (int k = 0; k < 4; ++k)
+                        {
+                            const float val = std::min(h(o),nn[k])*n[k];
+                            hog[o][y][x] += val;
+                            t[k] += val;
+                        }
+                    }
+                    for (int o = 0; o < 9; ++o)
+                    {
+                        hog[o+18][y][x] = 0;
+                        for (int k = 0; k < 4; ++k)
+                            hog[o+18][y][x] += std::min(h(o)+h(o+9),nn[k])*n[k];
+                    }
+                    for (int k = 0; k < 4; ++k)
+                        hog[27+k][y][x] = t[k]*2*0.2357;
+                }
+            }
+        }
+
+        template <typename pixel_type>
+        void test_against_scalar_version (
+            dlib::rand& rnd
+        )
+        {
+            // Use widths that leave between 0 and 7 columns for the scalar tail of the
+            // SIMD loop.
+            for (long nc = 3; nc < 45; ++nc)
+            {
+                print_spinner();
+                array2d<pixel_type> img(rnd.get_random_32bit_number()%30+3, nc);
+                for (long r = 0; r < img.nr(); ++r)
+                    for (long c = 0; c < img.nc(); ++c)
+                        assign_pixel(img[r][c], rnd.get_random_8bit_number());
+
+                for (int cell_size = 2; cell_size <= 8; ++cell_size)
+                {
+                    dlib::array<array2d<float> > hog, ref_hog;
+                    extract_fhog_features(img, hog, cell_size);
+                    ref_extract_fhog_features(img, ref_hog, cell_size);
+                    DLIB_TEST(hog.size() == 31);
+                    for (unsigned long o = 0; o < hog.size(); ++o)
+                    {
+                        DLIB_TEST(hog[o].nr() == ref_hog[o].nr());
+                        DLIB_TEST(hog[o].nc() == ref_hog[o].nc());
+                        for (long r = 0; r < hog[o].nr(); ++r)
+                        {
+                            for (long c = 0; c < hog[o].nc(); ++c)
+                            {
+                                // The SIMD path sums the votes in a different order so
+                                // the results aren't bit-identical.
+                                DLIB_TEST_MSG(std::abs(hog[o][r][c] - ref_hog[o][r][c]) < 1e-5,
+                                    std::abs(hog[o][r][c] - ref_hog[o][r][c]) << "  nc: " << nc << "  cell_size: " << cell_size);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        void test_snap_to_orientation (
+            dlib::rand& rnd
+        )
+        {
+            print_spinner();
+            matrix<float,2,1> directions[9];
+            directions[0] =  1.0000, 0.0000;
+            directions[1] =  0.9397, 0.3420;
+            directions[2] =  0.7660, 0.6428;
+            directions[3] =  0.500,  0.8660;
+            directions[4] =  0.1736, 0.9848;
+            directions[5] = -0.1736, 0.9848;
+            directions[6] = -0.5000, 0.8660;
+            directions[7] = -0.7660, 0.6428;
+            directions[8] = -0.9397, 0.3420;
+
+            std::vector<float> gx, gy;
+            // zero and axis aligned gradients, where ties are possible.
+            for (int i = -2; i <= 2; ++i)
+            {
+                for (int j = -2; j <= 2; ++j)
+                {
+                    gx.push_back(i);
+                    gy.push_back(j);
+                }
+            }
+            for (int i = 0; i < 10000; ++i)
+            {
+                gx.push_back((int)(rnd.get_random_32bit_number()%511) - 255);
+                gy.push_back((int)(rnd.get_random_32bit_number()%511) - 255);
+            }
+            while (gx.size()%8 != 0)
+            {
+                gx.push_back(0);
+                gy.push_back(0);
+            }
+
+            for (unsigned long i = 0; i < gx.size(); i += 8)
+            {
+                simd8f grad_x, grad_y;
+                grad_x.load(&gx[i]);
+                grad_y.load(&gy[i]);
+                int32 best[8];
+                impl_fhog::snap_to_orientation(grad_x, grad_y).store(best);
+                for (int j = 0; j < 8; ++j)
+                {
+                    matrix<float,2,1> grad;
+                    grad = gx[i+j], gy[i+j];
+                    float best_dot = 0;
+                    int best_o = 0;
+                    for (int o = 0; o < 9; o++)
+                    {
+                        const float dot = dlib::dot(directions[o], grad);
+                        if (dot > best_dot)
+                        {
+                            best_dot = dot;
+                            best_o = o;
+                        }
+                        else if (-dot > best_dot)
+                        {
+                            best_dot = -dot;
+                            best_o = o+9;
+                        }
+                    }
+                    DLIB_TEST_MSG(best[j] == best_o, trans(grad) << best[j] << " " << best_o);
+                }
+            }
+        }
+
+        template <typename pixel_type>
+        void test_gradient_row_buffer (
+            dlib::rand& rnd
+        )
+        {
+            print_spinner();
+            array2d<pixel_type> img(12, 27);
+            for (long r = 0; r < img.nr(); ++r)
+                for (long c = 0; c < img.nc(); ++c)
+                    assign_pixel(img[r][c], rnd.get_random_8bit_number());
+
+            const const_image_view<array2d<pixel_type> > view(img);
+            impl_fhog::gradient_row_buffer<const_image_view<array2d<pixel_type> > > grad_rows(view);
+            // Visit the rows in order and then jump around, since the buffer reloads
+            // differently in each case.
+            std::vector<long> rows;
+            for (long r = 1; r+1 < img.nr(); ++r)
+                rows.push_back(r);
+            rows.push_back(5);
+            rows.push_back(5);
+            rows.push_back(2);
+            rows.push_back(9);
+            rows.push_back(10);
+            for (unsigned long i = 0; i < rows.size(); ++i)
+            {
+                const long r = rows[i];
+                grad_rows.set_center_row(r);
+                for (long c = 1; c+8 < img.nc(); ++c)
+                {
+                    simd8f gx, gy, len, ref_gx, ref_gy, ref_len;
+                    grad_rows.get_gradient(c, gx, gy, len);
+                    impl_fhog::get_gradient(r, c, view, ref_gx, ref_gy, ref_len);
+                    float a[8], b[8];
+                    gx.store(a); ref_gx.store(b);
+                    DLIB_TEST(std::equal(a, a+8, b));
+                    gy.store(a); ref_gy.store(b);
+                    DLIB_TEST(std::equal(a, a+8, b));
+                    len.store(a); ref_len.store(b);
+                    DLIB_TEST(std::equal(a, a+8, b));
+                }
+            }
+        }
+
         void perform_test (
         )
         {
             test_point_transforms();
             test_on_small();
 
+            dlib::rand rnd;
+            test_snap_to_orientation(rnd);
+            test_gradient_row_buffer<unsigned char>(rnd);
+            test_gradient_row_buffer<rgb_pixel>(rnd);
+            test_against_scalar_version<unsigned char>(rnd);
+            test_against_scalar_version<rgb_pixel>(rnd);
+
             print_spinner();
             // load the testing data
             array2d<rgb_pixel> img;
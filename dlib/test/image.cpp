@@ -1,6 +1,7 @@
 // Copyright (C) 2008  Davis E. King (davis@dlib.net)
 // License: Boost Software License   See LICENSE.txt for the full license.
 #include <sstream>
+#include <fstream>
 #include <string>
 #include <cstdlib>
 #include <ctime>
@@ -849,6 +850,138 @@ namespace
 
     }
 
+    void test_fft_filtering(long nr, long nc, dlib::rand& rnd)
+    {
+        print_spinner();
+        dlog << LINFO << "test_fft_filtering(): " << nr << "  " << nc;
+        // These filters are big enough that spatially_filter_image() uses FFTs, so check
+        // that it still gives the same answers as direct filtering.  The filter sizes
+        // must be odd for the xcorr_same() comparisons to line up.
+        array2d<float> img(200,251);
+        array2d<unsigned char> img8(img.nr(), img.nc());
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                img[r][c] = rnd.get_random_gaussian();
+                img8[r][c] = rnd.get_random_8bit_number();
+            }
+        }
+        matrix<float> filt = matrix_cast<float>(randm(nr,nc,rnd)-0.5);
+        matrix<double> dfilt = randm(nr,nc,rnd)-0.5;
+
+        // These filters have a lot of taps so compute the reference output in double
+        // precision.
+        const matrix<float> out = matrix_cast<float>(xcorr_same(matrix_cast<double>(mat(img)),matrix_cast<double>(filt)));
+        array2d<float> imout, imout2;
+        rectangle rect = spatially_filter_image(img, imout, filt);
+        DLIB_TEST(rect == shrink_rect(get_rect(img), filt.nc()/2, filt.nr()/2));
+        border_enumerator be(get_rect(imout),rect);
+        while (be.move_next())
+        {
+            DLIB_TEST(imout[be.element().y()][be.element().x()] == 0);
+        }
+        DLIB_TEST_MSG(max(abs(subm(mat(imout),rect) - subm(out,rect))) < 1e-4, max(abs(subm(mat(imout),rect) - subm(out,rect))));
+
+        assign_all_pixels(imout, 10);
+        rect = spatially_filter_image(img, imout, filt, 2, true, true);
+        be = border_enumerator(get_rect(imout),rect);
+        while (be.move_next())
+        {
+            DLIB_TEST(imout[be.element().y()][be.element().x()] == 10);
+        }
+        DLIB_TEST(max(abs(subm(mat(imout),rect) - subm(10+abs(out/2),rect))) < 1e-4);
+
+        // Compare against the direct filtering code for a non-float image.
+        rect = spatially_filter_image(img8, imout, dfilt, 3, true);
+        impl::grayscale_spatially_filter_image(img8, imout2, dfilt, 3, true, false);
+        DLIB_TEST(max(abs(mat(imout) - mat(imout2))) < 1e-3);
+
+        // Filtering with integer valued filters always gives exact results. 
+        array2d<int> iout, iout2;
+        const matrix<int> ifilt = matrix_cast<int>(dfilt*10);
+        spatially_filter_image(img8, iout, ifilt);
+        impl::grayscale_spatially_filter_image(img8, iout2, ifilt, 1, false, false);
+        DLIB_TEST(mat(iout) == mat(iout2));
+
+        // So does filtering into an integer image, even with a real valued filter.
+        spatially_filter_image(img8, iout, dfilt*10);
+        impl::grayscale_spatially_filter_image(img8, iout2, dfilt*10, 1, false, false);
+        DLIB_TEST(mat(iout) == mat(iout2));
+        array2d<unsigned char> img8out, img8out2;
+        spatially_filter_image(img8, img8out, dfilt, 2, true);
+        impl::grayscale_spatially_filter_image(img8, img8out2, dfilt, 2, true, false);
+        DLIB_TEST(mat(img8out) == mat(img8out2));
+    }
+
+    void test_threaded_separable_filtering(long nr, long nc, dlib::rand& rnd)
+    {
+        print_spinner();
+        dlog << LINFO << "test_threaded_separable_filtering(): " << nr << "  " << nc;
+        // Splitting the image into bands for threading must not change the output at
+        // all, so everything here is checked for exact equality.
+        array2d<float> img(nr,nc);
+        array2d<unsigned char> img8(nr,nc);
+        array2d<rgb_pixel> imgrgb(nr,nc);
+        for (long r = 0; r < nr; ++r)
+        {
+            for (long c = 0; c < nc; ++c)
+            {
+                img[r][c] = rnd.get_random_gaussian();
+                img8[r][c] = rnd.get_random_8bit_number();
+                imgrgb[r][c] = rgb_pixel(rnd.get_random_8bit_number(),
+                                         rnd.get_random_8bit_number(),
+                                         rnd.get_random_8bit_number());
+            }
+        }
+        const matrix<float,0,1> rowf = matrix_cast<float>(randm(7,1,rnd)-0.5);
+        const matrix<float,0,1> colf = matrix_cast<float>(randm(5,1,rnd)-0.5);
+        const matrix<int,0,1> irowf = matrix_cast<int>(20*(randm(7,1,rnd)-0.5));
+        const matrix<int,0,1> icolf = matrix_cast<int>(20*(randm(5,1,rnd)-0.5));
+
+        array2d<float> out1, out2, scratch;
+        array2d<int> iout1, iout2;
+        array2d<unsigned char> out81, out82;
+        array2d<rgb_pixel> outrgb1, outrgb2;
+
+        spatially_filter_image_separable(img, out1, rowf, colf, 1);
+        float_spatially_filter_image_separable(img, out2, rowf, colf, scratch);
+        DLIB_TEST(mat(out1) == mat(out2));
+        DLIB_TEST(scratch.nr() == colf.size());
+        spatially_filter_image_separable(img, out1, rowf, colf, 1, true);
+        spatially_filter_image_separable(img8, iout1, irowf, icolf, 3, true);
+        for (unsigned long num_threads = 2; num_threads <= 5; ++num_threads)
+        {
+            spatially_filter_image_separable(img, out2, rowf, colf, 1, true, false, num_threads);
+            DLIB_TEST(mat(out1) == mat(out2));
+            spatially_filter_image_separable(img8, iout2, irowf, icolf, 3, true, false, num_threads);
+            DLIB_TEST(mat(iout1) == mat(iout2));
+        }
+
+        assign_all_pixels(out1, 1);
+        assign_all_pixels(out2, 1);
+        spatially_filter_image_separable(img, out1, rowf, colf, 2, false, true);
+        spatially_filter_image_separable(img, out2, rowf, colf, 2, false, true, 3);
+        DLIB_TEST(mat(out1) == mat(out2));
+
+        gaussian_blur(img, out1, 1.5);
+        gaussian_blur(img8, out81, 2.5);
+        gaussian_blur(imgrgb, outrgb1, 2);
+        for (unsigned long num_threads = 2; num_threads <= 5; ++num_threads)
+        {
+            gaussian_blur(img, out2, 1.5, 1001, num_threads);
+            DLIB_TEST(mat(out1) == mat(out2));
+            gaussian_blur(img8, out82, 2.5, 1001, num_threads);
+            DLIB_TEST(mat(out81) == mat(out82));
+            gaussian_blur(imgrgb, outrgb2, 2, 1001, num_threads);
+            for (long r = 0; r < nr; ++r)
+            {
+                for (long c = 0; c < nc; ++c)
+                    DLIB_TEST(pixel_to_vector<int>(outrgb1[r][c]) == pixel_to_vector<int>(outrgb2[r][c]));
+            }
+        }
+    }
+
     template <typename T>
     void test_filtering(bool use_abs, unsigned long scale )
     {
@@ -1308,6 +1441,286 @@ namespace
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    // These forward to neighbors_4 and neighbors_8 but since they are different types
+    // label_connected_blobs() uses its generic flood fill on them.
+    struct flood_fill_neighbors_4
+    {
+        void operator() (const point& p, std::vector<point>& neighbors) const
+        { neighbors_4()(p, neighbors); }
+    };
+
+    struct flood_fill_neighbors_8
+    {
+        void operator() (const point& p, std::vector<point>& neighbors) const
+        { neighbors_8()(p, neighbors); }
+    };
+
+    template <
+        typename label_type,
+        typename neighbors_type,
+        typename flood_fill_neighbors_type,
+        typename connected_type
+        >
+    void test_label_connected_blobs_union_find (
+        const array2d<unsigned char>& img,
+        const connected_type& is_connected
+    )
+    {
+        array2d<label_type> truth, labels;
+        const unsigned long num = label_connected_blobs(img, zero_pixels_are_background(),
+            flood_fill_neighbors_type(), is_connected, truth);
+
+        std::vector<blob_stats> truth_stats;
+        DLIB_TEST(label_connected_blobs(img, zero_pixels_are_background(), flood_fill_neighbors_type(),
+                is_connected, labels, truth_stats) == num);
+        DLIB_TEST(mat(labels) == mat(truth));
+        DLIB_TEST(truth_stats.size() == num);
+
+        // Check the stats against a brute force computation.
+        for (unsigned long i = 0; i < num; ++i)
+        {
+            unsigned long area = 0;
+            rectangle rect;
+            dpoint sum;
+            for (long r = 0; r < truth.nr(); ++r)
+            {
+                for (long c = 0; c < truth.nc(); ++c)
+                {
+                    if (truth[r][c] == i)
+                    {
+                        ++area;
+                        rect += point(c,r);
+                        sum += dpoint(c,r);
+                    }
+                }
+            }
+            DLIB_TEST(truth_stats[i].area == area);
+            DLIB_TEST(truth_stats[i].rect == rect);
+            if (area != 0)
+                DLIB_TEST(length(truth_stats[i].centroid - sum/area) < 1e-9);
+        }
+
+        for (unsigned long num_threads = 1; num_threads <= 5; num_threads += 2)
+        {
+            DLIB_TEST(label_connected_blobs(img, zero_pixels_are_background(), neighbors_type(),
+                    is_connected, labels, num_threads) == num);
+            DLIB_TEST(mat(labels) == mat(truth));
+
+            std::vector<blob_stats> stats;
+            DLIB_TEST(label_connected_blobs(img, zero_pixels_are_background(), neighbors_type(),
+                    is_connected, labels, stats, num_threads) == num);
+            DLIB_TEST(mat(labels) == mat(truth));
+            DLIB_TEST(stats.size() == num);
+            for (unsigned long i = 0; i < num; ++i)
+            {
+                DLIB_TEST(stats[i].area == truth_stats[i].area);
+                DLIB_TEST(stats[i].rect == truth_stats[i].rect);
+                DLIB_TEST(length(stats[i].centroid - truth_stats[i].centroid) < 1e-9);
+            }
+        }
+    }
+
+    void test_label_connected_blobs3()
+    {
+        print_spinner();
+        dlib::rand rnd;
+        array2d<unsigned char> img;
+        for (int iter = 0; iter < 30; ++iter)
+        {
+            img.set_size(rnd.get_random_32bit_number()%60+1, rnd.get_random_32bit_number()%60+1);
+            // Mostly long horizontal runs so that blobs wind across rows and bands.
+            const double density = rnd.get_random_double();
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                for (long c = 0; c < img.nc(); ++c)
+                {
+                    if (c == 0 || rnd.get_random_double() < 0.3)
+                        img[r][c] = rnd.get_random_double() < density ? rnd.get_random_8bit_number()%3 : 0;
+                    else
+                        img[r][c] = img[r][c-1];
+                }
+            }
+
+            test_label_connected_blobs_union_find<unsigned long, neighbors_4, flood_fill_neighbors_4>(img, connected_if_both_not_zero());
+            test_label_connected_blobs_union_find<unsigned long, neighbors_8, flood_fill_neighbors_8>(img, connected_if_both_not_zero());
+            test_label_connected_blobs_union_find<unsigned short, neighbors_4, flood_fill_neighbors_4>(img, connected_if_equal());
+            test_label_connected_blobs_union_find<unsigned short, neighbors_8, flood_fill_neighbors_8>(img, connected_if_equal());
+        }
+
+        // A serpentine blob whose rows are only joined at alternating ends.  This makes
+        // lots of provisional labels that all have to end up as one blob.
+        img.set_size(101,50);
+        assign_all_pixels(img, 0);
+        for (long r = 0; r < img.nr(); r += 2)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+                img[r][c] = 1;
+            if (r+1 < img.nr())
+                img[r+1][(r/2)%2 ? 0 : img.nc()-1] = 1;
+        }
+        array2d<int> labels;
+        std::vector<blob_stats> stats;
+        for (unsigned long num_threads = 1; num_threads <= 8; ++num_threads)
+        {
+            DLIB_TEST(label_connected_blobs(img, zero_pixels_are_background(), neighbors_4(),
+                    connected_if_both_not_zero(), labels, stats, num_threads) == 2);
+            DLIB_TEST(stats.size() == 2);
+            DLIB_TEST(stats[1].rect == get_rect(img));
+            DLIB_TEST(stats[0].area + stats[1].area == img.size());
+            DLIB_TEST(labels[img.nr()-1][0] == 1);
+        }
+
+        // Empty images
+        img.clear();
+        DLIB_TEST(label_connected_blobs(img, zero_pixels_are_background(), neighbors_8(),
+                connected_if_both_not_zero(), labels, stats, 4) == 0);
+        DLIB_TEST(labels.size() == 0);
+        DLIB_TEST(stats.size() == 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <long M, long N>
+    void naive_binary_morphology (
+        const array2d<unsigned char>& img,
+        array2d<unsigned char>& out,
+        const unsigned char (&se)[M][N],
+        bool dilate
+    )
+    {
+        out.set_size(img.nr(), img.nc());
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                bool val = !dilate;
+                for (long m = 0; m < M; ++m)
+                {
+                    for (long n = 0; n < N; ++n)
+                    {
+                        if (se[m][n] != on_pixel)
+                            continue;
+                        const point p(c+n-N/2, r+m-M/2);
+                        const bool pix = get_rect(img).contains(p) && img[p.y()][p.x()] == on_pixel;
+                        if (dilate)
+                            val = val || pix;
+                        else
+                            val = val && pix;
+                    }
+                }
+                out[r][c] = val ? on_pixel : off_pixel;
+            }
+        }
+    }
+
+    template <long M, long N>
+    void test_binary_morphology (
+        dlib::rand& rnd,
+        const array2d<unsigned char>& img,
+        bool random_se
+    )
+    {
+        unsigned char se[M][N];
+        for (long m = 0; m < M; ++m)
+        {
+            for (long n = 0; n < N; ++n)
+            {
+                if (random_se)
+                    se[m][n] = rnd.get_random_double() < 0.5 ? on_pixel : off_pixel;
+                else
+                    se[m][n] = on_pixel;
+            }
+        }
+
+        array2d<unsigned char> truth_dilate, truth_erode, out;
+        naive_binary_morphology(img, truth_dilate, se, true);
+        naive_binary_morphology(img, truth_erode, se, false);
+
+        binary_dilation(img, out, se);
+        DLIB_TEST(mat(out) == mat(truth_dilate));
+        binary_erosion(img, out, se);
+        DLIB_TEST(mat(out) == mat(truth_erode));
+
+        packed_binary_image packed, packed_out;
+        pack_binary_image(img, packed);
+        DLIB_TEST(packed.nr() == img.nr() && packed.nc() == img.nc());
+
+        binary_dilation(packed, packed_out, se);
+        unpack_binary_image(packed_out, out);
+        DLIB_TEST(mat(out) == mat(truth_dilate));
+        binary_erosion(packed, packed_out, se);
+        unpack_binary_image(packed_out, out);
+        DLIB_TEST(mat(out) == mat(truth_erode));
+
+        array2d<unsigned char> temp, truth;
+        binary_open(img, truth, se, 2);
+        binary_open(packed, packed_out, se, 2);
+        unpack_binary_image(packed_out, out);
+        DLIB_TEST(mat(out) == mat(truth));
+        binary_close(img, truth, se, 2);
+        binary_close(packed, packed_out, se, 2);
+        unpack_binary_image(packed_out, out);
+        DLIB_TEST(mat(out) == mat(truth));
+
+        if (!random_se)
+        {
+            binary_dilation(packed, packed_out, M, N);
+            unpack_binary_image(packed_out, out);
+            DLIB_TEST(mat(out) == mat(truth_dilate));
+            binary_erosion(packed, packed_out, M, N);
+            unpack_binary_image(packed_out, out);
+            DLIB_TEST(mat(out) == mat(truth_erode));
+
+            binary_open(img, truth, se, 2);
+            binary_open(packed, packed_out, M, N, 2);
+            unpack_binary_image(packed_out, out);
+            DLIB_TEST(mat(out) == mat(truth));
+            binary_close(img, truth, se, 2);
+            binary_close(packed, packed_out, M, N, 2);
+            unpack_binary_image(packed_out, out);
+            DLIB_TEST(mat(out) == mat(truth));
+        }
+    }
+
+    void test_binary_morphology (
+    )
+    {
+        print_spinner();
+        dlib::rand rnd;
+        array2d<unsigned char> img;
+        for (int iter = 0; iter < 40; ++iter)
+        {
+            // Cover widths on both sides of the 64 pixel word boundaries.
+            img.set_size(rnd.get_random_32bit_number()%50+1, rnd.get_random_32bit_number()%200+1);
+            const double density = rnd.get_random_double();
+            for (long r = 0; r < img.nr(); ++r)
+                for (long c = 0; c < img.nc(); ++c)
+                    img[r][c] = rnd.get_random_double() < density ? on_pixel : off_pixel;
+
+            test_binary_morphology<1,1>(rnd, img, false);
+            test_binary_morphology<3,3>(rnd, img, false);
+            test_binary_morphology<5,7>(rnd, img, false);
+            test_binary_morphology<9,1>(rnd, img, false);
+            test_binary_morphology<1,131>(rnd, img, false);
+            test_binary_morphology<3,5>(rnd, img, true);
+            test_binary_morphology<7,7>(rnd, img, true);
+        }
+
+        packed_binary_image packed(3,70);
+        DLIB_TEST(packed.words_per_row() == 2);
+        DLIB_TEST(packed(2,69) == false);
+        packed.set(2,69,true);
+        packed.set(0,1,true);
+        DLIB_TEST(packed(2,69) == true && packed(0,1) == true && packed(0,0) == false);
+        packed.set(0,1,false);
+        DLIB_TEST(packed(0,1) == false);
+        unpack_binary_image(packed, img);
+        DLIB_TEST(img.nr() == 3 && img.nc() == 70);
+        DLIB_TEST(img[2][69] == on_pixel && sum(matrix_cast<long>(mat(img))) == 255);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1479,6 +1892,65 @@ namespace
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename T>
+    void test_segment_image_threaded()
+    {
+        print_spinner();
+        dlib::rand rnd;
+        array2d<T> img(67,53);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                // smooth blobs plus noise, quantized so there are lots of tied edges.
+                const double val = 100 + 60*std::sin(r/7.0)*std::cos(c/9.0) + rnd.get_random_gaussian()*10;
+                assign_pixel(img[r][c], static_cast<int>(val)/4*4);
+            }
+        }
+
+        array2d<unsigned long> out1, out2;
+        segment_image(img, out1, 100, 5);
+
+        const segmentation_edges<T> graph(img, 3);
+        DLIB_TEST(graph.nr() == img.nr() && graph.nc() == img.nc());
+        // The edges, including the order of tied edges, must not depend on the number of
+        // threads used to find and sort them.
+        const segmentation_edges<T> graph1(img, 1);
+        for (unsigned long num_threads = 2; num_threads <= 9; num_threads += 3)
+        {
+            const segmentation_edges<T> graphn(img, num_threads);
+            DLIB_TEST(graph1.get_sorted_edges().size() == graphn.get_sorted_edges().size());
+            for (unsigned long i = 0; i < graph1.get_sorted_edges().size(); ++i)
+            {
+                const typename segmentation_edges<T>::edge_type& a = graph1.get_sorted_edges()[i];
+                const typename segmentation_edges<T>::edge_type& b = graphn.get_sorted_edges()[i];
+                DLIB_TEST(a.idx1 == b.idx1 && a.idx2 == b.idx2 && a.diff == b.diff);
+            }
+        }
+        for (unsigned long num_threads = 2; num_threads <= 5; ++num_threads)
+        {
+            segment_image(img, out2, 100, 5, num_threads);
+            DLIB_TEST(mat(out1) == mat(out2));
+        }
+        segment_image(graph, out2, 100, 5);
+        DLIB_TEST(mat(out1) == mat(out2));
+
+        std::vector<rectangle> rects1, rects2, rects3;
+        find_candidate_object_locations(img, rects1, linspace(20,200,4), 10, 20);
+        DLIB_TEST(rects1.size() > 1);
+        find_candidate_object_locations(img, rects2, linspace(20,200,4), 10, 20, 3);
+        DLIB_TEST(rects1 == rects2);
+        find_candidate_object_locations(graph, rects3, linspace(20,200,4), 10, 20, 2);
+        DLIB_TEST(rects1 == rects3);
+        rects3.clear();
+        find_candidate_object_locations(graph, rects3);
+        rects2.clear();
+        find_candidate_object_locations(img, rects2);
+        DLIB_TEST(rects2 == rects3);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <typename T>
@@ -1729,6 +2201,76 @@ namespace
         }
     }
 
+    void run_hough_test_sparse()
+    {
+        dlib::rand rnd;
+        for (int k = -2; k <= 2; ++k)
+        {
+            print_spinner();
+            hough_transform ht(100+k);
+            const rectangle box = translate_rect(get_rect(ht),point(10,20));
+
+            // Random weighted edge pixels, some of which fall outside box.
+            array2d<unsigned char> img(140,130);
+            assign_all_pixels(img, 0);
+            std::vector<point> pts;
+            for (int i = 0; i < 400; ++i)
+            {
+                const point p(rnd.get_random_32bit_number()%img.nc(), rnd.get_random_32bit_number()%img.nr());
+                if (img[p.y()][p.x()] != 0)
+                    continue;
+                img[p.y()][p.x()] = rnd.get_random_8bit_number()%255 + 1;
+                pts.push_back(p);
+            }
+
+            array2d<int> himg1, himg4;
+            ht(img, box, himg1);
+            ht(img, box, himg4, 4);
+            DLIB_TEST(mat(himg1) == mat(himg4));
+
+            // Floating point accumulators can round differently than a raster order sum
+            // would, but they still can't depend on the number of threads.
+            array2d<float> fimg(img.nr(), img.nc());
+            for (long r = 0; r < img.nr(); ++r)
+                for (long c = 0; c < img.nc(); ++c)
+                    fimg[r][c] = img[r][c]*0.1f;
+            array2d<float> fhimg1, fhimg4;
+            array2d<double> dhimg;
+            ht(fimg, box, fhimg1);
+            ht(fimg, box, fhimg4, 4);
+            ht(fimg, box, dhimg);
+            DLIB_TEST(mat(fhimg1) == mat(fhimg4));
+            DLIB_TEST(max(abs(matrix_cast<double>(mat(fhimg1)) - mat(dhimg))) < 1e-3);
+
+            // Binarize img so the sparse version sees the same votes.
+            for (long r = 0; r < img.nr(); ++r)
+                for (long c = 0; c < img.nc(); ++c)
+                    img[r][c] = img[r][c] ? 1 : 0;
+            ht(img, box, himg1);
+            ht(pts, box, himg4, 3);
+            DLIB_TEST(mat(himg1) == mat(himg4));
+            ht(pts, box, himg4);
+            DLIB_TEST(mat(himg1) == mat(himg4));
+
+            // Every point inside box votes exactly once for each angle.
+            long num_inside = 0;
+            for (unsigned long i = 0; i < pts.size(); ++i)
+                if (box.contains(pts[i]))
+                    ++num_inside;
+            for (long t = 0; t < himg4.nc(); ++t)
+                DLIB_TEST(sum(colm(mat(himg4),t)) == num_inside);
+
+            // A single point votes once for each angle and get_best_hough_point() walks
+            // along exactly those bins, returning the first one.
+            std::vector<point> one(1, box.tl_corner() + point(rnd.get_random_32bit_number()%ht.size(), 5));
+            ht(one, box, himg1, 2);
+            DLIB_TEST(sum(mat(himg1)) == (long)ht.size());
+            const point best = ht.get_best_hough_point(one[0]-box.tl_corner(), himg1);
+            DLIB_TEST(best.x() == 0);
+            DLIB_TEST(himg1[best.y()][best.x()] == 1);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     void test_extract_image_chips()
@@ -1775,6 +2317,76 @@ namespace
 
 
 
+        {
+            // The fast version of chip extraction used for unsigned char and rgb_pixel
+            // images should match the generic version.  Also check that the
+            // multi-threaded version gives the same results.
+            array2d<unsigned char> img(200,230);
+            array2d<rgb_pixel> rgb_img(200,230);
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                for (long c = 0; c < img.nc(); ++c)
+                {
+                    img[r][c] = rnd.get_random_8bit_number();
+                    assign_pixel(rgb_img[r][c], img[r][c]);
+                }
+            }
+
+            std::vector<chip_details> dets;
+            for (int i = 0; i < 40; ++i)
+            {
+                const drectangle rect = centered_drect(dpoint(rnd.get_random_double()*300-35, rnd.get_random_double()*250-25),
+                    rnd.get_random_double()*150+5, rnd.get_random_double()*150+5);
+                dets.push_back(chip_details(rect, chip_dims(rnd.get_random_32bit_number()%50+1, 
+                                                            rnd.get_random_32bit_number()%50+1),
+                                            rnd.get_random_double()*2*pi));
+            }
+            dets.push_back(chip_details(rectangle(10,10,40,30)));
+
+            dlib::array<matrix<unsigned char> > chips, chips2;
+            dlib::array<matrix<rgb_pixel> > rgb_chips;
+            dlib::array<matrix<float> > ref_chips;
+            extract_image_chips(img, dets, chips);
+            extract_image_chips(img, dets, chips2, 3);
+            extract_image_chips(rgb_img, dets, rgb_chips, 2);
+            extract_image_chips(img, dets, ref_chips);
+            DLIB_TEST(chips.size() == dets.size());
+            for (unsigned long i = 0; i < dets.size(); ++i)
+            {
+                DLIB_TEST(chips[i].nr() == (long)dets[i].rows && chips[i].nc() == (long)dets[i].cols);
+                DLIB_TEST(chips[i] == chips2[i]);
+                DLIB_TEST(max(abs(matrix_cast<float>(chips[i]) - floor(ref_chips[i]))) <= 1);
+                // The fast warp should give exactly what transform_image() gives.
+                const point_transform_affine tform = inv(get_mapping_to_chip(chip_details(dets[i].rect, chip_dims(60,70), dets[i].angle)));
+                matrix<unsigned char> fast(60,70), slow(60,70);
+                matrix<rgb_pixel> rgb_fast(60,70), rgb_slow(60,70);
+                impl::warp_image_chip(img, fast, tform);
+                transform_image(img, slow, interpolate_bilinear(), tform);
+                impl::warp_image_chip(rgb_img, rgb_fast, tform);
+                transform_image(rgb_img, rgb_slow, interpolate_bilinear(), tform);
+                DLIB_TEST(fast == slow);
+                bool rgb_same = true;
+                for (long r = 0; r < rgb_fast.nr(); ++r)
+                {
+                    for (long c = 0; c < rgb_fast.nc(); ++c)
+                    {
+                        rgb_same = rgb_same && rgb_fast(r,c).red == rgb_slow(r,c).red &&
+                            rgb_fast(r,c).green == rgb_slow(r,c).green && rgb_fast(r,c).blue == rgb_slow(r,c).blue;
+                    }
+                }
+                DLIB_TEST(rgb_same);
+                for (long r = 0; r < chips[i].nr(); ++r)
+                {
+                    for (long c = 0; c < chips[i].nc(); ++c)
+                    {
+                        DLIB_TEST(rgb_chips[i](r,c).red == chips[i](r,c));
+                        DLIB_TEST(rgb_chips[i](r,c).green == chips[i](r,c));
+                        DLIB_TEST(rgb_chips[i](r,c).blue == chips[i](r,c));
+                    }
+                }
+            }
+        }
+
         // Test the rotation ability of extract_image_chip().  Do this by drawing a line and
         // then rotating it so it's horizontal.  Check that it worked correctly by hough
         // transforming it.
@@ -1812,6 +2424,236 @@ namespace
 
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void test_resize_image_modes (
+        dlib::rand& rnd
+    )
+    {
+        // Shrinking by an integer factor with area averaging gives the block means.
+        matrix<unsigned char> img(40,60), small(20,30);
+        for (long r = 0; r < img.nr(); ++r)
+            for (long c = 0; c < img.nc(); ++c)
+                img(r,c) = rnd.get_random_8bit_number();
+        resize_image(img, small, interpolate_area());
+        for (long r = 0; r < small.nr(); ++r)
+        {
+            for (long c = 0; c < small.nc(); ++c)
+            {
+                const int sum = img(2*r,2*c) + img(2*r+1,2*c) + img(2*r,2*c+1) + img(2*r+1,2*c+1);
+                DLIB_TEST(std::abs(small(r,c) - sum/4.0) <= 0.5);
+            }
+        }
+
+        matrix<float> fimg = matrix_cast<float>(img), fsmall(13,20);
+        resize_image(fimg, fsmall, interpolate_area());
+        DLIB_TEST(std::abs(mean(fsmall) - mean(fimg)) < 1e-3);
+
+        // Constant images stay constant for any size and method.
+        matrix<rgb_pixel> cimg(37,51), cout1(13,101), cout2(80,20);
+        assign_all_pixels(cimg, rgb_pixel(10,200,255));
+        resize_image(cimg, cout1, interpolate_area());
+        resize_image(cimg, cout2, interpolate_lanczos3());
+        for (long r = 0; r < cout1.nr(); ++r)
+            for (long c = 0; c < cout1.nc(); ++c)
+                DLIB_TEST(pixel_to_vector<int>(cout1(r,c)) == pixel_to_vector<int>(cimg(0,0)));
+        for (long r = 0; r < cout2.nr(); ++r)
+            for (long c = 0; c < cout2.nc(); ++c)
+                DLIB_TEST(pixel_to_vector<int>(cout2(r,c)) == pixel_to_vector<int>(cimg(0,0)));
+
+        // The number of threads doesn't change the output.
+        matrix<rgb_pixel> rgb(45,70), out1(31,23), out2(31,23);
+        for (long r = 0; r < rgb.nr(); ++r)
+            for (long c = 0; c < rgb.nc(); ++c)
+                rgb(r,c) = rgb_pixel(rnd.get_random_8bit_number(), rnd.get_random_8bit_number(), rnd.get_random_8bit_number());
+        resize_image(rgb, out1, interpolate_lanczos3());
+        resize_image(rgb, out2, interpolate_lanczos3(), 4);
+        for (long r = 0; r < out1.nr(); ++r)
+            for (long c = 0; c < out1.nc(); ++c)
+                DLIB_TEST(pixel_to_vector<int>(out1(r,c)) == pixel_to_vector<int>(out2(r,c)));
+
+        matrix<unsigned char> big1(90,130), big2(90,130);
+        resize_image(img, big1, interpolate_area());
+        resize_image(img, big2, interpolate_area(), 3);
+        DLIB_TEST(big1 == big2);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_scaled_jpeg_loading (
+    )
+    {
+#ifdef DLIB_JPEG_SUPPORT
+        print_spinner();
+        matrix<rgb_pixel> img(67,101);
+        for (long r = 0; r < img.nr(); ++r)
+            for (long c = 0; c < img.nc(); ++c)
+                img(r,c) = rgb_pixel(r*3, c*2, 100);
+        save_jpeg(img, "test.jpg", 95);
+
+        // Decoding straight into the image must give the same pixels as jpeg_loader.
+        matrix<rgb_pixel> rgb1, rgb2;
+        matrix<unsigned char> gray1, gray2;
+        matrix<float> fimg;
+        jpeg_loader("test.jpg").get_image(rgb1);
+        jpeg_loader("test.jpg").get_image(gray1);
+        load_jpeg(rgb2, "test.jpg");
+        load_jpeg(gray2, "test.jpg");
+        load_jpeg(fimg, "test.jpg");
+        DLIB_TEST(rgb2.nr() == 67 && rgb2.nc() == 101);
+        DLIB_TEST(gray1 == gray2);
+        DLIB_TEST(matrix_cast<float>(gray1) == fimg);
+        for (long r = 0; r < rgb1.nr(); ++r)
+            for (long c = 0; c < rgb1.nc(); ++c)
+                DLIB_TEST(pixel_to_vector<int>(rgb1(r,c)) == pixel_to_vector<int>(rgb2(r,c)));
+
+        // Scaled decoding rounds the image size up and approximates a shrunken image.
+        for (unsigned long scale = 2; scale <= 8; scale *= 2)
+        {
+            matrix<unsigned char> small, ref((67+scale-1)/scale, (101+scale-1)/scale);
+            load_jpeg(small, "test.jpg", scale);
+            DLIB_TEST(small.nr() == ref.nr());
+            DLIB_TEST(small.nc() == ref.nc());
+            resize_image(gray1, ref, interpolate_area());
+            DLIB_TEST_MSG(max(abs(matrix_cast<int>(small) - matrix_cast<int>(ref))) < 20, scale);
+        }
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    std::vector<unsigned char> read_file_bytes (
+        const std::string& file_name
+    )
+    {
+        std::ifstream fin(file_name.c_str(), std::ios::binary);
+        return std::vector<unsigned char>((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    }
+
+    template <typename pixel_type>
+    void test_png_round_trip (
+        dlib::rand& rnd,
+        int compression_level,
+        png_filter filter
+    )
+    {
+#ifdef DLIB_PNG_SUPPORT
+        matrix<pixel_type> img(20+rnd.get_random_32bit_number()%30, 20+rnd.get_random_32bit_number()%30);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                rgb_alpha_pixel p(rnd.get_random_8bit_number(), r, c, 255-r);
+                assign_pixel(img(r,c), p);
+                if (is_same_type<pixel_type,uint16>::value)
+                    assign_pixel(img(r,c), rnd.get_random_16bit_number());
+            }
+        }
+        save_png(img, "test.png", compression_level, filter);
+
+        // load_png() decodes straight into the image so it must match the png_loader.
+        matrix<pixel_type> img2, img3;
+        load_png(img2, "test.png");
+        png_loader("test.png").get_image(img3);
+        DLIB_TEST(img2.nr() == img.nr() && img2.nc() == img.nc());
+        DLIB_TEST(img3.nr() == img.nr() && img3.nc() == img.nc());
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                DLIB_TEST(pixel_to_vector<int>(img(r,c)) == pixel_to_vector<int>(img2(r,c)));
+                DLIB_TEST(pixel_to_vector<int>(img(r,c)) == pixel_to_vector<int>(img3(r,c)));
+            }
+        }
+
+        // and also when the pixels have to be converted
+        matrix<float> f1, f2;
+        load_png(f1, "test.png");
+        png_loader("test.png").get_image(f2);
+        DLIB_TEST(f1 == f2);
+#endif
+    }
+
+    void test_png_options (
+        dlib::rand& rnd
+    )
+    {
+#ifdef DLIB_PNG_SUPPORT
+        print_spinner();
+        const png_filter filters[] = {png_filter_adaptive, png_filter_none, png_filter_sub,
+                                      png_filter_up, png_filter_average, png_filter_paeth};
+        for (int level = 0; level <= 9; level += 3)
+        {
+            for (int i = 0; i < 6; ++i)
+            {
+                test_png_round_trip<unsigned char>(rnd, level, filters[i]);
+                test_png_round_trip<uint16>(rnd, level, filters[i]);
+                test_png_round_trip<rgb_pixel>(rnd, level, filters[i]);
+                test_png_round_trip<rgb_alpha_pixel>(rnd, level, filters[i]);
+            }
+        }
+
+        // A smooth image must compress and a higher level can't make it bigger.
+        matrix<unsigned char> img(200,200);
+        for (long r = 0; r < img.nr(); ++r)
+            for (long c = 0; c < img.nc(); ++c)
+                img(r,c) = (r/10 + c/10)%2 ? 255 : 0;
+        save_png(img, "test.png", 0, png_filter_none);
+        const size_t size0 = read_file_bytes("test.png").size();
+        save_png(img, "test.png", 1, png_filter_none);
+        const size_t size1 = read_file_bytes("test.png").size();
+        save_png(img, "test.png", 9);
+        const size_t size9 = read_file_bytes("test.png").size();
+        DLIB_TEST((long)size0 > img.size());
+        DLIB_TEST(size1 < size0/10);
+        DLIB_TEST(size9 <= size1);
+#endif
+    }
+
+    void test_load_image_from_memory (
+    )
+    {
+        print_spinner();
+        matrix<rgb_pixel> img(31,45);
+        for (long r = 0; r < img.nr(); ++r)
+            for (long c = 0; c < img.nc(); ++c)
+                img(r,c) = rgb_pixel(r*5, c*3, r+c);
+
+        std::vector<std::string> files;
+        save_bmp(img, "test.bmp");  files.push_back("test.bmp");
+        save_dng(img, "test.dng");  files.push_back("test.dng");
+#ifdef DLIB_PNG_SUPPORT
+        save_png(img, "test.png");  files.push_back("test.png");
+#endif
+#ifdef DLIB_JPEG_SUPPORT
+        save_jpeg(img, "test.jpg"); files.push_back("test.jpg");
+#endif
+        for (unsigned long i = 0; i < files.size(); ++i)
+        {
+            const std::vector<unsigned char> bytes = read_file_bytes(files[i]);
+            matrix<rgb_pixel> from_file, from_mem;
+            load_image(from_file, files[i]);
+            load_image(from_mem, &bytes[0], bytes.size());
+            DLIB_TEST(from_mem.nr() == img.nr() && from_mem.nc() == img.nc());
+            for (long r = 0; r < img.nr(); ++r)
+                for (long c = 0; c < img.nc(); ++c)
+                    DLIB_TEST(pixel_to_vector<int>(from_file(r,c)) == pixel_to_vector<int>(from_mem(r,c)));
+
+            // Data that ends inside the header must be reported as an error rather than
+            // read past the end.
+            bool threw = false;
+            try { load_image(from_mem, &bytes[0], 20); }
+            catch (image_load_error&) { threw = true; }
+            DLIB_TEST_MSG(threw, files[i]);
+        }
+
+        bool threw = false;
+        const unsigned char junk[] = "not an image";
+        try { load_image(img, junk, sizeof(junk)); }
+        catch (image_load_error&) { threw = true; }
+        DLIB_TEST(threw);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class image_tester : public tester
@@ -1828,6 +2670,7 @@ namespace
         {
             image_test();
             run_hough_test();
+            run_hough_test_sparse();
             test_extract_image_chips();
             test_integral_image<long, unsigned char>();
             test_integral_image<double, int>();
@@ -1847,6 +2690,8 @@ namespace
 
             test_label_connected_blobs();
             test_label_connected_blobs2();
+            test_label_connected_blobs3();
+            test_binary_morphology();
             test_downsampled_filtering();
 
             test_segment_image<unsigned char>();
@@ -1855,6 +2700,10 @@ namespace
             test_segment_image<int>();
             test_segment_image<rgb_pixel>();
             test_segment_image<rgb_alpha_pixel>();
+            test_segment_image_threaded<unsigned char>();
+            test_segment_image_threaded<unsigned short>();
+            test_segment_image_threaded<double>();
+            test_segment_image_threaded<rgb_pixel>();
 
             test_dng_floats<float>(1);
             test_dng_floats<double>(1);
@@ -1874,6 +2723,16 @@ namespace
                 test_filtering2(5,5,rnd);
                 test_filtering2(7,7,rnd);
             }
+            test_fft_filtering(31,31,rnd);
+            test_fft_filtering(41,9,rnd);
+            test_fft_filtering(61,75,rnd);
+            test_threaded_separable_filtering(57,83,rnd);
+            test_threaded_separable_filtering(9,7,rnd);
+            test_threaded_separable_filtering(1,30,rnd);
+            test_resize_image_modes(rnd);
+            test_scaled_jpeg_loading();
+            test_load_image_from_memory();
+            test_png_options(rnd);
 
             for (int i = 0; i < 100; ++i)
                 test_filtering_center<float>(rnd);
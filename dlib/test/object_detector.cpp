@@ -430,6 +430,114 @@ namespace
             DLIB_TEST(d1.size() == d2.size());
             DLIB_TEST(set_intersection_size(d1,d2) == d1.size());
         }
+
+        {
+            // Multi-threaded detection should give exactly the same outputs.
+            image_scanner_type threaded_scanner;
+            threaded_scanner.copy_configuration(detector.get_scanner());
+            threaded_scanner.set_num_threads(4);
+            DLIB_TEST(threaded_scanner.get_num_threads() == 4);
+            object_detector<image_scanner_type> threaded_detector(threaded_scanner, detector.get_overlap_tester(), detector.get_w());
+
+            std::vector<std::vector<rectangle> > batch_dets = batch_detect(detector, images, 3);
+            std::vector<std::vector<rectangle> > batch_dets2 = batch_detect(threaded_detector, images, 2);
+            DLIB_TEST(batch_dets.size() == images.size());
+            DLIB_TEST(batch_dets2.size() == images.size());
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                std::vector<std::pair<double, rectangle> > dets1, dets2;
+                detector(images[i], dets1, -0.5);
+                threaded_detector(images[i], dets2, -0.5);
+                DLIB_TEST(dets1.size() > 0);
+                DLIB_TEST(dets1 == dets2);
+                DLIB_TEST(batch_dets[i] == detector(images[i]));
+                DLIB_TEST(batch_dets2[i] == batch_dets[i]);
+            }
+        }
+
+        {
+            // Running on video frames should give exactly the same outputs as running on
+            // each frame from scratch.
+            fhog_video_state<unsigned char> state;
+            std::vector<rect_detection> dets1;
+            std::vector<std::pair<double, rectangle> > dets2;
+            array2d<unsigned char> frame;
+            for (int iter = 0; iter < 7; ++iter)
+            {
+                if (iter == 3)
+                    assign_image(frame, images[1]);
+                else
+                    assign_image(frame, images[0]);
+                if (iter == 2 || iter == 5)
+                    fill_rect(frame, rectangle(10,10,30,20), 200);
+
+                detect_in_video_frame(detector, frame, state, dets1, -0.5);
+                if (iter == 0)
+                    DLIB_TEST(state.get_fraction_recomputed() == 1);
+                else if (iter == 1)
+                    DLIB_TEST(state.get_fraction_recomputed() == 0);
+                else if (iter == 3 || iter == 4)
+                    DLIB_TEST(state.get_fraction_recomputed() > 0);
+                else
+                    DLIB_TEST(0 < state.get_fraction_recomputed() && state.get_fraction_recomputed() < 1);
+
+                detector(frame, dets2, -0.5);
+                DLIB_TEST(dets1.size() > 0);
+                DLIB_TEST(dets1.size() == dets2.size());
+                for (unsigned long i = 0; i < dets1.size() && i < dets2.size(); ++i)
+                {
+                    DLIB_TEST(dets1[i].detection_confidence == dets2[i].first);
+                    DLIB_TEST(dets1[i].rect == dets2[i].second);
+                }
+                DLIB_TEST(detect_in_video_frame(detector, frame, state) == detector(frame));
+                DLIB_TEST(state.get_fraction_recomputed() == 0);
+            }
+        }
+
+        {
+            // With a change threshold, a region that changes a little on every frame
+            // must still get its features recomputed once it has drifted far enough from
+            // the pixels they were computed from.
+            const image_scanner_type& sc = detector.get_scanner();
+            fhog_video_state<unsigned char> state(10);
+            dlib::rand rnd;
+            array2d<unsigned char> base, frame;
+            assign_image(base, images[0]);
+            // Align the region to the cell grid so all its cells change at once.
+            const rectangle region(48,48,127,127);
+            for (long r = region.top(); r <= region.bottom(); ++r)
+                for (long c = region.left(); c <= region.right(); ++c)
+                    base[r][c] = rnd.get_random_8bit_number()/2;
+
+            dlib::array<array2d<float> > hog;
+            for (int iter = 0; iter < 41; ++iter)
+            {
+                print_spinner();
+                assign_image(frame, base);
+                for (long r = region.top(); r <= region.bottom(); ++r)
+                    for (long c = region.left(); c <= region.right(); ++c)
+                        frame[r][c] += 3*iter;
+
+                const dlib::array<dlib::array<array2d<float> > >& feats = state.update(sc, frame);
+                extract_fhog_features(frame, hog, sc.get_cell_size(), sc.get_fhog_window_height(), sc.get_fhog_window_width());
+                DLIB_TEST(feats[0].size() == hog.size());
+                float diff = 0;
+                for (unsigned long k = 0; k < hog.size(); ++k)
+                    diff = std::max(diff, max(abs(mat(feats[0][k]) - mat(hog[k]))));
+
+                // Each frame changes the region by 3 so every 4th frame it has changed by
+                // more than the threshold since the features were last computed.
+                if (iter%4 == 0)
+                {
+                    DLIB_TEST(state.get_fraction_recomputed() > 0);
+                    DLIB_TEST_MSG(diff == 0, "iter: " << iter << "  diff: " << diff);
+                }
+                else
+                {
+                    DLIB_TEST_MSG(diff > 0, "iter: " << iter);
+                }
+            }
+        }
     }
 
 // ----------------------------------------------------------------------------------------
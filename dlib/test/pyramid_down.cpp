@@ -304,6 +304,133 @@ void test_pyramid_down_small_sizes()
     }
 }
 
+// ----------------------------------------------------------------------------------------
+
+template <typename pyramid_down_type>
+void test_pyramid_down_fast_paths()
+{
+    // pyramid_down<2> and pyramid_down<3> have special code paths for unsigned char,
+    // float, and rgb_pixel images.  Make sure they give exactly the same outputs as the
+    // generic code, which we can get at by using a different output pixel type.
+    pyramid_down_type pyr;
+    dlib::rand rnd;
+    for (int iter = 0; iter < 40; ++iter)
+    {
+        const long nr = 9 + rnd.get_random_32bit_number()%60;
+        const long nc = 9 + rnd.get_random_32bit_number()%60;
+        array2d<unsigned char> img8(nr,nc), down8;
+        array2d<float> imgf(nr,nc), downf;
+        array2d<rgb_pixel> imgrgb(nr,nc), downrgb;
+        for (long r = 0; r < nr; ++r)
+        {
+            for (long c = 0; c < nc; ++c)
+            {
+                img8[r][c] = rnd.get_random_8bit_number();
+                imgf[r][c] = rnd.get_random_gaussian()*100;
+                imgrgb[r][c] = rgb_pixel(rnd.get_random_8bit_number(),
+                                         rnd.get_random_8bit_number(),
+                                         rnd.get_random_8bit_number());
+            }
+        }
+
+        array2d<int> down8_ref;
+        array2d<double> downf_ref;
+        array2d<bgr_pixel> downrgb_ref;
+        pyr(img8, down8);
+        pyr(img8, down8_ref);
+        pyr(imgf, downf);
+        pyr(imgf, downf_ref);
+        pyr(imgrgb, downrgb);
+        pyr(imgrgb, downrgb_ref);
+
+        DLIB_TEST(down8.nr() == down8_ref.nr() && down8.nc() == down8_ref.nc());
+        DLIB_TEST(downf.nr() == downf_ref.nr() && downf.nc() == downf_ref.nc());
+        DLIB_TEST(downrgb.nr() == downrgb_ref.nr() && downrgb.nc() == downrgb_ref.nc());
+        for (long r = 0; r < down8.nr(); ++r)
+        {
+            for (long c = 0; c < down8.nc(); ++c)
+            {
+                DLIB_TEST(down8[r][c] == down8_ref[r][c]);
+                DLIB_TEST(downf[r][c] == (float)downf_ref[r][c]);
+                DLIB_TEST(downrgb[r][c].red == downrgb_ref[r][c].red);
+                DLIB_TEST(downrgb[r][c].green == downrgb_ref[r][c].green);
+                DLIB_TEST(downrgb[r][c].blue == downrgb_ref[r][c].blue);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <typename pyramid_down_type>
+void test_tiled_pyramid()
+{
+    pyramid_down_type pyr;
+    dlib::rand rnd;
+
+    // make sure we know what size image the pyramid outputs
+    for (long nr = 0; nr < 30; ++nr)
+    {
+        for (long nc = 0; nc < 30; nc += 3)
+        {
+            array2d<unsigned char> img(nr,nc), down;
+            assign_all_pixels(img, 0);
+            pyr(img, down);
+            long out_nr, out_nc;
+            impl::pyramid_down_size(pyr, nr, nc, out_nr, out_nc);
+            DLIB_TEST(out_nr*out_nc == (long)down.size());
+            if (down.size() != 0)
+            {
+                DLIB_TEST(out_nr == down.nr());
+                DLIB_TEST(out_nc == down.nc());
+            }
+        }
+    }
+
+    for (int iter = 0; iter < 5; ++iter)
+    {
+        matrix<rgb_pixel> img(100+rnd.get_random_32bit_number()%200, 100+rnd.get_random_32bit_number()%200);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                img(r,c) = rgb_pixel(rnd.get_random_8bit_number(),
+                                     rnd.get_random_8bit_number(),
+                                     rnd.get_random_8bit_number());
+            }
+        }
+
+        matrix<rgb_pixel> tiled;
+        std::vector<rectangle> rects;
+        create_tiled_pyramid<pyramid_down_type>(img, tiled, rects);
+        DLIB_TEST(rects.size() > 1);
+        DLIB_TEST(rects[0] == get_rect(img));
+
+        // Each level in the tiled image should be exactly what we get by calling pyr
+        // repeatedly.
+        matrix<rgb_pixel> level = img, temp;
+        for (unsigned long i = 0; i < rects.size(); ++i)
+        {
+            if (i != 0)
+            {
+                pyr(level, temp);
+                level.swap(temp);
+            }
+            DLIB_TEST(get_rect(tiled).contains(rects[i]));
+            DLIB_TEST((long)rects[i].width() == level.nc() && (long)rects[i].height() == level.nr());
+            for (long r = 0; r < level.nr(); ++r)
+            {
+                for (long c = 0; c < level.nc(); ++c)
+                {
+                    const rgb_pixel a = level(r,c);
+                    const rgb_pixel b = tiled(rects[i].top()+r, rects[i].left()+c);
+                    DLIB_TEST(a.red == b.red && a.green == b.green && a.blue == b.blue);
+                }
+            }
+        }
+    }
+}
+
 // ----------------------------------------------------------------------------------------
 
 
@@ -338,6 +465,15 @@ void test_pyramid_down_small_sizes()
             dlog << LINFO << "call test_pyramid_down_small_sizes<pyramid_down<9> >();";
             test_pyramid_down_small_sizes<pyramid_down<9> >();
 
+            print_spinner();
+            test_pyramid_down_fast_paths<pyramid_down<2> >();
+            test_pyramid_down_fast_paths<pyramid_down<3> >();
+            print_spinner();
+            test_tiled_pyramid<pyramid_down<2> >();
+            test_tiled_pyramid<pyramid_down<3> >();
+            test_tiled_pyramid<pyramid_down<4> >();
+            test_tiled_pyramid<pyramid_down<6> >();
+
             print_spinner();
             dlog << LINFO << "call test_pyramid_down_rgb2<pyramid_down<2> >();";
             test_pyramid_down_rgb2<pyramid_down<2> >();
@@ -0,0 +1,125 @@
+// The contents of this file are in the public domain. See LICENSE_FOR_EXAMPLE_PROGRAMS.txt
+/*
+    This program measures the throughput of dlib's extract_fhog_features().  It
+    extracts FHOG features from a random grayscale and a random RGB image into both
+    the planar and the interleaved feature image layouts and prints the average time
+    per call.  For example, to time a 1920x1080 image with 8x8 pixel cells you would
+    run:
+        ./fhog_benchmark --size 1920 1080 --cell-size 8
+*/
+
+#include <dlib/image_transforms.h>
+#include <dlib/cmd_line_parser.h>
+#include <dlib/rand.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+template <typename image_type, typename hog_type>
+double time_fhog (
+    const image_type& img,
+    hog_type& hog,
+    int cell_size,
+    int iters
+)
+/*!
+    ensures
+        - returns the average number of milliseconds extract_fhog_features(img,hog,cell_size)
+          takes.
+!*/
+{
+    // warm up the caches and allocate hog.
+    extract_fhog_features(img, hog, cell_size);
+    const auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+        extract_fhog_features(img, hog, cell_size);
+    const auto stop = chrono::high_resolution_clock::now();
+    return chrono::duration<double,milli>(stop-start).count()/iters;
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <typename image_type>
+void run_benchmarks (
+    const string& name,
+    const image_type& img,
+    int cell_size,
+    int iters
+)
+{
+    dlib::array<array2d<float> > planar;
+    array2d<matrix<float,31,1> > interleaved;
+    const double planar_time = time_fhog(img, planar, cell_size, iters);
+    const double interleaved_time = time_fhog(img, interleaved, cell_size, iters);
+
+    cout << setw(6) << name << ":  planar " << setw(8) << planar_time << " ms"
+         << ",  interleaved " << setw(8) << interleaved_time << " ms" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        command_line_parser parser;
+        parser.add_option("h","Display this help message.");
+        parser.add_option("size","Size of the input image.  (default: 1920 1080)",2);
+        parser.add_option("cell-size","Size of the FHOG cells in pixels. (default: 8)",1);
+        parser.add_option("iters","Number of timed calls for each layout. (default: 20)",1);
+        parser.parse(argc, argv);
+
+        const char* one_time_opts[] = {"h", "size", "cell-size", "iters"};
+        parser.check_one_time_options(one_time_opts);
+        parser.check_option_arg_range("cell-size", 1, 1000);
+        parser.check_option_arg_range("iters", 1, 1000000);
+
+        if (parser.option("h"))
+        {
+            cout << "Usage: fhog_benchmark [options]\n";
+            parser.print_options();
+            return 0;
+        }
+
+        long nc = 1920, nr = 1080;
+        if (parser.option("size"))
+        {
+            nc = string_cast<long>(parser.option("size").argument(0));
+            nr = string_cast<long>(parser.option("size").argument(1));
+        }
+        const int cell_size = get_option(parser, "cell-size", 8);
+        const int iters = get_option(parser, "iters", 20);
+
+        dlib::rand rnd;
+        matrix<unsigned char> gray(nr, nc);
+        matrix<rgb_pixel> rgb(nr, nc);
+        for (long r = 0; r < nr; ++r)
+        {
+            for (long c = 0; c < nc; ++c)
+            {
+                gray(r,c) = rnd.get_random_8bit_number();
+                rgb(r,c) = rgb_pixel(rnd.get_random_8bit_number(),
+                                     rnd.get_random_8bit_number(),
+                                     rnd.get_random_8bit_number());
+            }
+        }
+
+        cout << nc << "x" << nr << ", cell size " << cell_size << ", " << iters << " iterations" << endl;
+        cout << fixed << setprecision(2);
+        run_benchmarks("gray", gray, cell_size, iters);
+        run_benchmarks("rgb", rgb, cell_size, iters);
+    }
+    catch (exception& e)
+    {
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
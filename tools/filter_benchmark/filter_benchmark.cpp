@@ -0,0 +1,157 @@
+// The contents of this file are in the public domain. See LICENSE_FOR_EXAMPLE_PROGRAMS.txt
+/*
+    This program measures the two ways spatially_filter_image() can filter an image
+    with a square filter: direct convolution and the FFT based overlap-save method.
+    For each filter size it times both, along with the choice spatially_filter_image()
+    makes, so the FFT/direct crossover in impl::use_fft_filtering() can be checked
+    against real timings.  Two cases are timed:
+        - simd:   float image, float filter, float output.  The direct method uses
+                  SIMD instructions here.
+        - scalar: float image, double filter, double output.  The direct method is
+                  the plain scalar loop here.
+    For example, to time filters up to 41x41 on a 640x480 image you would run:
+        ./filter_benchmark --size 640 480 --max-filter 41
+*/
+
+#include <dlib/image_transforms.h>
+#include <dlib/cmd_line_parser.h>
+#include <dlib/rand.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+template <typename funct_type>
+double time_call (
+    int iters,
+    funct_type funct
+)
+/*!
+    ensures
+        - returns the average number of milliseconds a call to funct() takes.
+!*/
+{
+    // warm up the caches and any lazily allocated state.
+    funct();
+    const auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+        funct();
+    const auto stop = chrono::high_resolution_clock::now();
+    return chrono::duration<double,milli>(stop-start).count()/iters;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void direct_filter (
+    const matrix<float>& img,
+    matrix<float>& out,
+    const matrix<float>& filter
+)
+{
+    // This is what spatially_filter_image() runs for all float inputs.
+    impl::float_spatially_filter_image(img, out, filter, false);
+}
+
+void direct_filter (
+    const matrix<float>& img,
+    matrix<double>& out,
+    const matrix<double>& filter
+)
+{
+    impl::grayscale_spatially_filter_image(img, out, filter, 1, false, false);
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <typename out_type, typename filter_type>
+void run_benchmark (
+    const string& name,
+    const matrix<float>& img,
+    long filter_size,
+    int iters
+)
+{
+    const bool simd_direct_path = is_same_type<out_type,float>::value;
+    dlib::rand rnd;
+    matrix<filter_type> filter(filter_size, filter_size);
+    for (long i = 0; i < filter.size(); ++i)
+        filter(i) = rnd.get_random_gaussian();
+
+    matrix<out_type> out;
+    const double direct = time_call(iters, [&]() { direct_filter(img, out, filter); });
+    const double fft = time_call(iters, [&]() { impl::fft_spatially_filter_image(img, out, filter, 1, false, false); });
+    const bool picks_fft = impl::use_fft_filtering(img.nr(), img.nc(), filter_size, filter_size, simd_direct_path);
+
+    cout << setw(7) << name << "  " << setw(3) << filter_size << "x" << setw(3) << left << filter_size << right
+         << "  direct " << setw(9) << direct << " ms"
+         << "  fft " << setw(9) << fft << " ms"
+         << "  faster: " << (fft < direct ? "fft   " : "direct")
+         << "  picked: " << (picks_fft ? "fft" : "direct") << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        command_line_parser parser;
+        parser.add_option("h","Display this help message.");
+        parser.add_option("size","Size of the input image.  (default: 640 480)",2);
+        parser.add_option("max-filter","Largest filter size to time. (default: 41)",1);
+        parser.add_option("iters","Number of timed calls for each method. (default: 3)",1);
+        parser.parse(argc, argv);
+
+        const char* one_time_opts[] = {"h", "size", "max-filter", "iters"};
+        parser.check_one_time_options(one_time_opts);
+        parser.check_option_arg_range("max-filter", 1, 1000);
+        parser.check_option_arg_range("iters", 1, 1000000);
+
+        if (parser.option("h"))
+        {
+            cout << "Usage: filter_benchmark [options]\n";
+            parser.print_options();
+            return 0;
+        }
+
+        long nc = 640, nr = 480;
+        if (parser.option("size"))
+        {
+            nc = string_cast<long>(parser.option("size").argument(0));
+            nr = string_cast<long>(parser.option("size").argument(1));
+        }
+        const long max_filter = get_option(parser, "max-filter", 41);
+        const int iters = get_option(parser, "iters", 3);
+
+        dlib::rand rnd;
+        matrix<float> img(nr, nc);
+        for (long i = 0; i < img.size(); ++i)
+            img(i) = rnd.get_random_8bit_number();
+
+        cout << nc << "x" << nr << ", " << iters << " iterations" << endl;
+        cout << fixed << setprecision(2);
+        const long filter_sizes[] = {5, 7, 9, 11, 13, 15, 17, 19, 21, 25, 31, 41, 51, 61};
+        for (auto size : filter_sizes)
+        {
+            if (size <= max_filter && size <= std::min(nr,nc))
+                run_benchmark<float,float>("simd", img, size, iters);
+        }
+        for (auto size : filter_sizes)
+        {
+            if (size <= max_filter && size <= std::min(nr,nc))
+                run_benchmark<double,double>("scalar", img, size, iters);
+        }
+    }
+    catch (exception& e)
+    {
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
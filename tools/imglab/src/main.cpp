@@ -630,6 +630,9 @@ int main(int argc, char** argv)
         parser.add_option("rmignore","Remove all boxes marked ignore and save the results to a new XML file.");
         parser.add_option("rm-if-overlaps","Remove all boxes labeled <arg> if they overlap any box not labeled <arg> and save the results to a new XML file.",1);
         parser.add_option("jpg", "When saving images to disk, write them as jpg files instead of png.");
+        parser.add_option("cache", "Decode all the images in the given XML file and save them, along with their annotations, "
+                                   "to a binary image dataset cache file named <arg>.  Load it with dlib::image_dataset_cache.",1);
+        parser.add_option("gray", "When using --cache, store the images in grayscale rather than color.");
 
         parser.set_group_name("Cropping sub images");
         parser.add_option("resample", "Crop out images that are centered on each object in the dataset. "
@@ -645,13 +648,15 @@ int main(int argc, char** argv)
 
         const char* singles[] = {"h","c","r","l","files","convert","parts","rmdiff", "rmtrunc", "rmdupes", "seed", "shuffle", "split", "add", 
                                  "flip", "rotate", "tile", "size", "cluster", "resample", "min-object-size", "rmempty",
-                                 "crop-size", "cropped-object-size", "rmlabel", "rm-if-overlaps", "sort-num-objects", "one-object-per-image", "jpg", "rmignore"};
+                                 "crop-size", "cropped-object-size", "rmlabel", "rm-if-overlaps", "sort-num-objects", "one-object-per-image", "jpg", "rmignore",
+                                 "cache", "gray"};
         parser.check_one_time_options(singles);
         const char* c_sub_ops[] = {"r", "convert"};
         parser.check_sub_options("c", c_sub_ops);
         parser.check_sub_option("shuffle", "seed");
         const char* resample_sub_ops[] = {"min-object-size", "crop-size", "cropped-object-size", "one-object-per-image"};
         parser.check_sub_options("resample", resample_sub_ops);
+        parser.check_sub_option("cache", "gray");
         const char* size_parent_ops[] = {"tile", "cluster"};
         parser.check_sub_options(size_parent_ops, "size");
         parser.check_incompatible_options("c", "l");
@@ -779,6 +784,21 @@ int main(int argc, char** argv)
             return resample_dataset(parser);
         }
 
+        if (parser.option("cache"))
+        {
+            if (parser.number_of_arguments() != 1)
+            {
+                cerr << "The --cache option requires you to give one XML file on the command line." << endl;
+                return EXIT_FAILURE;
+            }
+
+            if (parser.option("gray"))
+                create_image_dataset_cache<unsigned char>(parser[0], parser.option("cache").argument());
+            else
+                create_image_dataset_cache<rgb_pixel>(parser[0], parser.option("cache").argument());
+            return EXIT_SUCCESS;
+        }
+
         if (parser.option("c"))
         {
             if (parser.option("convert"))
@@ -0,0 +1,175 @@
+// The contents of this file are in the public domain. See LICENSE_FOR_EXAMPLE_PROGRAMS.txt
+/*
+    This program measures how fast dlib saves and loads PNG files.  It times
+    load_png() and save_png() with a few compression settings on an 8-bit grayscale
+    mask and on an RGB image, and prints the average time per call along with the
+    size of each saved file.  The test images are generated so that they compress
+    about as well as real images do, or you can time your own image instead.  For
+    example:
+        ./png_benchmark --size 1920 1080
+        ./png_benchmark --image photo.png
+*/
+
+#include <dlib/image_io.h>
+#include <dlib/image_transforms.h>
+#include <dlib/cmd_line_parser.h>
+#include <dlib/dir_nav.h>
+#include <dlib/rand.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+template <typename funct_type>
+double time_call (
+    int iters,
+    funct_type funct
+)
+/*!
+    ensures
+        - returns the average number of milliseconds a call to funct() takes.
+!*/
+{
+    // warm up the caches and any lazily allocated state.
+    funct();
+    const auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+        funct();
+    const auto stop = chrono::high_resolution_clock::now();
+    return chrono::duration<double,milli>(stop-start).count()/iters;
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <typename image_type>
+void run_benchmarks (
+    const string& name,
+    const image_type& img,
+    const string& filename,
+    int iters
+)
+{
+    struct setting
+    {
+        const char* name;
+        int level;
+        png_filter filter;
+    };
+    const setting settings[] = {
+        {"default",            6, png_filter_adaptive},
+        {"level 1, no filter", 1, png_filter_none},
+        {"level 1, sub",       1, png_filter_sub},
+        {"level 9",            9, png_filter_adaptive}
+    };
+
+    for (auto& s : settings)
+    {
+        const double save_time = time_call(iters, [&]() { save_png(img, filename, s.level, s.filter); });
+        cout << setw(5) << name << "  save " << setw(20) << left << s.name << right
+             << setw(9) << save_time << " ms  " << setw(9) << file(filename).size()/1024 << " KB" << endl;
+    }
+
+    // Load the file written with the default settings.
+    save_png(img, filename);
+    image_type loaded;
+    const double load_time = time_call(iters, [&]() { load_png(loaded, filename); });
+    cout << setw(5) << name << "  load " << setw(20) << "" << setw(9) << load_time << " ms" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        command_line_parser parser;
+        parser.add_option("h","Display this help message.");
+        parser.add_option("size","Size of the generated test images.  (default: 1920 1080)",2);
+        parser.add_option("image","Time this image instead of generated ones.",1);
+        parser.add_option("out","File the benchmark writes to. (default: png_benchmark.png)",1);
+        parser.add_option("iters","Number of timed calls for each case. (default: 5)",1);
+        parser.parse(argc, argv);
+
+        const char* one_time_opts[] = {"h", "size", "image", "out", "iters"};
+        parser.check_one_time_options(one_time_opts);
+        parser.check_incompatible_options("size", "image");
+        parser.check_option_arg_range("iters", 1, 1000000);
+
+        if (parser.option("h"))
+        {
+            cout << "Usage: png_benchmark [options]\n";
+            parser.print_options();
+            return 0;
+        }
+
+        const string filename = get_option(parser, "out", "png_benchmark.png");
+        const int iters = get_option(parser, "iters", 5);
+
+        matrix<unsigned char> mask;
+        matrix<rgb_pixel> rgb;
+        if (parser.option("image"))
+        {
+            load_image(rgb, parser.option("image").argument());
+            // A thresholded version of the image stands in for a mask.
+            threshold_image(rgb, mask, 128);
+        }
+        else
+        {
+            long nc = 1920, nr = 1080;
+            if (parser.option("size"))
+            {
+                nc = string_cast<long>(parser.option("size").argument(0));
+                nr = string_cast<long>(parser.option("size").argument(1));
+            }
+
+            // The mask is a set of solid ellipses, like a segmentation output.  The RGB
+            // image is a smooth gradient with some noise, like a photo.
+            dlib::rand rnd;
+            mask.set_size(nr, nc);
+            mask = 0;
+            for (int i = 0; i < 40; ++i)
+            {
+                const dpoint center(rnd.get_random_double()*nc, rnd.get_random_double()*nr);
+                const double rx = 10 + rnd.get_random_double()*nc/8;
+                const double ry = 10 + rnd.get_random_double()*nr/8;
+                for (long r = 0; r < nr; ++r)
+                {
+                    for (long c = 0; c < nc; ++c)
+                    {
+                        const double x = (c-center.x())/rx;
+                        const double y = (r-center.y())/ry;
+                        if (x*x + y*y <= 1)
+                            mask(r,c) = 255;
+                    }
+                }
+            }
+
+            rgb.set_size(nr, nc);
+            for (long r = 0; r < nr; ++r)
+            {
+                for (long c = 0; c < nc; ++c)
+                {
+                    const int noise = rnd.get_random_32bit_number()%8;
+                    rgb(r,c) = rgb_pixel(248*c/nc + noise, 248*r/nr + noise, 128 + noise);
+                }
+            }
+        }
+
+        cout << rgb.nc() << "x" << rgb.nr() << ", " << iters << " iterations" << endl;
+        cout << fixed << setprecision(2);
+        run_benchmarks("mask", mask, filename, iters);
+        run_benchmarks("rgb", rgb, filename, iters);
+    }
+    catch (exception& e)
+    {
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
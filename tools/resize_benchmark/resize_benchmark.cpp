@@ -0,0 +1,138 @@
+// The contents of this file are in the public domain. See LICENSE_FOR_EXAMPLE_PROGRAMS.txt
+/*
+    This program measures the throughput of dlib's resize_image() routines.  It
+    resizes a random grayscale and a random RGB image with each interpolation mode
+    and prints the average time per call.  For example, to time a 3840x2160 to
+    1920x1080 resize using 4 threads you would run:
+        ./resize_benchmark --in 3840 2160 --out 1920 1080 --threads 4
+*/
+
+#include <dlib/image_transforms.h>
+#include <dlib/cmd_line_parser.h>
+#include <dlib/rand.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+template <typename image_type, typename resize_function>
+double time_resize (
+    const image_type& img,
+    long out_nr,
+    long out_nc,
+    int iters,
+    resize_function resize
+)
+/*!
+    ensures
+        - returns the average number of milliseconds resize(img,out) takes, where out
+          is an image of size out_nr by out_nc.
+!*/
+{
+    image_type out(out_nr, out_nc);
+    // warm up the caches and any lazily allocated state.
+    resize(img, out);
+    const auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+        resize(img, out);
+    const auto stop = chrono::high_resolution_clock::now();
+    return chrono::duration<double,milli>(stop-start).count()/iters;
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <typename image_type>
+void run_benchmarks (
+    const string& name,
+    const image_type& img,
+    long out_nr,
+    long out_nc,
+    int iters,
+    unsigned long num_threads
+)
+{
+    const double bilinear = time_resize(img, out_nr, out_nc, iters,
+        [](const image_type& in, image_type& out) { resize_image(in, out, interpolate_bilinear()); });
+    const double area = time_resize(img, out_nr, out_nc, iters,
+        [&](const image_type& in, image_type& out) { resize_image(in, out, interpolate_area(), num_threads); });
+    const double lanczos = time_resize(img, out_nr, out_nc, iters,
+        [&](const image_type& in, image_type& out) { resize_image(in, out, interpolate_lanczos3(), num_threads); });
+
+    cout << setw(6) << name << ":  bilinear " << setw(8) << bilinear << " ms"
+         << ",  area " << setw(8) << area << " ms"
+         << ",  lanczos3 " << setw(8) << lanczos << " ms" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        command_line_parser parser;
+        parser.add_option("h","Display this help message.");
+        parser.add_option("in","Size of the input image.  (default: 3840 2160)",2);
+        parser.add_option("out","Size of the output image.  (default: 1920 1080)",2);
+        parser.add_option("threads","Number of threads used by the area and lanczos3 modes. (default: 1)",1);
+        parser.add_option("iters","Number of timed calls for each mode. (default: 10)",1);
+        parser.parse(argc, argv);
+
+        const char* one_time_opts[] = {"h", "in", "out", "threads", "iters"};
+        parser.check_one_time_options(one_time_opts);
+        parser.check_option_arg_range("threads", 1, 1000);
+        parser.check_option_arg_range("iters", 1, 1000000);
+
+        if (parser.option("h"))
+        {
+            cout << "Usage: resize_benchmark [options]\n";
+            parser.print_options();
+            return 0;
+        }
+
+        long in_nc = 3840, in_nr = 2160, out_nc = 1920, out_nr = 1080;
+        if (parser.option("in"))
+        {
+            in_nc = string_cast<long>(parser.option("in").argument(0));
+            in_nr = string_cast<long>(parser.option("in").argument(1));
+        }
+        if (parser.option("out"))
+        {
+            out_nc = string_cast<long>(parser.option("out").argument(0));
+            out_nr = string_cast<long>(parser.option("out").argument(1));
+        }
+        const unsigned long num_threads = get_option(parser, "threads", 1);
+        const int iters = get_option(parser, "iters", 10);
+
+        dlib::rand rnd;
+        matrix<unsigned char> gray(in_nr, in_nc);
+        matrix<rgb_pixel> rgb(in_nr, in_nc);
+        for (long r = 0; r < in_nr; ++r)
+        {
+            for (long c = 0; c < in_nc; ++c)
+            {
+                gray(r,c) = rnd.get_random_8bit_number();
+                rgb(r,c) = rgb_pixel(rnd.get_random_8bit_number(),
+                                     rnd.get_random_8bit_number(),
+                                     rnd.get_random_8bit_number());
+            }
+        }
+
+        cout << in_nc << "x" << in_nr << " -> " << out_nc << "x" << out_nr
+             << ", " << num_threads << " thread(s), " << iters << " iterations" << endl;
+        cout << fixed << setprecision(2);
+        run_benchmarks("gray", gray, out_nr, out_nc, iters, num_threads);
+        run_benchmarks("rgb", rgb, out_nr, out_nc, iters, num_threads);
+    }
+    catch (exception& e)
+    {
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+